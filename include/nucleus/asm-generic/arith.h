@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 The Xenomai project <http://www.xenomai.org>.
+ *
+ * Xenomai is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Xenomai is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Xenomai; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _XENO_ASM_GENERIC_ARITH_H
+#define _XENO_ASM_GENERIC_ARITH_H
+
+/* Division-free scaling of 64bit values by a constant m/d ratio.
+   The ratio is precomputed as an integral part and a 64bit binary
+   fraction, so that scaling only needs a few 32x32 multiplies. The
+   fraction is rounded up, which keeps exact multiples exact, and
+   makes the result differ from the one of a true 96bit division by
+   at most one unit over the whole 63bit range. */
+
+typedef struct xnarch_scale {
+
+    unsigned long long frac;	/* Fractional part of m/d, times 2^64. */
+    unsigned long integ;	/* Integral part of m/d. */
+
+} xnarch_scale_t;
+
+static inline void xnarch_init_scale (xnarch_scale_t *scale,
+				      unsigned long m,
+				      unsigned long d)
+{
+    unsigned long long r;
+    int n;
+
+    scale->integ = m / d;
+    scale->frac = 0;
+    r = m % d;
+
+    /* Plain long division, this is only done at init time. */
+
+    for (n = 0; n < 64; n++)
+	{
+	r <<= 1;
+	scale->frac <<= 1;
+
+	if (r >= d)
+	    {
+	    r -= d;
+	    scale->frac |= 1;
+	    }
+	}
+
+    if (r)
+	scale->frac++;
+}
+
+/* High 64bit word of the 128bit product a * b. */
+
+static inline unsigned long long __xnarch_mulhi64 (unsigned long long a,
+						   unsigned long long b)
+{
+    unsigned ah = (unsigned)(a >> 32), al = (unsigned)a;
+    unsigned bh = (unsigned)(b >> 32), bl = (unsigned)b;
+    unsigned long long ll, lh, hl, mid;
+
+    ll = (unsigned long long)al * bl;
+    lh = (unsigned long long)al * bh;
+    hl = (unsigned long long)ah * bl;
+    mid = (ll >> 32) + (unsigned)lh + (unsigned)hl;
+
+    return (unsigned long long)ah * bh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+}
+
+static inline unsigned long long xnarch_uscale (const xnarch_scale_t *scale,
+						unsigned long long op)
+{
+    return op * scale->integ + __xnarch_mulhi64(op,scale->frac);
+}
+
+static inline long long xnarch_scale (const xnarch_scale_t *scale,
+				      long long op)
+{
+    /* Round towards zero, as xnarch_llimd() does. */
+
+    if (op < 0)
+	return -(long long)xnarch_uscale(scale,-op);
+
+    return xnarch_uscale(scale,op);
+}
+
+#endif /* !_XENO_ASM_GENERIC_ARITH_H */
@@ -35,6 +35,9 @@ typedef struct xnsysinfo {
 
     unsigned long long cpufreq;	/* CPU frequency */
     unsigned long tickval;	/* Tick duration (ns) */
+    void *vdsoheap;		/* Shared heap holding the time page */
+    unsigned long vdsosize;	/* Size of this heap */
+    unsigned long vdsooff;	/* Offset of the time page in this heap */
 
 } xnsysinfo_t;
 
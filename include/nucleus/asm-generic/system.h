@@ -35,6 +35,7 @@
 #include <xeno_config.h>
 #include <nucleus/asm/hal.h>
 #include <nucleus/asm/atomic.h>
+#include <nucleus/asm-generic/arith.h>
 #include <nucleus/shadow.h>
 
 #define module_param_value(parm) (parm)
@@ -62,6 +63,9 @@ typedef struct {
         const char *file;
         const char *function;
         unsigned line;
+        /* Cross-CPU contention, all locks included. */
+        unsigned long nr_contended;
+        unsigned long long spin_total;
 
 } xnlockinfo_t;
 
@@ -74,6 +78,11 @@ typedef struct {
     int cpu;
     unsigned long long spin_time;
     unsigned long long lock_date;
+    /* Cross-CPU contention on this lock; only updated by the owner. */
+    unsigned long nr_acquired;
+    unsigned long nr_contended;
+    unsigned long long spin_total;
+    unsigned long long spin_max;
 
 } xnlock_t;
 
@@ -85,6 +94,10 @@ typedef struct {
         -1,                                     \
         0LL,                                    \
         0LL,                                    \
+        0,                                      \
+        0,                                      \
+        0LL,                                    \
+        0LL,                                    \
 }
 
 #define CONFIG_XENO_SPINLOCK_DEBUG  1
@@ -146,20 +159,29 @@ typedef struct xnarch_heapcb {
 
     int kmflags;	/* Kernel memory flags (0 if vmalloc()). */
 
+    int pgorder;	/* Page allocator order (-1 if unused). */
+
     void *heapbase;	/* Shared heap memory base. */
 
+    int rdonly;		/* Only read-only mappings are allowed. */
+
 } xnarch_heapcb_t;
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Precomputed 1e9/freq and freq/1e9 ratios, see
+   xnarch_init_timeconv(). */
+extern xnarch_scale_t xnarch_tsc2ns_scale,
+		      xnarch_ns2tsc_scale;
+
 static inline long long xnarch_tsc_to_ns (long long ts) {
-    return xnarch_llimd(ts,1000000000,RTHAL_CPU_FREQ);
+    return xnarch_scale(&xnarch_tsc2ns_scale,ts);
 }
 
 static inline long long xnarch_ns_to_tsc (long long ns) {
-    return xnarch_llimd(ns,RTHAL_CPU_FREQ,1000000000);
+    return xnarch_scale(&xnarch_ns2tsc_scale,ns);
 }
 
 static inline unsigned long long xnarch_get_cpu_time (void) {
@@ -221,6 +243,7 @@ static inline spl_t __xnlock_get_irqsave (xnlock_t *lock,
                                           const char *function)
 {
     unsigned spin_count = 0;
+    int contended = 0;
 #else /* !CONFIG_XENO_SPINLOCK_DEBUG */
 static inline spl_t __xnlock_get_irqsave (xnlock_t *lock)
 {
@@ -238,6 +261,13 @@ static inline spl_t __xnlock_get_irqsave (xnlock_t *lock)
         unsigned long long lock_date = rthal_rdtsc();
 #endif /* CONFIG_XENO_SPINLOCK_DEBUG */
         while (test_and_set_bit(BITS_PER_LONG - 1,&lock->lock))
+            {
+#ifdef CONFIG_XENO_SPINLOCK_DEBUG
+            /* Another CPU held the lock, even if it released it before
+               we could spin on it. */
+            contended = 1;
+#endif /* CONFIG_XENO_SPINLOCK_DEBUG */
+
             /* Use an non-locking test in the inner loop, as Linux'es
                bit_spin_lock. */
             while (test_bit(BITS_PER_LONG - 1,&lock->lock))
@@ -260,6 +290,7 @@ static inline spl_t __xnlock_get_irqsave (xnlock_t *lock)
                     }
 #endif /* CONFIG_XENO_SPINLOCK_DEBUG */
                 }
+            }
 
 #ifdef CONFIG_XENO_SPINLOCK_DEBUG
         lock->spin_time = rthal_rdtsc() - lock_date;
@@ -268,6 +299,24 @@ static inline spl_t __xnlock_get_irqsave (xnlock_t *lock)
         lock->function = function;
         lock->line = line;
         lock->cpu = cpuid;
+#ifdef CONFIG_XENO_OPT_STATS
+        lock->nr_acquired++;
+
+        if (contended)
+            {
+            /* We had to wait for another CPU to release the lock. */
+            extern xnlockinfo_t xnlock_stats[];
+
+            lock->nr_contended++;
+            lock->spin_total += lock->spin_time;
+
+            if (lock->spin_time > lock->spin_max)
+                lock->spin_max = lock->spin_time;
+
+            xnlock_stats[cpuid].nr_contended++;
+            xnlock_stats[cpuid].spin_total += lock->spin_time;
+            }
+#endif /* CONFIG_XENO_OPT_STATS */
 #endif /* CONFIG_XENO_SPINLOCK_DEBUG */
         }
     else
@@ -473,6 +522,26 @@ static inline unsigned long long xnarch_get_sys_time(void)
 
 #endif /* XENO_POD_MODULE */
 
+#ifdef XENO_MAIN_MODULE
+
+xnarch_scale_t xnarch_tsc2ns_scale,
+	       xnarch_ns2tsc_scale;
+
+EXPORT_SYMBOL(xnarch_tsc2ns_scale);
+EXPORT_SYMBOL(xnarch_ns2tsc_scale);
+
+/* Must run before any time conversion, i.e. first thing during the
+   calibration. */
+
+static inline void xnarch_init_timeconv (unsigned long freq)
+
+{
+    xnarch_init_scale(&xnarch_tsc2ns_scale,1000000000,freq);
+    xnarch_init_scale(&xnarch_ns2tsc_scale,freq,1000000000);
+}
+
+#endif /* XENO_MAIN_MODULE */
+
 #ifdef XENO_INTR_MODULE
 
 static inline int xnarch_hook_irq (unsigned irq,
@@ -525,7 +594,29 @@ static inline void xnarch_init_heapcb (xnarch_heapcb_t *hcb)
 {
     atomic_set(&hcb->numaps,0);
     hcb->kmflags = 0;
+    hcb->pgorder = -1;
     hcb->heapbase = NULL;
+    hcb->rdonly = 0;
+}
+
+static inline int xnarch_local_node (void)
+
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,0)
+    return numa_node_id();
+#else /* Linux version < 2.6.0 */
+    return 0;
+#endif /* Linux version >= 2.6.0 */
+}
+
+static inline int xnarch_node_online (int node)
+
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,0)
+    return node >= 0 && node < MAX_NUMNODES && node_online(node);
+#else /* Linux version < 2.6.0 */
+    return node >= 0 && node < numnodes;
+#endif /* Linux version >= 2.6.0 */
 }
 
 static inline int xnarch_remap_page_range(struct vm_area_struct *vma,
@@ -564,6 +564,8 @@ unsigned long xnarch_calibrate_timer (void)
 int xnarch_calibrate_sched (void)
 
 {
+    xnarch_init_timeconv(RTHAL_CPU_FREQ);
+
     nktimerlat = xnarch_calibrate_timer();
 
     if (!nktimerlat)
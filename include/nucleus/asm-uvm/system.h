@@ -35,6 +35,7 @@
 #include <xeno_config.h>
 #include <nucleus/asm/atomic.h>
 #include <nucleus/asm/syscall.h>
+#include <nucleus/asm-generic/arith.h>
 #include <uvm/uvm.h>
 
 /* Module arg macros */
@@ -25,8 +25,8 @@
 /*
  * CONSTRAINTS:
  *
- * Minimum page size is 2 ** XNHEAP_MINLOG2 (must be large enough to
- * hold a pointer).
+ * Minimum page size is 2 ** XNHEAP_MINLOG2, and must be large enough
+ * to hold a free range descriptor (xnheap_run_t).
  *
  * Maximum page size is 2 ** XNHEAP_MAXLOG2.
  *
@@ -40,6 +40,12 @@
  * list. So we need a bucket for each power of two between
  * XNHEAP_MINLOG2 and XNHEAP_MAXLOG2 inclusive, plus one to honor
  * requests ranging from the maximum page size to twice this size.
+ *
+ * Free pages are grouped in ranges of contiguous pages, which are
+ * queued to the list matching the log2 value of their length, so
+ * that a suitable range is found in constant time. Extents are
+ * hashed by address, so that the extent a block belongs to is found
+ * without scanning the extent queue.
  */
 
 #if defined(__KERNEL__) || defined(__XENO_UVM__) || defined(__XENO_SIM__)
@@ -50,11 +56,36 @@
 #define	XNHEAP_MINALIGNSZ (1 << 4) /* i.e. 16 bytes */
 #define	XNHEAP_NBUCKETS   (XNHEAP_MAXLOG2 - XNHEAP_MINLOG2 + 2)
 #define	XNHEAP_MAXEXTSZ   (1 << 24) /* i.e. 16Mb */
+#define	XNHEAP_NCLASSES   (24 - XNHEAP_MINLOG2 + 1) /* i.e. log2(MAXEXTSZ / min. pagesize) + 1 */
+#define	XNHEAP_EXTHASH    16 /* Must be a power of two */
+#define	XNHEAP_RUNSCAN    4  /* Max. ranges checked in a list before using a longer one */
 
 #define XNHEAP_PFREE   0
 #define XNHEAP_PCONT   1
 #define XNHEAP_PLIST   2
 
+/* A free range descriptor is stored in the first page of each range
+   of free pages. The last page of a range longer than one page
+   repeats its length in its first word, so that a range being
+   released can be merged with the free range which precedes it. */
+
+typedef struct xnheap_run {
+
+    u_long npages;	/* Must be first, see above */
+
+    struct xnheap_run *next,
+		      *prev;
+
+} xnheap_run_t;
+
+typedef struct xnextlink {
+
+    struct xnextlink *next;
+
+    struct xnextent *extent;
+
+} xnextlink_t;
+
 typedef struct xnextent {
 
     xnholder_t link;
@@ -63,13 +94,128 @@ typedef struct xnextent {
 ((xnextent_t *)(((char *)laddr) - (int)(&((xnextent_t *)0)->link)))
 
     caddr_t membase,	/* Base address of the page array */
-	    memlim,	/* Memory limit of page array */
-	    freelist;	/* Head of the free page list */
+	    memlim;	/* Memory limit of page array */
+
+    xnextlink_t hlinks[2];	/* Address hash links (first, last page) */
 
     u_char pagemap[1];	/* Beginning of page map */
 
 } xnextent_t;
 
+/*
+ * Blocks scheduled for deferred release are queued to per-CPU idle
+ * lists, so that xnheap_schedule_free() never contends on the heap
+ * lock. The per-list lock is only taken by the local CPU, and
+ * briefly by xnheap_finalize_free_inner() when picking blocks from
+ * the list. Since xnfreesync() runs with interrupts off on every
+ * switch to the root thread, each call only returns up to
+ * XNHEAP_FREEBATCH idle blocks to the heap and leaves the others
+ * queued for the next calls, so that a long list does not hold off
+ * interrupts for long. xnheap_alloc() drains the whole list of the
+ * local CPU before reporting a failure.
+ */
+
+#define XNHEAP_FREEBATCH  16	/* Max. blocks freed per call. */
+
+typedef struct xnheap_idleq {
+
+#ifdef CONFIG_SMP
+    xnlock_t lock;
+#endif /* CONFIG_SMP */
+
+    xnholder_t *head;	/* One-way list of idle blocks */
+
+} xnheap_idleq_t;
+
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+
+/*
+ * Per-CPU magazines cache the free blocks of each bucket size up to
+ * the heap page size. A magazine is only accessed from its own CPU
+ * with interrupts off, except when some CPU runs out of memory and
+ * reclaims the blocks cached by others, hence the per-magazine lock
+ * which is normally uncontended. Lock order is magazine, then heap.
+ */
+
+#define XNHEAP_MAGSIZE   CONFIG_XENO_OPT_HEAP_MAGSIZE
+#define XNHEAP_MAGBATCH  (XNHEAP_MAGSIZE / 2) /* Blocks per transfer. */
+
+typedef struct xnheap_magstat {
+
+    u_long hits,	/* Allocations served from the magazine */
+	   misses,	/* Allocations which went to the heap */
+	   refills,	/* Batch transfers from the heap */
+	   flushes,	/* Batch transfers to the heap */
+	   cached;	/* Bytes held in the magazine */
+
+} xnheap_magstat_t;
+
+typedef struct xnheap_magazine {
+
+#ifdef CONFIG_SMP
+    xnlock_t lock;
+#endif /* CONFIG_SMP */
+
+    caddr_t blocks[XNHEAP_NBUCKETS];	/* LIFO lists of free blocks */
+
+    u_short count[XNHEAP_NBUCKETS];
+
+    xnheap_magstat_t stat;
+
+} xnheap_magazine_t;
+
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+
+#ifdef CONFIG_XENO_OPT_STATS
+
+/* Per-CPU allocation counters, only updated by their own CPU with
+   interrupts off. */
+
+typedef struct xnheap_stat {
+
+    u_long nallocs,	/* Successful allocations */
+	   nfrees,	/* Successful releases */
+	   nfails;	/* Failed allocations */
+
+    xnticks_t maxalloc;	/* Worst-case allocation time (TSC) */
+
+} xnheap_stat_t;
+
+/* Heap usage report, see xnheap_get_info(). */
+
+typedef struct xnheap_info {
+
+    char label[XNOBJECT_NAME_LEN];
+
+    char parent[XNOBJECT_NAME_LEN]; /* Label of the parent of a reserve */
+
+    u_long size,	/* Overall size of the extents */
+	   reserved,	/* Memory lent to reserves */
+	   pagesize,
+	   nextents,
+	   used,	/* Bytes in use, see xnheap_used_mem() */
+	   maxcont;
+
+    u_long nallocs,
+	   nfrees,
+	   nfails;
+
+    xnticks_t maxalloc;
+
+    u_long freepages,	/* Pages available from the free ranges */
+	   nruns,	/* Number of free ranges */
+	   maxfree;	/* Length of the largest free range (bytes) */
+
+    struct {
+	u_long nblocks,	/* Blocks carved from the bucket pages */
+	       used,	/* Blocks held by the callers */
+	       cached;	/* Free blocks held by the magazines */
+    } buckets[XNHEAP_NBUCKETS];
+
+} xnheap_info_t;
+
+#endif /* CONFIG_XENO_OPT_STATS */
+
 typedef struct xnheap {
 
     xnholder_t link;
@@ -83,17 +229,47 @@ typedef struct xnheap {
 	   hdrsize,
 	   npages,	/* Number of pages per extent */
 	   ubytes,
-           maxcont;
+           maxcont,
+	   extshift,	/* Log2 of the extent hashing granularity */
+	   runmap;	/* Bitmap of non-empty free range lists */
 
     xnqueue_t extents;
 
+    xnextlink_t *exthash[XNHEAP_EXTHASH];
+
+    xnheap_run_t *runs[XNHEAP_NCLASSES];
+
 #ifdef CONFIG_SMP
     xnlock_t lock;
 #endif /* CONFIG_SMP */
 
     caddr_t buckets[XNHEAP_NBUCKETS];
 
-    xnholder_t *idleq;
+    xnheap_idleq_t idleq[XNARCH_NR_CPUS];
+
+    struct xnheap *parent;	/* Heap a reserve is carved from */
+
+    u_long rsvbytes;		/* Memory lent to reserves */
+
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+    xnheap_magazine_t mags[XNARCH_NR_CPUS];
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+
+#ifdef CONFIG_XENO_OPT_STATS
+    xnholder_t statlink;	/* Link in xnheap_statq */
+
+#define statlink2heap(laddr) \
+((xnheap_t *)(((char *)laddr) - (int)(&((xnheap_t *)0)->statlink)))
+
+    char label[XNOBJECT_NAME_LEN];
+
+    u_long bpages[XNHEAP_NBUCKETS],	/* Page ranges split per bucket */
+	   bused[XNHEAP_NBUCKETS],	/* Blocks handed out per bucket */
+	   nruns[XNHEAP_NCLASSES],	/* Free ranges per list */
+	   freepages;
+
+    xnheap_stat_t stats[XNARCH_NR_CPUS];
+#endif /* CONFIG_XENO_OPT_STATS */
 
     xnarch_heapcb_t archdep;
 
@@ -103,10 +279,62 @@ typedef struct xnheap {
 
 extern xnheap_t kheap;
 
+#ifdef CONFIG_XENO_OPT_STATS
+extern xnqueue_t xnheap_statq;
+#endif /* CONFIG_XENO_OPT_STATS */
+
+/*
+ * Fixed-size object slabs. A slab carves chunks obtained from a heap
+ * into objects of a single size, which are kept on a free list. The
+ * objects never straddle more cache lines than their size requires:
+ * objects larger than a cache line start on a line boundary, smaller
+ * ones are aligned on the next power of two of their size.
+ */
+
+#ifdef L1_CACHE_BYTES
+#define XNSLAB_ALIGNSZ  L1_CACHE_BYTES
+#else /* !L1_CACHE_BYTES */
+#define XNSLAB_ALIGNSZ  32
+#endif /* L1_CACHE_BYTES */
+
+#define XNSLAB_MINOBJS  8	/* Minimum number of objects per chunk */
+
+typedef struct xnslab {
+
+    xnheap_t *heap;	/* Heap chunks are obtained from */
+
+    u_long objsize,	/* Object size, as requested */
+	   stride,	/* Distance between two objects */
+	   align,	/* Object alignment */
+	   linkoff,	/* Offset of the free list link */
+	   chunksize,	/* Size of a chunk */
+	   nobjs,	/* Number of carved objects */
+	   nfree;	/* Number of free objects */
+
+    caddr_t freelist;
+
+    xnqueue_t chunkq;
+
+    void (*ctor)(void *obj);
+
+#ifdef CONFIG_SMP
+    xnlock_t lock;
+#endif /* CONFIG_SMP */
+
+} xnslab_t;
+
+#define xnslab_object_size(slab)  ((slab)->objsize)
+#define xnslab_count(slab)        ((slab)->nobjs)
+#define xnslab_free_count(slab)   ((slab)->nfree)
+
 #define xnheap_size(heap)            ((heap)->extentsize)
+#define xnheap_reserved_mem(heap)    ((heap)->rsvbytes)
+#define xnheap_reserve_p(heap)       ((heap)->parent != NULL)
 #define xnheap_page_size(heap)       ((heap)->pagesize)
 #define xnheap_page_count(heap)      ((heap)->npages)
+#ifndef CONFIG_XENO_OPT_HEAP_MAGAZINE
 #define xnheap_used_mem(heap)        ((heap)->ubytes)
+#endif /* !CONFIG_XENO_OPT_HEAP_MAGAZINE */
 #define xnheap_max_contiguous(heap)  ((heap)->maxcont)
 #define xnheap_overhead(hsize,psize) \
 ((sizeof(xnextent_t) + (((hsize) - sizeof(xnextent_t)) / (psize)) + \
@@ -141,14 +369,40 @@ int xnheap_init_shared(xnheap_t *heap,
 		       u_long heapsize,
 		       int memflags);
 
+#define XNHEAP_LOCAL_NODE  (-1)	/* Node of the current CPU. */
+
+int xnheap_init_shared_node(xnheap_t *heap,
+			    u_long heapsize,
+			    int memflags,
+			    int node);
+
 int xnheap_destroy_shared(xnheap_t *heap);
 
+struct vm_area_struct;
+
+int xnheap_remap_vm_area(xnheap_t *heap,
+			 struct vm_area_struct *vma);
+
+/* Refuse writable user mappings of a shared heap, e.g. one holding
+   data user-space must only read. */
+#define xnheap_set_rdonly(heap) ((heap)->archdep.rdonly = 1)
+
 #define xnheap_shared_offset(heap,ptr) \
 (((caddr_t)(ptr)) - ((caddr_t)(heap)->archdep.heapbase))
 
 #define xnheap_shared_address(heap,off) \
 (((caddr_t)(heap)->archdep.heapbase) + (off))
 
+/* A shared heap is made of a single extent starting at the base of
+   the mapping; these give the offsets of its page map and page
+   array, for mappers which need to identify blocks by themselves. */
+
+#define xnheap_shared_pagemap(heap) \
+((u_long)((xnextent_t *)0)->pagemap)
+
+#define xnheap_shared_pagebase(heap) \
+((heap)->hdrsize)
+
 #endif /* __KERNEL__ */
 
 /* Public interface. */
@@ -179,6 +433,15 @@ int xnheap_test_and_free(xnheap_t *heap,
 int xnheap_free(xnheap_t *heap,
 		void *block);
 
+int xnheap_check_block(xnheap_t *heap,
+		       void *block);
+
+int xnheap_init_reserve(xnheap_t *heap,
+			xnheap_t *rsv,
+			u_long size);
+
+int xnheap_destroy_reserve(xnheap_t *rsv);
+
 void xnheap_schedule_free(xnheap_t *heap,
 			  void *block,
 			  xnholder_t *link);
@@ -187,10 +450,53 @@ void xnheap_finalize_free_inner(xnheap_t *heap);
 
 static inline void xnheap_finalize_free(xnheap_t *heap)
 {
-    if (heap->idleq)
-	xnheap_finalize_free_inner(heap);
+    int cpu;
+
+    for (cpu = 0; cpu < XNARCH_NR_CPUS; cpu++)
+	if (heap->idleq[cpu].head)
+	    {
+	    xnheap_finalize_free_inner(heap);
+	    break;
+	    }
 }
 
+int xnslab_init(xnslab_t *slab,
+		xnheap_t *heap,
+		u_long objsize,
+		u_long reserve,
+		void (*ctor)(void *obj));
+
+void xnslab_destroy(xnslab_t *slab);
+
+void *xnslab_alloc(xnslab_t *slab);
+
+void xnslab_free(xnslab_t *slab,
+		 void *obj);
+
+#ifdef CONFIG_XENO_OPT_STATS
+
+void xnheap_set_label(xnheap_t *heap,
+		      const char *label);
+
+void xnheap_get_info(xnheap_t *heap,
+		     xnheap_info_t *info);
+
+#else /* !CONFIG_XENO_OPT_STATS */
+
+#define xnheap_set_label(heap,label)  do { } while(0)
+
+#endif /* CONFIG_XENO_OPT_STATS */
+
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+
+u_long xnheap_used_mem(xnheap_t *heap);
+
+void xnheap_get_magstat(xnheap_t *heap,
+			int cpu,
+			xnheap_magstat_t *stat);
+
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+
 #ifdef __cplusplus
 }
 #endif
@@ -84,6 +84,8 @@ struct xnltt_evmap {
 #define xeno_ev_tmstop       46
 #define xeno_ev_mark         47
 #define xeno_ev_watchdog     48
+#define xeno_ev_thrbudget    49
+#define xeno_ev_budgetovr    50
 
 #define xeno_evthr  0x1
 #define xeno_evirq  0x2
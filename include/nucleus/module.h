@@ -31,6 +31,20 @@ extern "C" {
 
 void xnmod_alloc_glinks(xnqueue_t *freehq);
 
+#if defined(__KERNEL__) && defined(CONFIG_SMP) && defined(CONFIG_XENO_OPT_STATS)
+
+int xnlock_stat_register(xnlock_t *lock,
+			 const char *name);
+
+void xnlock_stat_unregister(xnlock_t *lock);
+
+#else /* !(__KERNEL__ && CONFIG_SMP && CONFIG_XENO_OPT_STATS) */
+
+#define xnlock_stat_register(lock,name)  ({ 0; })
+#define xnlock_stat_unregister(lock)     do { } while(0)
+
+#endif /* __KERNEL__ && CONFIG_SMP && CONFIG_XENO_OPT_STATS */
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,17 +26,132 @@
 #define	XNPIPE_IOCTL_BASE     'p'
 #define XNPIPEIOC_GET_NRDEV   _IOW(XNPIPE_IOCTL_BASE,0,int)
 #define XNPIPEIOC_FLUSH       _IO(XNPIPE_IOCTL_BASE,1)
+#define XNPIPEIOC_SETRING     _IOWR(XNPIPE_IOCTL_BASE,2,struct xnpipe_ringinfo)
+#define XNPIPEIOC_SETCOALESCE _IOW(XNPIPE_IOCTL_BASE,3,struct xnpipe_coalesce)
+#define XNPIPEIOC_GETSTATS    _IOR(XNPIPE_IOCTL_BASE,4,struct xnpipe_stats)
 
 #define XNPIPE_NORMAL 0x0
 #define XNPIPE_URGENT 0x1
 
 #define XNPIPE_MINOR_AUTO	-1
 
+/* Ring mode. Once XNPIPEIOC_SETRING has been issued on /dev/rtpN,
+   messages sent from the real-time side are appended as records to
+   a ring the Linux reader maps into its address space with mmap(),
+   instead of being queued for read(). poll() reports POLLIN while
+   the ring holds some record. */
+
+#define XNPIPE_RING_LINESZ 64	/* Keeps both indices on separate lines. */
+
+/* Records are prefixed by their length and padded to a word. A record
+   never wraps around the end of the ring; the unused space left
+   there, if any, is marked by a XNPIPE_RING_PAD length. */
+#define XNPIPE_RING_PAD  (~0UL)
+#define XNPIPE_RING_ALIGN(n) \
+(((n) + sizeof(unsigned long) - 1) & ~(sizeof(unsigned long) - 1))
+#define XNPIPE_RING_RECSZ(n) (sizeof(unsigned long) + XNPIPE_RING_ALIGN(n))
+
+struct xnpipe_ringinfo {
+
+    unsigned long size;		/* Data area size -- rounded up to a power of 2 */
+    unsigned long mapsize;	/* Length to pass to mmap() */
+    unsigned long offset;	/* Offset of the ring in the mapping */
+};
+
+typedef struct xnpipe_ring {
+
+    volatile unsigned long head;	/* Write index -- real-time side */
+
+    char __pad1[XNPIPE_RING_LINESZ - sizeof(unsigned long)];
+
+    volatile unsigned long tail;	/* Read index -- Linux reader */
+
+    char __pad2[XNPIPE_RING_LINESZ - sizeof(unsigned long)];
+
+    unsigned long size;			/* Data area size (power of 2) */
+
+    volatile unsigned long lost;	/* Records dropped on overflow */
+
+} xnpipe_ring_t;
+
+#define xnpipe_ring_data(ring) ((char *)((ring) + 1))
+
+/* Wakeup coalescing. Once XNPIPEIOC_SETCOALESCE has been issued with
+   a non-zero watermark, the Linux reader is only woken up when the
+   data sent since the last wakeup reaches either watermark, or when
+   the oldest of it has been pending for the given delay. */
+
+struct xnpipe_coalesce {
+
+    unsigned long bytes;	/* Byte watermark -- 0 if unused */
+    unsigned long msgs;		/* Message watermark -- 0 if unused */
+    unsigned long long delay;	/* Max. wakeup delay (ns) */
+};
+
+struct xnpipe_stats {
+
+    unsigned long msgs;		/* Messages sent from the real-time side */
+    unsigned long bytes;	/* Bytes sent from the real-time side */
+    unsigned long wakeups;	/* Wakeups of the Linux reader */
+    unsigned long timeouts;	/* Wakeups forced by the coalescing delay */
+    unsigned long maxbatch;	/* Max. messages per wakeup */
+};
+
+#if !defined(__KERNEL__) && !defined(__XENO_SIM__)
+
+#include <stddef.h>
+#include <nucleus/asm/atomic.h>
+
+/* Return the address of the oldest record and store its length at
+   lenp, or NULL if the ring is empty. The record remains in place
+   until xnpipe_ring_release() is called, so that it can be processed
+   straight from the mapping. */
+
+static inline void *xnpipe_ring_peek (xnpipe_ring_t *ring,
+				      unsigned long *lenp)
+{
+    unsigned long tail = ring->tail, pos, len;
+
+    for (;;)
+	{
+	if (ring->head == tail)
+	    return NULL;
+
+	xnarch_memory_barrier();
+
+	pos = tail & (ring->size - 1);
+	len = *(unsigned long *)(xnpipe_ring_data(ring) + pos);
+
+	if (len != XNPIPE_RING_PAD)
+	    break;
+
+	/* Skip the padding up to the end of the ring. */
+	tail += ring->size - pos;
+	xnarch_atomic_xchg(&ring->tail,tail);
+	}
+
+    *lenp = len;
+
+    return xnpipe_ring_data(ring) + pos + sizeof(unsigned long);
+}
+
+/* Consume the record returned by the last xnpipe_ring_peek() call. */
+
+static inline void xnpipe_ring_release (xnpipe_ring_t *ring,
+					unsigned long len)
+{
+    xnarch_atomic_xchg(&ring->tail,ring->tail + XNPIPE_RING_RECSZ(len));
+}
+
+#endif /* !__KERNEL__ && !__XENO_SIM__ */
+
 #ifdef __KERNEL__
 
 #include <nucleus/queue.h>
 #include <nucleus/synch.h>
+#include <nucleus/select.h>
 #include <nucleus/thread.h>
+#include <nucleus/heap.h>
 #include <linux/types.h>
 #include <linux/poll.h>
 
@@ -45,6 +160,7 @@
 #define XNPIPE_USER_SIGIO  0x4
 #define XNPIPE_USER_WREAD  0x08
 #define XNPIPE_USER_WREAD_READY  0x10
+#define XNPIPE_USER_COALESCE  0x20
 
 #define XNPIPE_USER_WMASK \
 (XNPIPE_USER_WREAD)
@@ -88,6 +204,7 @@ typedef struct xnpipe_state {
     xnpipe_io_handler *input_handler;
     xnpipe_alloc_handler *alloc_handler;
     xnsynch_t synchbase;
+    xnselect_t select;	/* Input readiness */
     void *cookie;
 
     /* Linux kernel part */
@@ -96,6 +213,16 @@ typedef struct xnpipe_state {
     wait_queue_head_t readq;		/* read waiters and an open waiter */
     unsigned int readw;
     size_t ionrd;
+    xnpipe_ring_t *ring;		/* Shared ring -- NULL unless in ring mode */
+    xnheap_t *ringheap;			/* Backing memory of the ring */
+    unsigned long ringsize;		/* Kernel copies of the ring size and */
+    unsigned long ringhead;		/* write index, which Linux may corrupt */
+    struct xnpipe_coalesce coalesce;	/* Wakeup watermarks */
+    xnticks_t cdelay;			/* Coalescing delay in ticks */
+    unsigned long cbytes;		/* Bytes sent since last wakeup */
+    unsigned long cmsgs;		/* Messages sent since last wakeup */
+    xntimer_t ctimer;			/* Coalescing delay timer */
+    struct xnpipe_stats stats;
 
 } xnpipe_state_t;
 
@@ -129,12 +256,22 @@ ssize_t xnpipe_send(int minor,
 		    size_t size,
 		    int flags);
 
+ssize_t xnpipe_put(int minor,
+		   const void *buf,
+		   size_t size,
+		   int flags);
+
 ssize_t xnpipe_recv(int minor,
 		    struct xnpipe_mh **pmh,
 		    xnticks_t timeout);
 
 int xnpipe_inquire(int minor);
 
+xnselect_t *xnpipe_get_select(int minor);
+
+int xnpipe_get_stats(int minor,
+		     struct xnpipe_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
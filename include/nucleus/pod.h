@@ -98,6 +98,8 @@ typedef xnspqueue_t xnsched_queue_t;
 #define sched_getheadpq getheadspq
 #define sched_getpq     getspq
 #define sched_findpqh   findspqh
+#define sched_insertpq  insertspq
+#define sched_nextpq    nextspq
 #else /* ! CONFIG_XENO_OPT_SCALABLE_SCHED */
 typedef xnpqueue_t xnsched_queue_t;
 #define sched_initpq    initpq
@@ -110,6 +112,8 @@ typedef xnpqueue_t xnsched_queue_t;
 #define sched_getheadpq getheadpq
 #define sched_getpq     getpq
 #define sched_findpqh   findpqh
+#define sched_insertpq  insertpq
+#define sched_nextpq    nextpq
 #endif /* !CONFIG_XENO_OPT_SCALABLE_SCHED */
 
 #define XNPOD_FATAL_BUFSZ  16384
@@ -128,7 +132,19 @@ typedef struct xnsched {
 
     xnsched_queue_t readyq;     /*!< Ready-to-run threads (prioritized). */
 
-    xnqueue_t timerwheel[XNTIMER_WHEELSIZE]; /*!< BSDish timer wheel. */
+    xntimerq_t timerqueue;      /*!< Aperiodic timer queue. */
+
+    xntimerq_t slackqueue;      /*!< Aperiodic timers with slack, by date. */
+
+#ifdef CONFIG_XENO_OPT_STATS
+    u_long savedshots;          /*!< Timer shots saved by slack coalescing. */
+
+    xnticks_t swtsc;            /*!< TSC value at last context switch. */
+#endif /* CONFIG_XENO_OPT_STATS */
+
+#ifdef CONFIG_XENO_HW_PERIODIC_TIMER
+    xntwheel_t timerwheel;      /*!< Periodic timer wheel. */
+#endif /* CONFIG_XENO_HW_PERIODIC_TIMER */
 
     volatile unsigned inesting; /*!< Interrupt nesting level. */
 
@@ -207,6 +223,8 @@ struct xnpod {
     u_long ticks2sec;		/*!< Number of ticks per second (1e9
                                   if aperiodic). */
 
+    xnarch_scale_t tickscale;	/*!< 1/tickvalue ratio, for ns2ticks. */
+
     int refcnt;			/*!< Reference count.  */
 
     atomic_counter_t timerlck;	/*!< Timer lock depth.  */
@@ -263,6 +281,44 @@ void xnpod_renice_thread_inner(xnthread_t *thread,
 void xnpod_switch_fpu(xnsched_t *sched);
 #endif /* CONFIG_XENO_HW_FPU */
 
+#ifdef CONFIG_XENO_OPT_STATS
+static inline void xnpod_charge_exec_time (xnsched_t *sched,
+                                           xnthread_t *threadout)
+{
+    /* Charge the outgoing thread for the CPU time it consumed since
+       it was last switched in. */
+    xnticks_t now = xnarch_get_cpu_tsc();
+    threadout->stat.exec_time += now - sched->swtsc;
+    sched->swtsc = now;
+}
+#else /* !CONFIG_XENO_OPT_STATS */
+static inline void xnpod_charge_exec_time (xnsched_t *sched,
+                                           xnthread_t *threadout)
+{
+}
+#endif /* CONFIG_XENO_OPT_STATS */
+
+#ifdef CONFIG_XENO_OPT_BUDGET
+void xnpod_arm_budget(xnthread_t *thread);
+
+static inline void xnpod_switch_budget (xnthread_t *threadout,
+                                        xnthread_t *threadin)
+{
+    /* A thread only consumes its budget while running, so the
+       overrun timer is only armed for the current thread. */
+    if (threadout->bgt.quota)
+        xntimer_stop(&threadout->bgt.otimer);
+
+    if (threadin->bgt.quota && !threadin->bgt.exhausted)
+        xnpod_arm_budget(threadin);
+}
+#else /* !CONFIG_XENO_OPT_BUDGET */
+static inline void xnpod_switch_budget (xnthread_t *threadout,
+                                        xnthread_t *threadin)
+{
+}
+#endif /* CONFIG_XENO_OPT_BUDGET */
+
 #ifdef CONFIG_XENO_OPT_WATCHDOG
 static inline void xnpod_reset_watchdog (void)
 {
@@ -389,8 +445,15 @@ static inline xntime_t xnpod_ticks2ns (xnticks_t ticks) {
 }
 
 static inline xnticks_t xnpod_ns2ticks (xntime_t t) {
+    /* Convert a count of nanoseconds in ticks, rounding down */
 #ifdef CONFIG_XENO_HW_PERIODIC_TIMER
-    return xnarch_ulldiv(t,xnpod_get_tickval(),NULL);
+    xnticks_t ticks = xnarch_uscale(&nkpod->tickscale,t);
+
+    /* The scaled value may exceed the quotient by one unit. */
+    if (ticks * xnpod_get_tickval() > t)
+	ticks--;
+
+    return ticks;
 #else /* !CONFIG_XENO_HW_PERIODIC_TIMER */
     return t;
 #endif /* !CONFIG_XENO_HW_PERIODIC_TIMER */
@@ -492,8 +555,15 @@ int xnpod_set_thread_periodic(xnthread_t *thread,
 
 int xnpod_wait_thread_period(void);
 
+int xnpod_set_thread_budget(xnthread_t *thread,
+                            xnticks_t budget,
+                            xnticks_t period,
+                            int mode);
+
 xnticks_t xnpod_get_time(void);
 
+xnticks_t xnpod_get_exec_time(xnthread_t *thread);
+
 static inline xntime_t xnpod_get_cpu_time(void)
 {
     return xnarch_get_cpu_time();
@@ -298,7 +298,9 @@ static inline int insertpq (xnpqueue_t *pqslot,
                             xnpholder_t *head,
                             xnpholder_t *holder)
 {
-    /* Insert the <holder> element before <head> */
+    /* Insert the <holder> element before <head>, in the priority
+       group of <head>. */
+    holder->prio = head->prio;
     return insertq(&pqslot->pqueue,&head->plink,&holder->plink);
 }
 
@@ -380,7 +382,7 @@ static inline xnpholder_t *findpqh (xnpqueue_t *pqslot,
         }
     }
 
-    if (curr && ((xnpholder_t *)curr)->prio == prio)
+    if (curr != &pqslot->pqueue.head && ((xnpholder_t *)curr)->prio == prio)
         return (xnpholder_t *)curr;
 
     return NULL;
@@ -605,6 +607,14 @@ static inline unsigned int xnspqueue_prio2idx(xnspqueue_t *spqslot, int prio)
         return spqslot->maxpri - prio;
 }
 
+static inline int xnspqueue_idx2prio(xnspqueue_t *spqslot, unsigned int idx)
+{
+    if (spqslot->qdir == xnqueue_up)
+        return spqslot->maxpri + idx;
+    else
+        return spqslot->maxpri - idx;
+}
+
 static inline unsigned int xnspqueue_find_firstbit(xnspqueue_t *spqslot)
 {
     int i;
@@ -619,6 +629,30 @@ static inline unsigned int xnspqueue_find_firstbit(xnspqueue_t *spqslot)
     return 0; /* something already had gone wrong before this code was called */
 }
 
+static inline int xnspqueue_find_nextbit(xnspqueue_t *spqslot,
+                                         unsigned int idx)
+{
+    /* Find the first non-empty level strictly below <idx>, or -1. */
+    unsigned int i = ++idx / BITS_PER_LONG;
+    u_long word;
+
+    if (idx >= XNSPQUEUE_PRIOS)
+        return -1;
+
+    word = spqslot->bitmap[i] & ~((1UL << (idx % BITS_PER_LONG)) - 1);
+
+    for (;;)
+        {
+        if (word)
+            return ffnz(word) + i*BITS_PER_LONG;
+
+        if (++i >= XNSPQUEUE_BITMAPSIZE)
+            return -1;
+
+        word = spqslot->bitmap[i];
+        }
+}
+
 static inline void initspq(xnspqueue_t *spqslot, int qdir, int maxpri)
 {
     int i;
@@ -649,7 +683,7 @@ static inline void __xnspqueue_insert(xnspqueue_t *spqslot,
         appendq(queue, &holder->plink);
 
     spqslot->elems++;
-    __setbits(spqslot->bitmap[idx / BITS_PER_LONG],1 << (idx % BITS_PER_LONG));
+    __setbits(spqslot->bitmap[idx / BITS_PER_LONG],1UL << (idx % BITS_PER_LONG));
 }
 
 static inline void insertspql(xnspqueue_t *spqslot,
@@ -668,18 +702,33 @@ static inline void insertspqf(xnspqueue_t *spqslot,
     holder->prio = prio;
 }
 
+static inline void insertspq(xnspqueue_t *spqslot,
+                             xnpholder_t *head,
+                             xnpholder_t *holder)
+{
+    /* Insert the <holder> element before <head>, in the priority
+       level of <head>. */
+    insertq(&spqslot->queue[xnspqueue_prio2idx(spqslot,head->prio)],
+            &head->plink,&holder->plink);
+    holder->prio = head->prio;
+    spqslot->elems++;
+}
+
 static inline void appendspq(xnspqueue_t *spqslot,
                             xnpholder_t *holder)
 {
-    __xnspqueue_insert(spqslot, holder, spqslot->maxpri, XNSPQUEUE_APPEND);
-    holder->prio = spqslot->maxpri;
+    /* Queue at the tail of the lowest priority level, so that
+       removespq() can find the element back from its priority. */
+    __xnspqueue_insert(spqslot, holder, XNSPQUEUE_PRIOS - 1, XNSPQUEUE_APPEND);
+    holder->prio = xnspqueue_idx2prio(spqslot,XNSPQUEUE_PRIOS - 1);
 }
 
 static inline void prependspq(xnspqueue_t *spqslot,
                              xnpholder_t *holder)
 {
+    /* Queue at the head of the highest priority level. */
     __xnspqueue_insert(spqslot, holder, 0, XNSPQUEUE_PREPEND);
-    holder->prio = 0;
+    holder->prio = spqslot->maxpri;
 }
 
 static inline void removespq(xnspqueue_t *spqslot,
@@ -693,7 +742,7 @@ static inline void removespq(xnspqueue_t *spqslot,
     removeq(queue, &holder->plink);
     
     if (!countq(queue))
-        __clrbits(spqslot->bitmap[idx / BITS_PER_LONG],1 << (idx % BITS_PER_LONG));
+        __clrbits(spqslot->bitmap[idx / BITS_PER_LONG],1UL << (idx % BITS_PER_LONG));
 }
 
 static inline xnpholder_t* findspqh(xnspqueue_t *spqslot,
@@ -715,6 +764,32 @@ static inline xnpholder_t* getheadspq(xnspqueue_t *spqslot)
     return (xnpholder_t *)getheadq(queue);
 }
 
+static inline xnpholder_t* nextspq(xnspqueue_t *spqslot,
+                                  xnpholder_t *holder)
+{
+    unsigned int idx = xnspqueue_prio2idx(spqslot,holder->prio);
+    xnholder_t *nholder = nextq(&spqslot->queue[idx],&holder->plink);
+    int nidx;
+
+    if (nholder)
+        return (xnpholder_t *)nholder;
+
+    nidx = xnspqueue_find_nextbit(spqslot,idx);
+
+    if (nidx < 0)
+        return NULL;
+
+    return (xnpholder_t *)getheadq(&spqslot->queue[nidx]);
+}
+
+static inline xnpholder_t* popspq(xnspqueue_t *spqslot,
+                                 xnpholder_t *holder)
+{
+    xnpholder_t *nholder = nextspq(spqslot,holder);
+    removespq(spqslot,holder);
+    return nholder;
+}
+
 static inline xnpholder_t* getspq(xnspqueue_t *spqslot)
 {
     unsigned int idx;
@@ -734,7 +809,7 @@ static inline xnpholder_t* getspq(xnspqueue_t *spqslot)
     spqslot->elems--;    
 
     if (!countq(queue))
-        __clrbits(spqslot->bitmap[idx / BITS_PER_LONG],1 << (idx % BITS_PER_LONG));
+        __clrbits(spqslot->bitmap[idx / BITS_PER_LONG],1UL << (idx % BITS_PER_LONG));
     
     return (xnpholder_t *)holder;
 }
@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2026 The Xenomai project <http://www.xenomai.org>.
+ *
+ * Xenomai is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ *
+ * Xenomai is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Xenomai; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _XENO_NUCLEUS_RBTREE_H
+#define _XENO_NUCLEUS_RBTREE_H
+
+#include <nucleus/types.h>
+
+/*
+ * Red-black tree of holders. Elements are ordered by increasing key;
+ * elements bearing the same key are ordered by decreasing priority,
+ * then by insertion order, so that the head of the tree is always
+ * the element a sorted FIFO list would have returned. Insertion and
+ * removal of any element run in O(log N) worst-case time, and the
+ * head is cached so that reading it is O(1). The links are embedded
+ * into the holders, so the tree never allocates memory and has no
+ * capacity limit.
+ */
+
+typedef struct xnrbholder {
+
+    struct xnrbholder *parent;
+    struct xnrbholder *left;
+    struct xnrbholder *right;
+    int red;
+    xnticks_t key;	/* Sort key. */
+    int prio;		/* Secondary key, highest first. */
+
+} xnrbholder_t;
+
+typedef struct xnrbtree {
+
+    xnrbholder_t *root;
+    xnrbholder_t *head;	/* Leftmost holder. */
+
+} xnrbtree_t;
+
+#define initrbh(h)        ((h)->parent = (h)->left = (h)->right = NULL)
+#define initrbtree(t)     ((t)->root = (t)->head = NULL)
+#define getheadrbtree(t)  ((t)->head)
+
+static inline int __rbholder_lt (xnrbholder_t *h1, xnrbholder_t *h2)
+
+{
+    if (h1->key != h2->key)
+	return h1->key < h2->key;
+
+    return h1->prio > h2->prio;
+}
+
+static inline void __rbtree_replace (xnrbtree_t *tree,
+				     xnrbholder_t *old,
+				     xnrbholder_t *new)
+{
+    xnrbholder_t *parent = old->parent;
+
+    if (!parent)
+	tree->root = new;
+    else if (parent->left == old)
+	parent->left = new;
+    else
+	parent->right = new;
+
+    if (new)
+	new->parent = parent;
+}
+
+static inline void __rbtree_rotate_left (xnrbtree_t *tree, xnrbholder_t *h)
+
+{
+    xnrbholder_t *r = h->right;
+
+    h->right = r->left;
+
+    if (r->left)
+	r->left->parent = h;
+
+    __rbtree_replace(tree,h,r);
+    r->left = h;
+    h->parent = r;
+}
+
+static inline void __rbtree_rotate_right (xnrbtree_t *tree, xnrbholder_t *h)
+
+{
+    xnrbholder_t *l = h->left;
+
+    h->left = l->right;
+
+    if (l->right)
+	l->right->parent = h;
+
+    __rbtree_replace(tree,h,l);
+    l->right = h;
+    h->parent = l;
+}
+
+static inline void insertrbtree (xnrbtree_t *tree, xnrbholder_t *h)
+
+{
+    xnrbholder_t *parent = NULL, **link = &tree->root, *p, *g, *u;
+    int leftmost = 1;
+
+    /* Equal elements go to the right, which keeps them in FIFO
+       order. */
+
+    while (*link)
+	{
+	parent = *link;
+
+	if (__rbholder_lt(h,parent))
+	    link = &parent->left;
+	else
+	    {
+	    link = &parent->right;
+	    leftmost = 0;
+	    }
+	}
+
+    h->parent = parent;
+    h->left = h->right = NULL;
+    h->red = 1;
+    *link = h;
+
+    if (leftmost)
+	tree->head = h;
+
+    while ((p = h->parent) != NULL && p->red)
+	{
+	g = p->parent;
+
+	if (p == g->left)
+	    {
+	    u = g->right;
+
+	    if (u && u->red)
+		{
+		p->red = u->red = 0;
+		g->red = 1;
+		h = g;
+		continue;
+		}
+
+	    if (h == p->right)
+		{
+		__rbtree_rotate_left(tree,p);
+		h = p;
+		p = h->parent;
+		}
+
+	    p->red = 0;
+	    g->red = 1;
+	    __rbtree_rotate_right(tree,g);
+	    }
+	else
+	    {
+	    u = g->left;
+
+	    if (u && u->red)
+		{
+		p->red = u->red = 0;
+		g->red = 1;
+		h = g;
+		continue;
+		}
+
+	    if (h == p->left)
+		{
+		__rbtree_rotate_right(tree,p);
+		h = p;
+		p = h->parent;
+		}
+
+	    p->red = 0;
+	    g->red = 1;
+	    __rbtree_rotate_left(tree,g);
+	    }
+	}
+
+    tree->root->red = 0;
+}
+
+static inline void __rbtree_remove_fixup (xnrbtree_t *tree,
+					  xnrbholder_t *h,
+					  xnrbholder_t *parent)
+{
+    xnrbholder_t *s;
+
+    /* h is one black level short; it may be NULL, hence the parent
+       being tracked separately. */
+
+    while (h != tree->root && (!h || !h->red))
+	{
+	if (h == parent->left)
+	    {
+	    s = parent->right;
+
+	    if (s->red)
+		{
+		s->red = 0;
+		parent->red = 1;
+		__rbtree_rotate_left(tree,parent);
+		s = parent->right;
+		}
+
+	    if ((!s->left || !s->left->red) && (!s->right || !s->right->red))
+		{
+		s->red = 1;
+		h = parent;
+		parent = h->parent;
+		continue;
+		}
+
+	    if (!s->right || !s->right->red)
+		{
+		s->left->red = 0;
+		s->red = 1;
+		__rbtree_rotate_right(tree,s);
+		s = parent->right;
+		}
+
+	    s->red = parent->red;
+	    parent->red = 0;
+	    s->right->red = 0;
+	    __rbtree_rotate_left(tree,parent);
+	    }
+	else
+	    {
+	    s = parent->left;
+
+	    if (s->red)
+		{
+		s->red = 0;
+		parent->red = 1;
+		__rbtree_rotate_right(tree,parent);
+		s = parent->left;
+		}
+
+	    if ((!s->left || !s->left->red) && (!s->right || !s->right->red))
+		{
+		s->red = 1;
+		h = parent;
+		parent = h->parent;
+		continue;
+		}
+
+	    if (!s->left || !s->left->red)
+		{
+		s->right->red = 0;
+		s->red = 1;
+		__rbtree_rotate_left(tree,s);
+		s = parent->left;
+		}
+
+	    s->red = parent->red;
+	    parent->red = 0;
+	    s->left->red = 0;
+	    __rbtree_rotate_right(tree,parent);
+	    }
+
+	h = tree->root;
+	break;
+	}
+
+    if (h)
+	h->red = 0;
+}
+
+static inline void removerbtree (xnrbtree_t *tree, xnrbholder_t *h)
+
+{
+    xnrbholder_t *child, *parent, *next;
+    int red;
+
+    if (tree->head == h)
+	{
+	/* The head has no left child: its successor is the leftmost
+	   holder of its right subtree, or else its parent. */
+	next = h->right;
+
+	if (next)
+	    while (next->left)
+		next = next->left;
+	else
+	    next = h->parent;
+
+	tree->head = next;
+	}
+
+    if (h->left && h->right)
+	{
+	/* Swap h with its successor, which has no left child, then
+	   unlink the latter from its former place. */
+	next = h->right;
+
+	while (next->left)
+	    next = next->left;
+
+	child = next->right;
+	red = next->red;
+
+	if (next->parent == h)
+	    parent = next;
+	else
+	    {
+	    parent = next->parent;
+	    parent->left = child;
+
+	    if (child)
+		child->parent = parent;
+
+	    next->right = h->right;
+	    h->right->parent = next;
+	    }
+
+	next->left = h->left;
+	h->left->parent = next;
+	next->red = h->red;
+	__rbtree_replace(tree,h,next);
+	}
+    else
+	{
+	child = h->left ? h->left : h->right;
+	parent = h->parent;
+	red = h->red;
+	__rbtree_replace(tree,h,child);
+	}
+
+    if (!red)
+	__rbtree_remove_fixup(tree,child,parent);
+
+    initrbh(h);
+}
+
+#endif /* !_XENO_NUCLEUS_RBTREE_H */
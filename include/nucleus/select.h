@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 The Xenomai project <http://www.xenomai.org>.
+ *
+ * Xenomai is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ *
+ * Xenomai is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Xenomai; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _XENO_NUCLEUS_SELECT_H
+#define _XENO_NUCLEUS_SELECT_H
+
+#include <nucleus/queue.h>
+#include <nucleus/types.h>
+
+/* Binding modes */
+#define XNSELECT_ALL  0x0	/* Ready when all bits of the mask are set */
+#define XNSELECT_ANY  0x1	/* Ready when any bit of the mask is set */
+
+#if defined(__KERNEL__) || defined(__XENO_UVM__) || defined(__XENO_SIM__)
+
+struct xnselector;
+struct xnthread;
+
+/* Readiness state of a waitable object. The object owning it updates
+   the state word each time its condition changes; the nucleus cannot
+   infer it from the xnsynch_t wait queue, which only tells whether
+   threads are pending, not whether a resource is available. */
+
+typedef struct xnselect {
+
+    xnqueue_t bindings;	/* Selectors watching this object */
+
+    u_long state;	/* Current readiness bits */
+
+} xnselect_t;
+
+/* One (object, selector) association. */
+
+typedef struct xnselect_binding {
+
+    xnholder_t link;	/* Link in the object's binding queue */
+
+#define link2binding(laddr) \
+((xnselect_binding_t *)(((char *)laddr) - (int)(&((xnselect_binding_t *)0)->link)))
+
+    xnholder_t slink;	/* Link in the selector's binding queue */
+
+#define slink2binding(laddr) \
+((xnselect_binding_t *)(((char *)laddr) - (int)(&((xnselect_binding_t *)0)->slink)))
+
+    xnselect_t *fd;	/* Watched object -- NULL once destroyed */
+
+    struct xnselector *selector; /* Owning selector */
+
+    u_long mask;	/* Readiness bits of interest */
+
+    int mode;		/* XNSELECT_ANY or XNSELECT_ALL */
+
+    int ready;		/* Non-zero while the condition holds */
+
+} xnselect_binding_t;
+
+/* A selector has a single waiter, which is directly suspended and
+   resumed, so it does not need a full-blown wait queue. */
+
+typedef struct xnselector {
+
+    struct xnthread *waiter; /* Thread sleeping on the selector, if any */
+
+    xnqueue_t bindings;	/* Watched objects */
+
+    int nready;		/* Number of ready bindings */
+
+} xnselector_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void xnselect_init(xnselect_t *fd,
+		   u_long state);
+
+int __xnselect_signal(xnselect_t *fd);
+
+/* Update the readiness state of an object, returning non-zero if a
+   selector was woken up and the caller must reschedule. Cheap
+   enough to be called on every state change of the object. */
+
+static inline int xnselect_signal (xnselect_t *fd, u_long state)
+{
+    if (fd->state == state)
+	return 0;
+
+    fd->state = state;
+
+    return countq(&fd->bindings) ? __xnselect_signal(fd) : 0;
+}
+
+int xnselect_destroy(xnselect_t *fd);
+
+void xnselector_init(xnselector_t *selector);
+
+int xnselect_bind(xnselector_t *selector,
+		  xnselect_binding_t *binding,
+		  xnselect_t *fd,
+		  u_long mask,
+		  int mode);
+
+int xnselector_wait(xnselector_t *selector,
+		    xnticks_t timeout);
+
+void xnselector_destroy(xnselector_t *selector);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KERNEL__ || __XENO_UVM__ || __XENO_SIM__ */
+
+#endif /* !_XENO_NUCLEUS_SELECT_H */
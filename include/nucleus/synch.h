@@ -27,10 +27,11 @@
 #define XNSYNCH_PRIO    0x1
 #define XNSYNCH_NOPIP   0x0
 #define XNSYNCH_PIP     0x2
+#define XNSYNCH_PCP     0x8
 
 #if defined(__KERNEL__) || defined(__XENO_UVM__) || defined(__XENO_SIM__)
 
-#define XNSYNCH_CLAIMED 0x4	/* Claimed by other thread(s) w/ PIP */
+#define XNSYNCH_CLAIMED 0x4	/* Claimed by other thread(s) w/ PIP, or owned w/ PCP */
 
 /* Spare flags usable by upper interfaces */
 #define XNSYNCH_SPARE0  0x01000000
@@ -51,6 +52,30 @@ struct xnthread;
 struct xnsynch;
 struct xnmutex;
 
+#ifdef CONFIG_XENO_OPT_SCALABLE_SYNCH
+typedef xnspqueue_t xnsynch_queue_t;
+#define synch_initpq    initspq
+#define synch_countpq   countspq
+#define synch_insertpqf insertspqf
+#define synch_appendpq  appendspq
+#define synch_removepq  removespq
+#define synch_getheadpq getheadspq
+#define synch_nextpq    nextspq
+#define synch_getpq     getspq
+#define synch_poppq     popspq
+#else /* ! CONFIG_XENO_OPT_SCALABLE_SYNCH */
+typedef xnpqueue_t xnsynch_queue_t;
+#define synch_initpq    initpq
+#define synch_countpq   countpq
+#define synch_insertpqf insertpqf
+#define synch_appendpq  appendpq
+#define synch_removepq  removepq
+#define synch_getheadpq getheadpq
+#define synch_nextpq    nextpq
+#define synch_getpq     getpq
+#define synch_poppq     poppq
+#endif /* !CONFIG_XENO_OPT_SCALABLE_SYNCH */
+
 typedef struct xnsynch {
 
     xnpholder_t link;	/* Link in claim queues */
@@ -60,10 +85,12 @@ typedef struct xnsynch {
 
     xnflags_t status;	/* Status word */
 
-    xnpqueue_t pendq;	/* Pending threads */
+    xnsynch_queue_t pendq; /* Pending threads */
 
     struct xnthread *owner; /* Thread which owns the resource */
 
+    int ceiling;	/* Priority ceiling (XNSYNCH_PCP only) */
+
     XNARCH_DECL_DISPLAY_CONTEXT();
 
 } xnsynch_t;
@@ -72,8 +99,9 @@ typedef struct xnsynch {
 #define xnsynch_set_flags(synch,flags)   setbits((synch)->status,flags)
 #define xnsynch_clear_flags(synch,flags) clrbits((synch)->status,flags)
 #define xnsynch_wait_queue(synch)        (&((synch)->pendq))
-#define xnsynch_nsleepers(synch)         countpq(&((synch)->pendq))
+#define xnsynch_nsleepers(synch)         synch_countpq(&((synch)->pendq))
 #define xnsynch_owner(synch)             ((synch)->owner)
+#define xnsynch_ceiling(synch)           ((synch)->ceiling)
 
 #ifdef __cplusplus
 extern "C" {
@@ -85,8 +113,17 @@ void xnsynch_init(xnsynch_t *synch,
 #define xnsynch_destroy(synch) \
 xnsynch_flush(synch,XNRMID)
 
+void xnsynch_set_ceiling(xnsynch_t *synch,
+			int prio);
+
+void xnsynch_set_pcp_owner(xnsynch_t *synch,
+			   struct xnthread *thread);
+
 static inline void xnsynch_set_owner (xnsynch_t *synch, struct xnthread *thread) {
-    synch->owner = thread;
+    if (testbits(synch->status,XNSYNCH_PCP))
+	xnsynch_set_pcp_owner(synch,thread);
+    else
+	synch->owner = thread;
 }
 
 void xnsynch_sleep_on(xnsynch_t *synch,
@@ -50,6 +50,8 @@
 #define XNFPU     0x00100000	/* Thread uses FPU */
 #define XNSHADOW  0x00200000	/* Shadow thread */
 #define XNROOT    0x00400000	/* Root thread (i.e. Linux/IDLE) */
+#define XNTHROT   0x00800000	/* Throttled upon budget overrun */
+#define XNEDF     0x01000000	/* Earliest deadline first within priority group */
 
 /*
   Must follow the declaration order of the above bits. Status symbols
@@ -67,17 +69,19 @@
   's' -> interrupt shield enabled.
   't' -> mode switches trapped.
   'f' -> FPU enabled (for kernel threads).
+  'o' -> throttled upon CPU budget overrun.
+  'e' -> undergoes EDF scheduling within its priority group.
 */
 #define XNTHREAD_SLABEL_INIT { \
   'S', 'W', 'D', 'R', 'U', \
   '.', '.', '.', 'X', '.', \
   '.', '.', '.', 'b', 'T', \
   'l', 'r', '.', 's', 't', \
-  'f', '.', '.' \
+  'f', '.', '.', 'o', 'e' \
 }
 
-#define XNTHREAD_BLOCK_BITS   (XNSUSP|XNPEND|XNDELAY|XNDORMANT|XNRELAX)
-#define XNTHREAD_MODE_BITS    (XNLOCK|XNRRB|XNASDI|XNSHIELD|XNTRAPSW)
+#define XNTHREAD_BLOCK_BITS   (XNSUSP|XNPEND|XNDELAY|XNDORMANT|XNRELAX|XNTHROT)
+#define XNTHREAD_MODE_BITS    (XNLOCK|XNRRB|XNASDI|XNSHIELD|XNTRAPSW|XNEDF)
 #define XNTHREAD_SYSTEM_BITS  (XNROOT)
 
 /* These flags are available to the real-time interfaces */
@@ -87,6 +91,10 @@
 #define XNTHREAD_SPARE3  0x80000000
 #define XNTHREAD_SPARES  0xf0000000
 
+/* CPU budget overrun actions. */
+#define XNBUDGET_THROTTLE 0	/* Suspend until the next replenishment */
+#define XNBUDGET_NOTIFY   1	/* Keep running, notify the overrun */
+
 #if defined(__KERNEL__) || defined(__XENO_UVM__) || defined(__XENO_SIM__)
 
 #ifdef __XENO_SIM__
@@ -131,12 +139,18 @@ typedef struct xnthread {
 
     struct xnsynch *wchan;	/* Resource the thread pends on */
 
+    struct xnselector *selector; /* Selector the thread waits on */
+
     xntimer_t rtimer;		/* Resource timer */
 
     xntimer_t ptimer;		/* Periodic timer */
 
     int poverrun;		/* Periodic timer overrun. */
 
+    xnticks_t pperiod;		/* Release period (ticks), XN_INFINITE if aperiodic */
+
+    xnticks_t deadline;		/* Absolute deadline of the current job (ticks) */
+
     xnsigmask_t signals;	/* Pending signals */
 
     xnticks_t rrperiod;		/* Allotted round-robin period (ticks) */
@@ -150,9 +164,22 @@ typedef struct xnthread {
 	unsigned long csw;	/* Context switches (includes
 				   secondary -> primary switches) */
 	unsigned long pf;	/* Number of page faults */
+	xnticks_t exec_time;	/* Accumulated execution time (tsc) */
     } stat;
 #endif /* CONFIG_XENO_OPT_STATS */
 
+#ifdef CONFIG_XENO_OPT_BUDGET
+    struct {
+	xnticks_t quota;	/* CPU budget per period (tsc), 0 if none */
+	xnticks_t base;		/* Execution time at period start (tsc) */
+	xntimer_t rtimer;	/* Replenishment timer */
+	xntimer_t otimer;	/* Overrun timer */
+	unsigned long overruns;	/* Number of budget overruns */
+	int exhausted;		/* Budget exhausted for the current period */
+	int mode;		/* Overrun action (XNBUDGET_*) */
+    } bgt;
+#endif /* CONFIG_XENO_OPT_BUDGET */
+
     xnasr_t asr;		/* Asynchronous service routine */
 
     xnflags_t asrmode;		/* Thread's mode for ASR */
@@ -215,6 +242,7 @@ typedef struct xnhook {
 #define xnthread_asr_level(thread)         ((thread)->asrlevel)
 #define xnthread_pending_signals(thread)   ((thread)->signals)
 #define xnthread_timeout(thread)           xntimer_get_timeout(&(thread)->rtimer)
+#define xnthread_deadline(thread)          ((thread)->deadline)
 #define xnthread_stack_size(thread)        xnarch_stack_size(xnthread_archtcb(thread))
 #define xnthread_extended_info(thread)     ((thread)->extinfo)
 #define xnthread_set_magic(thread,m)       do { (thread)->magic = (m); } while(0)
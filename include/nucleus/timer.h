@@ -25,16 +25,52 @@
 #if defined(__KERNEL__) || defined(__XENO_UVM__) || defined(__XENO_SIM__)
 
 #ifdef CONFIG_XENO_HW_PERIODIC_TIMER
-/* Number of outstanding timers (hint only) -- must be ^2 */
-#define XNTIMER_WHEELSIZE 64
-#define XNTIMER_WHEELMASK (XNTIMER_WHEELSIZE - 1)
-#else /* !CONFIG_XENO_HW_PERIODIC_TIMER */
-#define XNTIMER_WHEELSIZE 1
+
+/* The periodic timer wheel is made of a root level addressing the
+   next XNTIMER_WHEEL_ROOTSIZE jiffies, and XNTIMER_WHEEL_LEVELS outer
+   levels, each of them addressing XNTIMER_WHEEL_LEVELSIZE times the
+   range of the previous one. Timers are cascaded down to the next
+   inner level as time elapses. */
+#define XNTIMER_WHEEL_ROOTBITS   8
+#define XNTIMER_WHEEL_LEVELBITS  6
+#define XNTIMER_WHEEL_LEVELS     4
+#define XNTIMER_WHEEL_ROOTSIZE   (1 << XNTIMER_WHEEL_ROOTBITS)
+#define XNTIMER_WHEEL_ROOTMASK   (XNTIMER_WHEEL_ROOTSIZE - 1)
+#define XNTIMER_WHEEL_LEVELSIZE  (1 << XNTIMER_WHEEL_LEVELBITS)
+#define XNTIMER_WHEEL_LEVELMASK  (XNTIMER_WHEEL_LEVELSIZE - 1)
+#define XNTIMER_WHEELSIZE \
+(XNTIMER_WHEEL_ROOTSIZE + XNTIMER_WHEEL_LEVELS * XNTIMER_WHEEL_LEVELSIZE)
+
+/* Max. distance from the wheel base (in jiffies) which can be
+   addressed; timers firing later are parked in the last slot, then
+   requeued as time elapses. */
+#define XNTIMER_WHEEL_MAXDELTA \
+((1ULL << (XNTIMER_WHEEL_ROOTBITS + \
+	   XNTIMER_WHEEL_LEVELS * XNTIMER_WHEEL_LEVELBITS)) - 1)
+
+typedef struct xntwheel {
+
+    xnticks_t base;		/* !< Next jiffy to be processed. */
+
+    u_long count[XNTIMER_WHEEL_LEVELS + 1]; /* !< Timers per level. */
+
+    xnqueue_t slots[XNTIMER_WHEELSIZE];	/* !< Root, then outer levels. */
+
+} xntwheel_t;
+
+#define xntwheel_root(w,n)  (&(w)->slots[n])
+#define xntwheel_slot(w,l,n) \
+(&(w)->slots[XNTIMER_WHEEL_ROOTSIZE + ((l) - 1) * XNTIMER_WHEEL_LEVELSIZE + (n)])
+#define xntwheel_level(w,q) \
+((q) - (w)->slots < XNTIMER_WHEEL_ROOTSIZE ? 0 : \
+ 1 + ((q) - (w)->slots - XNTIMER_WHEEL_ROOTSIZE) / XNTIMER_WHEEL_LEVELSIZE)
+
 #endif /* CONFIG_XENO_HW_PERIODIC_TIMER */
 
 #define XNTIMER_ENABLED   0x00000001
 #define XNTIMER_DEQUEUED  0x00000002
 #define XNTIMER_KILLED    0x00000004
+#define XNTIMER_SLACKQ    0x00000008
 
 /* These flags are available to the real-time interfaces */
 #define XNTIMER_SPARE0  0x01000000
@@ -52,21 +88,117 @@
 
 #define XNTIMER_KEEPER_ID 0
 
+#ifdef CONFIG_XENO_OPT_TIMER_RBTREE
+
+#include <nucleus/rbtree.h>
+
+/* Aperiodic timers are kept into a red-black tree. */
+
+typedef xnrbholder_t xntimerh_t;
+
+typedef xnrbtree_t xntimerq_t;
+
+#define xntimerh_init(h)      initrbh(h)
+#define xntimerh_date(h)      ((h)->key)
+#define xntimerq_init(q)      initrbtree(q)
+#define xntimerq_head(q)      getheadrbtree(q)
+#define xntimerq_remove(q,h)  removerbtree(q,h)
+
+static inline void xntimerq_insert (xntimerq_t *q,
+				    xntimerh_t *h,
+				    xnticks_t date,
+				    int prio)
+{
+    h->key = date;
+    h->prio = prio;
+    insertrbtree(q,h);
+}
+
+#else /* !CONFIG_XENO_OPT_TIMER_RBTREE */
+
+/* Aperiodic timers are kept into a sorted list. */
+
+typedef struct xntimerh {
+
+    xnholder_t link;
+    xnticks_t date;
+    int prio;
+
+} xntimerh_t;
+
+typedef xnqueue_t xntimerq_t;
+
+#define link2timerh(laddr) \
+((xntimerh_t *)(((char *)laddr) - (int)(&((xntimerh_t *)0)->link)))
+
+#define xntimerh_init(h)      inith(&(h)->link)
+#define xntimerh_date(h)      ((h)->date)
+#define xntimerq_init(q)      initq(q)
+#define xntimerq_remove(q,h)  removeq(q,&(h)->link)
+
+static inline xntimerh_t *xntimerq_head (xntimerq_t *q)
+
+{
+    xnholder_t *holder = getheadq(q);
+    return holder ? link2timerh(holder) : NULL;
+}
+
+static inline void xntimerq_insert (xntimerq_t *q,
+				    xntimerh_t *h,
+				    xnticks_t date,
+				    int prio)
+{
+    xnholder_t *p;
+
+    h->date = date;
+    h->prio = prio;
+
+    /* Insert the new holder at the proper place, i.e. by increasing
+       date, then decreasing priority, FIFO otherwise. O(N) here, see
+       CONFIG_XENO_OPT_TIMER_RBTREE for a logarithmic alternative. */
+
+    for (p = q->head.last; p != &q->head; p = p->last)
+        if (date > link2timerh(p)->date ||
+            (date == link2timerh(p)->date &&
+             prio <= link2timerh(p)->prio))
+            break;
+
+    insertq(q,p->next,&h->link);
+}
+
+#endif /* CONFIG_XENO_OPT_TIMER_RBTREE */
+
 struct xnsched;
 
 typedef struct xntimer {
 
-    xnholder_t link;
+    xnholder_t link;		/* !< Link in the periodic timer wheel. */
 
 #define link2timer(laddr) \
 ((xntimer_t *)(((char *)laddr) - (int)(&((xntimer_t *)0)->link)))
 
+    xntimerh_t aplink;		/* !< Link in the aperiodic timer queue. */
+
+#define aplink2timer(haddr) \
+((xntimer_t *)(((char *)haddr) - (int)(&((xntimer_t *)0)->aplink)))
+
+    xntimerh_t sllink;		/* !< Link in the aperiodic slack queue. */
+
+#define sllink2timer(haddr) \
+((xntimer_t *)(((char *)haddr) - (int)(&((xntimer_t *)0)->sllink)))
+
+#ifdef CONFIG_XENO_HW_PERIODIC_TIMER
+    xnqueue_t *wheelq;		/* !< Wheel slot the timer is linked to. */
+#endif /* CONFIG_XENO_HW_PERIODIC_TIMER */
+
     xnflags_t status;		/* !< Timer status. */
 
     xnticks_t date;		/* !< Absolute timeout date (in ticks). */
 
     xnticks_t interval;		/* !< Periodic interval (in ticks, 0 == one shot). */
 
+    xnticks_t slack;		/* !< Tolerated lateness (in ticks). */
+
     int prio;			/* !< Internal priority. */
 
     struct xnsched *sched;      /* !< Sched structure to which the timer is
@@ -89,6 +221,7 @@ typedef struct xntimer {
 #define xntimer_interval(t)       ((t)->interval)
 #define xntimer_set_cookie(t,c)   ((t)->cookie = (c))
 #define xntimer_set_priority(t,p) ((t)->prio = (p))
+#define xntimer_slack(t)          ((t)->slack)
 
 static inline int xntimer_active_p (xntimer_t *timer) {
     return timer->sched != NULL;
@@ -158,12 +291,56 @@ static inline void xntimer_stop(xntimer_t *timer)
 	nktimer->do_timer_stop(timer);
 }
 
+/*!
+ * \fn void xntimer_set_slack(xntimer_t *timer,xnticks_t slack)
+ *
+ * \brief Set the timer slack.
+ *
+ * Define the amount of lateness a timer tolerates, so that the
+ * nucleus may elapse it along with other timers from a single
+ * hardware shot, instead of programming a distinct one. The timer
+ * will never be elapsed before its nominal timeout date, nor later
+ * than this date plus @a slack (modulo the usual latencies). The
+ * new slack applies to the next shots, i.e. once the timer has been
+ * (re)started or reloaded.
+ *
+ * @param timer The address of a valid timer descriptor.
+ *
+ * @param slack The tolerated lateness, expressed in clock ticks
+ * (see note). Zero, which is the default, disables coalescing for
+ * this timer.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ *
+ * @note Slack only applies to the oneshot mode, in which clock ticks
+ * are interpreted as nanoseconds. It is ignored in periodic mode,
+ * where timers are already elapsed on tick boundaries.
+ */
+
+static inline void xntimer_set_slack(xntimer_t *timer, xnticks_t slack)
+{
+    timer->slack = slack;
+}
+
 void xntimer_freeze(void);
 
 xnticks_t xntimer_get_date(xntimer_t *timer);
 
 xnticks_t xntimer_get_timeout(xntimer_t *timer);
 
+#ifdef CONFIG_XENO_HW_PERIODIC_TIMER
+void xntimer_init_wheel(xntwheel_t *wheel);
+#endif /* CONFIG_XENO_HW_PERIODIC_TIMER */
+
 void xntimer_set_periodic_mode(void);
 
 void xntimer_set_aperiodic_mode(void);
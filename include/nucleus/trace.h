@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2026 The Xenomai project <http://www.xenomai.org>.
+ *
+ * Xenomai is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ *
+ * Xenomai is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Xenomai; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _XENO_NUCLEUS_TRACE_H
+#define _XENO_NUCLEUS_TRACE_H
+
+/*
+ * Built-in event tracer. Each CPU owns a ring of fixed-size binary
+ * records, which only this CPU writes to with interrupts off, so
+ * that no lock is ever needed. Rings are overwritten in a circular
+ * manner (flight recorder mode), and exported read-only to
+ * user-space through the mmap() interface of XNTRACE_DEV_NAME. A
+ * reader validates every record it copies against the sequence
+ * number it expects, since the writer may recycle the slot
+ * underneath.
+ */
+
+#define XNTRACE_DEV_NAME  "/dev/rttrace"
+
+#define XNTRACE_MAGIC     0x58545243 /* "XTRC" */
+#define XNTRACE_VERSION   1
+
+#define XNTRACE_SEQ_BUSY  0xffffffff /* Record being written. */
+
+/* Event codes. */
+
+#define XNTRACE_EV_SWITCH   1	/* arg[0]=threadout, arg[1]=threadin */
+#define XNTRACE_EV_SUSPEND  2	/* arg[0]=thread, arg[1]=mask */
+#define XNTRACE_EV_RESUME   3	/* arg[0]=thread, arg[1]=mask */
+#define XNTRACE_EV_TIMER    4	/* arg[0]=timer, arg[1]=handler */
+#define XNTRACE_EV_IENTER   5	/* aux=irq */
+#define XNTRACE_EV_IEXIT    6	/* aux=irq */
+#define XNTRACE_EV_SYSENTRY 7	/* aux=muxid, arg[0]=thread, arg[1]=muxop */
+#define XNTRACE_EV_SYSEXIT  8	/* aux=muxid, arg[0]=thread, arg[1]=status */
+#define XNTRACE_EV_THREAD   9	/* arg[0]=thread, arg[1]=pid, arg[2..5]=name */
+#define XNTRACE_EV_MARK     10	/* aux=id, arg[0..1]=user-defined */
+
+typedef struct xntrace_rec {
+
+    unsigned long long stamp;	/* CPU timestamp (TSC). */
+    unsigned int seq;		/* Sequence number. */
+    unsigned short event;	/* Event code. */
+    unsigned short aux;		/* Event-specific short argument. */
+    unsigned long long arg[6];	/* Event-specific arguments. */
+
+} xntrace_rec_t;
+
+/* The ring header is the size of a record, and is immediately
+   followed by the record array. */
+
+typedef struct xntrace_ring {
+
+    unsigned int magic;
+    unsigned int version;
+    unsigned int cpu;
+    unsigned int nrecs;		/* Number of records in the array. */
+    unsigned long long cpufreq;	/* TSC frequency (Hz). */
+    volatile unsigned int head;	/* Sequence number of the next record. */
+    unsigned int reserved[9];
+
+} xntrace_ring_t;
+
+#define xntrace_ring_recs(ring)  ((xntrace_rec_t *)((ring) + 1))
+#define xntrace_ring_slot(ring,seq) \
+(xntrace_ring_recs(ring) + (seq) % (ring)->nrecs)
+
+struct xntrace_info {
+
+    unsigned int ncpus;		/* Number of per-CPU rings. */
+    unsigned int ringsz;	/* Size of a ring mapping (bytes). */
+};
+
+/* Ring #n is mapped at offset n * ringsz. */
+
+#define	XNTRACE_IOCTL_BASE     't'
+#define XNTRACEIOC_GET_INFO    _IOR(XNTRACE_IOCTL_BASE,0,struct xntrace_info)
+#define XNTRACEIOC_FREEZE      _IO(XNTRACE_IOCTL_BASE,1)
+#define XNTRACEIOC_THAW        _IO(XNTRACE_IOCTL_BASE,2)
+
+#if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_TRACE)
+
+#include <nucleus/types.h>
+
+#define XNTRACE_DEV_MINOR  253
+
+#define XNTRACE_RING_SIZE  (CONFIG_XENO_OPT_TRACE_BUFSZ * 1024)
+#define XNTRACE_NRECS      (XNTRACE_RING_SIZE / sizeof(xntrace_rec_t) - 1)
+
+struct xnthread;
+
+extern xntrace_ring_t *xntrace_rings[];
+
+extern int xntrace_enabled;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Must be called with interrupts off. */
+
+static inline xntrace_rec_t *__xntrace_begin (int event, int aux)
+
+{
+    xntrace_ring_t *ring = xntrace_rings[xnarch_current_cpu()];
+    unsigned seq = ring->head;
+    xntrace_rec_t *rec;
+
+    /* The first slot holds the ring header, so the record count is
+       not a power of two; being constant, the divisor still lets the
+       compiler turn the modulo into a multiplication. */
+    rec = xntrace_ring_recs(ring) + seq % XNTRACE_NRECS;
+    rec->seq = XNTRACE_SEQ_BUSY;
+    xnarch_memory_barrier();
+    rec->stamp = xnarch_get_cpu_tsc();
+    rec->event = event;
+    rec->aux = aux;
+
+    return rec;
+}
+
+static inline void __xntrace_end (xntrace_rec_t *rec)
+
+{
+    xntrace_ring_t *ring = xntrace_rings[xnarch_current_cpu()];
+    unsigned seq = ring->head;
+
+    xnarch_memory_barrier();
+    rec->seq = seq;
+    ring->head = seq + 1;
+}
+
+static inline void xntrace_log (int event,
+				int aux,
+				unsigned long long arg0,
+				unsigned long long arg1)
+{
+    xntrace_rec_t *rec;
+    spl_t s;
+
+    if (!xntrace_enabled)
+	return;
+
+    splhigh(s);
+    rec = __xntrace_begin(event,aux);
+    rec->arg[0] = arg0;
+    rec->arg[1] = arg1;
+    __xntrace_end(rec);
+    splexit(s);
+}
+
+static inline void xntrace_freeze (void)
+{
+    xntrace_enabled = 0;
+}
+
+static inline void xntrace_thaw (void)
+{
+    xntrace_enabled = 1;
+}
+
+void xntrace_log_thread(struct xnthread *thread,
+			int pid);
+
+int xntrace_mount(void);
+
+void xntrace_umount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define xntrace_switch(out,in) \
+xntrace_log(XNTRACE_EV_SWITCH,0,(unsigned long)(out),(unsigned long)(in))
+#define xntrace_suspend(thread,mask) \
+xntrace_log(XNTRACE_EV_SUSPEND,0,(unsigned long)(thread),(mask))
+#define xntrace_resume(thread,mask) \
+xntrace_log(XNTRACE_EV_RESUME,0,(unsigned long)(thread),(mask))
+#define xntrace_timer(timer) \
+xntrace_log(XNTRACE_EV_TIMER,0,(unsigned long)(timer),(unsigned long)(timer)->handler)
+#define xntrace_irq_enter(irq) \
+xntrace_log(XNTRACE_EV_IENTER,(irq),0,0)
+#define xntrace_irq_exit(irq) \
+xntrace_log(XNTRACE_EV_IEXIT,(irq),0,0)
+#define xntrace_sysentry(thread,muxid,muxop) \
+xntrace_log(XNTRACE_EV_SYSENTRY,(muxid),(unsigned long)(thread),(muxop))
+#define xntrace_sysexit(thread,muxid,status) \
+xntrace_log(XNTRACE_EV_SYSEXIT,(muxid),(unsigned long)(thread),(long)(status))
+#define xntrace_mark(id,arg0,arg1) \
+xntrace_log(XNTRACE_EV_MARK,(id),(arg0),(arg1))
+
+#else /* !(__KERNEL__ && CONFIG_XENO_OPT_TRACE) */
+
+#define xntrace_switch(out,in)               do { } while(0)
+#define xntrace_suspend(thread,mask)         do { } while(0)
+#define xntrace_resume(thread,mask)          do { } while(0)
+#define xntrace_timer(timer)                 do { } while(0)
+#define xntrace_irq_enter(irq)               do { } while(0)
+#define xntrace_irq_exit(irq)                do { } while(0)
+#define xntrace_sysentry(thread,muxid,muxop) do { } while(0)
+#define xntrace_sysexit(thread,muxid,status) do { } while(0)
+#define xntrace_mark(id,arg0,arg1)           do { } while(0)
+#define xntrace_log_thread(thread,pid)       do { } while(0)
+#define xntrace_freeze()                     do { } while(0)
+#define xntrace_thaw()                       do { } while(0)
+
+#endif /* __KERNEL__ && CONFIG_XENO_OPT_TRACE */
+
+#endif /* !_XENO_NUCLEUS_TRACE_H */
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2026 The Xenomai project <http://www.xenomai.org>.
+ *
+ * Xenomai is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ *
+ * Xenomai is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Xenomai; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _XENO_NUCLEUS_VDSO_H
+#define _XENO_NUCLEUS_VDSO_H
+
+/*
+ * Shared time page. The nucleus publishes the TSC calibration and
+ * the timing state of the pod into a block of a shared heap, which
+ * user-space libraries map read-only through XNHEAP_DEV_NAME, so
+ * that they can read the nucleus clocks without issuing any
+ * syscall. The page is only updated under nklock, the sequence count
+ * being odd while an update is in progress; readers retry until they
+ * get the same even count before and after copying the data.
+ */
+
+#include <nucleus/asm-generic/arith.h>
+
+#define XNVDSO_MAGIC     0x58564453 /* "XVDS" */
+
+/* Pod state flags. */
+#define XNVDSO_POD       0x1	/* A pod is up and running. */
+#define XNVDSO_PERIODIC  0x2	/* The timer runs in periodic mode. */
+
+typedef struct xnvdso {
+
+    unsigned int magic;
+    volatile unsigned int seq;	/* Update sequence count. */
+    unsigned long flags;	/* Pod state flags. */
+    unsigned long long cpufreq;	/* TSC frequency (Hz). */
+    xnarch_scale_t tsc2ns;	/* TSC to nanoseconds ratio. */
+    xnarch_scale_t ns2tsc;	/* Nanoseconds to TSC ratio. */
+    unsigned long tickval;	/* Tick duration (ns, 1 if aperiodic). */
+    long long wallclock_offset;	/* Pod time minus monotonic time. */
+
+} xnvdso_t;
+
+#ifdef __KERNEL__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern xnvdso_t *nkvdso;
+
+void xnshadow_update_vdso(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#else /* !__KERNEL__ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <nucleus/asm/atomic.h>
+#include <nucleus/asm/syscall.h>
+#include <nucleus/heap.h>
+
+/* Map the shared time page described by the information block
+   returned by the __xn_sys_bind syscall. NULL is returned if the
+   page is unavailable, in which case the caller should keep on
+   issuing syscalls. */
+
+static inline xnvdso_t *xnvdso_map (const xnsysinfo_t *info)
+
+{
+    xnvdso_t *vdso;
+    caddr_t mapbase;
+    int heapfd;
+
+    if (info->vdsoheap == NULL)
+	return NULL;
+
+    heapfd = open(XNHEAP_DEV_NAME,O_RDONLY);
+
+    if (heapfd < 0)
+	return NULL;
+
+    if (ioctl(heapfd,0,info->vdsoheap) != 0)
+	{
+	close(heapfd);
+	return NULL;
+	}
+
+    mapbase = (caddr_t)mmap(NULL,
+			    info->vdsosize,
+			    PROT_READ,
+			    MAP_SHARED,
+			    heapfd,
+			    0L);
+    close(heapfd);
+
+    if (mapbase == MAP_FAILED)
+	return NULL;
+
+    vdso = (xnvdso_t *)(mapbase + info->vdsooff);
+
+    if (vdso->magic != XNVDSO_MAGIC)
+	{
+	munmap(mapbase,info->vdsosize);
+	return NULL;
+	}
+
+    return vdso;
+}
+
+/* Get a consistent snapshot of the pod state; returns the state
+   flags, and the wallclock offset into *offsetp. */
+
+static inline unsigned long xnvdso_read_state (const xnvdso_t *vdso,
+					       long long *offsetp)
+{
+    unsigned long flags;
+    unsigned int seq;
+
+    do
+	{
+	seq = vdso->seq;
+	xnarch_memory_barrier();
+	flags = vdso->flags;
+	*offsetp = vdso->wallclock_offset;
+	xnarch_memory_barrier();
+	}
+    while ((seq & 1) != 0 || seq != vdso->seq);
+
+    return flags;
+}
+
+#endif /* __KERNEL__ */
+
+#endif /* !_XENO_NUCLEUS_VDSO_H */
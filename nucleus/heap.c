@@ -36,13 +36,21 @@
  * http://docs.FreeBSD.org/44doc/papers/kernmalloc.pdf.  A minor
  * variation allows this implementation to have 'extendable' heaps
  * when needed, with multiple memory extents providing autonomous page
- * address spaces.
+ * address spaces. Unlike the original design, multi-page blocks are
+ * carved from ranges of free pages kept on segregated lists indexed
+ * by the log2 value of their length, and merged back with their free
+ * neighbours upon release. Releasing runs in bounded time regardless
+ * of the heap fragmentation, and so does allocating as long as some
+ * free range is long enough to serve the request from the first
+ * entries of its list, or from a longer list (see find_run()).
  *
  * The data structures hierarchy is as follows:
  *
  * <tt> @verbatim
 HEAP {
      block_buckets[]
+     free_range_lists[]
+     extent_hash[]
      extent_queue -------+
 }                        |
                          V
@@ -71,34 +79,298 @@ HEAP {
 
 xnheap_t kheap;	/* System heap */
 
+#ifdef CONFIG_XENO_OPT_STATS
+
+DECLARE_XNQUEUE(xnheap_statq);	/* Heaps reported by /proc/xenomai/heap. */
+
+#define heap_stat_add(heap,counter,n)  ((heap)->counter += (n))
+
+/* Must be called with interrupts off. */
+#define heap_stat_free(heap)  ((heap)->stats[xnarch_current_cpu()].nfrees++)
+
+#else /* !CONFIG_XENO_OPT_STATS */
+
+#define heap_stat_add(heap,counter,n)  do { } while(0)
+#define heap_stat_free(heap)           do { } while(0)
+
+#endif /* CONFIG_XENO_OPT_STATS */
+
+/*
+ * Free page ranges are queued to the list of index log2(npages), so
+ * that any range from list #n is at least 2 ** n pages long. The
+ * following routines must be called with the heap lock held.
+ */
+
+static inline int run_class (u_long npages)
+
+{
+    int class = 0;
+
+    while (npages >>= 1)
+	class++;
+
+    return class;
+}
+
+static void insert_run (xnheap_t *heap,
+			caddr_t page,
+			u_long npages)
+{
+    xnheap_run_t *run = (xnheap_run_t *)page;
+    int class = run_class(npages);
+
+    run->npages = npages;
+
+    if (npages > 1)
+	*((u_long *)(page + ((npages - 1) << heap->pageshift))) = npages;
+
+    run->prev = NULL;
+    run->next = heap->runs[class];
+
+    if (run->next)
+	run->next->prev = run;
+
+    heap->runs[class] = run;
+    heap->runmap |= (1UL << class);
+
+    heap_stat_add(heap,nruns[class],1);
+    heap_stat_add(heap,freepages,npages);
+}
+
+static void remove_run (xnheap_t *heap,
+			xnheap_run_t *run)
+{
+    int class = run_class(run->npages);
+
+    if (run->prev)
+	run->prev->next = run->next;
+    else
+	heap->runs[class] = run->next;
+
+    if (run->next)
+	run->next->prev = run->prev;
+
+    if (heap->runs[class] == NULL)
+	heap->runmap &= ~(1UL << class);
+
+    heap_stat_add(heap,nruns[class],-1);
+    heap_stat_add(heap,freepages,-run->npages);
+}
+
+/*
+ * find_run() -- Pick a free range of at least 'npages' pages. Unless
+ * npages is a power of two, the list npages belongs to may hold
+ * ranges which are too short. The first XNHEAP_RUNSCAN entries of
+ * this list are checked, then the first non-empty list of longer
+ * ranges is used. This bounds the allocation time while avoiding to
+ * break longer ranges in most cases. Only when no longer range is
+ * left, the rest of the list is scanned, so that the allocation
+ * never fails while some free range could serve it: this unbounded
+ * walk is confined to a nearly exhausted heap.
+ */
+
+static xnheap_run_t *find_run (xnheap_t *heap,
+			       u_long npages)
+{
+    int class = run_class(npages), n = 0;
+    xnheap_run_t *run;
+    u_long map;
+
+    if (npages > (1UL << class))
+	{
+	for (run = heap->runs[class]; run; run = run->next)
+	    {
+	    if (run->npages >= npages)
+		return run;
+
+	    if (++n >= XNHEAP_RUNSCAN && (heap->runmap >> class) > 1)
+		break;
+	    }
+
+	class++;
+	}
+
+    map = heap->runmap & ~((1UL << class) - 1);
+
+    if (!map)
+	return NULL;
+
+    return heap->runs[ffnz(map)];
+}
+
+static inline u_long extent_hash (xnheap_t *heap,
+				  caddr_t addr)
+{
+    return ((u_long)addr >> heap->extshift) & (XNHEAP_EXTHASH - 1);
+}
+
+/*
+ * find_extent() -- Return the extent which contains 'addr'. Since the
+ * hashing granularity is not smaller than the extent size, an extent
+ * overlaps two hash slots at most, and is linked to both.
+ */
+
+static inline xnextent_t *find_extent (xnheap_t *heap,
+				       caddr_t addr)
+{
+    xnextlink_t *hlink;
+
+    for (hlink = heap->exthash[extent_hash(heap,addr)];
+	 hlink != NULL; hlink = hlink->next)
+	{
+	if (addr >= hlink->extent->membase &&
+	    addr < hlink->extent->memlim)
+	    return hlink->extent;
+	}
+
+    return NULL;
+}
+
+static void hash_link (xnheap_t *heap,
+		       xnextlink_t *hlink,
+		       xnextent_t *extent,
+		       u_long slot)
+{
+    hlink->extent = extent;
+    hlink->next = heap->exthash[slot];
+    /* Readers may walk the hash chains locklessly. */
+    xnarch_memory_barrier();
+    heap->exthash[slot] = hlink;
+}
+
 static void init_extent (xnheap_t *heap,
 			 xnextent_t *extent)
 {
-    caddr_t freepage;
-    int n, lastpgnum;
+    u_long n;
 
     inith(&extent->link);
 
     /* The page area starts right after the (aligned) header. */
     extent->membase = (caddr_t)extent + heap->hdrsize;
-    lastpgnum = heap->npages - 1;
+    extent->memlim = extent->membase + (heap->npages << heap->pageshift);
 
     /* Mark each page as free in the page map. */
-    for (n = 0, freepage = extent->membase;
-	 n < lastpgnum; n++, freepage += heap->pagesize)
-	{
-	*((caddr_t *)freepage) = freepage + heap->pagesize;
+    for (n = 0; n < heap->npages; n++)
 	extent->pagemap[n] = XNHEAP_PFREE;
+}
+
+/*
+ * attach_extent() -- Make an initialized extent available for
+ * allocation. The caller must have acquired the heap lock.
+ */
+
+static void attach_extent (xnheap_t *heap,
+			   xnextent_t *extent)
+{
+    u_long first, last;
+
+    appendq(&heap->extents,&extent->link);
+
+    first = extent_hash(heap,(caddr_t)extent);
+    last = extent_hash(heap,extent->memlim - 1);
+
+    hash_link(heap,&extent->hlinks[0],extent,first);
+
+    if (last != first)
+	hash_link(heap,&extent->hlinks[1],extent,last);
+
+    /* The whole page array starts as a single free range. */
+    insert_run(heap,extent->membase,heap->npages);
+}
+
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+
+#if XNHEAP_MAGSIZE < 2
+#error "CONFIG_XENO_OPT_HEAP_MAGSIZE must be at least 2"
+#endif
+
+static void init_magazines (xnheap_t *heap)
+
+{
+    xnheap_magazine_t *mag;
+    int cpu, n;
+
+    for (cpu = 0; cpu < XNARCH_NR_CPUS; cpu++)
+	{
+	mag = &heap->mags[cpu];
+	xnlock_init(&mag->lock);
+
+	for (n = 0; n < XNHEAP_NBUCKETS; n++)
+	    {
+	    mag->blocks[n] = NULL;
+	    mag->count[n] = 0;
+	    }
+
+	mag->stat.hits = 0;
+	mag->stat.misses = 0;
+	mag->stat.refills = 0;
+	mag->stat.flushes = 0;
+	mag->stat.cached = 0;
+	}
+}
+
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+
+#ifdef CONFIG_XENO_OPT_STATS
+
+static void register_heap (xnheap_t *heap)
+
+{
+    int n;
+    spl_t s;
+
+    heap->label[0] = '\0';
+    heap->freepages = 0;
+
+    for (n = 0; n < XNHEAP_NBUCKETS; n++)
+	{
+	heap->bpages[n] = 0;
+	heap->bused[n] = 0;
+	}
+
+    for (n = 0; n < XNHEAP_NCLASSES; n++)
+	heap->nruns[n] = 0;
+
+    for (n = 0; n < XNARCH_NR_CPUS; n++)
+	{
+	heap->stats[n].nallocs = 0;
+	heap->stats[n].nfrees = 0;
+	heap->stats[n].nfails = 0;
+	heap->stats[n].maxalloc = 0;
 	}
 
-    *((caddr_t *)freepage) = NULL;
-    extent->pagemap[lastpgnum] = XNHEAP_PFREE;
-    extent->memlim = freepage + heap->pagesize;
+    inith(&heap->statlink);
+
+    xnlock_get_irqsave(&nklock,s);
+    appendq(&xnheap_statq,&heap->statlink);
+    xnlock_put_irqrestore(&nklock,s);
+}
+
+static void unregister_heap (xnheap_t *heap)
+
+{
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    /* The heap may have been unregistered already. */
+
+    if (heap->statlink.next != &heap->statlink)
+	{
+	removeq(&xnheap_statq,&heap->statlink);
+	inith(&heap->statlink);
+	}
 
-    /* The first page starts the free list of a new extent. */
-    extent->freelist = extent->membase;
+    xnlock_put_irqrestore(&nklock,s);
 }
 
+#else /* !CONFIG_XENO_OPT_STATS */
+
+#define register_heap(heap)    do { } while(0)
+#define unregister_heap(heap)  do { } while(0)
+
+#endif /* CONFIG_XENO_OPT_STATS */
+
 /*! 
  * \fn xnheap_init(xnheap_t *heap,void *heapaddr,u_long heapsize,u_long pagesize)
  * \brief Initialize a memory heap.
@@ -130,7 +402,9 @@ static void init_extent (xnheap_t *heap,
  * fragmentation issues, so it might be a good idea to take a look at
  * http://docs.FreeBSD.org/44doc/papers/kernmalloc.pdf to pick the
  * best one for your needs. In the current implementation, pagesize
- * must be a power of two in the range [ 8 .. 32768 ] inclusive.
+ * must be a power of two in the range [ 8 .. 32768 ] inclusive, and
+ * large enough to hold a free range descriptor, i.e. three machine
+ * words (16 bytes on 32bit platforms, 32 bytes on 64bit ones).
  *
  * @return 0 is returned upon success, or one of the following error
  * codes:
@@ -153,7 +427,7 @@ int xnheap_init (xnheap_t *heap,
 		 u_long heapsize,
 		 u_long pagesize)
 {
-    u_long hdrsize, shiftsize, pageshift;
+    u_long hdrsize, shiftsize, pageshift, extshift;
     xnextent_t *extent;
     int n;
 
@@ -163,6 +437,7 @@ int xnheap_init (xnheap_t *heap,
      * PAGESIZE must be >= 2 ** MINLOG2.
      * PAGESIZE must be <= 2 ** MAXLOG2.
      * PAGESIZE must be a power of 2.
+     * PAGESIZE must be large enough to contain a free range descriptor.
      * HEAPSIZE must be large enough to contain the static part of an
      * extent header.
      * HEAPSIZE must be a multiple of PAGESIZE.
@@ -172,6 +447,7 @@ int xnheap_init (xnheap_t *heap,
     if ((pagesize < (1 << XNHEAP_MINLOG2)) ||
 	(pagesize > (1 << XNHEAP_MAXLOG2)) ||
 	(pagesize & (pagesize - 1)) != 0 ||
+	pagesize < sizeof(xnheap_run_t) ||
 	heapsize <= sizeof(xnextent_t) ||
 	heapsize > XNHEAP_MAXEXTSZ ||
 	(heapsize & (pagesize - 1)) != 0)
@@ -198,6 +474,11 @@ int xnheap_init (xnheap_t *heap,
 	 shiftsize > 1; shiftsize >>= 1, pageshift++)
 	; /* Loop */
 
+    /* Extents are hashed by address over slots of the smallest power
+       of two which is not lower than the extent size. */
+    for (extshift = pageshift; (1UL << extshift) < heapsize; extshift++)
+	; /* Loop */
+
     heap->pagesize = pagesize;
     heap->pageshift = pageshift;
     heap->extentsize = heapsize;
@@ -205,7 +486,10 @@ int xnheap_init (xnheap_t *heap,
     heap->npages = (heapsize - hdrsize) >> pageshift;
     heap->ubytes = 0;
     heap->maxcont = heap->npages * pagesize;
-    heap->idleq = NULL;
+    heap->extshift = extshift;
+    heap->runmap = 0;
+    heap->parent = NULL;
+    heap->rsvbytes = 0;
     inith(&heap->link);
     initq(&heap->extents);
     xnlock_init(&heap->lock);
@@ -215,11 +499,29 @@ int xnheap_init (xnheap_t *heap,
     for (n = 0; n < XNHEAP_NBUCKETS; n++)
 	heap->buckets[n] = NULL;
 
+    for (n = 0; n < XNARCH_NR_CPUS; n++)
+	{
+	xnlock_init(&heap->idleq[n].lock);
+	heap->idleq[n].head = NULL;
+	}
+
+    for (n = 0; n < XNHEAP_NCLASSES; n++)
+	heap->runs[n] = NULL;
+
+    for (n = 0; n < XNHEAP_EXTHASH; n++)
+	heap->exthash[n] = NULL;
+
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+    init_magazines(heap);
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+
+    register_heap(heap);
+
     extent = (xnextent_t *)heapaddr;
 
     init_extent(heap,extent);
 
-    appendq(&heap->extents,&extent->link);
+    attach_extent(heap,extent);
 
     xnarch_init_display_context(heap);
 
@@ -265,6 +567,8 @@ int xnheap_destroy (xnheap_t *heap,
     xnholder_t *holder;
     spl_t s;
 
+    unregister_heap(heap);
+
     if (!flushfn)
 	return 0;
 
@@ -284,65 +588,38 @@ int xnheap_destroy (xnheap_t *heap,
 
 /*
  * get_free_range() -- Obtain a range of contiguous free pages to
- * fulfill an allocation of 2 ** log2size.  The caller must have
- * acquired the heap lock.
+ * fulfill an allocation of 2 ** log2size, or of bsize bytes when
+ * log2size is zero.  The caller must have acquired the heap lock.
  */
 
 static caddr_t get_free_range (xnheap_t *heap,
 			       u_long bsize,
 			       int log2size)
 {
-    caddr_t block, eblock, freepage, lastpage, headpage, freehead = NULL;
-    u_long pagenum, pagecont, freecont;
-    xnholder_t *holder;
+    caddr_t block, eblock, headpage;
+    u_long pagenum, pagecont, npages;
     xnextent_t *extent;
+    xnheap_run_t *run;
 
-    holder = getheadq(&heap->extents);
-
-    while (holder != NULL)
-	{
-	extent = link2extent(holder);
-
-	freepage = extent->freelist;
-
-	while (freepage != NULL)
-	    {
-	    headpage = freepage;
-    	    freecont = 0;
-
-	    /* Search for a range of contiguous pages in the free page
-	       list of the current extent. The range must be 'bsize'
-	       long. */
-	    do
-		{
-		lastpage = freepage;
-		freepage = *((caddr_t *)freepage);
-		freecont += heap->pagesize;
-		}
-	    while (freepage == lastpage + heap->pagesize && freecont < bsize);
+    npages = bsize > heap->pagesize ? bsize >> heap->pageshift : 1;
 
-	    if (freecont >= bsize)
-		{
-		/* Ok, got it. Just update the extent's free page
-		   list, then proceed to the next step. */
+    run = find_run(heap,npages);
 
-		if (headpage == extent->freelist)
-		    extent->freelist = *((caddr_t *)lastpage);
-		else   
-		    *((caddr_t *)freehead) = *((caddr_t *)lastpage);
+    if (run == NULL)
+	return NULL;
 
-		goto splitpage;
-		}
+    remove_run(heap,run);
 
-	    freehead = lastpage;
-	    }
+    headpage = (caddr_t)run;
 
-	holder = nextq(&heap->extents,holder);
-	}
+    /* Give the unused tail of the range back to the free lists. */
 
-    return NULL;
+    if (run->npages > npages)
+	insert_run(heap,
+		   headpage + (npages << heap->pageshift),
+		   run->npages - npages);
 
-splitpage:
+    extent = find_extent(heap,headpage);
 
     /* At this point, headpage is valid and points to the first page
        of a range of contiguous free pages larger or equal than
@@ -376,150 +653,441 @@ splitpage:
 
     extent->pagemap[pagenum] = log2size ?: XNHEAP_PLIST;
 
+    if (log2size)
+	heap_stat_add(heap,bpages[log2size - XNHEAP_MINLOG2],1);
+
     for (pagecont = bsize >> heap->pageshift; pagecont > 1; pagecont--)
 	extent->pagemap[pagenum + pagecont - 1] = XNHEAP_PCONT;
 
     return headpage;
 }
 
-/*! 
- * \fn void *xnheap_alloc(xnheap_t *heap, u_long size)
- * \brief Allocate a memory block from a memory heap.
- *
- * Allocates a contiguous region of memory from an active memory heap.
- * Such allocation is guaranteed to be time-bounded.
- *
- * @param heap The descriptor address of the heap to get memory from.
- *
- * @param size The size in bytes of the requested block. Sizes lower
- * or equal to the page size are rounded either to the minimum
- * allocation size if lower than this value, or to the minimum
- * alignment size if greater or equal to this value. In the current
- * implementation, with MINALLOC = 8 and MINALIGN = 16, a 7 bytes
- * request will be rounded to 8 bytes, and a 17 bytes request will be
- * rounded to 32.
- *
- * @return The address of the allocated region upon success, or NULL
- * if no memory is available from the specified heap.
- *
- * Environments:
- *
- * This service can be called from:
- *
- * - Kernel module initialization/cleanup code
- * - Interrupt service routine
- * - Kernel-based task
- * - User-space task
- *
- * Rescheduling: never.
+/*
+ * get_bucket_block() -- Obtain a block of 2 ** log2size bytes from
+ * the bucketed memory space, splitting a new page if the bucket is
+ * empty. The caller must have acquired the heap lock.
  */
 
-void *xnheap_alloc (xnheap_t *heap, u_long size)
-
+static inline caddr_t get_bucket_block (xnheap_t *heap,
+					u_long bsize,
+					int log2size)
 {
-    caddr_t block;
-    u_long bsize;
-    int log2size;
-    spl_t s;
-
-    if (size == 0)
-	return NULL;
+    caddr_t block = heap->buckets[log2size - XNHEAP_MINLOG2];
 
-    if (size <= heap->pagesize)
-	/* Sizes lower or equal to the page size are rounded either to
-	   the minimum allocation size if lower than this value, or to
-	   the minimum alignment size if greater or equal to this
-	   value. In other words, with MINALLOC = 8 and MINALIGN = 16,
-	   a 7 bytes request will be rounded to 8 bytes, and a 17
-	   bytes request will be rounded to 32. */
+    if (block == NULL)
 	{
-	if (size <= XNHEAP_MINALIGNSZ)
-	    size = (size + XNHEAP_MINALLOCSZ - 1) & ~(XNHEAP_MINALLOCSZ - 1);
-	else
-	    size = (size + XNHEAP_MINALIGNSZ - 1) & ~(XNHEAP_MINALIGNSZ - 1);
+	block = get_free_range(heap,bsize,log2size);
+
+	if (block == NULL)
+	    return NULL;
 	}
-    else
-	/* Sizes greater than the page size are rounded to a multiple
-	   of the page size. */
-	size = (size + heap->pagesize - 1) & ~(heap->pagesize - 1);
 
-    /* It becomes more space efficient to directly allocate pages from
-       the free page list whenever the requested size is greater than
-       2 times the page size. Otherwise, use the bucketed memory
-       blocks. */
+    heap->buckets[log2size - XNHEAP_MINLOG2] = *((caddr_t *)block);
+    heap->ubytes += bsize;
+    heap_stat_add(heap,bused[log2size - XNHEAP_MINLOG2],1);
 
-    if (size <= heap->pagesize * 2)
-	{
-	/* Find the first power of two greater or equal to the rounded
-	   size. The log2 value of this size is also computed. */
+    return block;
+}
 
-	for (bsize = (1 << XNHEAP_MINLOG2), log2size = XNHEAP_MINLOG2;
-	     bsize < size; bsize <<= 1, log2size++)
-	    ; /* Loop */
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
 
-	xnlock_get_irqsave(&heap->lock,s);
+/*
+ * Blocks held by a magazine are still accounted as used memory by
+ * the heap. The magazine lock must be held by the caller, who is
+ * expected to have masked the interrupts.
+ */
 
-	block = heap->buckets[log2size - XNHEAP_MINLOG2];
+static void flush_magazine (xnheap_t *heap,
+			    xnheap_magazine_t *mag,
+			    int bucket,
+			    int count)
+{
+    u_long bsize = 1 << (bucket + XNHEAP_MINLOG2);
+    caddr_t head, tail;
+    int n;
+    spl_t s;
 
-	if (block == NULL)
-	    {
-	    block = get_free_range(heap,bsize,log2size);
+    head = mag->blocks[bucket];
 
-	    if (block == NULL)
-		goto release_and_exit;
-	    }
+    if (head == NULL)
+	return;
 
-	heap->buckets[log2size - XNHEAP_MINLOG2] = *((caddr_t *)block);
-	heap->ubytes += bsize;
-	}
-    else
-        {
-        if (size > heap->maxcont)
-            return NULL;
+    /* Detach the 'count' most recent blocks, then splice them to the
+       bucket in a single step, so that the heap lock is held as
+       shortly as possible. */
 
-	xnlock_get_irqsave(&heap->lock,s);
+    for (tail = head, n = 1; n < count && *((caddr_t *)tail) != NULL; n++)
+	tail = *((caddr_t *)tail);
 
-	/* Directly request a free page range. */
-	block = get_free_range(heap,size,0);
+    mag->blocks[bucket] = *((caddr_t *)tail);
+    mag->count[bucket] -= n;
+    mag->stat.cached -= n * bsize;
 
-	if (block)   
-	    heap->ubytes += size;
-	}
+    xnlock_get_irqsave(&heap->lock,s);
+    *((caddr_t *)tail) = heap->buckets[bucket];
+    heap->buckets[bucket] = head;
+    heap->ubytes -= n * bsize;
+    heap_stat_add(heap,bused[bucket],-n);
+    xnlock_put_irqrestore(&heap->lock,s);
+}
 
-release_and_exit:
+/*
+ * Return the blocks cached by all CPUs to the heap. This is only
+ * done when an allocation cannot be satisfied otherwise, since the
+ * memory we need might be idling in remote magazines. Must be called
+ * with interrupts off, without holding any magazine lock.
+ */
 
-    xnlock_put_irqrestore(&heap->lock,s);
+static void reclaim_magazines (xnheap_t *heap)
 
-    return block;
-}
+{
+    xnheap_magazine_t *mag;
+    int cpu, bucket;
+    spl_t s;
 
-/*! 
- * \fn int xnheap_test_and_free(xnheap_t *heap,void *block,int (*ckfn)(void *block))
- * \brief Test and release a memory block to a memory heap.
- *
- * Releases a memory region to the memory heap it was previously
- * allocated from. Before the actual release is performed, an optional
- * user-defined can be invoked to check for additional criteria with
- * respect to the request consistency.
+    for (cpu = 0; cpu < XNARCH_NR_CPUS; cpu++)
+	{
+	mag = &heap->mags[cpu];
+
+	xnlock_get_irqsave(&mag->lock,s);
+
+	for (bucket = 0; bucket < XNHEAP_NBUCKETS; bucket++)
+	    if (mag->count[bucket] > 0)
+		flush_magazine(heap,mag,bucket,mag->count[bucket]);
+
+	xnlock_put_irqrestore(&mag->lock,s);
+	}
+}
+
+static caddr_t mag_alloc (xnheap_t *heap,
+			  u_long bsize,
+			  int log2size)
+{
+    int bucket = log2size - XNHEAP_MINLOG2, n;
+    xnheap_magazine_t *mag;
+    caddr_t block, next;
+    spl_t s, ms, hs;
+
+    splhigh(s);
+
+    mag = &heap->mags[xnarch_current_cpu()];
+
+    xnlock_get_irqsave(&mag->lock,ms);
+
+    block = mag->blocks[bucket];
+
+    if (block != NULL)
+	{
+	mag->blocks[bucket] = *((caddr_t *)block);
+	mag->count[bucket]--;
+	mag->stat.cached -= bsize;
+	mag->stat.hits++;
+	goto unlock_and_exit;
+	}
+
+    mag->stat.misses++;
+
+    /* Refill the magazine by a batch of blocks which are already
+       available from the bucket, so that the cost of grabbing the
+       heap lock is amortized over the next allocations. */
+
+    xnlock_get_irqsave(&heap->lock,hs);
+
+    block = get_bucket_block(heap,bsize,log2size);
+
+    if (block != NULL)
+	{
+	for (n = 0; n < XNHEAP_MAGBATCH; n++)
+	    {
+	    next = heap->buckets[bucket];
+
+	    if (next == NULL)
+		break;
+
+	    heap->buckets[bucket] = *((caddr_t *)next);
+	    *((caddr_t *)next) = mag->blocks[bucket];
+	    mag->blocks[bucket] = next;
+	    }
+
+	if (n > 0)
+	    {
+	    heap->ubytes += n * bsize;
+	    heap_stat_add(heap,bused[bucket],n);
+	    mag->count[bucket] += n;
+	    mag->stat.cached += n * bsize;
+	    mag->stat.refills++;
+	    }
+	}
+
+    xnlock_put_irqrestore(&heap->lock,hs);
+
+    if (block == NULL)
+	{
+	xnlock_put_irqrestore(&mag->lock,ms);
+
+	reclaim_magazines(heap);
+
+	xnlock_get_irqsave(&heap->lock,hs);
+	block = get_bucket_block(heap,bsize,log2size);
+	xnlock_put_irqrestore(&heap->lock,hs);
+
+	splexit(s);
+
+	return block;
+	}
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&mag->lock,ms);
+
+    splexit(s);
+
+    return block;
+}
+
+/*
+ * Returns 1 if the block shall be processed by the regular release
+ * path, i.e. page ranges, blocks larger than a page and invalid
+ * addresses, or the status of the operation otherwise.
+ */
+
+static int mag_free (xnheap_t *heap,
+		     void *block,
+		     int (*ckfn)(void *block))
+{
+    xnheap_magazine_t *mag;
+    int log2size, bucket, err = 0;
+    xnextent_t *extent;
+    u_long bsize;
+    spl_t s, ms;
+
+    splhigh(s);
+
+    /* Extents are only ever added to a live heap, so we may look
+       them up without holding the heap lock. Likewise, the page map
+       slot of an allocated block does not change until it is
+       released. */
+
+    extent = find_extent(heap,(caddr_t)block);
+
+    if (!extent)
+	goto slow_path;
+
+    log2size = extent->pagemap[((caddr_t)block - extent->membase) >> heap->pageshift];
+
+    /* PFREE, PCONT and PLIST are all lower than XNHEAP_MINLOG2. */
+
+    if (log2size < XNHEAP_MINLOG2)
+	goto slow_path;
+
+    bsize = (1 << log2size);
+
+    if (bsize > heap->pagesize ||
+	(((caddr_t)block - extent->membase) & (bsize - 1)) != 0)
+	goto slow_path;
+
+    bucket = log2size - XNHEAP_MINLOG2;
+    mag = &heap->mags[xnarch_current_cpu()];
+
+    xnlock_get_irqsave(&mag->lock,ms);
+
+    if (ckfn && (err = ckfn(block)) != 0)
+	goto unlock_and_exit;
+
+    if (mag->count[bucket] >= XNHEAP_MAGSIZE)
+	{
+	flush_magazine(heap,mag,bucket,XNHEAP_MAGBATCH);
+	mag->stat.flushes++;
+	}
+
+    *((caddr_t *)block) = mag->blocks[bucket];
+    mag->blocks[bucket] = block;
+    mag->count[bucket]++;
+    mag->stat.cached += bsize;
+
+    heap_stat_free(heap);
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&mag->lock,ms);
+
+    splexit(s);
+
+    return err;
+
+ slow_path:
+
+    splexit(s);
+
+    return 1;
+}
+
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+
+static inline void *alloc_block (xnheap_t *heap, u_long size)
+
+{
+    caddr_t block;
+    u_long bsize;
+    int log2size;
+    spl_t s;
+
+    if (size == 0)
+	return NULL;
+
+    if (size <= heap->pagesize)
+	/* Sizes lower or equal to the page size are rounded either to
+	   the minimum allocation size if lower than this value, or to
+	   the minimum alignment size if greater or equal to this
+	   value. In other words, with MINALLOC = 8 and MINALIGN = 16,
+	   a 7 bytes request will be rounded to 8 bytes, and a 17
+	   bytes request will be rounded to 32. */
+	{
+	if (size <= XNHEAP_MINALIGNSZ)
+	    size = (size + XNHEAP_MINALLOCSZ - 1) & ~(XNHEAP_MINALLOCSZ - 1);
+	else
+	    size = (size + XNHEAP_MINALIGNSZ - 1) & ~(XNHEAP_MINALIGNSZ - 1);
+	}
+    else
+	/* Sizes greater than the page size are rounded to a multiple
+	   of the page size. */
+	size = (size + heap->pagesize - 1) & ~(heap->pagesize - 1);
+
+    /* It becomes more space efficient to directly allocate pages from
+       the free page list whenever the requested size is greater than
+       2 times the page size. Otherwise, use the bucketed memory
+       blocks. */
+
+    if (size <= heap->pagesize * 2)
+	{
+	/* Find the first power of two greater or equal to the rounded
+	   size. The log2 value of this size is also computed. */
+
+	for (bsize = (1 << XNHEAP_MINLOG2), log2size = XNHEAP_MINLOG2;
+	     bsize < size; bsize <<= 1, log2size++)
+	    ; /* Loop */
+
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+	if (bsize <= heap->pagesize)
+	    return mag_alloc(heap,bsize,log2size);
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+
+	xnlock_get_irqsave(&heap->lock,s);
+
+	block = get_bucket_block(heap,bsize,log2size);
+	}
+    else
+        {
+        if (size > heap->maxcont)
+            return NULL;
+
+	xnlock_get_irqsave(&heap->lock,s);
+
+	/* Directly request a free page range. */
+	block = get_free_range(heap,size,0);
+
+	if (block)   
+	    heap->ubytes += size;
+	}
+
+    xnlock_put_irqrestore(&heap->lock,s);
+
+    return block;
+}
+
+static int free_block(xnheap_t *heap, void *block, int (*ckfn)(void *block));
+
+/*
+ * Return all the blocks pending release on the local CPU to the
+ * heap. Unlike xnheap_finalize_free_inner(), the whole list is
+ * drained, since we are about to fail an allocation otherwise.
+ * Returns the number of released blocks.
+ */
+
+static int drain_idleq (xnheap_t *heap)
+
+{
+    xnholder_t *holder, *batch;
+    xnheap_idleq_t *idleq;
+    int n = 0;
+    spl_t s, ls;
+
+    splhigh(s);
+
+    /* A thread which deletes itself schedules the release of its
+       own control block, which it keeps running on until it
+       switches out; do not pull the rug from under its feet if it
+       allocates memory from a deletion hook meanwhile. */
+
+    if (nkpod && testbits(xnpod_current_thread()->status,XNZOMBIE))
+	goto out;
+
+    idleq = &heap->idleq[xnarch_current_cpu()];
+
+    if (idleq->head == NULL)
+	goto out;
+
+    xnlock_get_irqsave(&idleq->lock,ls);
+    batch = idleq->head;
+    idleq->head = NULL;
+    xnlock_put_irqrestore(&idleq->lock,ls);
+
+    xnlock_get_irqsave(&heap->lock,ls);
+
+    while (batch != NULL)
+	{
+	holder = batch->next;
+	free_block(heap,batch->last,NULL);
+	batch = holder;
+	n++;
+	}
+
+    xnlock_put_irqrestore(&heap->lock,ls);
+
+ out:
+
+    splexit(s);
+
+    return n;
+}
+
+static void *__xnheap_alloc (xnheap_t *heap, u_long size)
+
+{
+    void *block = alloc_block(heap,size);
+
+    /* Some blocks pending release may be enough to satisfy the
+       request: return those of the local CPU to the heap, then
+       retry before giving up. */
+
+    if (block == NULL && drain_idleq(heap) > 0)
+	block = alloc_block(heap,size);
+
+    return block;
+}
+
+/*! 
+ * \fn void *xnheap_alloc(xnheap_t *heap, u_long size)
+ * \brief Allocate a memory block from a memory heap.
  *
- * @param heap The descriptor address of the heap to release memory
- * to.
+ * Allocates a contiguous region of memory from an active memory heap.
+ * Such allocation is guaranteed to be time-bounded.
  *
- * @param block The address of the region to be returned to the heap.
+ * @param heap The descriptor address of the heap to get memory from.
  *
- * @param ckfn The address of a user-supplied verification routine
- * which is to be called after the memory address specified by @a
- * block has been checked for validity. The routine is expected to
- * proceed to further consistency checks, and either return zero upon
- * success, or non-zero upon error. In the latter case, the release
- * process is aborted, and @a ckfn's return value is passed back to
- * the caller of this service as its error return code. @a ckfn must
- * not trigger the rescheduling procedure either directly or
- * indirectly.
+ * @param size The size in bytes of the requested block. Sizes lower
+ * or equal to the page size are rounded either to the minimum
+ * allocation size if lower than this value, or to the minimum
+ * alignment size if greater or equal to this value. In the current
+ * implementation, with MINALLOC = 8 and MINALIGN = 16, a 7 bytes
+ * request will be rounded to 8 bytes, and a 17 bytes request will be
+ * rounded to 32.
  *
- * @return 0 is returned upon success, or -EINVAL is returned whenever
- * the block is not a valid region of the specified heap. Additional
- * return codes can also be defined locally by the @a ckfn routine.
+ * @return The address of the allocated region upon success, or NULL
+ * if no memory is available from the specified heap. Before failing,
+ * the blocks scheduled for release from the current CPU by
+ * xnheap_schedule_free() are returned to the heap, and the
+ * allocation is attempted again.
  *
  * Environments:
  *
@@ -533,33 +1101,65 @@ release_and_exit:
  * Rescheduling: never.
  */
 
-int xnheap_test_and_free (xnheap_t *heap, void *block, int (*ckfn)(void *block))
+void *xnheap_alloc (xnheap_t *heap, u_long size)
 
 {
-    caddr_t freepage, lastpage, nextpage, tailpage;
-    u_long pagenum, pagecont, boffset, bsize;
-    xnextent_t *extent = NULL;
-    int log2size, npages, err;
-    xnholder_t *holder;
+#ifdef CONFIG_XENO_OPT_STATS
+    xnticks_t start, elapsed;
+    xnheap_stat_t *stat;
+    void *block;
+    int cpu;
     spl_t s;
 
-    xnlock_get_irqsave(&heap->lock,s);
+    cpu = xnarch_current_cpu();
+    start = xnarch_get_cpu_tsc();
+    block = __xnheap_alloc(heap,size);
+    elapsed = xnarch_get_cpu_tsc() - start;
+
+    /* The allocation itself runs with the same interrupt state as
+       without statistics, so the measured time includes any
+       preemption by interrupts, as callers see it. The counters are
+       per-CPU, so keeping interrupts off while updating them is
+       enough. The time is only recorded if the caller did not
+       migrate meanwhile, since TSCs may differ between CPUs. */
+
+    splhigh(s);
+
+    stat = &heap->stats[xnarch_current_cpu()];
+
+    if (block)
+	stat->nallocs++;
+    else
+	stat->nfails++;
+
+    if (cpu == xnarch_current_cpu() && elapsed > stat->maxalloc)
+	stat->maxalloc = elapsed;
+
+    splexit(s);
+
+    return block;
+#else /* !CONFIG_XENO_OPT_STATS */
+    return __xnheap_alloc(heap,size);
+#endif /* CONFIG_XENO_OPT_STATS */
+}
+
+/* Must be called with the heap lock held. */
+
+static int free_block (xnheap_t *heap, void *block, int (*ckfn)(void *block))
+
+{
+    u_long pagenum, pagecont, boffset, bsize, npages, prevpages;
+    caddr_t freepage, nextpage;
+    xnextent_t *extent;
+    int log2size, err;
 
     /* Find the extent from which the returned block is
        originating. */
 
-    for (holder = getheadq(&heap->extents);
-	 holder != NULL; holder = nextq(&heap->extents,holder))
-	{
-	extent = link2extent(holder);
-
-	if ((caddr_t)block >= extent->membase &&
-	    (caddr_t)block < extent->memlim)
-	    break;
-	}
+    extent = find_extent(heap,(caddr_t)block);
 
-    if (!holder)
-	goto bad_block;
+    if (!extent)
+	return -EINVAL;
 
     /* Compute the heading page number in the page map. */
     pagenum = ((caddr_t)block - extent->membase) >> heap->pageshift;
@@ -570,131 +1170,959 @@ int xnheap_test_and_free (xnheap_t *heap, void *block, int (*ckfn)(void *block))
 	case XNHEAP_PFREE: /* Unallocated page? */
 	case XNHEAP_PCONT:  /* Not a range heading page? */
 
-bad_block:
-	    err = -EINVAL;
-
-unlock_and_fail:
-
-	    xnlock_put_irqrestore(&heap->lock,s);
-	    return err;
+	    return -EINVAL;
 
 	case XNHEAP_PLIST:
 
 	    if (ckfn && (err = ckfn(block)) != 0)
-		goto unlock_and_fail;
+		return err;
 
 	    npages = 1;
 
-	    while (npages < heap->npages &&
+	    while (pagenum + npages < heap->npages &&
 		   extent->pagemap[pagenum + npages] == XNHEAP_PCONT)
 		npages++;
 
 	    bsize = npages * heap->pagesize;
 
-	    /* Link all freed pages in a single sub-list. */
+	    /* Mark the released pages as free in the extent's page map. */
+
+	    for (pagecont = 0; pagecont < npages; pagecont++)
+		extent->pagemap[pagenum + pagecont] = XNHEAP_PFREE;
+
+	    /* Merge the released pages with the adjacent free ranges,
+	       if any. A free page which follows the block starts a
+	       range, a free page which precedes it ends one. */
+
+	    freepage = (caddr_t)block;
+
+	    if (pagenum + npages < heap->npages &&
+		extent->pagemap[pagenum + npages] == XNHEAP_PFREE)
+		{
+		nextpage = freepage + (npages << heap->pageshift);
+		npages += ((xnheap_run_t *)nextpage)->npages;
+		remove_run(heap,(xnheap_run_t *)nextpage);
+		}
+
+	    if (pagenum > 0 && extent->pagemap[pagenum - 1] == XNHEAP_PFREE)
+		{
+		prevpages = *((u_long *)(freepage - heap->pagesize));
+		freepage -= prevpages << heap->pageshift;
+		npages += prevpages;
+		remove_run(heap,(xnheap_run_t *)freepage);
+		}
+
+	    insert_run(heap,freepage,npages);
+
+	    break;
+
+	default:
 
-	    for (freepage = (caddr_t)block,
-		     tailpage = (caddr_t)block + bsize - heap->pagesize;
-		 freepage < tailpage; freepage += heap->pagesize)
-		*((caddr_t *)freepage) = freepage + heap->pagesize;
+	    log2size = extent->pagemap[pagenum];
+	    bsize = (1 << log2size);
+
+	    if ((boffset & (bsize - 1)) != 0) /* Not a block start? */
+		return -EINVAL;
+
+	    if (ckfn && (err = ckfn(block)) != 0)
+		return err;
+
+	    /* Return the block to the bucketed memory space. */
+
+	    *((caddr_t *)block) = heap->buckets[log2size - XNHEAP_MINLOG2];
+	    heap->buckets[log2size - XNHEAP_MINLOG2] = block;
+	    heap_stat_add(heap,bused[log2size - XNHEAP_MINLOG2],-1);
+
+	    break;
+	}
+
+    heap->ubytes -= bsize;
+
+    heap_stat_free(heap);
+
+    return 0;
+}
+
+/*! 
+ * \fn int xnheap_test_and_free(xnheap_t *heap,void *block,int (*ckfn)(void *block))
+ * \brief Test and release a memory block to a memory heap.
+ *
+ * Releases a memory region to the memory heap it was previously
+ * allocated from. Before the actual release is performed, an optional
+ * user-defined can be invoked to check for additional criteria with
+ * respect to the request consistency.
+ *
+ * @param heap The descriptor address of the heap to release memory
+ * to.
+ *
+ * @param block The address of the region to be returned to the heap.
+ *
+ * @param ckfn The address of a user-supplied verification routine
+ * which is to be called after the memory address specified by @a
+ * block has been checked for validity. The routine is expected to
+ * proceed to further consistency checks, and either return zero upon
+ * success, or non-zero upon error. In the latter case, the release
+ * process is aborted, and @a ckfn's return value is passed back to
+ * the caller of this service as its error return code. @a ckfn must
+ * not trigger the rescheduling procedure either directly or
+ * indirectly.
+ *
+ * @return 0 is returned upon success, or -EINVAL is returned whenever
+ * the block is not a valid region of the specified heap. Additional
+ * return codes can also be defined locally by the @a ckfn routine.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+int xnheap_test_and_free (xnheap_t *heap, void *block, int (*ckfn)(void *block))
+
+{
+    int err;
+    spl_t s;
+
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+    err = mag_free(heap,block,ckfn);
+
+    if (err <= 0)
+	return err;
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+
+    xnlock_get_irqsave(&heap->lock,s);
+    err = free_block(heap,block,ckfn);
+    xnlock_put_irqrestore(&heap->lock,s);
+
+    return err;
+}
+
+/*! 
+ * \fn int xnheap_free(xnheap_t *heap, void *block)
+ * \brief Release a memory block to a memory heap.
+ *
+ * Releases a memory region to the memory heap it was previously
+ * allocated from.
+ *
+ * @param heap The descriptor address of the heap to release memory
+ * to.
+ *
+ * @param block The address of the region to be returned to the heap.
+ *
+ * @return 0 is returned upon success, or -EINVAL is returned whenever
+ * the block is not a valid region of the specified heap.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+int xnheap_free (xnheap_t *heap, void *block)
+
+{
+    return xnheap_test_and_free(heap,block,NULL);
+}
+
+/*! 
+ * \fn int xnheap_extend(xnheap_t *heap, void *extaddr, u_long extsize)
+ * \brief Extend a memory heap.
+ *
+ * Add a new extent to an existing memory heap.
+ *
+ * @param heap The descriptor address of the heap to add an extent to.
+ *
+ * @param extaddr The address of the extent memory.
+ *
+ * @param extsize The size of the extent memory (in bytes). In the
+ * current implementation, this size must match the one of the initial
+ * extent passed to xnheap_init().
+ *
+ * @return 0 is returned upon success, or -EINVAL is returned if
+ * @a extsize differs from the initial extent's size.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+int xnheap_extend (xnheap_t *heap, void *extaddr, u_long extsize)
+
+{
+    xnextent_t *extent = (xnextent_t *)extaddr;
+    spl_t s;
+
+    if (extsize != heap->extentsize)
+	return -EINVAL;
+
+    init_extent(heap,extent);
+
+    xnlock_get_irqsave(&heap->lock,s);
+
+    attach_extent(heap,extent);
+
+    xnlock_put_irqrestore(&heap->lock,s);
+
+    return 0;
+}
+
+/*! 
+ * \fn int xnheap_check_block(xnheap_t *heap, void *block)
+ * \brief Tell whether a block belongs to a heap.
+ *
+ * @param heap The descriptor address of the heap to check.
+ *
+ * @param block The address of some memory.
+ *
+ * @return Non-zero is returned if @a block lies within one of the
+ * extents of @a heap, zero otherwise. The block is not required to
+ * be allocated.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+int xnheap_check_block (xnheap_t *heap, void *block)
+
+{
+    int ret;
+    spl_t s;
+
+    xnlock_get_irqsave(&heap->lock,s);
+    ret = find_extent(heap,(caddr_t)block) != NULL;
+    xnlock_put_irqrestore(&heap->lock,s);
+
+    return ret;
+}
+
+/*! 
+ * \fn int xnheap_init_reserve(xnheap_t *heap, xnheap_t *rsv, u_long size)
+ * \brief Carve a memory reserve out of a heap.
+ *
+ * Takes a single range of pages from a heap and manages it as a
+ * private heap, so that @a size bytes remain available to the owner
+ * of the reserve whatever the other users of the parent heap
+ * allocate. Blocks are obtained from and returned to the reserve
+ * using the regular services, e.g. xnheap_alloc(rsv,size). Since the
+ * reserve lives in the parent's memory, it is mapped along with a
+ * shared parent heap, and the owner may find out which heap a block
+ * came from by calling xnheap_check_block() on the reserve.
+ *
+ * The memory lent to reserves is reported in the usage data of the
+ * parent heap, and each reserve shows up in /proc/xenomai/heap on
+ * its own once labeled by xnheap_set_label().
+ *
+ * @param heap The descriptor address of the parent heap.
+ *
+ * @param rsv The address of a heap descriptor for the reserve.
+ *
+ * @param size The amount of memory to reserve. It is rounded up to
+ * the page size of the parent heap, and to a minimum of three pages,
+ * after room is made for the internal header of the reserve.
+ *
+ * @return 0 is returned upon success, or -ENOMEM if the parent heap
+ * has no free page range large enough for the reserve.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+int xnheap_init_reserve (xnheap_t *heap, xnheap_t *rsv, u_long size)
+
+{
+    u_long pagesize = heap->pagesize, rsvsize;
+    void *rsvmem;
+    int err;
+    spl_t s;
+
+    /* Reserves are always served from the free page ranges, so that
+       they start on a page boundary of the parent heap. */
+
+    rsvsize = size + xnheap_overhead(size,pagesize);
+    rsvsize = (rsvsize + pagesize - 1) & ~(pagesize - 1);
+
+    if (rsvsize < pagesize * 3)
+	rsvsize = pagesize * 3;
+
+    rsvmem = xnheap_alloc(heap,rsvsize);
+
+    if (!rsvmem)
+	return -ENOMEM;
+
+    err = xnheap_init(rsv,rsvmem,rsvsize,pagesize);
+
+    if (err)
+	{
+	xnheap_free(heap,rsvmem);
+	return err;
+	}
+
+    xnlock_get_irqsave(&heap->lock,s);
+    rsv->parent = heap;
+    heap->rsvbytes += rsvsize;
+    xnlock_put_irqrestore(&heap->lock,s);
+
+    return 0;
+}
+
+static void __flush_reserve (xnheap_t *rsv,
+			     void *rsvmem,
+			     u_long rsvsize,
+			     void *cookie)
+{
+    xnheap_t *heap = (xnheap_t *)cookie;
+    spl_t s;
+
+    xnheap_free(heap,rsvmem);
+
+    xnlock_get_irqsave(&heap->lock,s);
+    heap->rsvbytes -= rsvsize;
+    xnlock_put_irqrestore(&heap->lock,s);
+}
+
+/*! 
+ * \fn int xnheap_destroy_reserve(xnheap_t *rsv)
+ * \brief Return a memory reserve to its parent heap.
+ *
+ * @param rsv The descriptor address of a reserve previously set up
+ * by xnheap_init_reserve().
+ *
+ * @return 0 is returned upon success, or -EBUSY if some blocks are
+ * still allocated from the reserve.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+int xnheap_destroy_reserve (xnheap_t *rsv)
+
+{
+    if (xnheap_used_mem(rsv) != 0)
+	return -EBUSY;
+
+    return xnheap_destroy(rsv,&__flush_reserve,rsv->parent);
+}
+
+/*! 
+ * \fn int xnheap_schedule_free(xnheap_t *heap, void *block, xnholder_t *link)
+ * \brief Schedule a memory block for release.
+ *
+ * This routine records a block for later release by
+ * xnheap_finalize_free(). This service is useful to lazily free
+ * blocks of heap memory when immediate release is not an option,
+ * e.g. when active references are still pending on the object for a
+ * short time after the call. xnheap_finalize_free() is expected to be
+ * eventually called by the client code at some point in the future
+ * when actually freeing the idle objects is deemed safe. Each call
+ * releases at most XNHEAP_FREEBATCH blocks, so that its duration is
+ * bounded; it must be called repeatedly to drain a longer backlog.
+ *
+ * The block is queued to an idle list private to the current CPU,
+ * so this service does not contend on the heap lock.
+ *
+ * @param heap The descriptor address of the heap to release memory
+ * to.
+ *
+ * @param block The address of the region to be returned to the heap.
+ *
+ * @param link The address of a link member, likely but not
+ * necessarily within the released object, which will be used by the
+ * heap manager to hold the block in the queue of idle objects.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+void xnheap_schedule_free (xnheap_t *heap, void *block, xnholder_t *link)
+
+{
+    xnheap_idleq_t *idleq;
+    spl_t s, ls;
+
+    /* Hack: we only need a one-way linked list for remembering the
+       idle objects through the 'next' field, so the 'last' field of
+       the link is used to point at the beginning of the freed
+       memory. */
+    link->last = (xnholder_t *)block;
+
+    /* A lock-free push would need a compare-and-swap primitive the
+       arch layer does not provide on all platforms, and would make
+       the bounded batch pop of xnheap_finalize_free_inner() subject
+       to ABA races. The per-CPU lock is only ever contended by the
+       latter picking blocks from a remote CPU, so holding it for a
+       couple of stores is cheap. */
+
+    splhigh(s);
+    idleq = &heap->idleq[xnarch_current_cpu()];
+    xnlock_get_irqsave(&idleq->lock,ls);
+    link->next = idleq->head;
+    idleq->head = link;
+    xnlock_put_irqrestore(&idleq->lock,ls);
+    splexit(s);
+}
+
+void xnheap_finalize_free_inner (xnheap_t *heap)
+
+{
+    xnholder_t *holder, *batch = NULL;
+    xnheap_idleq_t *idleq;
+    int cpu, n = 0;
+    spl_t s;
+
+    /* This is called with the nklock held and interrupts off on
+       every switch back to Linux, so only pick a bounded batch of
+       idle blocks from the per-CPU lists; the rest is left queued
+       for the next calls. */
+
+    for (cpu = 0; cpu < XNARCH_NR_CPUS && n < XNHEAP_FREEBATCH; cpu++)
+	{
+	idleq = &heap->idleq[cpu];
+
+	if (idleq->head == NULL)
+	    continue;
+
+	xnlock_get_irqsave(&idleq->lock,s);
+
+	while (n < XNHEAP_FREEBATCH && (holder = idleq->head) != NULL)
+	    {
+	    idleq->head = holder->next;
+	    holder->next = batch;
+	    batch = holder;
+	    n++;
+	    }
+
+	xnlock_put_irqrestore(&idleq->lock,s);
+	}
+
+    if (batch == NULL)
+	return;
+
+    xnlock_get_irqsave(&heap->lock,s);
+
+    while (batch != NULL)
+	{
+	holder = batch->next;
+	free_block(heap,batch->last,NULL);
+	batch = holder;
+	}
+
+    xnlock_put_irqrestore(&heap->lock,s);
+}
+
+#ifdef CONFIG_XENO_OPT_STATS
+
+/*! 
+ * \fn void xnheap_set_label(xnheap_t *heap, const char *label)
+ * \brief Name a heap in usage reports.
+ *
+ * Sets the symbolic name which identifies a heap in
+ * /proc/xenomai/heap. Heaps without a label are reported by
+ * address.
+ *
+ * @param heap The descriptor address of the heap.
+ *
+ * @param label The heap name, which is copied and possibly
+ * truncated to XNOBJECT_NAME_LEN - 1 characters.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+void xnheap_set_label (xnheap_t *heap, const char *label)
+
+{
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+    strncpy(heap->label,label,sizeof(heap->label) - 1);
+    heap->label[sizeof(heap->label) - 1] = '\0';
+    xnlock_put_irqrestore(&nklock,s);
+}
+
+/*! 
+ * \fn void xnheap_get_info(xnheap_t *heap, xnheap_info_t *info)
+ * \brief Report the usage of a heap.
+ *
+ * Takes a snapshot of the occupation and fragmentation state of a
+ * heap, along with its allocation counters. The free blocks of a
+ * bucket are the carved blocks neither used nor cached, i.e.
+ * nblocks - used - cached; a large figure for a bucket which is
+ * seldom used denotes memory pinned by transient peaks, since bucket
+ * pages are never given back to the free ranges. The worst-case
+ * allocation time is measured with interrupts off.
+ *
+ * @param heap The descriptor address of the heap.
+ *
+ * @param info The address of a structure the report is copied to.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+void xnheap_get_info (xnheap_t *heap, xnheap_info_t *info)
+
+{
+    u_long bsize, perpage, npages;
+    xnheap_run_t *run;
+    int n, cpu, class;
+    spl_t s;
+
+    memset(info,0,sizeof(*info));
+
+    for (cpu = 0; cpu < XNARCH_NR_CPUS; cpu++)
+	{
+	info->nallocs += heap->stats[cpu].nallocs;
+	info->nfrees += heap->stats[cpu].nfrees;
+	info->nfails += heap->stats[cpu].nfails;
+
+	if (heap->stats[cpu].maxalloc > info->maxalloc)
+	    info->maxalloc = heap->stats[cpu].maxalloc;
+
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+	for (n = 0; n < XNHEAP_NBUCKETS; n++)
+	    info->buckets[n].cached += heap->mags[cpu].count[n];
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+	}
+
+    xnlock_get_irqsave(&heap->lock,s);
+
+    memcpy(info->label,heap->label,sizeof(info->label));
+    info->pagesize = heap->pagesize;
+    info->nextents = countq(&heap->extents);
+    info->size = info->nextents * heap->extentsize;
+    info->reserved = heap->rsvbytes;
+    info->maxcont = heap->maxcont;
+    info->freepages = heap->freepages;
+
+    for (class = 0; class < XNHEAP_NCLASSES; class++)
+	info->nruns += heap->nruns[class];
+
+    /* The longest free range belongs to the highest non-empty list,
+       whose length spans [ 2 ** class .. 2 ** (class + 1) - 1 ]
+       pages. */
+
+    for (class = XNHEAP_NCLASSES - 1; class >= 0; class--)
+	if (heap->runs[class])
+	    {
+	    for (npages = 0, run = heap->runs[class]; run; run = run->next)
+		if (run->npages > npages)
+		    npages = run->npages;
+
+	    info->maxfree = npages << heap->pageshift;
+	    break;
+	    }
+
+    for (n = 0; n < XNHEAP_NBUCKETS; n++)
+	{
+	bsize = 1 << (n + XNHEAP_MINLOG2);
+	perpage = bsize < heap->pagesize ? heap->pagesize / bsize : 1;
+	info->buckets[n].nblocks = heap->bpages[n] * perpage;
+	/* Magazines are sampled locklessly. */
+	if (heap->bused[n] > info->buckets[n].cached)
+	    info->buckets[n].used = heap->bused[n] - info->buckets[n].cached;
+	else
+	    info->buckets[n].cached = heap->bused[n];
+	}
+
+    xnlock_put_irqrestore(&heap->lock,s);
+
+    info->used = xnheap_used_mem(heap);
+
+    if (heap->parent)
+	memcpy(info->parent,heap->parent->label,sizeof(info->parent));
+}
+
+#endif /* CONFIG_XENO_OPT_STATS */
+
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+
+/*! 
+ * \fn u_long xnheap_used_mem(xnheap_t *heap)
+ * \brief Return the amount of memory in use.
+ *
+ * Returns the amount of memory currently allocated from a heap,
+ * excluding the free blocks cached by the per-CPU magazines. The
+ * value is only indicative, since magazines are sampled without
+ * locking.
+ *
+ * @param heap The descriptor address of the heap.
+ *
+ * @return The number of bytes in use.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+u_long xnheap_used_mem (xnheap_t *heap)
+
+{
+    u_long cached = 0;
+    int cpu;
+
+    for (cpu = 0; cpu < XNARCH_NR_CPUS; cpu++)
+	cached += heap->mags[cpu].stat.cached;
+
+    /* Blocks migrating between CPUs while we sample may be counted
+       twice. */
+    return heap->ubytes > cached ? heap->ubytes - cached : 0;
+}
+
+/*! 
+ * \fn void xnheap_get_magstat(xnheap_t *heap, int cpu, xnheap_magstat_t *stat)
+ * \brief Return the statistics of the heap magazines.
+ *
+ * Copies the counters of the magazine attached to a given CPU, or
+ * their sum over all CPUs. The hit rate of a magazine is
+ * hits / (hits + misses); a high refill or flush count relative to
+ * the number of misses suggests a larger magazine size.
+ *
+ * @param heap The descriptor address of the heap.
+ *
+ * @param cpu The CPU number of the magazine to report, or -1 to sum
+ * the counters of all magazines.
+ *
+ * @param stat The address of a structure the counters are copied
+ * to.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+void xnheap_get_magstat (xnheap_t *heap, int cpu, xnheap_magstat_t *stat)
+
+{
+    xnheap_magazine_t *mag;
+    int n, first, last;
+    spl_t s;
+
+    if (cpu < 0)
+	{
+	first = 0;
+	last = XNARCH_NR_CPUS - 1;
+	}
+    else
+	first = last = cpu;
+
+    stat->hits = 0;
+    stat->misses = 0;
+    stat->refills = 0;
+    stat->flushes = 0;
+    stat->cached = 0;
+
+    for (n = first; n <= last; n++)
+	{
+	mag = &heap->mags[n];
+	xnlock_get_irqsave(&mag->lock,s);
+	stat->hits += mag->stat.hits;
+	stat->misses += mag->stat.misses;
+	stat->refills += mag->stat.refills;
+	stat->flushes += mag->stat.flushes;
+	stat->cached += mag->stat.cached;
+	xnlock_put_irqrestore(&mag->lock,s);
+	}
+}
+
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+
+#define slab_link(slab,obj)  (*((caddr_t *)((caddr_t)(obj) + (slab)->linkoff)))
+
+/*
+ * grow_slab() -- Carve a new chunk into free objects. The caller
+ * must have acquired the slab lock.
+ */
+
+static int grow_slab (xnslab_t *slab)
+
+{
+    caddr_t chunk, obj, limit;
+    xnholder_t *holder;
+
+    chunk = (caddr_t)xnheap_alloc(slab->heap,slab->chunksize);
+
+    if (!chunk)
+	return -ENOMEM;
+
+    /* Chunks are linked through their heading holder, which is
+       followed by the (aligned) object array. */
+
+    holder = (xnholder_t *)chunk;
+    inith(holder);
+    appendq(&slab->chunkq,holder);
+
+    obj = (caddr_t)(((u_long)(holder + 1) + slab->align - 1) & ~(slab->align - 1));
+    limit = chunk + slab->chunksize - slab->stride;
+
+    for (; obj <= limit; obj += slab->stride)
+	{
+	if (slab->ctor)
+	    slab->ctor(obj);
+
+	slab_link(slab,obj) = slab->freelist;
+	slab->freelist = obj;
+	slab->nobjs++;
+	slab->nfree++;
+	}
+
+    return 0;
+}
 
-	    /* Mark the released pages as free in the extent's page map. */
+/*! 
+ * \fn int xnslab_init(xnslab_t *slab,xnheap_t *heap,u_long objsize,u_long reserve,void (*ctor)(void *obj))
+ * \brief Initialize a fixed-size object slab.
+ *
+ * Initializes a slab which serves objects of a single size from
+ * memory chunks obtained from a heap. Allocating and releasing an
+ * object are constant-time operations as long as free objects are
+ * available; otherwise, a new chunk of at least XNSLAB_MINOBJS
+ * objects is obtained from the heap.
+ *
+ * @param slab The address of a slab descriptor which will be used to
+ * store the allocation data.
+ *
+ * @param heap The descriptor address of the heap to obtain memory
+ * chunks from.
+ *
+ * @param objsize The size in bytes of each object.
+ *
+ * @param reserve The number of objects which should be made
+ * available immediately. Reserving the maximum number of objects
+ * which can be outstanding concurrently ensures that the heap is
+ * never involved when allocating objects afterwards.
+ *
+ * @param ctor If non-NULL, the address of a routine which is called
+ * once for each object when it is carved from a new chunk, receiving
+ * the object address as its sole argument. Objects are expected to
+ * be returned to the slab in their constructed state, i.e. the
+ * contents of a constructed object are preserved across
+ * xnslab_free() and xnslab_alloc() calls. This routine is called
+ * with interrupts off, and must not reschedule.
+ *
+ * @return 0 is returned upon success, or one of the following error
+ * codes:
+ *
+ * - -EINVAL is returned if @a objsize is zero.
+ *
+ * - -ENOMEM is returned if the heap could not provide enough memory
+ * to reserve the requested number of objects.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
 
-	    for (pagecont = 0; pagecont < npages; pagecont++)
-		extent->pagemap[pagenum + pagecont] = XNHEAP_PFREE;
+int xnslab_init (xnslab_t *slab,
+		 xnheap_t *heap,
+		 u_long objsize,
+		 u_long reserve,
+		 void (*ctor)(void *obj))
+{
+    u_long size, chunksize;
+    int err;
+    spl_t s;
 
-	    /* Return the sub-list to the free page list, keeping
-	       an increasing address order to favor coalescence. */
-    
-	    for (nextpage = extent->freelist, lastpage = NULL;
-		 nextpage != NULL && nextpage < (caddr_t)block;
-		 lastpage = nextpage, nextpage = *((caddr_t *)nextpage))
-		; /* Loop */
+    if (objsize == 0)
+	return -EINVAL;
 
-	    *((caddr_t *)tailpage) = nextpage;
+    /* The free list link overlays the beginning of free objects,
+       unless a constructor is given, in which case it is stored
+       right after the object so that the constructed state is
+       preserved. */
 
-	    if (lastpage)
-		*((caddr_t *)lastpage) = (caddr_t)block;
-	    else
-		extent->freelist = (caddr_t)block;
+    if (ctor)
+	{
+	slab->linkoff = (objsize + sizeof(caddr_t) - 1) & ~(sizeof(caddr_t) - 1);
+	size = slab->linkoff + sizeof(caddr_t);
+	}
+    else
+	{
+	slab->linkoff = 0;
+	size = objsize < sizeof(caddr_t) ? sizeof(caddr_t) : objsize;
+	}
 
-	    break;
+    if (size < XNSLAB_ALIGNSZ)
+	{
+	for (slab->stride = sizeof(caddr_t); slab->stride < size; slab->stride <<= 1)
+	    ; /* Loop */
 
-	default:
+	slab->align = slab->stride;
+	}
+    else
+	{
+	slab->stride = (size + XNSLAB_ALIGNSZ - 1) & ~(XNSLAB_ALIGNSZ - 1);
+	slab->align = XNSLAB_ALIGNSZ;
+	}
 
-	    log2size = extent->pagemap[pagenum];
-	    bsize = (1 << log2size);
+    /* Size the chunks after the blocks the heap would return
+       anyway, so that no memory is wasted on rounding. */
 
-	    if ((boffset & (bsize - 1)) != 0) /* Not a block start? */
-		goto bad_block;
+    chunksize = sizeof(xnholder_t) + slab->align - 1 + XNSLAB_MINOBJS * slab->stride;
 
-	    if (ckfn && (err = ckfn(block)) != 0)
-		goto unlock_and_fail;
+    if (chunksize <= heap->pagesize)
+	chunksize = heap->pagesize;
+    else if (chunksize <= heap->pagesize * 2)
+	chunksize = heap->pagesize * 2;
+    else
+	chunksize = (chunksize + heap->pagesize - 1) & ~(heap->pagesize - 1);
 
-	    /* Return the block to the bucketed memory space. */
+    slab->heap = heap;
+    slab->objsize = objsize;
+    slab->chunksize = chunksize;
+    slab->nobjs = 0;
+    slab->nfree = 0;
+    slab->freelist = NULL;
+    slab->ctor = ctor;
+    initq(&slab->chunkq);
+    xnlock_init(&slab->lock);
 
-	    *((caddr_t *)block) = heap->buckets[log2size - XNHEAP_MINLOG2];
-	    heap->buckets[log2size - XNHEAP_MINLOG2] = block;
+    xnlock_get_irqsave(&slab->lock,s);
 
-	    break;
-	}
+    for (err = 0; slab->nfree < reserve && !err; )
+	err = grow_slab(slab);
 
-    heap->ubytes -= bsize;
+    xnlock_put_irqrestore(&slab->lock,s);
 
-    xnlock_put_irqrestore(&heap->lock,s);
+    if (err)
+	xnslab_destroy(slab);
 
-    return 0;
+    return err;
 }
 
 /*! 
- * \fn int xnheap_free(xnheap_t *heap, void *block)
- * \brief Release a memory block to a memory heap.
- *
- * Releases a memory region to the memory heap it was previously
- * allocated from.
+ * \fn void xnslab_destroy(xnslab_t *slab)
+ * \brief Destroy a fixed-size object slab.
  *
- * @param heap The descriptor address of the heap to release memory
- * to.
- *
- * @param block The address of the region to be returned to the heap.
+ * Returns all the memory chunks of a slab to the heap they were
+ * obtained from. Outstanding objects become invalid.
  *
- * @return 0 is returned upon success, or -EINVAL is returned whenever
- * the block is not a valid region of the specified heap.
+ * @param slab The descriptor address of the destroyed slab.
  *
  * Environments:
  *
  * This service can be called from:
  *
  * - Kernel module initialization/cleanup code
- * - Interrupt service routine
  * - Kernel-based task
  * - User-space task
  *
  * Rescheduling: never.
  */
 
-int xnheap_free (xnheap_t *heap, void *block)
+void xnslab_destroy (xnslab_t *slab)
 
 {
-    return xnheap_test_and_free(heap,block,NULL);
+    xnholder_t *holder;
+    spl_t s;
+
+    xnlock_get_irqsave(&slab->lock,s);
+
+    while ((holder = getq(&slab->chunkq)) != NULL)
+	xnheap_free(slab->heap,holder);
+
+    slab->freelist = NULL;
+    slab->nobjs = 0;
+    slab->nfree = 0;
+
+    xnlock_put_irqrestore(&slab->lock,s);
 }
 
 /*! 
- * \fn int xnheap_extend(xnheap_t *heap, void *extaddr, u_long extsize)
- * \brief Extend a memory heap.
- *
- * Add a new extent to an existing memory heap.
- *
- * @param heap The descriptor address of the heap to add an extent to.
+ * \fn void *xnslab_alloc(xnslab_t *slab)
+ * \brief Allocate an object from a slab.
  *
- * @param extaddr The address of the extent memory.
+ * Picks a free object from a slab. This is a constant-time operation
+ * unless the slab has no free object left, in which case a new chunk
+ * of objects is obtained from the underlying heap, in bounded time.
  *
- * @param extsize The size of the extent memory (in bytes). In the
- * current implementation, this size must match the one of the initial
- * extent passed to xnheap_init().
+ * @param slab The descriptor address of the slab to get the object
+ * from.
  *
- * @return 0 is returned upon success, or -EINVAL is returned if
- * @a extsize differs from the initial extent's size.
+ * @return The address of the object upon success, or NULL if no
+ * memory is available from the underlying heap.
  *
  * Environments:
  *
@@ -708,46 +2136,42 @@ int xnheap_free (xnheap_t *heap, void *block)
  * Rescheduling: never.
  */
 
-int xnheap_extend (xnheap_t *heap, void *extaddr, u_long extsize)
+void *xnslab_alloc (xnslab_t *slab)
 
 {
-    xnextent_t *extent = (xnextent_t *)extaddr;
+    caddr_t obj;
     spl_t s;
 
-    if (extsize != heap->extentsize)
-	return -EINVAL;
-
-    init_extent(heap,extent);
+    xnlock_get_irqsave(&slab->lock,s);
 
-    xnlock_get_irqsave(&heap->lock,s);
+    if (slab->freelist == NULL && grow_slab(slab) != 0)
+	{
+	xnlock_put_irqrestore(&slab->lock,s);
+	return NULL;
+	}
 
-    appendq(&heap->extents,&extent->link);
+    obj = slab->freelist;
+    slab->freelist = slab_link(slab,obj);
+    slab->nfree--;
 
-    xnlock_put_irqrestore(&heap->lock,s);
+    xnlock_put_irqrestore(&slab->lock,s);
 
-    return 0;
+    return obj;
 }
 
 /*! 
- * \fn int xnheap_schedule_free(xnheap_t *heap, void *block, xnholder_t *link)
- * \brief Schedule a memory block for release.
- *
- * This routine records a block for later release by
- * xnheap_finalize_free(). This service is useful to lazily free
- * blocks of heap memory when immediate release is not an option,
- * e.g. when active references are still pending on the object for a
- * short time after the call. xnheap_finalize_free() is expected to be
- * eventually called by the client code at some point in the future
- * when actually freeing the idle objects is deemed safe.
+ * \fn void xnslab_free(xnslab_t *slab, void *obj)
+ * \brief Release an object to a slab.
  *
- * @param heap The descriptor address of the heap to release memory
- * to.
+ * Returns an object to the slab it was allocated from, in constant
+ * time. Chunks are never returned to the underlying heap before the
+ * slab is destroyed.
  *
- * @param block The address of the region to be returned to the heap.
+ * @param slab The descriptor address of the slab to release the
+ * object to.
  *
- * @param link The address of a link member, likely but not
- * necessarily within the released object, which will be used by the
- * heap manager to hold the block in the queue of idle objects.
+ * @param obj The address of the object, as returned by
+ * xnslab_alloc().
  *
  * Environments:
  *
@@ -761,37 +2185,16 @@ int xnheap_extend (xnheap_t *heap, void *extaddr, u_long extsize)
  * Rescheduling: never.
  */
 
-void xnheap_schedule_free (xnheap_t *heap, void *block, xnholder_t *link)
-
-{
-    spl_t s;
-
-    xnlock_get_irqsave(&heap->lock,s);
-    /* Hack: we only need a one-way linked list for remembering the
-       idle objects through the 'next' field, so the 'last' field of
-       the link is used to point at the beginning of the freed
-       memory. */
-    link->last = (xnholder_t *)block;
-    link->next = heap->idleq;
-    heap->idleq = link;
-    xnlock_put_irqrestore(&heap->lock,s);
-}
-
-void xnheap_finalize_free_inner (xnheap_t *heap)
+void xnslab_free (xnslab_t *slab, void *obj)
 
 {
-    xnholder_t *holder;
     spl_t s;
 
-    xnlock_get_irqsave(&heap->lock,s);
-
-    while ((holder = heap->idleq) != NULL)
-	{
-	heap->idleq = holder->next;
-	xnheap_free(heap,holder->last);
-	}
-
-    xnlock_put_irqrestore(&heap->lock,s);
+    xnlock_get_irqsave(&slab->lock,s);
+    slab_link(slab,obj) = slab->freelist;
+    slab->freelist = (caddr_t)obj;
+    slab->nfree++;
+    xnlock_put_irqrestore(&slab->lock,s);
 }
 
 #if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
@@ -928,16 +2331,26 @@ static unsigned long __va_to_kva (unsigned long va)
     return kva;
 }
 
-static int xnheap_mmap (struct file *file,
-			struct vm_area_struct *vma)
+/* Map a shared heap into the address space described by vma. This
+   is also used by the drivers which expose shared heaps through their
+   own device, e.g. message pipes in ring mode. The mapping holds a
+   reference on the heap until it is closed, so that
+   xnheap_destroy_shared() fails with -EBUSY in the meantime. */
+
+int xnheap_remap_vm_area (xnheap_t *heap,
+			  struct vm_area_struct *vma)
 {
     unsigned long offset, size, vaddr;
-    xnheap_t *heap;
+    pgprot_t prot;
 
-    if (vma->vm_ops != NULL || file->private_data == NULL)
-	/* Caller should mmap() once for a given file instance, after
-	   the ioctl() binding has been issued. */
-	return -ENXIO;
+    if (heap->archdep.rdonly)
+	{
+	if (vma->vm_flags & VM_WRITE)
+	    return -EACCES;
+
+	/* Prevent mprotect() from granting write access later on. */
+	vma->vm_flags &= ~VM_MAYWRITE;
+	}
 
     if ((vma->vm_flags & VM_WRITE) && !(vma->vm_flags & VM_SHARED))
 	return -EINVAL;	/* COW unsupported. */
@@ -948,24 +2361,27 @@ static int xnheap_mmap (struct file *file,
 	return -ENXIO;	/* We must map the entire heap. */
         
     size = vma->vm_end - vma->vm_start;
-    heap = (xnheap_t *)file->private_data;
 
     if (size != heap->extentsize)
 	return -ENXIO;	/* Doesn't match the heap size. */
         
     vma->vm_ops = &xnheap_vmops;
     vma->vm_flags |= VM_LOCKED;	/* Don't swap this out. */
-    vma->vm_private_data = file->private_data;
+    vma->vm_private_data = heap;
 
     vaddr = (unsigned long)heap->archdep.heapbase;
 
-    if (heap->archdep.kmflags)
+    /* Honor read-only mappings, e.g. of the shared time page. */
+    prot = (vma->vm_flags & VM_WRITE) ? PAGE_SHARED : PAGE_READONLY;
+
+    if (heap->archdep.kmflags || heap->archdep.pgorder >= 0)
 	{
+	/* Physically contiguous memory is remapped at once. */
 	if (xnarch_remap_page_range(vma,
 				    vma->vm_start,
 				    virt_to_phys((void *)vaddr),
 				    size,
-				    PAGE_SHARED))
+				    prot))
 	    return -ENXIO;
 	}
     else
@@ -978,7 +2394,7 @@ static int xnheap_mmap (struct file *file,
 					maddr,
 					__pa(__va_to_kva(vaddr)),
 					PAGE_SIZE,
-					PAGE_SHARED))
+					prot))
 		return -ENXIO;
 
 	    maddr += PAGE_SIZE;
@@ -992,6 +2408,17 @@ static int xnheap_mmap (struct file *file,
     return 0;
 }
 
+static int xnheap_mmap (struct file *file,
+			struct vm_area_struct *vma)
+{
+    if (vma->vm_ops != NULL || file->private_data == NULL)
+	/* Caller should mmap() once for a given file instance, after
+	   the ioctl() binding has been issued. */
+	return -ENXIO;
+
+    return xnheap_remap_vm_area((xnheap_t *)file->private_data,vma);
+}
+
 static struct file_operations xnheap_fops = {
     .owner =	THIS_MODULE,
     .open =	&xnheap_open,
@@ -1102,12 +2529,85 @@ static inline void __unreserve_and_free_heap (void *ptr, size_t size, int kmflag
 	}
 }
 
+static inline void *__alloc_and_reserve_pages (size_t size,
+						int kmflags,
+						int node,
+						int order)
+{
+    unsigned long vaddr, vabase;
+    struct page *page;
+
+    page = alloc_pages_node(node,GFP_KERNEL|kmflags,order);
+
+    if (!page)
+	return NULL;
+
+    vabase = (unsigned long)page_address(page);
+
+    /* Reserve the whole block, so that the pages beyond the heap
+       size are not mistaken for free ones while it is mapped. */
+
+    for (vaddr = vabase; vaddr < vabase + (PAGE_SIZE << order); vaddr += PAGE_SIZE)
+	SetPageReserved(virt_to_page(vaddr));
+
+    return (void *)vabase;
+}
+
+static inline void __unreserve_and_free_pages (void *ptr, int order)
+
+{
+    unsigned long vaddr, vabase;
+
+    vabase = (unsigned long)ptr;
+
+    for (vaddr = vabase; vaddr < vabase + (PAGE_SIZE << order); vaddr += PAGE_SIZE)
+	ClearPageReserved(virt_to_page(vaddr));
+
+    __free_pages(virt_to_page(vabase),order);
+}
+
+static void __release_shared_memory (xnheap_t *heap)
+
+{
+    if (heap->archdep.pgorder >= 0)
+	__unreserve_and_free_pages(heap->archdep.heapbase,
+				   heap->archdep.pgorder);
+    else
+	__unreserve_and_free_heap(heap->archdep.heapbase,
+				  heap->extentsize,
+				  heap->archdep.kmflags);
+}
+
+static int __init_shared_heap (xnheap_t *heap,
+			       void *heapbase,
+			       u_long heapsize,
+			       int memflags,
+			       int pgorder)
+{
+    spl_t s;
+    int err;
+
+    err = xnheap_init(heap,heapbase,heapsize,PAGE_SIZE);
+
+    if (err)
+	return err;
+
+    heap->archdep.kmflags = memflags;
+    heap->archdep.pgorder = pgorder;
+    heap->archdep.heapbase = heapbase;
+
+    xnlock_get_irqsave(&nklock,s);
+    appendq(&kheapq,&heap->link);
+    xnlock_put_irqrestore(&nklock,s);
+
+    return 0;
+}
+
 int xnheap_init_shared (xnheap_t *heap,
 			u_long heapsize,
 			int memflags)
 {
     void *heapbase;
-    spl_t s;
     int err;
 
     heapsize = PAGE_ALIGN(heapsize);
@@ -1116,22 +2616,91 @@ int xnheap_init_shared (xnheap_t *heap,
     if (!heapbase)
 	return -ENOMEM;
     
-    err = xnheap_init(heap,heapbase,heapsize,PAGE_SIZE);
+    err = __init_shared_heap(heap,heapbase,heapsize,memflags,-1);
 
     if (err)
-	{
 	__unreserve_and_free_heap(heapbase,heapsize,memflags);
-	return err;
-	}
 
-    heap->archdep.kmflags = memflags;
-    heap->archdep.heapbase = heapbase;
+    return err;
+}
 
-    xnlock_get_irqsave(&nklock,s);
-    appendq(&kheapq,&heap->link);
-    xnlock_put_irqrestore(&nklock,s);
+/*! 
+ * \fn int xnheap_init_shared_node(xnheap_t *heap,u_long heapsize,int memflags,int node)
+ * \brief Initialize a shared heap in node-local contiguous memory.
+ *
+ * This variant of xnheap_init_shared() backs the heap with a single
+ * block of physically contiguous pages obtained from the page
+ * allocator of a given memory node. The kernel accesses such memory
+ * through its linear mapping, which most architectures build from
+ * large pages, and the heap is mapped into user-space by a single
+ * contiguous remapping instead of a page-by-page one, which reduces
+ * the TLB pressure on both sides for large heaps. On NUMA machines,
+ * allocating the heap on the node of the CPUs which use it most
+ * also avoids remote memory accesses.
+ *
+ * @param heap The address of a heap descriptor the memory manager
+ * will use to store the allocation data.
+ *
+ * @param heapsize The size of the heap, which is rounded up to the
+ * next page size. The block obtained from the page allocator is
+ * rounded up to the next power of two pages, the excess pages being
+ * left unused.
+ *
+ * @param memflags Additional allocation flags passed to the page
+ * allocator, e.g. GFP_DMA.
+ *
+ * @param node The memory node to allocate from, or
+ * XNHEAP_LOCAL_NODE for the node of the current CPU.
+ *
+ * @return 0 is returned upon success, or:
+ *
+ * - -EINVAL is returned if @a node is not an online memory node, or
+ * @a heapsize is invalid.
+ *
+ * - -ENOMEM is returned if the node cannot provide enough contiguous
+ * memory, or @a heapsize exceeds the largest block the page allocator
+ * can return.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization code
+ * - User-space task in secondary mode
+ *
+ * Rescheduling: never.
+ */
 
-    return 0;
+int xnheap_init_shared_node (xnheap_t *heap,
+			     u_long heapsize,
+			     int memflags,
+			     int node)
+{
+    void *heapbase;
+    int err, order;
+
+    if (node == XNHEAP_LOCAL_NODE)
+	node = xnarch_local_node();
+    else if (!xnarch_node_online(node))
+	return -EINVAL;
+
+    heapsize = PAGE_ALIGN(heapsize);
+    order = get_order(heapsize);
+
+    if (order >= MAX_ORDER)
+	return -ENOMEM;
+
+    heapbase = __alloc_and_reserve_pages(heapsize,memflags,node,order);
+
+    if (!heapbase)
+	return -ENOMEM;
+
+    err = __init_shared_heap(heap,heapbase,heapsize,memflags,order);
+
+    if (err)
+	__unreserve_and_free_pages(heapbase,order);
+
+    return err;
 }
 
 int xnheap_destroy_shared (xnheap_t *heap)
@@ -1152,14 +2721,17 @@ int xnheap_destroy_shared (xnheap_t *heap)
 
     xnlock_put_irqrestore(&nklock,s);
 
-    __unreserve_and_free_heap(heap->archdep.heapbase,
-			      heap->extentsize,
-			      heap->archdep.kmflags);
+    unregister_heap(heap);
+
+    __release_shared_memory(heap);
+
     return 0;
 }
 
 EXPORT_SYMBOL(xnheap_init_shared);
+EXPORT_SYMBOL(xnheap_init_shared_node);
 EXPORT_SYMBOL(xnheap_destroy_shared);
+EXPORT_SYMBOL(xnheap_remap_vm_area);
 
 #endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
 
@@ -1171,7 +2743,23 @@ EXPORT_SYMBOL(xnheap_extend);
 EXPORT_SYMBOL(xnheap_test_and_free);
 EXPORT_SYMBOL(xnheap_free);
 EXPORT_SYMBOL(xnheap_init);
+EXPORT_SYMBOL(xnheap_check_block);
+EXPORT_SYMBOL(xnheap_init_reserve);
+EXPORT_SYMBOL(xnheap_destroy_reserve);
 EXPORT_SYMBOL(xnheap_schedule_free);
 EXPORT_SYMBOL(xnheap_finalize_free_inner);
+EXPORT_SYMBOL(xnslab_init);
+EXPORT_SYMBOL(xnslab_destroy);
+EXPORT_SYMBOL(xnslab_alloc);
+EXPORT_SYMBOL(xnslab_free);
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+EXPORT_SYMBOL(xnheap_used_mem);
+EXPORT_SYMBOL(xnheap_get_magstat);
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+#ifdef CONFIG_XENO_OPT_STATS
+EXPORT_SYMBOL(xnheap_statq);
+EXPORT_SYMBOL(xnheap_set_label);
+EXPORT_SYMBOL(xnheap_get_info);
+#endif /* CONFIG_XENO_OPT_STATS */
 
 EXPORT_SYMBOL(kheap);
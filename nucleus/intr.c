@@ -35,6 +35,7 @@
 #include <nucleus/pod.h>
 #include <nucleus/intr.h>
 #include <nucleus/ltt.h>
+#include <nucleus/trace.h>
 
 xnintr_t nkclock;
 
@@ -358,6 +359,7 @@ static void xnintr_irq_handler (unsigned irq, void *cookie)
     xnarch_memory_barrier();
 
     xnltt_log_event(xeno_ev_ienter,irq);
+    xntrace_irq_enter(irq);
 
     ++sched->inesting;
     s = intr->isr(intr);
@@ -383,6 +385,7 @@ static void xnintr_irq_handler (unsigned irq, void *cookie)
 	xnarch_relay_tick();
 	}
 
+    xntrace_irq_exit(irq);
     xnltt_log_event(xeno_ev_iexit,irq);
 }
 
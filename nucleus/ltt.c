@@ -143,6 +143,8 @@ struct xnltt_evmap xnltt_evtable[] = {
     [xeno_ev_tmstop] = { "Xenomai stop timer", NULL, -1, xeno_evall },
     [xeno_ev_mark] = { "Xenomai **mark**", "%s", -1, xeno_evall },
     [xeno_ev_watchdog] = { "Xenomai watchdog", "runthread=%s", -1, xeno_evall },
+    [xeno_ev_thrbudget] = { "Xenomai thread budget", "thread=%s, budget=%Lu, period=%Lu, mode=%d", -1, xeno_evthr },
+    [xeno_ev_budgetovr] = { "Xenomai budget overrun", "thread=%s, overruns=%lu", -1, xeno_evthr },
     { NULL, NULL, -1, 0 },
 };
 
@@ -38,6 +38,7 @@
 #include <nucleus/core.h>
 #endif /* CONFIG_XENO_OPT_PERVASIVE */
 #include <nucleus/ltt.h>
+#include <nucleus/trace.h>
 
 MODULE_DESCRIPTION("Xenomai nucleus");
 MODULE_AUTHOR("rpm@xenomai.org");
@@ -247,6 +248,7 @@ struct stat_seq_iterator {
 	unsigned long ssw;
 	unsigned long csw;
 	unsigned long pf;
+	xnticks_t exec_time;
     } stat_info[1];
 };
 
@@ -287,15 +289,16 @@ static int stat_seq_show(struct seq_file *seq, void *v)
     char msw[64];
 
     if (v == SEQ_START_TOKEN)
-	seq_printf(seq,"%-3s  %-6s %-10s %-10s %-4s  %-8s  %s\n",
-		   "CPU","PID","MSW","CSW","PF","STAT","NAME");
+	seq_printf(seq,"%-3s  %-6s %-10s %-10s %-4s  %-14s  %-8s  %s\n",
+		   "CPU","PID","MSW","CSW","PF","EXEC(us)","STAT","NAME");
     else
 	{
 	struct stat_seq_info *p = (struct stat_seq_info *)v;
 	snprintf(msw,sizeof(msw),"%lu/%lu",p->psw, p->ssw);
-	seq_printf(seq,"%3u  %-6d %-10s %-10lu %-4lu  %.8lx  %s\n",
+	seq_printf(seq,"%3u  %-6d %-10s %-10lu %-4lu  %-14Lu  %.8lx  %s\n",
 		   p->cpu, p->pid,
 		   msw, p->csw, p->pf,
+		   xnarch_ulldiv(p->exec_time,1000,NULL),
 		   p->status, p->name);
 	}
 
@@ -358,6 +361,7 @@ static int stat_seq_open(struct inode *inode, struct file *file)
 	iter->stat_info[n].ssw = thread->stat.ssw;
 	iter->stat_info[n].csw = thread->stat.csw;
 	iter->stat_info[n].pf = thread->stat.pf;
+	iter->stat_info[n].exec_time = xnpod_get_exec_time(thread);
 	}
     
     xnlock_put_irqrestore(&nklock,s);
@@ -376,6 +380,164 @@ static struct file_operations stat_seq_operations = {
     .release = seq_release_private,
 };
 
+struct heap_seq_iterator {
+    int nentries;
+    struct heap_seq_info {
+	void *heap;
+	xnheap_info_t info;
+    } heap_info[1];
+};
+
+static void *heap_seq_start(struct seq_file *seq, loff_t *pos)
+{
+    struct heap_seq_iterator *iter = (struct heap_seq_iterator *)seq->private;
+
+    if (*pos >= iter->nentries)
+	return NULL;
+
+    return iter->heap_info + *pos;
+}
+
+static void *heap_seq_next(struct seq_file *seq, void *v, loff_t *pos)
+{
+    struct heap_seq_iterator *iter = (struct heap_seq_iterator *)seq->private;
+
+    ++*pos;
+
+    if (*pos >= iter->nentries)
+	return NULL;
+
+    return iter->heap_info + *pos;
+}
+
+static void heap_seq_stop(struct seq_file *seq, void *v)
+{
+}
+
+static int heap_seq_show(struct seq_file *seq, void *v)
+{
+    struct heap_seq_info *p = (struct heap_seq_info *)v;
+    xnheap_info_t *info = &p->info;
+    int n;
+
+    if (*info->label)
+	seq_printf(seq,"%s\n",info->label);
+    else
+	seq_printf(seq,"%p\n",p->heap);
+
+    if (*info->parent)
+	seq_printf(seq,"  reserve of %s\n",info->parent);
+
+    seq_printf(seq,"  size=%lu:pagesize=%lu:extents=%lu:used=%lu:maxcont=%lu:reserved=%lu\n",
+	       info->size,
+	       info->pagesize,
+	       info->nextents,
+	       info->used,
+	       info->maxcont,
+	       info->reserved);
+
+    seq_printf(seq,"  allocs=%lu:frees=%lu:fails=%lu:maxalloc=%Lu (%Lu ns)\n",
+	       info->nallocs,
+	       info->nfrees,
+	       info->nfails,
+	       info->maxalloc,
+	       xnarch_tsc_to_ns(info->maxalloc));
+
+    seq_printf(seq,"  freepages=%lu:runs=%lu:maxfree=%lu\n",
+	       info->freepages,
+	       info->nruns,
+	       info->maxfree);
+
+    seq_printf(seq,"  %8s %8s %8s %8s %8s\n",
+	       "BUCKET","BLOCKS","USED","CACHED","FREE");
+
+    for (n = 0; n < XNHEAP_NBUCKETS; n++)
+	{
+	if (info->buckets[n].nblocks == 0)
+	    continue;
+
+	seq_printf(seq,"  %8lu %8lu %8lu %8lu %8lu\n",
+		   1UL << (n + XNHEAP_MINLOG2),
+		   info->buckets[n].nblocks,
+		   info->buckets[n].used,
+		   info->buckets[n].cached,
+		   info->buckets[n].nblocks
+		   - info->buckets[n].used
+		   - info->buckets[n].cached);
+	}
+
+    seq_printf(seq,"\n");
+
+    return 0;
+}
+
+static struct seq_operations heap_op = {
+    .start = &heap_seq_start,
+    .next = &heap_seq_next,
+    .stop = &heap_seq_stop,
+    .show = &heap_seq_show
+};
+
+static int heap_seq_open(struct inode *inode, struct file *file)
+{
+    struct heap_seq_iterator *iter;
+    struct seq_file *seq;
+    xnholder_t *holder;
+    int err, count;
+    xnheap_t *heap;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+    count = countq(&xnheap_statq);
+    xnlock_put_irqrestore(&nklock,s);
+
+    iter = kmalloc(sizeof(*iter)
+		   + (count > 0 ? count - 1 : 0) * sizeof(struct heap_seq_info),
+		   GFP_KERNEL);
+    if (!iter)
+	return -ENOMEM;
+
+    err = seq_open(file, &heap_op);
+
+    if (err)
+	{
+	kfree(iter);
+	return err;
+	}
+
+    iter->nentries = 0;
+
+    /* Heaps may come and go while the queue is unlocked, so we only
+       collect as many of them as we made room for. */
+
+    xnlock_get_irqsave(&nklock,s);
+
+    for (holder = getheadq(&xnheap_statq);
+	 holder && count > 0;
+	 holder = nextq(&xnheap_statq,holder), count--)
+	{
+	heap = statlink2heap(holder);
+	iter->heap_info[iter->nentries].heap = heap;
+	xnheap_get_info(heap,&iter->heap_info[iter->nentries].info);
+	iter->nentries++;
+	}
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    seq = (struct seq_file *)file->private_data;
+    seq->private = iter;
+
+    return 0;
+}
+
+static struct file_operations heap_seq_operations = {
+    .owner = THIS_MODULE,
+    .open = heap_seq_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = seq_release_private,
+};
+
 #ifdef CONFIG_SMP
 
 xnlockinfo_t xnlock_stats[RTHAL_NR_CPUS];
@@ -424,7 +586,186 @@ static int lock_read_proc (char *page,
     return len;
 }
 
+/* Named locks reported by /proc/xenomai/lockstat. */
+
+#define XNLOCK_STAT_SLOTS 32
+
+static struct {
+
+    xnlock_t *lock;
+    const char *name;
+
+} lockstat_table[XNLOCK_STAT_SLOTS];
+
+/**
+ * @internal
+ * @fn int xnlock_stat_register(xnlock_t *lock,const char *name)
+ * @brief Report cross-CPU contention on a lock.
+ *
+ * Register a lock so that its contention statistics are reported by
+ * /proc/xenomai/lockstat. This is meant for subsystems which
+ * serialize on their own lock instead of the nucleus lock, so that
+ * the contention on each of them can be compared.
+ *
+ * The scheduler, the timers and the synchronization objects are
+ * still serialized by the single nucleus lock, which is always
+ * reported; only the heaps have their own locks so far.
+ *
+ * @param lock The address of the lock.
+ *
+ * @param name A symbolic name for the lock; the string must remain
+ * valid until the lock is unregistered.
+ *
+ * @return 0 is returned upon success, or -ENOSPC if the table of
+ * reported locks is full.
+ */
+
+int xnlock_stat_register (xnlock_t *lock, const char *name)
+
+{
+    int n, err = -ENOSPC;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    for (n = 0; n < XNLOCK_STAT_SLOTS; n++)
+	if (!lockstat_table[n].lock)
+	    {
+	    lockstat_table[n].lock = lock;
+	    lockstat_table[n].name = name;
+	    err = 0;
+	    break;
+	    }
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
+void xnlock_stat_unregister (xnlock_t *lock)
+
+{
+    int n;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    for (n = 0; n < XNLOCK_STAT_SLOTS; n++)
+	if (lockstat_table[n].lock == lock)
+	    lockstat_table[n].lock = NULL;
+
+    xnlock_put_irqrestore(&nklock,s);
+}
+
+static int lockstat_read_proc (char *page,
+			       char **start,
+			       off_t off,
+			       int count,
+			       int *eof,
+			       void *data)
+{
+    unsigned long long spin_total, spin_max;
+    unsigned long acquired, contended;
+    xnlockinfo_t lockinfo;
+    const char *name;
+    xnlock_t *lock;
+    int cpu, n, len;
+    char *p = page;
+    spl_t s;
+
+    p += sprintf(p,"%-16s %10s %10s %12s %12s\n",
+		 "LOCK","ACQUIRED","CONTENDED","SPIN-AVG(ns)","SPIN-MAX(ns)");
+
+    for (n = 0; n < XNLOCK_STAT_SLOTS; n++)
+	{
+	xnlock_get_irqsave(&nklock,s);
+
+	lock = lockstat_table[n].lock;
+
+	if (!lock)
+	    {
+	    xnlock_put_irqrestore(&nklock,s);
+	    continue;
+	    }
+
+	name = lockstat_table[n].name;
+	acquired = lock->nr_acquired;
+	contended = lock->nr_contended;
+	spin_total = lock->spin_total;
+	spin_max = lock->spin_max;
+
+	xnlock_put_irqrestore(&nklock,s);
+
+	p += sprintf(p,"%-16s %10lu %10lu %12llu %12llu\n",
+		     name,
+		     acquired,
+		     contended,
+		     contended ? xnarch_tsc_to_ns(xnarch_ulldiv(spin_total,contended,NULL)) : 0,
+		     xnarch_tsc_to_ns(spin_max));
+	}
+
+    p += sprintf(p,"\n%-16s %10s %12s\n","CPU","CONTENDED","SPIN(ns)");
+
+    for_each_online_cpu(cpu) {
+
+        xnlock_get_irqsave(&nklock,s);
+	lockinfo = xnlock_stats[cpu];
+        xnlock_put_irqrestore(&nklock,s);
+
+	p += sprintf(p,"%-16d %10lu %12llu\n",
+		     cpu,
+		     lockinfo.nr_contended,
+		     xnarch_tsc_to_ns(lockinfo.spin_total));
+    }
+
+    len = p - page - off;
+
+    if (len <= off + count) *eof = 1;
+    *start = page + off;
+    if (len > count) len = count;
+    if (len < 0) len = 0;
+
+    return len;
+}
+
+static int lockstat_write_proc (struct file *file,
+				const char __user *buffer,
+				unsigned long count,
+				void *data)
+{
+    int cpu, n;
+    spl_t s;
+
+    /* Any write resets the contention counters. */
+
+    xnlock_get_irqsave(&nklock,s);
+
+    for (n = 0; n < XNLOCK_STAT_SLOTS; n++)
+	{
+	xnlock_t *lock = lockstat_table[n].lock;
+
+	if (lock)
+	    {
+	    lock->nr_acquired = 0;
+	    lock->nr_contended = 0;
+	    lock->spin_total = 0;
+	    lock->spin_max = 0;
+	    }
+	}
+
+    for_each_online_cpu(cpu) {
+	xnlock_stats[cpu].nr_contended = 0;
+	xnlock_stats[cpu].spin_total = 0;
+    }
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return count;
+}
+
 EXPORT_SYMBOL(xnlock_stats);
+EXPORT_SYMBOL(xnlock_stat_register);
+EXPORT_SYMBOL(xnlock_stat_unregister);
 
 #endif /* CONFIG_SMP */
 
@@ -528,7 +869,11 @@ static int timer_read_proc (char *page,
 {
     xnticks_t jiffies = 0, tickval = 0;
     const char *status = "off";
-    int len;
+    int len, cpu;
+#ifdef CONFIG_XENO_HW_PERIODIC_TIMER
+    int level;
+#endif /* CONFIG_XENO_HW_PERIODIC_TIMER */
+    spl_t s;
 
     if (nkpod && testbits(nkpod->status,XNTIMED))
 	{
@@ -544,6 +889,38 @@ static int timer_read_proc (char *page,
 		  tickval,
 		  jiffies);
 
+    xnlock_get_irqsave(&nklock,s);
+
+    if (nkpod && testbits(nkpod->status,XNTIMED))
+	for (cpu = 0; cpu < xnarch_num_online_cpus(); cpu++)
+	    {
+#ifdef CONFIG_XENO_HW_PERIODIC_TIMER
+	    if (testbits(nkpod->status,XNTMPER))
+		{
+		/* Report the number of timers queued to each level of
+		   the periodic wheels, from the root to the outermost
+		   one. */
+		xntwheel_t *wheel = &xnpod_sched_slot(cpu)->timerwheel;
+
+		len += sprintf(page + len,"wheel%d=",cpu);
+
+		for (level = 0; level <= XNTIMER_WHEEL_LEVELS; level++)
+		    len += sprintf(page + len,
+				   level < XNTIMER_WHEEL_LEVELS ? "%lu/" : "%lu\n",
+				   wheel->count[level]);
+		continue;
+		}
+#endif /* CONFIG_XENO_HW_PERIODIC_TIMER */
+#ifdef CONFIG_XENO_OPT_STATS
+	    /* Report the number of hardware shots saved by coalescing
+	       aperiodic timers within their slack window. */
+	    len += sprintf(page + len,"saved%d=%lu\n",
+			   cpu,xnpod_sched_slot(cpu)->savedshots);
+#endif /* CONFIG_XENO_OPT_STATS */
+	    }
+
+    xnlock_put_irqrestore(&nklock,s);
+
     len -= off;
     if (len <= off + count) *eof = 1;
     *start = page + off;
@@ -553,6 +930,102 @@ static int timer_read_proc (char *page,
     return len;
 }
 
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+
+static int heapmag_read_proc (char *page,
+			      char **start,
+			      off_t off,
+			      int count,
+			      int *eof,
+			      void *data)
+{
+    xnheap_magstat_t stat;
+    u_long hits, total;
+    char *p = page;
+    int len, cpu;
+
+    p += sprintf(p,"%-4s %10s %10s %10s %10s %10s %5s\n",
+		 "CPU","HITS","MISSES","REFILLS","FLUSHES","CACHED","HIT%");
+
+    for (cpu = 0; cpu < xnarch_num_online_cpus(); cpu++)
+	{
+	xnheap_get_magstat(&kheap,cpu,&stat);
+
+	/* Scale the counters down so that the hit rate computation
+	   cannot overflow. */
+	for (hits = stat.hits, total = stat.hits + stat.misses;
+	     total > 10000000; hits >>= 1, total >>= 1)
+	    ;
+
+	p += sprintf(p,"%-4d %10lu %10lu %10lu %10lu %10lu %5lu\n",
+		     cpu,
+		     stat.hits,
+		     stat.misses,
+		     stat.refills,
+		     stat.flushes,
+		     stat.cached,
+		     total ? hits * 100 / total : 0);
+	}
+
+    len = (p - page) - off;
+    if (len <= off + count) *eof = 1;
+    *start = page + off;
+    if(len > count) len = count;
+    if(len < 0) len = 0;
+
+    return len;
+}
+
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+
+#ifdef CONFIG_XENO_OPT_PIPE
+
+static int pipes_read_proc (char *page,
+			    char **start,
+			    off_t off,
+			    int count,
+			    int *eof,
+			    void *data)
+{
+    struct xnpipe_stats stats;
+    char *p = page;
+    int len, minor;
+
+    p += sprintf(p,"%-5s %10s %12s %10s %10s %8s\n",
+		 "MINOR","MSGS","BYTES","WAKEUPS","TIMEOUTS","MAXBATCH");
+
+    for (minor = 0; minor < XNPIPE_NDEVS; minor++)
+	{
+	/* Leave room for one more line. */
+	if (p - page > PAGE_SIZE - 80)
+	    break;
+
+	xnpipe_get_stats(minor,&stats);
+
+	if (stats.msgs == 0 &&
+	    !(xnpipe_inquire(minor) & (XNPIPE_KERN_CONN|XNPIPE_USER_CONN)))
+	    continue;
+
+	p += sprintf(p,"%-5d %10lu %12lu %10lu %10lu %8lu\n",
+		     minor,
+		     stats.msgs,
+		     stats.bytes,
+		     stats.wakeups,
+		     stats.timeouts,
+		     stats.maxbatch);
+	}
+
+    len = (p - page) - off;
+    if (len <= off + count) *eof = 1;
+    *start = page + off;
+    if(len > count) len = count;
+    if(len < 0) len = 0;
+
+    return len;
+}
+
+#endif /* CONFIG_XENO_OPT_PIPE */
+
 static struct proc_dir_entry *add_proc_leaf (const char *name,
 					     read_proc_t rdproc,
 					     write_proc_t wrproc,
@@ -613,12 +1086,26 @@ void xnpod_init_proc (void)
 		  &stat_seq_operations,
 		  0,
 		  rthal_proc_root);
+
+    add_proc_fops("heap",
+		  &heap_seq_operations,
+		  0,
+		  rthal_proc_root);
 #ifdef CONFIG_SMP
     add_proc_leaf("lock",
 		  &lock_read_proc,
 		  NULL,
 		  NULL,
 		  rthal_proc_root);
+
+    xnlock_stat_register(&nklock,"nklock");
+    xnlock_stat_register(&kheap.lock,"kheap");
+
+    add_proc_leaf("lockstat",
+		  &lockstat_read_proc,
+		  &lockstat_write_proc,
+		  NULL,
+		  rthal_proc_root);
 #endif /* CONFIG_SMP */
 
 #endif /* CONFIG_XENO_OPT_STATS */
@@ -648,6 +1135,22 @@ void xnpod_init_proc (void)
 		  NULL,
 		  rthal_proc_root);
 
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+    add_proc_leaf("heapmag",
+		  &heapmag_read_proc,
+		  NULL,
+		  NULL,
+		  rthal_proc_root);
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+
+#ifdef CONFIG_XENO_OPT_PIPE
+    add_proc_leaf("pipes",
+		  &pipes_read_proc,
+		  NULL,
+		  NULL,
+		  rthal_proc_root);
+#endif /* CONFIG_XENO_OPT_PIPE */
+
 #ifdef CONFIG_XENO_OPT_PERVASIVE
     iface_proc_root = create_proc_entry("interfaces",
 					S_IFDIR,
@@ -670,13 +1173,21 @@ void xnpod_delete_proc (void)
 #ifdef CONFIG_XENO_OPT_CONFIG_GZ
     remove_proc_entry("config.gz",rthal_proc_root);
 #endif /* CONFIG_XENO_OPT_CONFIG_GZ */
+#ifdef CONFIG_XENO_OPT_PIPE
+    remove_proc_entry("pipes",rthal_proc_root);
+#endif /* CONFIG_XENO_OPT_PIPE */
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+    remove_proc_entry("heapmag",rthal_proc_root);
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
     remove_proc_entry("timer",rthal_proc_root);
     remove_proc_entry("version",rthal_proc_root);
     remove_proc_entry("latency",rthal_proc_root);
     remove_proc_entry("sched",rthal_proc_root);
 #ifdef CONFIG_XENO_OPT_STATS
+    remove_proc_entry("heap",rthal_proc_root);
     remove_proc_entry("stat",rthal_proc_root);
 #ifdef CONFIG_SMP
+    remove_proc_entry("lockstat",rthal_proc_root);
     remove_proc_entry("lock",rthal_proc_root);
 #endif /* CONFIG_SMP */
 #endif /* CONFIG_XENO_OPT_STATS */
@@ -754,11 +1265,18 @@ int __init __xeno_sys_init (void)
     xnltt_mount();
 #endif /* CONFIG_LTT */
 
+#ifdef CONFIG_XENO_OPT_TRACE
+    err = xntrace_mount();
+
+    if (err)
+	goto cleanup_proc;
+#endif /* CONFIG_XENO_OPT_TRACE */
+
 #ifdef CONFIG_XENO_OPT_PIPE
     err = xnpipe_mount();
 
     if (err)
-	goto cleanup_arch;
+	goto cleanup_trace;
 #endif /* CONFIG_XENO_OPT_PIPE */
 
 #ifdef CONFIG_XENO_OPT_PERVASIVE
@@ -794,10 +1312,17 @@ int __init __xeno_sys_init (void)
 #ifdef CONFIG_XENO_OPT_PIPE
     xnpipe_umount();
 
- cleanup_arch:
+ cleanup_trace:
 
 #endif /* CONFIG_XENO_OPT_PIPE */
 
+#ifdef CONFIG_XENO_OPT_TRACE
+    xntrace_umount();
+
+ cleanup_proc:
+
+#endif /* CONFIG_XENO_OPT_TRACE */
+
 #ifdef CONFIG_PROC_FS
     xnpod_delete_proc();
 #endif /* CONFIG_PROC_FS */
@@ -828,6 +1353,9 @@ void __exit __xeno_sys_exit (void)
 #ifdef CONFIG_XENO_OPT_PIPE
     xnpipe_umount();
 #endif /* CONFIG_XENO_OPT_PIPE */
+#ifdef CONFIG_XENO_OPT_TRACE
+    xntrace_umount();
+#endif /* CONFIG_XENO_OPT_TRACE */
 #ifdef CONFIG_LTT
     xnltt_umount();
 #endif /* CONFIG_LTT */
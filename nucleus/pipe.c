@@ -29,6 +29,7 @@
 #include <linux/proc_fs.h>
 #include <linux/spinlock.h>
 #include <linux/device.h>
+#include <linux/mm.h>
 #include <asm/io.h>
 #include <asm/uaccess.h>
 #include <asm/system.h>
@@ -233,6 +234,225 @@ static inline void xnpipe_schedule_request (void) {
     rthal_apc_schedule(xnpipe_wakeup_apc);
 }
 
+/* Get nklock locked before calling this routine. Wake up the Linux
+   reader now, returning non-zero if the wakeup APC must be
+   scheduled. */
+
+static int xnpipe_wakeup_reader (xnpipe_state_t *state)
+
+{
+    int need_sched = 0;
+
+    if (testbits(state->status,XNPIPE_USER_WREAD))
+        {
+        /* Wake up the userland thread waiting for input
+           from the kernel side. */
+        setbits(state->status,XNPIPE_USER_WREAD_READY);
+        need_sched = 1;
+        }
+
+    if (state->asyncq) /* Schedule asynch sig. */
+        {
+        setbits(state->status,XNPIPE_USER_SIGIO);
+        need_sched = 1;
+        }
+
+    if (need_sched)
+	{
+	state->stats.wakeups++;
+
+	if (state->cmsgs > state->stats.maxbatch)
+	    state->stats.maxbatch = state->cmsgs;
+	}
+
+    state->cbytes = 0;
+    state->cmsgs = 0;
+
+    if (testbits(state->status,XNPIPE_USER_COALESCE))
+	xntimer_stop(&state->ctimer);
+
+    return need_sched;
+}
+
+/* Get nklock locked before calling this routine. Account for size
+   bytes sent to the Linux reader, and wake the latter up unless the
+   wakeup can be coalesced with the next ones. Non-zero is returned if
+   the wakeup APC must be scheduled. */
+
+static inline int xnpipe_kick_reader (xnpipe_state_t *state, size_t size)
+
+{
+    state->stats.msgs++;
+    state->stats.bytes += size;
+    state->cmsgs++;
+    state->cbytes += size;
+
+    if (!testbits(state->status,XNPIPE_USER_COALESCE))
+	return xnpipe_wakeup_reader(state);
+
+    if (!testbits(state->status,XNPIPE_USER_WREAD) && !state->asyncq)
+	{
+	/* Nobody to wake up: the reader will find the data by
+	   itself, so start a new batch. */
+	state->cbytes = 0;
+	state->cmsgs = 0;
+	xntimer_stop(&state->ctimer);
+	return 0;
+	}
+
+    if ((state->coalesce.bytes && state->cbytes >= state->coalesce.bytes) ||
+	(state->coalesce.msgs && state->cmsgs >= state->coalesce.msgs) ||
+	!nkpod || !testbits(nkpod->status,XNTIMED))
+	return xnpipe_wakeup_reader(state);
+
+    /* The delay runs from the oldest pending message. */
+
+    if (!xntimer_running_p(&state->ctimer) &&
+	xntimer_start(&state->ctimer,state->cdelay,XN_INFINITE) != 0)
+	return xnpipe_wakeup_reader(state);
+
+    return 0;
+}
+
+static void xnpipe_coalesce_timeout (void *cookie)
+
+{
+    xnpipe_state_t *state = (xnpipe_state_t *)cookie;
+    int need_sched;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    need_sched = xnpipe_wakeup_reader(state);
+
+    if (need_sched)
+	state->stats.timeouts++;
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    if (need_sched)
+	xnpipe_schedule_request();
+}
+
+/* Get nklock locked before calling this routine. Flush the pending
+   batch and return to immediate wakeups. */
+
+static int xnpipe_reset_coalesce (xnpipe_state_t *state)
+
+{
+    int need_sched = xnpipe_wakeup_reader(state);
+
+    if (testbits(state->status,XNPIPE_USER_COALESCE))
+	{
+	xntimer_destroy(&state->ctimer);
+	clrbits(state->status,XNPIPE_USER_COALESCE);
+	}
+
+    state->coalesce.bytes = 0;
+    state->coalesce.msgs = 0;
+    state->coalesce.delay = 0;
+
+    return need_sched;
+}
+
+static int xnpipe_set_coalesce (xnpipe_state_t *state,
+				struct xnpipe_coalesce *cinfo)
+{
+    int need_sched, err = 0;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    need_sched = xnpipe_reset_coalesce(state);
+
+    if (cinfo->bytes == 0 && cinfo->msgs == 0)
+	/* Back to one wakeup per message. */
+	goto unlock_and_exit;
+
+    if (cinfo->delay == 0)
+	{
+	/* A watermark alone could leave data pending forever. */
+	err = -EINVAL;
+	goto unlock_and_exit;
+	}
+
+    if (!nkpod || !testbits(nkpod->status,XNTIMED))
+	{
+	err = -EWOULDBLOCK;
+	goto unlock_and_exit;
+	}
+
+    state->coalesce = *cinfo;
+    state->cdelay = xnpod_ns2ticks(cinfo->delay) ?: 1;
+    xntimer_init(&state->ctimer,&xnpipe_coalesce_timeout,state);
+    setbits(state->status,XNPIPE_USER_COALESCE);
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    if (need_sched)
+	xnpipe_schedule_request();
+
+    return err;
+}
+
+/* Append a record to the shared ring of a pipe in ring mode. Real-time
+   writers are serialized by the nklock, which must be held; the Linux
+   reader only moves the tail index. Records which do not fit are
+   dropped and accounted for in the ring, since the real-time side
+   cannot wait for the reader. The ring is writable from user-space,
+   so the size and write index are only taken from the pipe state,
+   and the tail index is checked before use: a tail the reader has
+   moved past the head or more than a ring away from it makes the
+   ring look full. */
+
+static int xnpipe_ring_put (xnpipe_state_t *state,
+			    const void *buf,
+			    size_t size)
+{
+    unsigned long head = state->ringhead, rsize = state->ringsize;
+    unsigned long need = XNPIPE_RING_RECSZ(size), pos, pad, used;
+    xnpipe_ring_t *ring = state->ring;
+
+    if (need > rsize)
+	return -EINVAL;
+
+    used = head - ring->tail;
+
+    /* Do not overwrite a record before the reader is done with it,
+       i.e. before its tail update is visible. */
+    xnarch_memory_barrier();
+
+    pos = head & (rsize - 1);
+    pad = rsize - pos < need ? rsize - pos : 0;
+
+    if (used > rsize || rsize - used < pad + need)
+	{
+	ring->lost++;
+	return -ENOSPC;
+	}
+
+    if (pad)
+	{
+	/* Records never wrap, so that the reader can process them in
+	   place. */
+	*(unsigned long *)(xnpipe_ring_data(ring) + pos) = XNPIPE_RING_PAD;
+	head += pad;
+	pos = 0;
+	}
+
+    *(unsigned long *)(xnpipe_ring_data(ring) + pos) = size;
+    memcpy(xnpipe_ring_data(ring) + pos + sizeof(unsigned long),buf,size);
+
+    /* Publish the record only once its contents are visible. */
+    xnarch_memory_barrier();
+    state->ringhead = head + need;
+    ring->head = state->ringhead;
+
+    return 0;
+}
+
 /* Real-time entry points. Remember that we _must_ enforce critical
    sections since we might be competing with the real-time threads for
    data access. */
@@ -273,6 +493,7 @@ int xnpipe_connect (int minor,
     state->alloc_handler = alloc_handler;
     state->cookie = cookie;
     state->ionrd = 0;
+    xnselect_signal(&state->select,countq(&state->inq) != 0);
 
     if (testbits(state->status,XNPIPE_USER_CONN))
 	{
@@ -358,6 +579,11 @@ int xnpipe_disconnect (int minor)
 	    }
 	}
 
+    /* Selectors watching this pipe will see it ready, then get
+       -EBADF from the next receive. */
+    if (xnselect_destroy(&state->select))
+	xnpod_schedule();
+
     xnpipe_minor_free(minor);
 
     xnlock_put_irqrestore(&nklock,s);
@@ -401,26 +627,96 @@ ssize_t xnpipe_send (int minor,
 
     inith(xnpipe_m_link(mh));
     xnpipe_m_size(mh) = size - sizeof(*mh);
-    state->ionrd += xnpipe_m_size(mh);
 
-    if (flags & XNPIPE_URGENT)
-	prependq(&state->outq,xnpipe_m_link(mh));
+    if (state->ring)
+	{
+	/* Ring mode: copy the message to the shared ring, then
+	   release the buffer as if it had been read. Urgent messages
+	   cannot overtake others in a ring. */
+	xnpipe_io_handler *handler = state->output_handler;
+	void *cookie = state->cookie;
+	int err;
+
+	err = xnpipe_ring_put(state,xnpipe_m_data(mh),xnpipe_m_size(mh));
+
+	if (err)
+	    {
+	    xnlock_put_irqrestore(&nklock,s);
+	    return err;
+	    }
+
+	need_sched = xnpipe_kick_reader(state,xnpipe_m_size(mh));
+
+	xnlock_put_irqrestore(&nklock,s);
+
+	if (handler != NULL)
+	    handler(minor,mh,0,cookie);
+	}
     else
-	appendq(&state->outq,xnpipe_m_link(mh));
+	{
+	state->ionrd += xnpipe_m_size(mh);
 
-    if (testbits(state->status,XNPIPE_USER_WREAD))
-        {
-        /* Wake up the userland thread waiting for input
-           from the kernel side. */
-        setbits(state->status,XNPIPE_USER_WREAD_READY);
-        need_sched = 1;
-        }
+	if (flags & XNPIPE_URGENT)
+	    prependq(&state->outq,xnpipe_m_link(mh));
+	else
+	    appendq(&state->outq,xnpipe_m_link(mh));
 
-    if (state->asyncq) /* Schedule asynch sig. */
-        {
-        setbits(state->status,XNPIPE_USER_SIGIO);
-        need_sched = 1;
-        }
+	need_sched = xnpipe_kick_reader(state,xnpipe_m_size(mh));
+
+	xnlock_put_irqrestore(&nklock,s);
+	}
+
+    if (need_sched)
+        xnpipe_schedule_request();
+
+    return (ssize_t)size;
+}
+
+ssize_t xnpipe_put (int minor,
+		    const void *buf,
+		    size_t size,
+		    int flags)
+{
+    xnpipe_state_t *state;
+    int need_sched, err;
+    spl_t s;
+
+    if (minor < 0 || minor >= XNPIPE_NDEVS)
+	return -ENODEV;
+
+    if (size == 0)
+	return -EINVAL;
+
+    state = &xnpipe_states[minor];
+
+    xnlock_get_irqsave(&nklock,s);
+
+    if (!testbits(state->status,XNPIPE_KERN_CONN))
+	{
+	err = -EBADF;
+	goto unlock_and_exit;
+	}
+
+    if (!testbits(state->status,XNPIPE_USER_CONN))
+	{
+	err = -EPIPE;
+	goto unlock_and_exit;
+	}
+
+    if (!state->ring)
+	{
+	/* Not in ring mode; the caller should build a message and
+	   use xnpipe_send() instead. */
+	err = -ENXIO;
+	goto unlock_and_exit;
+	}
+
+    err = xnpipe_ring_put(state,buf,size);
+
+    if (err)
+	goto unlock_and_exit;
+
+    need_sched = xnpipe_kick_reader(state,size);
 
     xnlock_put_irqrestore(&nklock,s);
 
@@ -428,6 +724,12 @@ ssize_t xnpipe_send (int minor,
         xnpipe_schedule_request();
 
     return (ssize_t)size;
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
 }
 
 ssize_t xnpipe_recv (int minor,
@@ -511,6 +813,8 @@ ssize_t xnpipe_recv (int minor,
 
     ret = (ssize_t)xnpipe_m_size(*pmh);
 
+    xnselect_signal(&state->select,countq(&state->inq) != 0);
+
  unlock_and_exit:
 
     xnlock_put_irqrestore(&nklock,s);
@@ -527,6 +831,33 @@ int xnpipe_inquire (int minor)
     return xnpipe_states[minor].status;
 }
 
+xnselect_t *xnpipe_get_select (int minor)
+
+{
+    if (minor < 0 || minor >= XNPIPE_NDEVS)
+	return NULL;
+
+    return &xnpipe_states[minor].select;
+}
+
+/* Snapshot the wakeup statistics of a pipe. They are reset each time
+   the Linux side opens the pipe. */
+
+int xnpipe_get_stats (int minor, struct xnpipe_stats *stats)
+
+{
+    spl_t s;
+
+    if (minor < 0 || minor >= XNPIPE_NDEVS)
+	return -ENODEV;
+
+    xnlock_get_irqsave(&nklock,s);
+    *stats = xnpipe_states[minor].stats;
+    xnlock_put_irqrestore(&nklock,s);
+
+    return 0;
+}
+
 /*
  * Clear XNPIPE_USER_CONN flag and cleanup the associated data queues
  * in one atomic step.
@@ -554,11 +885,131 @@ static void xnpipe_cleanup_user_conn(xnpipe_state_t *state)
 	    xnfree(link2mh(holder));
 	}
 
+    xnselect_signal(&state->select,0);
+
     __clrbits(state->status,XNPIPE_USER_CONN);
 
     xnlock_put_irqrestore(&nklock,s);
 }
 
+#ifdef CONFIG_XENO_OPT_PERVASIVE
+
+/*
+ * Switch the pipe to ring mode, allocating a shared ring the Linux
+ * reader can map.
+ */
+
+static int xnpipe_setup_ring (xnpipe_state_t *state,
+			      struct xnpipe_ringinfo *info)
+{
+    unsigned long rsize, heapsize;
+    xnpipe_ring_t *ring;
+    xnheap_t *heap;
+    int err;
+    spl_t s;
+
+    if (info->size == 0 || info->size > (1UL << (BITS_PER_LONG - 2)))
+	return -EINVAL;
+
+    for (rsize = XNPIPE_RING_LINESZ; rsize < info->size; rsize <<= 1)
+	;
+
+    heap = (xnheap_t *)xnmalloc(sizeof(*heap));
+
+    if (!heap)
+	return -ENOMEM;
+
+    /* The ring is obtained as a single block, so the heap must be
+       large enough to hold the power of two the allocator might
+       round it up to. */
+
+    heapsize = PAGE_ALIGN(sizeof(*ring) + rsize);
+
+    if (heapsize < 2 * PAGE_SIZE)
+	heapsize = 2 * PAGE_SIZE;
+
+    heapsize += xnheap_overhead(heapsize,PAGE_SIZE);
+    heapsize = PAGE_ALIGN(heapsize);
+
+    err = xnheap_init_shared(heap,heapsize,0);
+
+    if (err)
+	{
+	xnfree(heap);
+	return err;
+	}
+
+    ring = (xnpipe_ring_t *)xnheap_alloc(heap,sizeof(*ring) + rsize);
+
+    if (!ring)
+	{
+	err = -ENOMEM;
+	goto destroy_and_exit;
+	}
+
+    ring->head = 0;
+    ring->tail = 0;
+    ring->size = rsize;
+    ring->lost = 0;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    if (state->ring)
+	{
+	xnlock_put_irqrestore(&nklock,s);
+	err = -EBUSY;
+	goto destroy_and_exit;
+	}
+
+    state->ringheap = heap;
+    state->ring = ring;
+    state->ringsize = rsize;
+    state->ringhead = 0;
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    info->size = rsize;
+    info->mapsize = xnheap_size(heap);
+    info->offset = xnheap_shared_offset(heap,ring);
+
+    return 0;
+
+ destroy_and_exit:
+
+    xnheap_destroy_shared(heap);
+    xnfree(heap);
+
+    return err;
+}
+
+static void xnpipe_release_ring (xnpipe_state_t *state)
+
+{
+    xnheap_t *heap;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    heap = state->ringheap;
+    state->ringheap = NULL;
+    state->ring = NULL;
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    if (!heap)
+	return;
+
+    /* The mappings pin the file, so none may remain at this point. */
+
+    if (xnheap_destroy_shared(heap) == 0)
+	xnfree(heap);
+    else
+	xnlogerr("Cannot release the ring of pipe #%d.\n",
+		 xnminor_from_state(state));
+}
+
+#endif /* CONFIG_XENO_OPT_PERVASIVE */
+
 /*
  * Open the pipe from user-space.
  */
@@ -588,6 +1039,11 @@ static int xnpipe_open (struct inode *inode,
 
     setbits(state->status,XNPIPE_USER_CONN);
 
+    /* Statistics cover the current session. */
+    memset(&state->stats,0,sizeof(state->stats));
+    state->cbytes = 0;
+    state->cmsgs = 0;
+
     file->private_data = state;
     init_waitqueue_head(&state->readq);
     state->readw = 0;
@@ -692,6 +1148,14 @@ static int xnpipe_release (struct inode *inode,
 	fasync_helper(-1,file,0,&state->asyncq);
 	}
 
+#ifdef CONFIG_XENO_OPT_PERVASIVE
+    xnpipe_release_ring(state);
+#endif /* CONFIG_XENO_OPT_PERVASIVE */
+
+    xnlock_get_irqsave(&nklock,s);
+    xnpipe_reset_coalesce(state);
+    xnlock_put_irqrestore(&nklock,s);
+
     /* Free the state object. Since that time it can be open by
        someone else */
     xnpipe_cleanup_user_conn(state);
@@ -839,6 +1303,9 @@ static ssize_t xnpipe_write (struct file *file,
 	xnpod_schedule();
 	}
 
+    if (xnselect_signal(&state->select,1))
+	xnpod_schedule();
+
     xnlock_put_irqrestore(&nklock,s);
 
     if (input_handler != NULL)
@@ -924,6 +1391,48 @@ static int xnpipe_ioctl (struct inode *inode,
 
 	    break;
 
+	case XNPIPEIOC_SETRING:
+	    {
+	    struct xnpipe_ringinfo info;
+
+	    if (copy_from_user(&info,(void *)arg,sizeof(info)))
+		return -EFAULT;
+
+#ifdef CONFIG_XENO_OPT_PERVASIVE
+	    err = xnpipe_setup_ring(state,&info);
+#else /* !CONFIG_XENO_OPT_PERVASIVE */
+	    err = -ENOSYS;
+#endif /* CONFIG_XENO_OPT_PERVASIVE */
+
+	    if (!err && copy_to_user((void *)arg,&info,sizeof(info)))
+		return -EFAULT;
+
+	    break;
+	    }
+
+	case XNPIPEIOC_SETCOALESCE:
+	    {
+	    struct xnpipe_coalesce cinfo;
+
+	    if (copy_from_user(&cinfo,(void *)arg,sizeof(cinfo)))
+		return -EFAULT;
+
+	    err = xnpipe_set_coalesce(state,&cinfo);
+	    break;
+	    }
+
+	case XNPIPEIOC_GETSTATS:
+	    {
+	    struct xnpipe_stats stats;
+
+	    err = xnpipe_get_stats(xnminor_from_state(state),&stats);
+
+	    if (!err && copy_to_user((void *)arg,&stats,sizeof(stats)))
+		return -EFAULT;
+
+	    break;
+	    }
+
 	case TCGETS:
 	    /* For isatty() probing. */
 	    return -ENOTTY;
@@ -979,6 +1488,16 @@ static unsigned xnpipe_poll (struct file *file,
 
     if (countq(&state->outq) > 0)
 	r_mask |= (POLLIN|POLLRDNORM);
+    else if (state->ring)
+	{
+	/* Same as xnpipe_ring_put(), the tail index is untrusted. */
+	unsigned long used = state->ringhead - state->ring->tail;
+
+	if (used > state->ringsize)
+	    r_mask |= POLLERR;
+	else if (used > 0)
+	    r_mask |= (POLLIN|POLLRDNORM);
+	}
 
     if (!r_mask)
 	/* Procs which have issued a timed out poll req will remain
@@ -994,12 +1513,27 @@ static unsigned xnpipe_poll (struct file *file,
     return r_mask|w_mask;
 }
 
+static int xnpipe_mmap (struct file *file,
+			struct vm_area_struct *vma)
+{
+#ifdef CONFIG_XENO_OPT_PERVASIVE
+    xnpipe_state_t *state = (xnpipe_state_t *)file->private_data;
+
+    if (vma->vm_ops == NULL && state->ringheap != NULL)
+	return xnheap_remap_vm_area(state->ringheap,vma);
+#endif /* CONFIG_XENO_OPT_PERVASIVE */
+
+    /* XNPIPEIOC_SETRING must be issued first. */
+    return -ENXIO;
+}
+
 static struct file_operations xnpipe_fops = {
 	.owner =	THIS_MODULE,
 	.read =		xnpipe_read,
 	.write =	xnpipe_write,
 	.poll =		xnpipe_poll,
 	.ioctl =	xnpipe_ioctl,
+	.mmap =		xnpipe_mmap,
 	.open =		xnpipe_open,
 	.release =	xnpipe_release,
 	.fasync =	xnpipe_fasync
@@ -1020,9 +1554,20 @@ int xnpipe_mount (void)
 	state->asyncq = NULL;
 	initq(&state->inq);
 	initq(&state->outq);
+	xnselect_init(&state->select,0);
 	state->output_handler = NULL;
 	state->input_handler = NULL;
 	state->alloc_handler = NULL;
+	state->ring = NULL;
+	state->ringheap = NULL;
+	state->ringsize = 0;
+	state->ringhead = 0;
+	state->coalesce.bytes = 0;
+	state->coalesce.msgs = 0;
+	state->coalesce.delay = 0;
+	state->cbytes = 0;
+	state->cmsgs = 0;
+	memset(&state->stats,0,sizeof(state->stats));
 	}
 
     initq(&xnpipe_sleepq);
@@ -1066,6 +1611,10 @@ void xnpipe_umount (void)
 {
     int i;
 
+    for (i = 0; i < XNPIPE_NDEVS; i++)
+	if (testbits(xnpipe_states[i].status,XNPIPE_USER_COALESCE))
+	    xntimer_destroy(&xnpipe_states[i].ctimer);
+
     rthal_apc_free(xnpipe_wakeup_apc);
     unregister_chrdev(XNPIPE_DEV_MAJOR,"rtpipe");
 
@@ -1078,6 +1627,9 @@ void xnpipe_umount (void)
 EXPORT_SYMBOL(xnpipe_connect);
 EXPORT_SYMBOL(xnpipe_disconnect);
 EXPORT_SYMBOL(xnpipe_send);
+EXPORT_SYMBOL(xnpipe_put);
 EXPORT_SYMBOL(xnpipe_recv);
 EXPORT_SYMBOL(xnpipe_inquire);
+EXPORT_SYMBOL(xnpipe_get_select);
+EXPORT_SYMBOL(xnpipe_get_stats);
 EXPORT_SYMBOL(xnpipe_setup);
@@ -38,10 +38,15 @@
 #include <nucleus/pod.h>
 #include <nucleus/timer.h>
 #include <nucleus/synch.h>
+#include <nucleus/select.h>
 #include <nucleus/heap.h>
 #include <nucleus/intr.h>
 #include <nucleus/module.h>
 #include <nucleus/ltt.h>
+#include <nucleus/trace.h>
+#if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
+#include <nucleus/vdso.h>
+#endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
 
 /* NOTE: We need to initialize the globals: remember that this code
    also runs over user-space VMs... */
@@ -278,7 +283,7 @@ int xnpod_init (xnpod_t *pod, int minpri, int maxpri, xnflags_t flags)
     char root_name[16];
     xnsched_t *sched;
     void *heapaddr;
-    int rc, n;
+    int rc;
     spl_t s;
 
     xnlock_get_irqsave(&nklock,s);
@@ -312,8 +317,17 @@ int xnpod_init (xnpod_t *pod, int minpri, int maxpri, xnflags_t flags)
     initq(&pod->tdeleteq);
 
     for (cpu = 0; cpu < xnarch_num_online_cpus(); cpu++)
-        for (n = 0; n < XNTIMER_WHEELSIZE; n++)
-            initq(&pod->sched[cpu].timerwheel[n]);
+        {
+        xntimerq_init(&pod->sched[cpu].timerqueue);
+        xntimerq_init(&pod->sched[cpu].slackqueue);
+#ifdef CONFIG_XENO_OPT_STATS
+        pod->sched[cpu].savedshots = 0;
+        pod->sched[cpu].swtsc = xnarch_get_cpu_tsc();
+#endif /* CONFIG_XENO_OPT_STATS */
+#ifdef CONFIG_XENO_HW_PERIODIC_TIMER
+        xntimer_init_wheel(&pod->sched[cpu].timerwheel);
+#endif /* CONFIG_XENO_HW_PERIODIC_TIMER */
+        }
 
     xnarch_atomic_set(&pod->schedlck,0);
     pod->minpri = minpri;
@@ -322,6 +336,7 @@ int xnpod_init (xnpod_t *pod, int minpri, int maxpri, xnflags_t flags)
     pod->wallclock_offset = 0;
     pod->tickvalue = XNARCH_DEFAULT_TICK;
     pod->ticks2sec = 1000000000/ XNARCH_DEFAULT_TICK;
+    xnarch_init_scale(&pod->tickscale,1,XNARCH_DEFAULT_TICK);
     pod->refcnt = 0;
     xnarch_atomic_set(&pod->timerlck,0);
 
@@ -367,6 +382,8 @@ int xnpod_init (xnpod_t *pod, int minpri, int maxpri, xnflags_t flags)
         goto fail;
         }
 
+    xnheap_set_label(&kheap,"kheap");
+
     for (cpu = 0; cpu < nr_cpus; ++cpu)
         {
         sched = xnpod_sched_slot(cpu);
@@ -425,6 +442,10 @@ fail:
     
     clrbits(pod->status,XNPIDLE);
 
+#if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
+    xnshadow_update_vdso();
+#endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
+
     xnarch_notify_ready();
 
     return 0;
@@ -515,6 +536,10 @@ void xnpod_shutdown (int xtype)
 
     nkpod = NULL;
 
+#if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
+    xnshadow_update_vdso();
+#endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
+
  unlock_and_exit:
 
     xnlock_put_irqrestore(&nklock,s);
@@ -543,6 +568,98 @@ static inline void xnpod_fire_callouts (xnqueue_t *hookq, xnthread_t *thread)
     __clrbits(sched->status,XNKCOUT);
 }
 
+static inline int xnpod_edf_before (xnthread_t *t1, xnthread_t *t2)
+
+{
+    /* Returns true if the deadline of t1 is strictly earlier than
+       the one of t2. Threads without deadline come last. */
+
+    if (t1->deadline == XN_INFINITE)
+        return 0;
+
+    if (t2->deadline == XN_INFINITE)
+        return 1;
+
+    return (xnsticks_t)(t1->deadline - t2->deadline) < 0;
+}
+
+static inline int xnpod_preempts_p (xnthread_t *thread, xnthread_t *curr)
+
+{
+    /* Whether thread should preempt curr. Priority always prevails;
+       within a priority group, an EDF thread preempts another EDF
+       thread with a later deadline. */
+
+    int delta = xnpod_priocompare(thread->cprio,curr->cprio);
+
+    if (delta != 0)
+        return delta > 0;
+
+    return testbits(thread->status,XNEDF) &&
+        testbits(curr->status,XNEDF) &&
+        xnpod_edf_before(thread,curr);
+}
+
+/*! 
+ * @internal
+ * \fn void xnpod_enqueue_ready(xnsched_t *sched,xnthread_t *thread,int lifo);
+ * \brief Link a thread to the ready queue.
+ *
+ * Regular threads are queued at the end (FIFO) or front (LIFO) of
+ * their priority group. Threads undergoing EDF scheduling (XNEDF)
+ * are queued by increasing absolute deadline within their priority
+ * group, ahead of any regular thread following them; equal deadlines
+ * are ordered FIFO or LIFO as requested. EDF threads are best given
+ * a priority level of their own. Must be called with nklock locked,
+ * interrupts off.
+ */
+
+static void xnpod_enqueue_ready (xnsched_t *sched, xnthread_t *thread, int lifo)
+
+{
+    xnpholder_t *pholder;
+    xnthread_t *curr;
+
+    if (!testbits(thread->status,XNEDF))
+        {
+        if (lifo)
+            sched_insertpql(&sched->readyq,&thread->rlink,thread->cprio);
+        else
+            sched_insertpqf(&sched->readyq,&thread->rlink,thread->cprio);
+
+        return;
+        }
+
+    for (pholder = sched_findpqh(&sched->readyq,thread->cprio);
+         pholder && pholder->prio == thread->cprio;
+         pholder = sched_nextpq(&sched->readyq,pholder))
+        {
+        curr = link2thread(pholder,rlink);
+
+        if (!testbits(curr->status,XNEDF) ||
+            xnpod_edf_before(thread,curr) ||
+            (lifo && !xnpod_edf_before(curr,thread)))
+            {
+            sched_insertpq(&sched->readyq,pholder,&thread->rlink);
+            return;
+            }
+        }
+
+    sched_insertpqf(&sched->readyq,&thread->rlink,thread->cprio);
+}
+
+static inline void xnpod_requeue_ready (xnthread_t *thread)
+
+{
+    /* Re-rank a ready thread whose EDF mode or deadline changed. */
+
+    if (testbits(thread->status,XNREADY))
+        {
+        sched_removepq(&thread->sched->readyq,&thread->rlink);
+        xnpod_enqueue_ready(thread->sched,thread,0);
+        }
+}
+
 static inline void xnpod_switch_zombie (xnthread_t *threadout,
                                         xnthread_t *threadin)
 {
@@ -697,6 +814,7 @@ int xnpod_init_thread (xnthread_t *thread,
         return err;
 
     xnltt_log_event(xeno_ev_thrinit,thread->name,flags);
+    xntrace_log_thread(thread,0);
 
     xnlock_get_irqsave(&nklock,s);
     thread->sched = xnpod_current_sched();
@@ -736,6 +854,10 @@ int xnpod_init_thread (xnthread_t *thread,
  * - XNASDI disables the asynchronous signal handling for this thread.
  * See xnpod_schedule() for more on this.
  *
+ * - XNEDF causes the thread to be scheduled by earliest deadline
+ * first among the threads of its priority group undergoing the same
+ * policy. See xnpod_set_thread_mode() for more on this.
+ *
  * - XNSUSP makes the thread start in a suspended state. In such a
  * case, the thread will have to be explicitely resumed using the
  * xnpod_resume_thread() service for its execution to actually begin.
@@ -1012,6 +1134,17 @@ void xnpod_restart_thread (xnthread_t *thread)
  * enabled at configuration time; otherwise, this flag is simply
  * ignored.
  *
+ * - XNEDF causes the thread to undergo the earliest deadline first
+ * (EDF) scheduling within its priority group: ready EDF threads of
+ * the same priority level run by increasing absolute deadline, and a
+ * thread readied with an earlier deadline preempts the running one.
+ * The deadline of each job is the next release point of the thread,
+ * as defined by xnpod_set_thread_periodic(); aperiodic EDF threads
+ * have no deadline and run after the periodic ones. Priorities
+ * still prevail over deadlines, so that EDF threads gathered in a
+ * dedicated priority level coexist with fixed-priority threads
+ * above and below this level.
+ *
  * Environments:
  *
  * This service can be called from:
@@ -1058,6 +1191,9 @@ xnflags_t xnpod_set_thread_mode (xnthread_t *thread,
     if (!(oldmode & XNRRB) && testbits(thread->status,XNRRB))
         thread->rrcredit = thread->rrperiod;
 
+    if ((oldmode ^ thread->status) & XNEDF)
+        xnpod_requeue_ready(thread);
+
     xnlock_put_irqrestore(&nklock,s);
 
 #if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE) && defined(CONFIG_XENO_OPT_ISHIELD)
@@ -1146,6 +1282,11 @@ void xnpod_delete_thread (xnthread_t *thread)
 
     xntimer_stop(&thread->ptimer);
 
+#ifdef CONFIG_XENO_OPT_BUDGET
+    xntimer_stop(&thread->bgt.rtimer);
+    xntimer_stop(&thread->bgt.otimer);
+#endif /* CONFIG_XENO_OPT_BUDGET */
+
     /* Ensure the rescheduling can take place if the deleted thread is
        the running one. */
 
@@ -1158,6 +1299,15 @@ void xnpod_delete_thread (xnthread_t *thread)
     if (testbits(thread->status,XNPEND))
         xnsynch_forget_sleeper(thread);
 
+    /* The selector and its bindings usually live on the stack of the
+       deleted thread: detach them from the watched objects. */
+
+    if (thread->selector)
+        {
+        xnselector_destroy(thread->selector);
+        thread->selector = NULL;
+        }
+
     xnsynch_release_all_ownerships(thread);
 
 #ifdef CONFIG_XENO_HW_FPU
@@ -1284,6 +1434,7 @@ void xnpod_suspend_thread (xnthread_t *thread,
     xnlock_get_irqsave(&nklock,s);
 
     xnltt_log_event(xeno_ev_thrsuspend,thread->name,mask,timeout,wchan);
+    xntrace_suspend(thread,mask);
 
     sched = thread->sched;
 
@@ -1473,6 +1624,7 @@ void xnpod_resume_thread (xnthread_t *thread,
     xnlock_get_irqsave(&nklock,s);
 
     xnltt_log_event(xeno_ev_thresume,thread->name,mask);
+    xntrace_resume(thread,mask);
 
     sched = thread->sched;
 
@@ -1571,9 +1723,9 @@ void xnpod_resume_thread (xnthread_t *thread,
         }
 
     /* The readied thread is always put to the end of its priority
-       group. */
+       group, or at its deadline rank for EDF threads. */
 
-    sched_insertpqf(&sched->readyq,&thread->rlink,thread->cprio);
+    xnpod_enqueue_ready(sched,thread,0);
 
     xnsched_set_resched(sched);
 
@@ -1846,6 +1998,13 @@ int xnpod_migrate_thread (int cpu)
     /* Migrate the thread periodic timer. */
     xntimer_set_sched(&thread->ptimer, thread->sched);
 
+#ifdef CONFIG_XENO_OPT_BUDGET
+    /* Migrate the budget replenishment timer. The overrun timer is
+       stopped when the thread is switched out below, then re-armed
+       on the destination CPU when it is switched in again. */
+    xntimer_set_sched(&thread->bgt.rtimer, thread->sched);
+#endif /* CONFIG_XENO_OPT_BUDGET */
+
     /* Put thread in the ready queue of the destination CPU's scheduler. */
     xnpod_resume_thread(thread, 0);
 
@@ -2189,7 +2348,7 @@ static inline void xnpod_preempt_current_thread (xnsched_t *sched)
 {
     xnthread_t *thread = sched->runthread;
 
-    sched_insertpql(&sched->readyq,&thread->rlink,thread->cprio);
+    xnpod_enqueue_ready(sched,thread,1);
     __setbits(thread->status,XNREADY);
 
 #ifdef __XENO_SIM__
@@ -2299,6 +2458,19 @@ void xnpod_schedule (void)
     if (xnpod_callout_p() || xnpod_interrupt_p())
         return;
 
+#if defined(CONFIG_SMP) && !defined(CONFIG_XENO_OPT_DEBUG)
+    /* The rescheduling mask of a CPU is only updated by this CPU,
+       remote CPUs post their requests by IPI. If it is empty, there
+       is neither a local switch nor an IPI to perform, so most calls
+       issued after services which did not change the scheduling
+       state return without touching the nucleus lock. */
+
+    sched = xnpod_current_sched();
+
+    if (!xnsched_resched_p() && !xnthread_signaled_p(sched->runthread))
+        return;
+#endif /* CONFIG_SMP && !CONFIG_XENO_OPT_DEBUG */
+
     xnlock_get_irqsave(&nklock,s);
 
     sched = xnpod_current_sched();
@@ -2349,7 +2521,7 @@ void xnpod_schedule (void)
 
             if (head == runthread)
                 goto do_switch;
-            else if (xnpod_priocompare(head->cprio,runthread->cprio) > 0)
+            else if (xnpod_preempts_p(head,runthread))
                 {
                 if (!testbits(runthread->status,XNREADY))
                     /* Preempt the running thread */
@@ -2390,6 +2562,7 @@ void xnpod_schedule (void)
         goto signal_unlock_and_exit;
 
     xnltt_log_event(xeno_ev_switch,threadout->name,threadin->name);
+    xntrace_switch(threadout,threadin);
 
 #if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
     shadow = testbits(threadout->status,XNSHADOW);
@@ -2409,6 +2582,8 @@ void xnpod_schedule (void)
     }
 
     xnthread_inc_csw(threadin);
+    xnpod_charge_exec_time(sched,threadout);
+    xnpod_switch_budget(threadout,threadin);
 
     xnarch_switch_to(xnthread_archtcb(threadout),
                      xnthread_archtcb(threadin));
@@ -2518,7 +2693,7 @@ void xnpod_schedule_runnable (xnthread_t *thread, int flags)
             if (testbits(runthread->status,XNLOCK))
                 sched_prependpq(&sched->readyq,&runthread->rlink);
             else
-                sched_insertpql(&sched->readyq,&runthread->rlink,runthread->cprio);
+                xnpod_enqueue_ready(sched,runthread,1);
 
             __setbits(runthread->status,XNREADY);
             }
@@ -2528,12 +2703,8 @@ void xnpod_schedule_runnable (xnthread_t *thread, int flags)
            with a soon-to-be-blocked running thread as argument. */
         goto maybe_switch;
 
-    if (flags & XNPOD_SCHEDLIFO)
-        /* Insert LIFO inside priority group */
-        sched_insertpql(&sched->readyq,&thread->rlink,thread->cprio);
-    else
-        /* Insert FIFO inside priority group */
-        sched_insertpqf(&sched->readyq,&thread->rlink,thread->cprio);
+    /* Insert LIFO or FIFO inside priority group */
+    xnpod_enqueue_ready(sched,thread,flags & XNPOD_SCHEDLIFO);
 
     __setbits(thread->status,XNREADY);
 
@@ -2561,6 +2732,8 @@ maybe_switch:
     if (threadin == runthread)
         return; /* No switch. */
 
+    xntrace_switch(runthread,threadin);
+
     if (testbits(runthread->status, XNZOMBIE))
         xnpod_switch_zombie(runthread, threadin);
 
@@ -2580,6 +2753,8 @@ maybe_switch:
 #endif /* __XENO_SIM__ */
 
     xnthread_inc_csw(threadin);
+    xnpod_charge_exec_time(sched,runthread);
+    xnpod_switch_budget(runthread,threadin);
 
     xnarch_switch_to(xnthread_archtcb(runthread),
                      xnthread_archtcb(threadin));
@@ -2630,6 +2805,9 @@ void xnpod_set_time (xnticks_t newtime)
     xnltt_log_event(xeno_ev_timeset,newtime);
     nkpod->wallclock_offset += newtime - xnpod_get_time();
     setbits(nkpod->status,XNTMSET);
+#if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
+    xnshadow_update_vdso();
+#endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
     xnlock_put_irqrestore(&nklock,s);
 }
 
@@ -2664,6 +2842,59 @@ xnticks_t xnpod_get_time (void)
     return nktimer->get_jiffies() + nkpod->wallclock_offset;
 }
 
+/*! 
+ * \fn xnticks_t xnpod_get_exec_time(xnthread_t *thread);
+ * \brief Get the CPU time consumed by a thread.
+ *
+ * This service returns the accumulated execution time of a thread,
+ * including the time elapsed since it was last switched in if it is
+ * currently running. The execution time is accounted at each context
+ * switch using the CPU time-stamp counter, and is always expressed in
+ * nanoseconds, regardless of the current timer mode.
+ *
+ * @param thread The descriptor address of the thread to inquire
+ * about.
+ *
+ * @return The execution time of @a thread in nanoseconds. Zero is
+ * always returned if the statistics collection is disabled
+ * (i.e. CONFIG_XENO_OPT_STATS is unset).
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+xnticks_t xnpod_get_exec_time (xnthread_t *thread)
+
+{
+#ifdef CONFIG_XENO_OPT_STATS
+    xnticks_t exec_time;
+    xnsched_t *sched;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    sched = thread->sched;
+    exec_time = thread->stat.exec_time;
+
+    if (sched->runthread == thread)
+        exec_time += xnarch_get_cpu_tsc() - sched->swtsc;
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return xnarch_tsc_to_ns(exec_time);
+#else /* !CONFIG_XENO_OPT_STATS */
+    return 0;
+#endif /* CONFIG_XENO_OPT_STATS */
+}
+
 /*! 
  * \fn int xnpod_add_hook(int type,void (*routine)(xnthread_t *))
  * \brief Install a nucleus hook.
@@ -2997,6 +3228,7 @@ int xnpod_start_timer (u_long nstick, xnisr_t tickhandler)
         /* Pre-calculate the number of ticks per second. */
         nkpod->tickvalue = nstick;
         nkpod->ticks2sec = 1000000000 / nstick;
+        xnarch_init_scale(&nkpod->tickscale,1,nstick);
 	xntimer_set_periodic_mode();
         }
     else /* Periodic setup. */
@@ -3005,6 +3237,7 @@ int xnpod_start_timer (u_long nstick, xnisr_t tickhandler)
         clrbits(nkpod->status,XNTMPER);
         nkpod->tickvalue = 1; /* Virtually the highest precision: 1ns */
         nkpod->ticks2sec = 1000000000;
+        xnarch_init_scale(&nkpod->tickscale,1,1);
 	xntimer_set_aperiodic_mode();
         }
 
@@ -3033,6 +3266,10 @@ unlock_and_exit:
 
     setbits(nkpod->status,XNTIMED);
 
+#if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
+    xnshadow_update_vdso();
+#endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
+
 #ifdef CONFIG_XENO_OPT_WATCHDOG
     nkpod->watchdog_reload = xnarch_ns_to_tsc(4000000000LL);
     xnpod_reset_watchdog();
@@ -3113,6 +3350,9 @@ void xnpod_stop_timer (void)
            xnarch_stop_timer() called when freezing timers. In any
            case, no resource is associated with this object. */
 	xntimer_set_aperiodic_mode();
+#if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
+	xnshadow_update_vdso();
+#endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
         }
 
  unlock_and_exit:
@@ -3166,6 +3406,8 @@ int xnpod_announce_tick (xnintr_t *intr)
     if (xnarch_get_cpu_tsc() >= nkpod->watchdog_trigger) {
         if (!xnpod_root_p() && nkpod->watchdog_armed) {
             xnltt_log_event(xeno_ev_watchdog,xnpod_current_thread()->name);
+            /* Keep the history which led to the runaway. */
+            xntrace_freeze();
             xnprintf("Xenomai: watchdog triggered -- suspending runaway thread '%s'\n",
                      xnpod_current_thread()->name);
             xnpod_suspend_thread(xnpod_current_thread(),XNSUSP,XN_INFINITE,NULL);
@@ -3246,7 +3488,10 @@ int xnpod_announce_tick (xnintr_t *intr)
  * @param period The period of the thread, expressed in clock ticks
  * (see note). Passing XN_INFINITE attempts to stop the thread's
  * periodic timer; in the latter case, the routine always exits
- * succesfully, regardless of the pervious state of this timer.
+ * succesfully, regardless of the pervious state of this timer. Each
+ * job released at a periodic point must complete by the next one,
+ * which defines its deadline for the EDF scheduling (see XNEDF in
+ * xnpod_set_thread_mode()).
  *
  * @return 0 is returned upon success. Otherwise:
  *
@@ -3293,13 +3538,24 @@ int xnpod_set_thread_periodic (xnthread_t *thread,
         if (xntimer_running_p(&thread->ptimer))
             xntimer_stop(&thread->ptimer);
 
+        thread->pperiod = XN_INFINITE;
+        thread->deadline = XN_INFINITE;
+        xnpod_requeue_ready(thread);
+
         goto unlock_and_exit;
         }
 
     xntimer_set_sched(&thread->ptimer, thread->sched);
+    thread->pperiod = period;
 
     if (idate == XN_INFINITE)
+        {
+        /* The current job is released now, and must complete by the
+           next release point. */
         xntimer_start(&thread->ptimer,period,period);
+        thread->deadline = xntimer_get_date(&thread->ptimer);
+        xnpod_requeue_ready(thread);
+        }
     else
         {
         now = xnpod_get_time();
@@ -3389,7 +3645,12 @@ int xnpod_wait_thread_period (void)
 	    err = -ETIMEDOUT;
         }
     else
+        {
+        /* The next job has already been released: move on to its
+           deadline. */
+        thread->deadline += thread->pperiod;
         err = -ETIMEDOUT;
+        }
 
     thread->poverrun--;
 
@@ -3400,6 +3661,159 @@ int xnpod_wait_thread_period (void)
     return err;
 }
 
+#ifdef CONFIG_XENO_OPT_BUDGET
+
+/* Must be called with nklock held, on behalf of the CPU which
+   currently runs the thread. */
+
+void xnpod_arm_budget (xnthread_t *thread)
+
+{
+    xnsched_t *sched = thread->sched;
+    xnticks_t used, delay = 1;
+
+    used = thread->stat.exec_time + xnarch_get_cpu_tsc() - sched->swtsc;
+    used -= thread->bgt.base;
+
+    if (used < thread->bgt.quota)
+        {
+        delay = xnpod_ns2ticks(xnarch_tsc_to_ns(thread->bgt.quota - used));
+
+        if (delay == 0)
+            delay = 1;
+        }
+
+    xntimer_set_sched(&thread->bgt.otimer,sched);
+    xntimer_start(&thread->bgt.otimer,delay,XN_INFINITE);
+}
+
+/*! 
+ * \fn int xnpod_set_thread_budget(xnthread_t *thread,xnticks_t budget,xnticks_t period,int mode)
+ * \brief Set the CPU budget of a thread.
+ *
+ * Limit the CPU time a thread may consume over a recurring period.
+ * The execution time is accounted at each context switch, and a
+ * thread only consumes its budget while it is running. When the
+ * budget is exhausted before the end of the current period, the
+ * overrun counter of the thread is incremented and the action
+ * selected by @a mode is taken. The budget is replenished at the
+ * beginning of each period.
+ *
+ * Unlike the global watchdog (CONFIG_XENO_OPT_WATCHDOG), which only
+ * detects a runaway real-time activity as a whole, budgets confine
+ * a misbehaving thread without disturbing the others, so that
+ * threads with soft real-time requirements can safely share a CPU
+ * with time-critical ones.
+ *
+ * @param thread The descriptor address of the affected thread.
+ *
+ * @param budget The CPU time the thread may consume per period,
+ * expressed in clock ticks (see note). Passing zero or XN_INFINITE
+ * removes the current budget, releasing the thread if it is
+ * throttled; @a period and @a mode are ignored in this case.
+ *
+ * @param period The replenishment period, expressed in clock ticks
+ * (see note). The first period starts upon return from this call.
+ *
+ * @param mode The action taken upon budget overrun:
+ *
+ * - XNBUDGET_THROTTLE suspends the thread (XNTHROT) until the next
+ * replenishment.
+ *
+ * - XNBUDGET_NOTIFY lets the thread run, sending it SIGXCPU if it is
+ * a shadow thread. The overrun is notified once per period.
+ *
+ * @return 0 is returned upon success. Otherwise:
+ *
+ * - -EINVAL is returned if @a mode is invalid, or @a period is zero,
+ * infinite or shorter than @a budget.
+ *
+ * - -EWOULDBLOCK is returned if the system timer has not been
+ * started using xnpod_start_timer().
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: possible if a throttled thread is released.
+ *
+ * @note The overrun timer of a thread running on another CPU is
+ * only armed when the thread is next switched in; the replenishment
+ * period bounds the resulting delay.
+ *
+ * @note A thread throttled while holding a resource delays all
+ * threads waiting for it, including higher priority ones. Budgets
+ * are best applied to threads which do not share resources with
+ * time-critical ones.
+ *
+ * @note This service is sensitive to the current operation mode of
+ * the system timer, as defined by the xnpod_start_timer() service. In
+ * periodic mode, clock ticks are interpreted as periodic jiffies. In
+ * oneshot mode, clock ticks are interpreted as nanoseconds.
+ */
+
+int xnpod_set_thread_budget (xnthread_t *thread,
+                             xnticks_t budget,
+                             xnticks_t period,
+                             int mode)
+{
+    xnsched_t *sched;
+    spl_t s;
+
+    if (!testbits(nkpod->status,XNTIMED))
+        return -EWOULDBLOCK;
+
+    if (budget != 0 && budget != XN_INFINITE &&
+        ((mode != XNBUDGET_THROTTLE && mode != XNBUDGET_NOTIFY) ||
+         period == 0 || period == XN_INFINITE || period < budget))
+        return -EINVAL;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    xnltt_log_event(xeno_ev_thrbudget,thread->name,budget,period,mode);
+
+    xntimer_stop(&thread->bgt.rtimer);
+    xntimer_stop(&thread->bgt.otimer);
+
+    thread->bgt.exhausted = 0;
+
+    if (budget == 0 || budget == XN_INFINITE)
+        thread->bgt.quota = 0;
+    else
+        {
+        sched = thread->sched;
+        thread->bgt.quota = xnarch_ns_to_tsc(xnpod_ticks2ns(budget));
+        thread->bgt.mode = mode;
+        thread->bgt.overruns = 0;
+        thread->bgt.base = thread->stat.exec_time;
+
+        if (sched->runthread == thread)
+            thread->bgt.base += xnarch_get_cpu_tsc() - sched->swtsc;
+
+        xntimer_set_sched(&thread->bgt.rtimer,sched);
+        xntimer_start(&thread->bgt.rtimer,period,period);
+
+        if (thread == xnpod_current_thread())
+            xnpod_arm_budget(thread);
+        }
+
+    if (testbits(thread->status,XNTHROT))
+        {
+        xnpod_resume_thread(thread,XNTHROT);
+        xnpod_schedule();
+        }
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return 0;
+}
+
+#endif /* CONFIG_XENO_OPT_BUDGET */
+
 /*@}*/
 
 EXPORT_SYMBOL(xnpod_activate_rr);
@@ -3410,6 +3824,7 @@ EXPORT_SYMBOL(xnpod_deactivate_rr);
 EXPORT_SYMBOL(xnpod_delete_thread);
 EXPORT_SYMBOL(xnpod_fatal_helper);
 EXPORT_SYMBOL(xnpod_get_time);
+EXPORT_SYMBOL(xnpod_get_exec_time);
 EXPORT_SYMBOL(xnpod_init);
 EXPORT_SYMBOL(xnpod_init_thread);
 EXPORT_SYMBOL(xnpod_migrate_thread);
@@ -3421,6 +3836,9 @@ EXPORT_SYMBOL(xnpod_rotate_readyq);
 EXPORT_SYMBOL(xnpod_schedule);
 EXPORT_SYMBOL(xnpod_schedule_runnable);
 EXPORT_SYMBOL(xnpod_set_thread_mode);
+#ifdef CONFIG_XENO_OPT_BUDGET
+EXPORT_SYMBOL(xnpod_set_thread_budget);
+#endif /* CONFIG_XENO_OPT_BUDGET */
 EXPORT_SYMBOL(xnpod_set_thread_periodic);
 EXPORT_SYMBOL(xnpod_set_time);
 EXPORT_SYMBOL(xnpod_shutdown);
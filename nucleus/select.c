@@ -0,0 +1,481 @@
+/*!\file select.c
+ * \brief Multiple object waiting services.
+ *
+ * Copyright (C) 2026 The Xenomai project <http://www.xenomai.org>.
+ *
+ * Xenomai is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ *
+ * Xenomai is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Xenomai; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * \ingroup select
+ */
+
+/*!
+ * \ingroup nucleus
+ * \defgroup select Multiple object waiting services.
+ *
+ * Multiple object waiting services.
+ *
+ * A selector lets a single thread wait for any of a set of objects
+ * to become ready. Each waitable object embeds an xnselect_t
+ * descriptor holding its readiness state, which the object updates
+ * through xnselect_signal() whenever its condition changes (e.g. a
+ * message is queued, a semaphore count goes positive). Selectors
+ * are bound to such descriptors for the duration of a wait; the
+ * binding records whether the object currently satisfies the
+ * selector's condition, so that waking up the waiter costs a
+ * constant time regardless of the number of watched objects.
+ *
+ *@{*/
+
+#include <nucleus/pod.h>
+#include <nucleus/select.h>
+#include <nucleus/thread.h>
+#include <nucleus/module.h>
+
+static inline int xnselect_test (xnselect_binding_t *binding, u_long state)
+{
+    if (binding->mode == XNSELECT_ANY)
+	return (state & binding->mask) != 0;
+
+    return (state & binding->mask) == binding->mask;
+}
+
+/* Update a binding's ready flag, returning non-zero if the selector
+   waiter has been woken up as a result. */
+
+static int xnselect_update (xnselect_binding_t *binding, int ready)
+{
+    xnselector_t *selector = binding->selector;
+
+    if (binding->ready == ready)
+	return 0;
+
+    binding->ready = ready;
+
+    if (!ready)
+	{
+	selector->nready--;
+	return 0;
+	}
+
+    if (selector->nready++ > 0 || selector->waiter == NULL)
+	/* Already woken up by another binding, or nobody waits. */
+	return 0;
+
+    xnpod_resume_thread(selector->waiter,XNDELAY);
+    selector->waiter = NULL;
+
+    return 1;
+}
+
+/*!
+ * \fn void xnselect_init(xnselect_t *fd,u_long state);
+ * \brief Initialize the readiness state of a waitable object.
+ *
+ * @param fd The address of the descriptor embedded into the
+ * waitable object.
+ *
+ * @param state The initial readiness bits of the object.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+void xnselect_init (xnselect_t *fd, u_long state)
+
+{
+    initq(&fd->bindings);
+    fd->state = state;
+}
+
+/*!
+ * \fn int xnselect_signal(xnselect_t *fd,u_long state);
+ * \brief Update the readiness state of a waitable object.
+ *
+ * Record the new readiness bits of an object, and wake up any
+ * selector waiting for a condition which becomes satisfied as a
+ * result. This service is cheap when no selector is bound to the
+ * object, and is meant to be called from every place the owning
+ * object changes its state, with the nklock held.
+ *
+ * @param fd The address of the object's descriptor.
+ *
+ * @param state The new readiness bits of the object.
+ *
+ * @return Non-zero is returned if a selector waiter has been readied,
+ * in which case the caller should invoke xnpod_schedule() before
+ * releasing the nklock.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+int __xnselect_signal (xnselect_t *fd)
+
+{
+    xnholder_t *holder;
+    int resched = 0;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    for (holder = getheadq(&fd->bindings);
+	 holder != NULL; holder = nextq(&fd->bindings,holder))
+	{
+	xnselect_binding_t *binding = link2binding(holder);
+	resched |= xnselect_update(binding,xnselect_test(binding,fd->state));
+	}
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return resched;
+}
+
+/*!
+ * \fn int xnselect_destroy(xnselect_t *fd);
+ * \brief Detach a waitable object from all selectors.
+ *
+ * This service must be called when the object owning @a fd is
+ * deleted. Every binding to this object is detached and reported as
+ * ready, so that the selector waiters notice the deletion when
+ * operating on the object afterwards.
+ *
+ * @param fd The address of the object's descriptor.
+ *
+ * @return Non-zero is returned if a selector waiter has been readied,
+ * in which case the caller should invoke xnpod_schedule().
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+int xnselect_destroy (xnselect_t *fd)
+
+{
+    xnholder_t *holder;
+    int resched = 0;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    while ((holder = getq(&fd->bindings)) != NULL)
+	{
+	xnselect_binding_t *binding = link2binding(holder);
+	binding->fd = NULL;
+	resched |= xnselect_update(binding,1);
+	}
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return resched;
+}
+
+/*!
+ * \fn void xnselector_init(xnselector_t *selector);
+ * \brief Initialize a selector.
+ *
+ * @param selector The address of the selector descriptor, usually
+ * living on the stack of the waiting thread.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+void xnselector_init (xnselector_t *selector)
+
+{
+    selector->waiter = NULL;
+    initq(&selector->bindings);
+    selector->nready = 0;
+}
+
+/*!
+ * \fn int xnselect_bind(xnselector_t *selector,xnselect_binding_t *binding,xnselect_t *fd,u_long mask,int mode);
+ * \brief Watch a waitable object.
+ *
+ * @param selector The selector to bind.
+ *
+ * @param binding The address of a binding descriptor, which must
+ * remain valid until xnselector_destroy() is called.
+ *
+ * @param fd The descriptor of the object to watch.
+ *
+ * @param mask The readiness bits of interest.
+ *
+ * @param mode Either XNSELECT_ANY, in which case the object is ready
+ * when any bit from @a mask is set in its state, or XNSELECT_ALL,
+ * in which case all of them are required.
+ *
+ * @return 0 is returned upon success, or -EINVAL if @a mask is
+ * empty.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+int xnselect_bind (xnselector_t *selector,
+		   xnselect_binding_t *binding,
+		   xnselect_t *fd,
+		   u_long mask,
+		   int mode)
+{
+    spl_t s;
+
+    if (mask == 0)
+	return -EINVAL;
+
+    inith(&binding->link);
+    inith(&binding->slink);
+    binding->selector = selector;
+    binding->fd = fd;
+    binding->mask = mask;
+    binding->mode = mode;
+    binding->ready = 0;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    appendq(&fd->bindings,&binding->link);
+    appendq(&selector->bindings,&binding->slink);
+
+    if (xnselect_test(binding,fd->state))
+	{
+	binding->ready = 1;
+	selector->nready++;
+	}
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return 0;
+}
+
+/*!
+ * \fn int xnselector_wait(xnselector_t *selector,xnticks_t timeout);
+ * \brief Wait for any bound object to become ready.
+ *
+ * The ready flag of each binding tells the caller which objects
+ * satisfy their condition upon return.
+ *
+ * @param selector The selector to wait on.
+ *
+ * @param timeout The timeout which may be used to limit the time the
+ * thread waits. This value is a relative count of clock ticks. If
+ * XN_INFINITE is specified, the thread waits indefinitely. If
+ * XN_NONBLOCK is specified, the readiness state is only polled.
+ *
+ * @return The number of ready bindings is returned upon success,
+ * which may be zero if @a timeout is XN_NONBLOCK. Otherwise:
+ *
+ * - -ETIMEDOUT is returned if no object became ready within the
+ * specified amount of time.
+ *
+ * - -EINTR is returned if the caller was unblocked before any object
+ * became ready.
+ *
+ * - -EPERM is returned if the caller is not allowed to block.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: always unless an object is already ready or @a
+ * timeout is XN_NONBLOCK.
+ *
+ * @note This service is sensitive to the current operation mode of
+ * the system timer, as defined by the xnpod_start_timer() service. In
+ * periodic mode, clock ticks are interpreted as periodic jiffies. In
+ * oneshot mode, clock ticks are interpreted as nanoseconds.
+ */
+
+int xnselector_wait (xnselector_t *selector,
+		     xnticks_t timeout)
+{
+    xnthread_t *thread;
+    xnticks_t stime, now;
+    int ret = 0;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    if (selector->nready > 0 || timeout == XN_NONBLOCK)
+	goto done;
+
+    if (xnpod_unblockable_p())
+	{
+	ret = -EPERM;
+	goto unlock_and_exit;
+	}
+
+    thread = xnpod_current_thread();
+
+    stime = xnpod_get_time();
+
+    /* Let xnpod_delete_thread() unbind the selector, should we be
+       deleted while waiting. */
+    thread->selector = selector;
+
+    /* A readied binding may have turned idle again before we resumed
+       (e.g. a competing receiver grabbed the message), so wait until
+       the condition actually holds on return. */
+
+    while (selector->nready == 0)
+	{
+	/* The thread is put to sleep on a plain delay, which
+	   xnselect_update() cuts short when a binding becomes
+	   ready. */
+	selector->waiter = thread;
+	xnpod_suspend_thread(thread,XNDELAY,timeout,NULL);
+	selector->waiter = NULL;
+
+	if (selector->nready > 0)
+	    break;
+
+	if (xnthread_test_flags(thread,XNTIMEO))
+	    {
+	    ret = -ETIMEDOUT;
+	    break;
+	    }
+
+	if (xnthread_test_flags(thread,XNBREAK))
+	    {
+	    ret = -EINTR;
+	    break;
+	    }
+
+	if (timeout != XN_INFINITE)
+	    {
+	    now = xnpod_get_time();
+
+	    if (now - stime >= timeout)
+		{
+		ret = -ETIMEDOUT;
+		break;
+		}
+
+	    timeout -= now - stime;
+	    stime = now;
+	    }
+	}
+
+    thread->selector = NULL;
+
+    if (ret)
+	goto unlock_and_exit;
+
+ done:
+
+    ret = selector->nready;
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return ret;
+}
+
+/*!
+ * \fn void xnselector_destroy(xnselector_t *selector);
+ * \brief Release a selector.
+ *
+ * Detach all the bindings of @a selector from the objects they
+ * watch. The ready flags of the bindings are left untouched, so that
+ * the caller may still inspect them afterwards.
+ *
+ * @param selector The selector to release.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+void xnselector_destroy (xnselector_t *selector)
+
+{
+    xnselect_binding_t *binding;
+    xnholder_t *holder;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    selector->waiter = NULL;
+
+    while ((holder = getq(&selector->bindings)) != NULL)
+	{
+	binding = slink2binding(holder);
+
+	if (binding->fd)
+	    {
+	    removeq(&binding->fd->bindings,&binding->link);
+	    binding->fd = NULL;
+	    }
+	}
+
+    xnlock_put_irqrestore(&nklock,s);
+}
+
+/*@}*/
+
+EXPORT_SYMBOL(__xnselect_signal);
+EXPORT_SYMBOL(xnselect_bind);
+EXPORT_SYMBOL(xnselect_destroy);
+EXPORT_SYMBOL(xnselect_init);
+EXPORT_SYMBOL(xnselector_destroy);
+EXPORT_SYMBOL(xnselector_init);
+EXPORT_SYMBOL(xnselector_wait);
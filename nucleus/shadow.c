@@ -48,9 +48,15 @@
 #include <nucleus/shadow.h>
 #include <nucleus/core.h>
 #include <nucleus/ltt.h>
+#include <nucleus/trace.h>
+#include <nucleus/vdso.h>
 
 int nkgkptd;
 
+xnvdso_t *nkvdso;
+
+static xnheap_t vdso_heap;
+
 struct xnskentry muxtable[XENOMAI_MUX_NR];
 
 static struct __gatekeeper {
@@ -754,6 +760,7 @@ int xnshadow_map (xnthread_t *thread,
 	CAP_TO_MASK(CAP_SYS_NICE);
 
     xnarch_init_shadow_tcb(xnthread_archtcb(thread),thread,xnthread_name(thread));
+    xntrace_log_thread(thread,current->pid);
     set_linux_task_priority(current,xnthread_base_priority(thread));
     xnshadow_ptd(current) = thread;
     xnpod_suspend_thread(thread,XNRELAX,XN_INFINITE,NULL);
@@ -968,6 +975,20 @@ static int bind_to_interface (struct task_struct *curr,
 	{
 	info.cpufreq = xnarch_get_cpu_freq();
 	info.tickval = xnpod_get_tickval();
+
+	if (nkvdso)
+	    {
+	    info.vdsoheap = &vdso_heap;
+	    info.vdsosize = xnheap_size(&vdso_heap);
+	    info.vdsooff = xnheap_shared_offset(&vdso_heap,nkvdso);
+	    }
+	else
+	    {
+	    info.vdsoheap = NULL;
+	    info.vdsosize = 0;
+	    info.vdsooff = 0;
+	    }
+
 	__xn_copy_to_user(curr,(void *)infarg,&info,sizeof(info));
 	}
 
@@ -1051,6 +1072,7 @@ static inline int do_hisyscall_event (unsigned event, unsigned domid, void *data
     muxop = __xn_mux_op(regs);
 
     xnltt_log_event(xeno_ev_syscall,thread->name,muxid,muxop);
+    xntrace_sysentry(thread,muxid,muxop);
 
     if (muxid != 0)
 	goto skin_syscall;
@@ -1213,6 +1235,7 @@ static inline int do_hisyscall_event (unsigned event, unsigned domid, void *data
  done:
 
     __xn_status_return(regs,err);
+    xntrace_sysexit(thread,muxid,err);
 
     if (xnpod_shadow_p() && signal_pending(p))
 	request_syscall_restart(thread,regs);
@@ -1310,6 +1333,7 @@ static inline int do_losyscall_event (unsigned event, unsigned domid, void *data
 		    nkpod ? xnpod_current_thread()->name : "<system>",
 		    muxid,
 		    muxop);
+    xntrace_sysentry(xnshadow_thread(current),muxid,muxop);
 
     if (muxid == 0)
 	{
@@ -1361,6 +1385,7 @@ static inline int do_losyscall_event (unsigned event, unsigned domid, void *data
 	}
 
     __xn_status_return(regs,err);
+    xntrace_sysexit(xnshadow_thread(current),muxid,err);
 
     if (xnpod_shadow_p() && signal_pending(current))
 	request_syscall_restart(xnshadow_thread(current),regs);
@@ -1696,10 +1721,89 @@ void xnshadow_release_events (void)
     rthal_catch_setsched(NULL);
 }
 
+/*
+ * Shared time page. See <nucleus/vdso.h>.
+ */
+
+void xnshadow_update_vdso (void)
+
+{
+    xnvdso_t *vdso = nkvdso;
+    spl_t s;
+
+    if (!vdso)
+	return;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    vdso->seq++;
+    xnarch_memory_barrier();
+
+    if (nkpod && !testbits(nkpod->status,XNPIDLE))
+	{
+	vdso->flags = XNVDSO_POD;
+
+	if (testbits(nkpod->status,XNTMPER))
+	    vdso->flags |= XNVDSO_PERIODIC;
+
+	vdso->tickval = xnpod_get_tickval();
+	vdso->wallclock_offset = nkpod->wallclock_offset;
+	}
+    else
+	vdso->flags = 0;
+
+    xnarch_memory_barrier();
+    vdso->seq++;
+
+    xnlock_put_irqrestore(&nklock,s);
+}
+
+static int __init xnshadow_mount_vdso (void)
+
+{
+    xnvdso_t *vdso;
+    int err;
+
+    /* A shared heap cannot be smaller than three pages. */
+    err = xnheap_init_shared(&vdso_heap,PAGE_SIZE * 3,0);
+
+    if (err)
+	return err;
+
+    xnheap_set_label(&vdso_heap,"vdso");
+    xnheap_set_rdonly(&vdso_heap);
+
+    vdso = (xnvdso_t *)xnheap_alloc(&vdso_heap,sizeof(*vdso));
+
+    if (!vdso)
+	{
+	xnheap_destroy_shared(&vdso_heap);
+	return -ENOMEM;
+	}
+
+    memset(vdso,0,sizeof(*vdso));
+    vdso->magic = XNVDSO_MAGIC;
+    vdso->cpufreq = xnarch_get_cpu_freq();
+    /* The conversion ratios are set during calibration, which
+       happens before we get there, and never change afterwards. */
+    vdso->tsc2ns = xnarch_tsc2ns_scale;
+    vdso->ns2tsc = xnarch_ns2tsc_scale;
+    nkvdso = vdso;
+
+    xnshadow_update_vdso();
+
+    return 0;
+}
+
 int __init xnshadow_mount (void)
 
 {
-    int cpu;
+    int cpu, err;
+
+    err = xnshadow_mount_vdso();
+
+    if (err)
+	return err;
 
 #ifdef CONFIG_XENO_OPT_ISHIELD
     if (rthal_register_domain(&irq_shield,
@@ -1707,7 +1811,11 @@ int __init xnshadow_mount (void)
 			      0x53484c44,
 			      RTHAL_ROOT_PRIO + 50,
 			      &shield_domain_entry))
+	{
+	nkvdso = NULL;
+	xnheap_destroy_shared(&vdso_heap);
 	return -EBUSY;
+	}
 
     shielded_cpus = CPU_MASK_NONE;
     unshielded_cpus = xnarch_cpu_online_map;
@@ -1752,6 +1860,9 @@ void __exit xnshadow_cleanup (void)
 #ifdef CONFIG_XENO_OPT_ISHIELD
     rthal_unregister_domain(&irq_shield);
 #endif /* CONFIG_XENO_OPT_ISHIELD */
+
+    nkvdso = NULL;
+    xnheap_destroy_shared(&vdso_heap);
 }
 
 /*@}*/
@@ -1767,3 +1878,5 @@ EXPORT_SYMBOL(xnshadow_unregister_interface);
 EXPORT_SYMBOL(xnshadow_wait_barrier);
 EXPORT_SYMBOL(xnshadow_suspend);
 EXPORT_SYMBOL(nkgkptd);
+EXPORT_SYMBOL(nkvdso);
+EXPORT_SYMBOL(xnshadow_update_vdso);
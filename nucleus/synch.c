@@ -65,6 +65,15 @@
  * threads using this object. Otherwise, no priority inheritance takes
  * place upon priority inversion (XNSYNCH_NOPIP).
  *
+ * - XNSYNCH_PCP enables the immediate priority ceiling protocol:
+ * the owner of the object is raised to the object's ceiling priority
+ * as soon as it acquires it, and restored when it releases it. No
+ * priority inheritance chain is walked when threads contend for the
+ * object. XNSYNCH_PCP overrides XNSYNCH_PIP. The ceiling defaults to
+ * the highest priority level, and can be changed using
+ * xnsynch_set_ceiling(). Ownership of such object must be granted
+ * through xnsynch_set_owner() or one of the wakeup services.
+ *
  * Environments:
  *
  * This service can be called from:
@@ -81,12 +90,16 @@ void xnsynch_init (xnsynch_t *synch,
 {
     initph(&synch->link);
 
-    if (flags & XNSYNCH_PIP)
+    if (flags & XNSYNCH_PCP)
+	flags &= ~XNSYNCH_PIP;
+
+    if (flags & (XNSYNCH_PIP|XNSYNCH_PCP))
 	flags |= XNSYNCH_PRIO;	/* Obviously... */
 
     synch->status = flags;
     synch->owner = NULL;
-    initpq(&synch->pendq,xnpod_get_qdir(nkpod),xnpod_get_maxprio(nkpod,0));
+    synch->ceiling = xnpod_get_maxprio(nkpod,0);
+    synch_initpq(&synch->pendq,xnpod_get_qdir(nkpod),xnpod_get_maxprio(nkpod,0));
     xnarch_init_display_context(synch);
 }
 
@@ -165,7 +178,7 @@ void xnsynch_sleep_on (xnsynch_t *synch,
 	{
 	xnthread_t *owner = synch->owner;
 
-	insertpqf(&synch->pendq,&thread->plink,thread->cprio);
+	synch_insertpqf(&synch->pendq,&thread->plink,thread->cprio);
 
 	if (testbits(synch->status,XNSYNCH_PIP) &&
 	    owner != NULL &&
@@ -188,7 +201,7 @@ void xnsynch_sleep_on (xnsynch_t *synch,
 	    }
 	}
     else /* otherwise FIFO */
-	appendpq(&synch->pendq,&thread->plink);
+	synch_appendpq(&synch->pendq,&thread->plink);
 
     xnpod_suspend_thread(thread,XNPEND,timeout,synch);
 
@@ -254,10 +267,11 @@ void xnsynch_renice_sleeper (xnthread_t *thread)
 	{
 	xnthread_t *owner = synch->owner;
 
-	removepq(&synch->pendq,&thread->plink);
-	insertpqf(&synch->pendq,&thread->plink,thread->cprio);
+	synch_removepq(&synch->pendq,&thread->plink);
+	synch_insertpqf(&synch->pendq,&thread->plink,thread->cprio);
 
-	if (testbits(synch->status,XNSYNCH_CLAIMED) &&
+	if (testbits(synch->status,XNSYNCH_PIP) &&
+	    testbits(synch->status,XNSYNCH_CLAIMED) &&
 	    xnpod_priocompare(thread->cprio,owner->cprio) > 0)
 	    {
 	    removepq(&owner->claimq,&synch->link);
@@ -267,6 +281,129 @@ void xnsynch_renice_sleeper (xnthread_t *thread)
 	}
 }
 
+/*
+ * xnsynch_raise_to_ceiling() -- Register a PCP object as claimed by
+ * its new owner, raising the latter to the object's ceiling if
+ * needed. The claim queue of the owner holds the PCP objects it owns
+ * along with the PIP objects it is boosted by, so that
+ * xnsynch_clear_boost() always restores the proper priority, whatever
+ * the release order. The owner is marked as boosted even if its
+ * current priority already exceeds the ceiling, since the claim queue
+ * is not empty anymore: xnsynch_clear_boost() clears XNBOOST only
+ * when it drains, and xnpod_renice_thread() must not lower the owner
+ * below the ceiling meanwhile.
+ */
+
+static void xnsynch_raise_to_ceiling (xnsynch_t *synch,
+				      xnthread_t *owner)
+{
+    insertpqf(&owner->claimq,&synch->link,synch->ceiling);
+    setbits(synch->status,XNSYNCH_CLAIMED);
+
+    if (!testbits(owner->status,XNBOOST))
+	{
+	owner->bprio = owner->cprio;
+	setbits(owner->status,XNBOOST);
+	}
+
+    if (xnpod_priocompare(synch->ceiling,owner->cprio) > 0)
+	xnsynch_renice_thread(owner,synch->ceiling);
+}
+
+/*! 
+ * \fn void xnsynch_set_pcp_owner(xnsynch_t *synch, xnthread_t *thread);
+ * \brief Grant ownership of a priority ceiling object.
+ *
+ * This service is called by xnsynch_set_owner() for objects created
+ * with the XNSYNCH_PCP flag. The previous owner, if any, is restored
+ * to the priority it would have without holding the object, then the
+ * new owner is raised to the object's ceiling if its current priority
+ * is lower.
+ *
+ * @param synch The descriptor address of the synchronization object.
+ *
+ * @param thread The descriptor address of the new owner, or NULL to
+ * leave the object unowned.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+void xnsynch_set_pcp_owner (xnsynch_t *synch,
+			    xnthread_t *thread)
+{
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    if (synch->owner != thread)
+	{
+	if (testbits(synch->status,XNSYNCH_CLAIMED))
+	    xnsynch_clear_boost(synch,synch->owner);
+
+	synch->owner = thread;
+
+	if (thread)
+	    xnsynch_raise_to_ceiling(synch,thread);
+	}
+
+    xnlock_put_irqrestore(&nklock,s);
+}
+
+/*! 
+ * \fn void xnsynch_set_ceiling(xnsynch_t *synch, int prio);
+ * \brief Change the priority ceiling of a synchronization object.
+ *
+ * Sets the priority the owner of an object created with the
+ * XNSYNCH_PCP flag is raised to while holding it. If the object is
+ * currently owned, the new ceiling applies immediately.
+ *
+ * @param synch The descriptor address of the synchronization object.
+ *
+ * @param prio The new ceiling priority. It must be a valid priority
+ * level for the current pod.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+void xnsynch_set_ceiling (xnsynch_t *synch,
+			  int prio)
+{
+    xnthread_t *owner;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    synch->ceiling = prio;
+    owner = synch->owner;
+
+    if (testbits(synch->status,XNSYNCH_PCP) &&
+	testbits(synch->status,XNSYNCH_CLAIMED))
+	{
+	xnsynch_clear_boost(synch,owner);
+	xnsynch_raise_to_ceiling(synch,owner);
+	}
+
+    xnlock_put_irqrestore(&nklock,s);
+}
+
 /*! 
  * \fn xnthread_t *xnsynch_wakeup_one_sleeper(xnsynch_t *synch);
  * \brief Give the resource ownership to the next waiting thread.
@@ -291,7 +428,8 @@ void xnsynch_renice_sleeper (xnthread_t *thread)
  * inheritance boost being cleared.
  *
  * - The synchronization object ownership is transfered to the
- * unblocked thread.
+ * unblocked thread. If the object enforces the priority ceiling
+ * protocol, the new owner is raised to the object's ceiling.
  *
  * Environments:
  *
@@ -314,7 +452,7 @@ xnthread_t *xnsynch_wakeup_one_sleeper (xnsynch_t *synch)
 
     xnlock_get_irqsave(&nklock,s);
 
-    holder = getpq(&synch->pendq);
+    holder = synch_getpq(&synch->pendq);
 
     if (holder)
 	{
@@ -330,9 +468,12 @@ xnthread_t *xnsynch_wakeup_one_sleeper (xnsynch_t *synch)
     if (testbits(synch->status,XNSYNCH_CLAIMED))
 	xnsynch_clear_boost(synch,lastowner);
 
+    if (thread && testbits(synch->status,XNSYNCH_PCP))
+	xnsynch_raise_to_ceiling(synch,thread);
+
     xnlock_put_irqrestore(&nklock,s);
 
-    xnarch_post_graph_if(synch,0,countpq(&synch->pendq) == 0);
+    xnarch_post_graph_if(synch,0,synch_countpq(&synch->pendq) == 0);
 
     return thread;
 }
@@ -366,7 +507,8 @@ xnthread_t *xnsynch_wakeup_one_sleeper (xnsynch_t *synch)
  * inheritance boost being cleared.
  *
  * - The synchronization object ownership is transfered to the
- * unblocked thread.
+ * unblocked thread. If the object enforces the priority ceiling
+ * protocol, the new owner is raised to the object's ceiling.
  *
  * Environments:
  *
@@ -389,7 +531,7 @@ xnpholder_t *xnsynch_wakeup_this_sleeper (xnsynch_t *synch,
 
     xnlock_get_irqsave(&nklock,s);
 
-    nholder = poppq(&synch->pendq,holder);
+    nholder = synch_poppq(&synch->pendq,holder);
     thread = link2thread(holder,plink);
     thread->wchan = NULL;
     synch->owner = thread;
@@ -399,9 +541,12 @@ xnpholder_t *xnsynch_wakeup_this_sleeper (xnsynch_t *synch,
     if (testbits(synch->status,XNSYNCH_CLAIMED))
 	xnsynch_clear_boost(synch,lastowner);
 
+    if (testbits(synch->status,XNSYNCH_PCP))
+	xnsynch_raise_to_ceiling(synch,thread);
+
     xnlock_put_irqrestore(&nklock,s);
 
-    xnarch_post_graph_if(synch,0,countpq(&synch->pendq) == 0);
+    xnarch_post_graph_if(synch,0,synch_countpq(&synch->pendq) == 0);
 
     return nholder;
 }
@@ -466,9 +611,9 @@ int xnsynch_flush (xnsynch_t *synch, xnflags_t reason)
 
     xnltt_log_event(xeno_ev_syncflush,synch,reason);
 
-    status = countpq(&synch->pendq) > 0 ? XNSYNCH_RESCHED : XNSYNCH_DONE;
+    status = synch_countpq(&synch->pendq) > 0 ? XNSYNCH_RESCHED : XNSYNCH_DONE;
 
-    while ((holder = getpq(&synch->pendq)) != NULL)
+    while ((holder = synch_getpq(&synch->pendq)) != NULL)
 	{
 	xnthread_t *sleeper = link2thread(holder,plink);
 	setbits(sleeper->status,reason);
@@ -486,7 +631,7 @@ int xnsynch_flush (xnsynch_t *synch, xnflags_t reason)
 
     xnlock_put_irqrestore(&nklock,s);
 
-    xnarch_post_graph_if(synch,0,countpq(&synch->pendq) == 0);
+    xnarch_post_graph_if(synch,0,synch_countpq(&synch->pendq) == 0);
 
     return status;
 }
@@ -517,18 +662,19 @@ void xnsynch_forget_sleeper (xnthread_t *thread)
 
     clrbits(thread->status,XNPEND);
     thread->wchan = NULL;
-    removepq(&synch->pendq,&thread->plink);
+    synch_removepq(&synch->pendq,&thread->plink);
 
-    if (testbits(synch->status,XNSYNCH_CLAIMED))
+    if (testbits(synch->status,XNSYNCH_PIP) &&
+	testbits(synch->status,XNSYNCH_CLAIMED))
 	{
 	/* Find the highest priority needed to enforce the PIP. */
 	xnthread_t *owner = synch->owner;
 	int rprio;
 
-	if (countpq(&synch->pendq) == 0)
+	if (synch_countpq(&synch->pendq) == 0)
 	    /* No more sleepers: clear the boost. */
 	    xnsynch_clear_boost(synch,owner);
-	else if (getheadpq(&synch->pendq)->prio !=
+	else if (synch_getheadpq(&synch->pendq)->prio !=
 		getheadpq(&owner->claimq)->prio)
 		{
 		/* Reorder the claim queue, and lower the priority to the
@@ -538,7 +684,7 @@ void xnsynch_forget_sleeper (xnthread_t *thread)
 
 		insertpqf(&owner->claimq,
 			  &synch->link,
-			  getheadpq(&synch->pendq)->prio);
+			  synch_getheadpq(&synch->pendq)->prio);
 
 		rprio = getheadpq(&owner->claimq)->prio;
 
@@ -547,7 +693,7 @@ void xnsynch_forget_sleeper (xnthread_t *thread)
 		}
 	}
 
-    xnarch_post_graph_if(synch,0,countpq(&synch->pendq) == 0);
+    xnarch_post_graph_if(synch,0,synch_countpq(&synch->pendq) == 0);
 }
 
 /*! 
@@ -584,6 +730,8 @@ EXPORT_SYMBOL(xnsynch_forget_sleeper);
 EXPORT_SYMBOL(xnsynch_init);
 EXPORT_SYMBOL(xnsynch_release_all_ownerships);
 EXPORT_SYMBOL(xnsynch_renice_sleeper);
+EXPORT_SYMBOL(xnsynch_set_ceiling);
+EXPORT_SYMBOL(xnsynch_set_pcp_owner);
 EXPORT_SYMBOL(xnsynch_sleep_on);
 EXPORT_SYMBOL(xnsynch_wakeup_one_sleeper);
 EXPORT_SYMBOL(xnsynch_wakeup_this_sleeper);
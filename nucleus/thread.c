@@ -24,6 +24,7 @@
 #include <nucleus/heap.h>
 #include <nucleus/thread.h>
 #include <nucleus/module.h>
+#include <nucleus/ltt.h>
 
 static void xnthread_timeout_handler (void *cookie)
 
@@ -41,9 +42,74 @@ static void xnthread_periodic_handler (void *cookie)
     thread->poverrun++;
 
     if (xnthread_test_flags(thread,XNDELAY)) /* Prevent unwanted round-robin. */
+	{
+	/* A new job is released; its deadline is the next release
+	   point. Must be set before the thread is readied, since EDF
+	   threads are queued by deadline. */
+	thread->deadline = xntimer_get_date(&thread->ptimer) + thread->pperiod;
 	xnpod_resume_thread(thread,XNDELAY);
+	}
+}
+
+#ifdef CONFIG_XENO_OPT_BUDGET
+
+static void xnthread_replenish_handler (void *cookie)
+
+{
+    xnthread_t *thread = (xnthread_t *)cookie;
+    xnsched_t *sched = thread->sched;
+
+    /* Start a new budget period: only the execution time consumed
+       from now on will be charged against the thread's quota. */
+
+    thread->bgt.base = thread->stat.exec_time;
+    thread->bgt.exhausted = 0;
+
+    if (sched->runthread == thread)
+	thread->bgt.base += xnarch_get_cpu_tsc() - sched->swtsc;
+
+    if (xnthread_test_flags(thread,XNTHROT))
+	xnpod_resume_thread(thread,XNTHROT);
+
+    if (sched->runthread == thread)
+	xnpod_arm_budget(thread);
 }
 
+static void xnthread_overrun_handler (void *cookie)
+
+{
+    xnthread_t *thread = (xnthread_t *)cookie;
+
+    /* The overrun timer is only armed while the thread is running,
+       so we are preempting it right now. */
+
+#if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
+    /* A kicked shadow is about to relax, which will stop the budget
+       accounting anyway; let it go. */
+    if (xnthread_test_flags(thread,XNKICKED))
+	return;
+#endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
+
+    thread->bgt.overruns++;
+    thread->bgt.exhausted = 1;
+
+    xnltt_log_event(xeno_ev_budgetovr,thread->name,thread->bgt.overruns);
+
+    if (thread->bgt.mode == XNBUDGET_THROTTLE)
+	{
+	/* A thread which locked the scheduler cannot be suspended;
+	   the overrun is only accounted for in such a case. */
+	if (!xnthread_test_flags(thread,XNLOCK))
+	    xnpod_suspend_thread(thread,XNTHROT,XN_INFINITE,NULL);
+	}
+#if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
+    else if (xnthread_test_flags(thread,XNSHADOW))
+	xnshadow_send_sig(thread,SIGXCPU);
+#endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
+}
+
+#endif /* CONFIG_XENO_OPT_BUDGET */
+
 int xnthread_init (xnthread_t *thread,
 		   const char *name,
 		   int prio,
@@ -57,6 +123,20 @@ int xnthread_init (xnthread_t *thread,
     xntimer_init(&thread->ptimer,&xnthread_periodic_handler,thread);
     xntimer_set_priority(&thread->ptimer,XNTIMER_HIPRIO);
     thread->poverrun = -1;
+    thread->pperiod = XN_INFINITE;
+    thread->deadline = XN_INFINITE;
+
+#ifdef CONFIG_XENO_OPT_BUDGET
+    xntimer_init(&thread->bgt.rtimer,&xnthread_replenish_handler,thread);
+    xntimer_set_priority(&thread->bgt.rtimer,XNTIMER_HIPRIO);
+    xntimer_init(&thread->bgt.otimer,&xnthread_overrun_handler,thread);
+    xntimer_set_priority(&thread->bgt.otimer,XNTIMER_HIPRIO);
+    thread->bgt.quota = 0;
+    thread->bgt.base = 0;
+    thread->bgt.overruns = 0;
+    thread->bgt.exhausted = 0;
+    thread->bgt.mode = XNBUDGET_THROTTLE;
+#endif /* CONFIG_XENO_OPT_BUDGET */
 
     /* Setup the TCB. */
 
@@ -86,6 +166,7 @@ int xnthread_init (xnthread_t *thread,
     thread->rrperiod = XN_INFINITE;
     thread->rrcredit = XN_INFINITE;
     thread->wchan = NULL;
+    thread->selector = NULL;
     thread->magic = 0;
 
 #ifdef CONFIG_XENO_OPT_STATS
@@ -93,6 +174,7 @@ int xnthread_init (xnthread_t *thread,
     thread->stat.ssw = 0;
     thread->stat.csw = 0;
     thread->stat.pf = 0;
+    thread->stat.exec_time = 0;
 #endif /* CONFIG_XENO_OPT_STATS */
 
     /* These will be filled by xnpod_start_thread() */
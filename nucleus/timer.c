@@ -28,25 +28,42 @@
  * depending on the underlying system timer mode, i.e. periodic or
  * aperiodic. In periodic mode, the hardware timer ticks periodically
  * without any external programming (aside of the initial one which
- * sets its period). In such a case, a BSD timer wheel (see
- * "Redesigning the BSD Callout and Timer Facilities" by Adam
- * M. Costello and George Varghese) is used to its full addressing
- * capabilities.
+ * sets its period). In such a case, a hierarchical timer wheel (see
+ * "Hashed and Hierarchical Timing Wheels" by George Varghese and
+ * Tony Lauck) is used: a root level addresses the next
+ * XNTIMER_WHEEL_ROOTSIZE jiffies with one slot per jiffy, and outer
+ * levels with coarser slots hold the farther timers, which are
+ * cascaded to the inner levels as time elapses. This way, each tick
+ * only scans the timers which actually elapse.
  * 
  * If the underlying timer source is aperiodic, we need to reprogram
  * the next shot after each tick at hardware level, and we do not need
- * any periodic source. In such a case, the timer manager only uses a
- * single slot (#0) from the wheel as a plain linked list, which is
- * ordered by increasing timeout values of the running timers.
+ * any periodic source. In such a case, the timer manager uses a
+ * single per-CPU queue which is ordered by increasing timeout values
+ * of the running timers.
  *
  * Depending on the above mode, the timer object stores time values
  * either as count of periodic ticks, or as count of CPU ticks.
  *
- * The current implementation assumes that the maximum number of
- * outstanding timers in aperiodic mode is low (< 16?). Would this
- * assumption prove false, we would need to go for an AVL of some
- * sort, likely a RB tree. The periodic mode is already based on a
- * timer wheel, so there should not be any problem here, unless your
+ * In aperiodic mode, timers may be given some slack, i.e. an amount
+ * of lateness they tolerate (see xntimer_set_slack()). A timer is
+ * queued by its latest acceptable date, so that the next hardware
+ * shot is programmed for the earliest of those dates; then, each
+ * tick elapses all the timers which have reached their nominal
+ * timeout date so far. Since a timer with a large slack may be
+ * queued behind timers which are not due yet, timers with slack are
+ * also linked to a second per-CPU queue ordered by nominal date,
+ * which the tick scans as well. This way, timers with overlapping
+ * slack windows are processed by a single interrupt, instead of
+ * requiring one hardware shot each.
+ *
+ * By default, the aperiodic queue is a plain sorted list, which
+ * assumes that the maximum number of outstanding timers is low (<
+ * 16?). Systems running a larger number of timers should enable
+ * CONFIG_XENO_OPT_TIMER_RBTREE, which turns this queue into a
+ * red-black tree, so that inserting and removing a timer runs in
+ * O(log N) instead of O(N). The periodic mode is already based on a timer
+ * wheel, so there should not be any problem here, unless your
  * application is some ugly monster from the dark ages...
  *
  *@{*/
@@ -56,60 +73,77 @@
 #include <nucleus/pod.h>
 #include <nucleus/thread.h>
 #include <nucleus/timer.h>
+#include <nucleus/trace.h>
 
 static inline void xntimer_enqueue_aperiodic (xntimer_t *timer)
 
 {
-    xnqueue_t *q = &timer->sched->timerwheel[0];
-    xnholder_t *p;
+    xnticks_t xdate = timer->date;
 
-    /* Insert the new timer at the proper place in the single
-       queue managed when running in aperiodic mode. O(N) here,
-       but users of the aperiodic mode need to pay a price for
-       the increased flexibility... */
+    /* Timers are queued by latest acceptable expiry date, i.e. the
+       timeout date plus the slack the timer tolerates. Timers with
+       slack are also queued by timeout date, so that the tick finds
+       them as soon as they are due. */
+
+    if (timer->slack)
+	{
+	xdate += xnarch_ns_to_tsc(timer->slack);
+	xntimerq_insert(&timer->sched->slackqueue,
+			&timer->sllink,
+			timer->date,
+			timer->prio);
+	__setbits(timer->status,XNTIMER_SLACKQ);
+	}
+
+    /* Insert the new timer at the proper place in the single queue
+       managed when running in aperiodic mode. O(log N) if
+       CONFIG_XENO_OPT_TIMER_RBTREE is set, O(N) otherwise. */
+
+    xntimerq_insert(&timer->sched->timerqueue,
+		    &timer->aplink,
+		    xdate,
+		    timer->prio);
 
-    for (p = q->head.last; p != &q->head; p = p->last)
-        if (timer->date > link2timer(p)->date ||
-            (timer->date == link2timer(p)->date &&
-             timer->prio <= link2timer(p)->prio))
-            break;
-        
-    insertq(q,p->next,&timer->link);
     __clrbits(timer->status,XNTIMER_DEQUEUED);
 }
 
 static inline void xntimer_dequeue_aperiodic (xntimer_t *timer)
 
 {
-    removeq(&timer->sched->timerwheel[0],&timer->link);
+    xntimerq_remove(&timer->sched->timerqueue,&timer->aplink);
+
+    if (testbits(timer->status,XNTIMER_SLACKQ))
+	{
+	xntimerq_remove(&timer->sched->slackqueue,&timer->sllink);
+	__clrbits(timer->status,XNTIMER_SLACKQ);
+	}
+
     __setbits(timer->status,XNTIMER_DEQUEUED);
 }
 
 static inline void xntimer_next_local_shot (xnsched_t *this_sched)
 
 {
-    xnholder_t *holder = getheadq(&this_sched->timerwheel[0]);
+    xntimerh_t *holder = xntimerq_head(&this_sched->timerqueue);
     xnticks_t now, delay, xdate;
-    xntimer_t *timer;
 
     if (!holder)
         return; /* No pending timer. */
 
-    timer = link2timer(holder);
     now = xnarch_get_cpu_tsc();
     xdate = now + nkschedlat + nktimerlat;
 
-    if (xdate >= timer->date)
+    if (xdate >= xntimerh_date(holder))
         delay = 0;
     else
-        delay = timer->date - xdate;
+        delay = xntimerh_date(holder) - xdate;
 
     xnarch_program_timer_shot(delay <= ULONG_MAX ? delay : ULONG_MAX);
 }
 
 static inline int xntimer_heading_p (xntimer_t *timer)
 {
-    return getheadq(&timer->sched->timerwheel[0]) == &timer->link;
+    return xntimerq_head(&timer->sched->timerqueue) == &timer->aplink;
 }
         
 static inline void xntimer_next_remote_shot (xnsched_t *sched)
@@ -193,6 +227,38 @@ static const char *xntimer_get_type_aperiodic (void)
     return "oneshot";
 }
 
+/* Return the next timer which has reached its timeout date, if
+   any. The head of the main queue bears the earliest latest
+   acceptable date; if it is not due, no timer without slack can be,
+   so only the earliest timer of the slack queue remains to be
+   checked. */
+
+static inline xntimer_t *xntimer_next_due (xnsched_t *sched, xnticks_t now)
+
+{
+    xntimerh_t *holder;
+    xntimer_t *timer;
+
+    holder = xntimerq_head(&sched->timerqueue);
+
+    if (!holder)
+	return NULL;
+
+    timer = aplink2timer(holder);
+
+    if (timer->date - nkschedlat <= now)
+	return timer;
+
+    holder = xntimerq_head(&sched->slackqueue);
+
+    if (!holder)
+	return NULL;
+
+    timer = sllink2timer(holder);
+
+    return timer->date - nkschedlat <= now ? timer : NULL;
+}
+
 /*!
  * @internal
  * \fn void xntimer_do_tick_aperiodic(void)
@@ -201,7 +267,9 @@ static const char *xntimer_get_type_aperiodic (void)
  *
  * This routine informs all active timers that the clock has been
  * updated by processing the outstanding timer list. Elapsed timer
- * actions will be fired.
+ * actions will be fired. All the timers which have reached their
+ * timeout date are elapsed, including those queued behind timers
+ * which are not due yet because of their slack.
  *
  * Environments:
  *
@@ -218,28 +286,41 @@ void xntimer_do_tick_aperiodic (void)
 
 {
     xnsched_t *sched = xnpod_current_sched();
-    xnqueue_t *timerq = &sched->timerwheel[0];
-    xnholder_t *nextholder, *holder;
     xntimer_t *timer;
+    xnticks_t now;
+#ifdef CONFIG_XENO_OPT_STATS
+    xnticks_t lastsaved = XN_INFINITE, xdate;
+#endif /* CONFIG_XENO_OPT_STATS */
 
-    nextholder = getheadq(timerq);
-
-    while ((holder = nextholder) != NULL)
+    for (;;)
         {
-        nextholder = nextq(timerq,holder);
-        timer = link2timer(holder);
+	now = xnarch_get_cpu_tsc();
+	timer = xntimer_next_due(sched,now);
 
-	if (timer->date - nkschedlat > xnarch_get_cpu_tsc())
-	    /* No need to continue in aperiodic mode since timeout
-	       dates are ordered by increasing values. */
+	if (!timer)
+	    /* The next shot will be programmed for the earliest latest
+	       expiry date at worst. */
 	    break;
 
+#ifdef CONFIG_XENO_OPT_STATS
+	xdate = xntimerh_date(&timer->aplink);
+
+	if (xdate - nkschedlat > now && xdate != lastsaved)
+	    {
+	    /* Without slack, this timer would have required its own
+	       shot. */
+	    lastsaved = xdate;
+	    sched->savedshots++;
+	    }
+#endif /* CONFIG_XENO_OPT_STATS */
+
 	xntimer_dequeue_aperiodic(timer);
 
         if (timer != &nkpod->htimer)
 	    {
 	    if (!testbits(nkpod->status,XNTLOCK))
 		{
+		xntrace_timer(timer);
 		timer->handler(timer->cookie);
 
 		if (timer->interval == XN_INFINITE ||
@@ -287,20 +368,96 @@ void xntimer_set_remote_aperiodic (xntimer_t *timer)
 static inline void xntimer_enqueue_periodic (xntimer_t *timer)
 
 {
-    xnsched_t *sched = timer->sched;
-    /* Just prepend the new timer to the proper slot. */
-    prependq(&sched->timerwheel[timer->date & XNTIMER_WHEELMASK],&timer->link);
+    xntwheel_t *wheel = &timer->sched->timerwheel;
+    xnticks_t date = timer->date;
+    xnsticks_t delta = date - wheel->base;
+    int level, shift;
+    xnqueue_t *q;
+
+    /* Pick the innermost wheel level which can address the timeout
+       date, then hash the latter into the proper slot. O(1). */
+
+    if (delta < XNTIMER_WHEEL_ROOTSIZE)
+	{
+	if (delta < 0)
+	    /* Already elapsed: fire at the next tick. */
+	    date = wheel->base;
+
+	level = 0;
+	q = xntwheel_root(wheel,date & XNTIMER_WHEEL_ROOTMASK);
+	}
+    else
+	{
+	if ((xnticks_t)delta > XNTIMER_WHEEL_MAXDELTA)
+	    /* Out of range: park the timer in the farthest slot. */
+	    date = wheel->base + XNTIMER_WHEEL_MAXDELTA;
+
+	shift = XNTIMER_WHEEL_ROOTBITS;
+
+	for (level = 1; level < XNTIMER_WHEEL_LEVELS; level++)
+	    {
+	    if ((xnticks_t)delta < 1ULL << (shift + XNTIMER_WHEEL_LEVELBITS))
+		break;
+
+	    shift += XNTIMER_WHEEL_LEVELBITS;
+	    }
+
+	q = xntwheel_slot(wheel,level,(date >> shift) & XNTIMER_WHEEL_LEVELMASK);
+	}
+
+    appendq(q,&timer->link);
+    timer->wheelq = q;
+    wheel->count[level]++;
     __clrbits(timer->status,XNTIMER_DEQUEUED);
 }
 
 static inline void xntimer_dequeue_periodic (xntimer_t *timer)
 
 {
-    unsigned slot = (timer->date & XNTIMER_WHEELMASK);
-    removeq(&timer->sched->timerwheel[slot],&timer->link);
+    xntwheel_t *wheel = &timer->sched->timerwheel;
+
+    removeq(timer->wheelq,&timer->link);
+    wheel->count[xntwheel_level(wheel,timer->wheelq)]--;
     __setbits(timer->status,XNTIMER_DEQUEUED);
 }
 
+/* Requeue the timers from the current slot of an outer level of the
+   wheel; they will move to some inner level, depending on how close
+   their timeout date is. Returns the index of the slot which has been
+   cascaded, so that the caller knows whether the next outer level
+   must be cascaded too (i.e. on index wrap). */
+
+static int xntimer_cascade_periodic (xntwheel_t *wheel, int level)
+
+{
+    int shift = XNTIMER_WHEEL_ROOTBITS + (level - 1) * XNTIMER_WHEEL_LEVELBITS;
+    int idx = (wheel->base >> shift) & XNTIMER_WHEEL_LEVELMASK;
+    xnqueue_t *q = xntwheel_slot(wheel,level,idx);
+    xnholder_t *holder;
+
+    while ((holder = getq(q)) != NULL)
+	{
+	wheel->count[level]--;
+	xntimer_enqueue_periodic(link2timer(holder));
+	}
+
+    return idx;
+}
+
+void xntimer_init_wheel (xntwheel_t *wheel)
+
+{
+    int n;
+
+    wheel->base = 0;
+
+    for (n = 0; n <= XNTIMER_WHEEL_LEVELS; n++)
+	wheel->count[n] = 0;
+
+    for (n = 0; n < XNTIMER_WHEELSIZE; n++)
+	initq(&wheel->slots[n]);
+}
+
 void xntimer_do_start_periodic (xntimer_t *timer,
 				xnticks_t value,
 				xnticks_t interval)
@@ -361,7 +518,9 @@ static const char *xntimer_get_type_periodic (void)
  *
  * This routine informs all active timers that the clock has been
  * updated by processing the timer wheel. Elapsed timer actions will
- * be fired.
+ * be fired. Only the slot matching the current jiffy is scanned, and
+ * all the timers it links are elapsed; the outer levels of the wheel
+ * are cascaded once every XNTIMER_WHEEL_ROOTSIZE jiffies.
  *
  * Environments:
  *
@@ -378,9 +537,11 @@ void xntimer_do_tick_periodic (void)
 
 {
     xnsched_t *sched = xnpod_current_sched();
-    xnholder_t *nextholder, *holder;
-    xnqueue_t *timerq;
+    xntwheel_t *wheel = &sched->timerwheel;
+    xnholder_t *holder;
     xntimer_t *timer;
+    xnticks_t now;
+    int level, idx;
 
     /* Update the periodic clocks keeping the things strictly
        monotonous (this routine is run on every cpu, but only CPU
@@ -388,43 +549,59 @@ void xntimer_do_tick_periodic (void)
     if (sched == xnpod_sched_slot(XNTIMER_KEEPER_ID))
 	++nkpod->jiffies;
 
-    timerq = &sched->timerwheel[nkpod->jiffies & XNTIMER_WHEELMASK];
+    /* Catch up with the keeper's idea of time, in case this CPU
+       lagged behind. */
 
-    nextholder = getheadq(timerq);
+    while (wheel->base <= nkpod->jiffies)
+	{
+	now = wheel->base;
+	idx = now & XNTIMER_WHEEL_ROOTMASK;
 
-    while ((holder = nextholder) != NULL)
-        {
-        nextholder = nextq(timerq,holder);
-        timer = link2timer(holder);
+	if (idx == 0)
+	    for (level = 1; level <= XNTIMER_WHEEL_LEVELS; level++)
+		if (xntimer_cascade_periodic(wheel,level) != 0)
+		    break;
 
-	if (timer->date > nkpod->jiffies)
-	    continue;
+	++wheel->base;
 
-	xntimer_dequeue_periodic(timer);
+	/* Timers are appended to the slots, so that the ones reloaded
+	   to the same slot by the loop below (i.e. one full root turn
+	   later) show up after all the elapsed ones. */
 
-        if (timer != &nkpod->htimer)
+	while ((holder = getheadq(xntwheel_root(wheel,idx))) != NULL)
 	    {
-	    if (!testbits(nkpod->status,XNTLOCK))
-		{
-		timer->handler(timer->cookie);
+	    timer = link2timer(holder);
 
-		if (timer->interval == XN_INFINITE ||
-		    !testbits(timer->status,XNTIMER_DEQUEUED) ||
-		    testbits(timer->status,XNTIMER_KILLED))
-		    continue;
-		}
-	    else if (timer->interval == XN_INFINITE)
+	    if (timer->date > now)
+		break;
+
+	    xntimer_dequeue_periodic(timer);
+
+	    if (timer != &nkpod->htimer)
 		{
-		timer->date = nkpod->jiffies + nkpod->htimer.interval;
-		continue;
+		if (!testbits(nkpod->status,XNTLOCK))
+		    {
+		    xntrace_timer(timer);
+		    timer->handler(timer->cookie);
+
+		    if (timer->interval == XN_INFINITE ||
+			!testbits(timer->status,XNTIMER_DEQUEUED) ||
+			testbits(timer->status,XNTIMER_KILLED))
+			continue;
+		    }
+		else if (timer->interval == XN_INFINITE)
+		    {
+		    timer->date = now + nkpod->htimer.interval;
+		    continue;
+		    }
 		}
-            }
-	else
-            __setbits(sched->status,XNHTICK);
+	    else
+		__setbits(sched->status,XNHTICK);
 
-	timer->date = nkpod->jiffies + timer->interval;
-	xntimer_enqueue_periodic(timer);
-        }
+	    timer->date = now + timer->interval;
+	    xntimer_enqueue_periodic(timer);
+	    }
+	}
 }
 
 void xntimer_set_remote_periodic (xntimer_t *timer)
@@ -447,6 +624,14 @@ static xntmops_t timer_ops_periodic = {
 
 void xntimer_set_periodic_mode (void)
 {
+    int cpu;
+
+    /* Timers have all been frozen when the timer was last stopped,
+       so the wheels are empty; just sync them with the current
+       jiffy count. */
+    for (cpu = 0; cpu < xnarch_num_online_cpus(); cpu++)
+	xnpod_sched_slot(cpu)->timerwheel.base = nkpod->jiffies + 1;
+
     nktimer = &timer_ops_periodic;
 }
 
@@ -492,12 +677,15 @@ void xntimer_init (xntimer_t *timer,
        periodic/aperiodic timing mode. */
      
     inith(&timer->link);
+    xntimerh_init(&timer->aplink);
+    xntimerh_init(&timer->sllink);
     timer->status = XNTIMER_DEQUEUED;
     timer->handler = handler;
     timer->cookie = cookie;
     timer->interval = 0;
     timer->date = XN_INFINITE;
     timer->prio = XNTIMER_STDPRIO;
+    timer->slack = 0;
     timer->sched = xnpod_current_sched();
     
     xnarch_init_display_context(timer);
@@ -554,8 +742,6 @@ void xntimer_destroy (xntimer_t *timer)
  * expressed in clock ticks (see note). If @a interval is equal to
  * XN_INFINITE, the timer will not be reloaded after it has expired.
  *
- * @return 0 is always returned.
- *
  * Environments:
  *
  * This service can be called from:
@@ -747,8 +933,10 @@ xnticks_t xntimer_get_timeout (xntimer_t *timer)
 void xntimer_freeze (void)
 
 {
-    int nr_cpus;
-    int n, cpu;
+    int nr_cpus, cpu;
+#ifdef CONFIG_XENO_HW_PERIODIC_TIMER
+    int n;
+#endif /* CONFIG_XENO_HW_PERIODIC_TIMER */
     spl_t s;
 
     xnarch_stop_timer();
@@ -760,18 +948,42 @@ void xntimer_freeze (void)
 
     nr_cpus = xnarch_num_online_cpus();
     for (cpu = 0; cpu < nr_cpus; cpu++)
+        {
+        xntimerq_t *timerq = &xnpod_sched_slot(cpu)->timerqueue;
+        xntimerq_t *slackq = &xnpod_sched_slot(cpu)->slackqueue;
+        xntimerh_t *holder;
+
+        while ((holder = xntimerq_head(timerq)) != NULL)
+            {
+            __setbits(aplink2timer(holder)->status,XNTIMER_DEQUEUED);
+            xntimerq_remove(timerq,holder);
+            }
+
+        while ((holder = xntimerq_head(slackq)) != NULL)
+            {
+            __clrbits(sllink2timer(holder)->status,XNTIMER_SLACKQ);
+            xntimerq_remove(slackq,holder);
+            }
+
+#ifdef CONFIG_XENO_HW_PERIODIC_TIMER
         for (n = 0; n < XNTIMER_WHEELSIZE; n++)
             {
-            xnqueue_t *timerq = &xnpod_sched_slot(cpu)->timerwheel[n];
-            xnholder_t *holder = getheadq(timerq);
+            xntwheel_t *wheel = &xnpod_sched_slot(cpu)->timerwheel;
+            xnqueue_t *wheelq = &wheel->slots[n];
+            xnholder_t *wholder = getheadq(wheelq);
 
-            while (holder != NULL)
+            while (wholder != NULL)
                 {
-                __setbits(link2timer(holder)->status,XNTIMER_DEQUEUED);
-                holder = popq(timerq,holder);
+                __setbits(link2timer(wholder)->status,XNTIMER_DEQUEUED);
+                wholder = popq(wheelq,wholder);
                 }
             }
 
+        for (n = 0; n <= XNTIMER_WHEEL_LEVELS; n++)
+            xnpod_sched_slot(cpu)->timerwheel.count[n] = 0;
+#endif /* CONFIG_XENO_HW_PERIODIC_TIMER */
+        }
+
  unlock_and_exit:
 
     xnlock_put_irqrestore(&nklock,s);
@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2026 The Xenomai project <http://www.xenomai.org>.
+ *
+ * Xenomai is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ *
+ * Xenomai is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Xenomai; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * Built-in event tracer. Unlike the LTT tracepoints, which format
+ * strings at logging time and depend on a patched kernel, this
+ * facility only stores fixed-size binary records into per-CPU rings,
+ * and leaves any decoding to the user-space dumper. It is cheap
+ * enough to be left always on, the rings holding the most recent
+ * history of each CPU when something goes wrong.
+ */
+
+#define XENO_HEAP_MODULE 1	/* For xnarch_remap_page_range(). */
+
+#include <linux/config.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/miscdevice.h>
+#include <linux/device.h>
+#include <linux/mm.h>
+#include <asm/io.h>
+#include <asm/uaccess.h>
+#include <nucleus/pod.h>
+#include <nucleus/trace.h>
+
+#if (XNTRACE_RING_SIZE & (XNTRACE_RING_SIZE - 1)) != 0 || XNTRACE_RING_SIZE < PAGE_SIZE
+#error "CONFIG_XENO_OPT_TRACE_BUFSZ must be a power of two, and at least a page"
+#endif
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,13)
+static struct class *xntrace_class;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,15)
+#define do_class_device_create class_device_create
+#else
+#define do_class_device_create(c,p,dt,dv,fmt,args...) class_device_create(c,dt,dv,fmt , ##args)
+#endif
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,0)
+static struct class_simple *xntrace_class;
+#define class_create class_simple_create
+#define do_class_device_create(c,p,dt,dv,fmt,args...) class_simple_device_add(c,dt,dv,fmt , ##args)
+#define class_device_destroy(a,b) class_simple_device_remove(b)
+#define class_destroy class_simple_destroy
+#endif
+
+xntrace_ring_t *xntrace_rings[XNARCH_NR_CPUS];
+
+int xntrace_enabled;
+
+static unsigned xntrace_ncpus;
+
+void xntrace_log_thread (xnthread_t *thread, int pid)
+
+{
+    xntrace_rec_t *rec;
+    spl_t s;
+
+    if (!xntrace_enabled)
+	return;
+
+    splhigh(s);
+    rec = __xntrace_begin(XNTRACE_EV_THREAD,0);
+    rec->arg[0] = (unsigned long)thread;
+    rec->arg[1] = pid;
+    /* arg[2..5] hold exactly XNOBJECT_NAME_LEN bytes. */
+    memcpy(&rec->arg[2],xnthread_name(thread),sizeof(rec->arg[2]) * 4);
+    __xntrace_end(rec);
+    splexit(s);
+}
+
+static int xntrace_ioctl (struct inode *inode,
+			  struct file *file,
+			  unsigned int cmd,
+			  unsigned long arg)
+{
+    struct xntrace_info info;
+
+    switch (cmd)
+	{
+	case XNTRACEIOC_GET_INFO:
+
+	    info.ncpus = xntrace_ncpus;
+	    info.ringsz = XNTRACE_RING_SIZE;
+
+	    if (copy_to_user((void *)arg,&info,sizeof(info)))
+		return -EFAULT;
+
+	    return 0;
+
+	case XNTRACEIOC_FREEZE:
+
+	    xntrace_freeze();
+	    return 0;
+
+	case XNTRACEIOC_THAW:
+
+	    xntrace_thaw();
+	    return 0;
+	}
+
+    return -ENOTTY;
+}
+
+static int xntrace_mmap (struct file *file,
+			 struct vm_area_struct *vma)
+{
+    unsigned long offset, size;
+    unsigned cpu;
+
+    if (vma->vm_flags & VM_WRITE)
+	return -EACCES;	/* Rings are read-only for user-space. */
+
+    offset = vma->vm_pgoff << PAGE_SHIFT;
+    size = vma->vm_end - vma->vm_start;
+
+    if ((offset % XNTRACE_RING_SIZE) != 0 || size != XNTRACE_RING_SIZE)
+	return -ENXIO;	/* One ring per mapping. */
+
+    cpu = offset / XNTRACE_RING_SIZE;
+
+    if (cpu >= xntrace_ncpus)
+	return -ENXIO;
+
+    /* Nor may mprotect() make the mapping writable later. */
+    vma->vm_flags &= ~VM_MAYWRITE;
+    vma->vm_flags |= VM_LOCKED;
+
+    if (xnarch_remap_page_range(vma,
+				vma->vm_start,
+				virt_to_phys(xntrace_rings[cpu]),
+				size,
+				PAGE_READONLY))
+	return -ENXIO;
+
+    return 0;
+}
+
+static struct file_operations xntrace_fops = {
+    .owner =	THIS_MODULE,
+    .ioctl =	&xntrace_ioctl,
+    .mmap =	&xntrace_mmap
+};
+
+static struct miscdevice xntrace_dev = {
+    XNTRACE_DEV_MINOR,"rttrace",&xntrace_fops
+};
+
+static void xntrace_free_rings (void)
+
+{
+    int order = get_order(XNTRACE_RING_SIZE);
+    unsigned long vaddr, vabase;
+    unsigned cpu;
+
+    for (cpu = 0; cpu < xntrace_ncpus; cpu++)
+	{
+	if (!xntrace_rings[cpu])
+	    continue;
+
+	vabase = (unsigned long)xntrace_rings[cpu];
+
+	for (vaddr = vabase; vaddr < vabase + XNTRACE_RING_SIZE; vaddr += PAGE_SIZE)
+	    ClearPageReserved(virt_to_page(vaddr));
+
+	free_pages(vabase,order);
+	xntrace_rings[cpu] = NULL;
+	}
+}
+
+int __init xntrace_mount (void)
+
+{
+    int order = get_order(XNTRACE_RING_SIZE), err;
+    unsigned long vaddr, vabase;
+    struct class_device* cldev;
+    xntrace_ring_t *ring;
+    unsigned cpu;
+
+    xntrace_ncpus = xnarch_num_online_cpus();
+
+    /* Rings are physically contiguous, so that a single remapping
+       exports each of them to user-space. */
+
+    for (cpu = 0; cpu < xntrace_ncpus; cpu++)
+	{
+	vabase = __get_free_pages(GFP_KERNEL,order);
+
+	if (!vabase)
+	    {
+	    err = -ENOMEM;
+	    goto cleanup_rings;
+	    }
+
+	memset((void *)vabase,0,XNTRACE_RING_SIZE);
+
+	for (vaddr = vabase; vaddr < vabase + XNTRACE_RING_SIZE; vaddr += PAGE_SIZE)
+	    SetPageReserved(virt_to_page(vaddr));
+
+	ring = (xntrace_ring_t *)vabase;
+	ring->magic = XNTRACE_MAGIC;
+	ring->version = XNTRACE_VERSION;
+	ring->cpu = cpu;
+	ring->nrecs = XNTRACE_NRECS;
+	ring->cpufreq = xnarch_get_cpu_freq();
+	ring->head = 0;
+	xntrace_rings[cpu] = ring;
+	}
+
+    xntrace_class = class_create(THIS_MODULE, "rttrace");
+
+    if(IS_ERR(xntrace_class))
+	{
+	xnlogerr("Error creating rttrace class, err=%ld.\n",PTR_ERR(xntrace_class));
+	err = -EBUSY;
+	goto cleanup_rings;
+	}
+
+    cldev = do_class_device_create(xntrace_class, NULL, MKDEV(MISC_MAJOR, XNTRACE_DEV_MINOR),
+				   NULL, "rttrace");
+    if(IS_ERR(cldev))
+	{
+	xnlogerr("Can't add device class, major=%d, minor=%d, err=%ld\n",
+		 MISC_MAJOR, XNTRACE_DEV_MINOR, PTR_ERR(cldev));
+	err = -EBUSY;
+	goto cleanup_class;
+	}
+
+    if (misc_register(&xntrace_dev) < 0)
+	{
+	err = -EBUSY;
+	goto cleanup_cldev;
+	}
+
+    xntrace_thaw();
+
+    return 0;
+
+ cleanup_cldev:
+
+    class_device_destroy(xntrace_class, MKDEV(MISC_MAJOR, XNTRACE_DEV_MINOR));
+
+ cleanup_class:
+
+    class_destroy(xntrace_class);
+
+ cleanup_rings:
+
+    xntrace_free_rings();
+
+    return err;
+}
+
+void xntrace_umount (void)
+
+{
+    /* The pod is gone, so nobody may be logging anymore. */
+    xntrace_freeze();
+    misc_deregister(&xntrace_dev);
+    class_device_destroy(xntrace_class, MKDEV(MISC_MAJOR, XNTRACE_DEV_MINOR));
+    class_destroy(xntrace_class);
+    xntrace_free_rings();
+}
+
+EXPORT_SYMBOL(xntrace_rings);
+EXPORT_SYMBOL(xntrace_enabled);
+EXPORT_SYMBOL(xntrace_log_thread);
@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2026 The Xenomai project <http://www.xenomai.org>.
+ *
+ * Xenomai is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ *
+ * Xenomai is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Xenomai; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * Dumper for the nucleus built-in event tracer: snapshots the
+ * per-CPU trace rings exported by /dev/rttrace, merges them by
+ * timestamp and prints the result.
+ */
+
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <getopt.h>
+#include <nucleus/trace.h>
+
+/* Same as the user-space xnarch_memory_barrier(). */
+#define barrier()  __asm__ __volatile__("": : :"memory")
+
+struct event {
+
+    xntrace_rec_t rec;
+    unsigned cpu;
+    double freq;
+};
+
+struct thread {
+
+    unsigned long long addr;
+    char name[sizeof(((xntrace_rec_t *)0)->arg[0]) * 4 + 1];
+};
+
+static struct event *events;
+static unsigned nevents;
+
+static struct thread *threads;
+static unsigned nthreads;
+
+static int snapshot_ring (xntrace_ring_t *ring, unsigned cpu, unsigned count)
+
+{
+    unsigned head = ring->head, seq, first;
+    xntrace_rec_t *slot;
+    struct event *ev;
+
+    if (ring->magic != XNTRACE_MAGIC || ring->version != XNTRACE_VERSION)
+	{
+	fprintf(stderr,"xeno-trace: bad trace ring for CPU%u\n",cpu);
+	return -1;
+	}
+
+    first = head > ring->nrecs ? head - ring->nrecs : 0;
+
+    if (count > 0 && head - first > count)
+	first = head - count;
+
+    events = realloc(events,(nevents + head - first) * sizeof(*events));
+
+    if (!events)
+	{
+	perror("xeno-trace");
+	return -1;
+	}
+
+    for (seq = first; seq != head; seq++)
+	{
+	slot = xntrace_ring_slot(ring,seq);
+	ev = events + nevents;
+
+	/* The kernel may recycle the slot while we copy it, in which
+	   case its sequence number won't match before and after. */
+
+	if (slot->seq != seq)
+	    continue;
+
+	barrier();
+	ev->rec = *slot;
+	barrier();
+
+	if (slot->seq != seq)
+	    continue;
+
+	ev->rec.seq = seq;
+	ev->cpu = cpu;
+	ev->freq = (double)ring->cpufreq;
+	nevents++;
+	}
+
+    return 0;
+}
+
+static int compare_events (const void *a, const void *b)
+
+{
+    const struct event *ea = a, *eb = b;
+
+    if (ea->rec.stamp != eb->rec.stamp)
+	return ea->rec.stamp < eb->rec.stamp ? -1 : 1;
+
+    return ea->cpu - eb->cpu;
+}
+
+static void collect_threads (void)
+
+{
+    unsigned n, t;
+
+    for (n = 0; n < nevents; n++)
+	{
+	xntrace_rec_t *rec = &events[n].rec;
+
+	if (rec->event != XNTRACE_EV_THREAD)
+	    continue;
+
+	for (t = 0; t < nthreads; t++)
+	    if (threads[t].addr == rec->arg[0])
+		break;
+
+	if (t == nthreads)
+	    {
+	    threads = realloc(threads,(nthreads + 1) * sizeof(*threads));
+
+	    if (!threads)
+		return;
+
+	    nthreads++;
+	    }
+
+	/* Later records supersede former ones for recycled TCBs. */
+	threads[t].addr = rec->arg[0];
+	memcpy(threads[t].name,&rec->arg[2],sizeof(threads[t].name) - 1);
+	threads[t].name[sizeof(threads[t].name) - 1] = '\0';
+	}
+}
+
+static const char *thread_name (unsigned long long addr)
+
+{
+    static char buf[2][32];
+    static int rr;
+    unsigned t;
+
+    if (addr == 0)
+	return "<none>";
+
+    for (t = 0; t < nthreads; t++)
+	if (threads[t].addr == addr)
+	    return threads[t].name;
+
+    rr ^= 1;
+    snprintf(buf[rr],sizeof(buf[rr]),"%#llx",addr);
+
+    return buf[rr];
+}
+
+static void print_event (struct event *ev, unsigned long long origin)
+
+{
+    xntrace_rec_t *rec = &ev->rec;
+    double us = (double)(rec->stamp - origin) * 1000000.0 / ev->freq;
+
+    printf("%3u %14.3f  ",ev->cpu,us);
+
+    switch (rec->event)
+	{
+	case XNTRACE_EV_SWITCH:
+
+	    printf("switch   %s -> %s\n",
+		   thread_name(rec->arg[0]),
+		   thread_name(rec->arg[1]));
+	    break;
+
+	case XNTRACE_EV_SUSPEND:
+
+	    printf("suspend  %s mask=0x%llx\n",thread_name(rec->arg[0]),rec->arg[1]);
+	    break;
+
+	case XNTRACE_EV_RESUME:
+
+	    printf("resume   %s mask=0x%llx\n",thread_name(rec->arg[0]),rec->arg[1]);
+	    break;
+
+	case XNTRACE_EV_TIMER:
+
+	    printf("timer    %#llx handler=%#llx\n",rec->arg[0],rec->arg[1]);
+	    break;
+
+	case XNTRACE_EV_IENTER:
+
+	    printf("i-enter  irq=%u\n",rec->aux);
+	    break;
+
+	case XNTRACE_EV_IEXIT:
+
+	    printf("i-exit   irq=%u\n",rec->aux);
+	    break;
+
+	case XNTRACE_EV_SYSENTRY:
+
+	    printf("sysentry %s skin=%u call=%llu\n",
+		   thread_name(rec->arg[0]),rec->aux,rec->arg[1]);
+	    break;
+
+	case XNTRACE_EV_SYSEXIT:
+
+	    printf("sysexit  %s skin=%u status=%lld\n",
+		   thread_name(rec->arg[0]),rec->aux,(long long)rec->arg[1]);
+	    break;
+
+	case XNTRACE_EV_THREAD:
+
+	    printf("thread   %s addr=%#llx pid=%llu\n",
+		   thread_name(rec->arg[0]),rec->arg[0],rec->arg[1]);
+	    break;
+
+	case XNTRACE_EV_MARK:
+
+	    printf("mark     id=%u arg0=%#llx arg1=%#llx\n",
+		   rec->aux,rec->arg[0],rec->arg[1]);
+	    break;
+
+	default:
+
+	    printf("event #%u\n",rec->event);
+	}
+}
+
+static void usage (void)
+
+{
+    fprintf(stderr,"usage: xeno-trace [options]\n");
+    fprintf(stderr,"  -c <cpu>    dump this CPU only\n");
+    fprintf(stderr,"  -n <count>  dump the last <count> events of each CPU\n");
+    fprintf(stderr,"  -F          freeze tracing, then dump\n");
+    fprintf(stderr,"  -T          thaw tracing, do not dump\n");
+}
+
+int main (int argc, char **argv)
+
+{
+    int fd, c, cpu = -1, freeze = 0, thaw = 0;
+    struct xntrace_info info;
+    unsigned count = 0, n;
+    void *ring;
+
+    while ((c = getopt(argc,argv,"c:n:FT")) != EOF)
+	switch (c)
+	    {
+	    case 'c':
+
+		cpu = atoi(optarg);
+		break;
+
+	    case 'n':
+
+		count = atoi(optarg);
+		break;
+
+	    case 'F':
+
+		freeze = 1;
+		break;
+
+	    case 'T':
+
+		thaw = 1;
+		break;
+
+	    default:
+
+		usage();
+		exit(2);
+	    }
+
+    fd = open(XNTRACE_DEV_NAME,O_RDONLY);
+
+    if (fd < 0)
+	{
+	perror("xeno-trace: cannot open " XNTRACE_DEV_NAME);
+	exit(1);
+	}
+
+    if (thaw)
+	{
+	if (ioctl(fd,XNTRACEIOC_THAW) < 0)
+	    {
+	    perror("xeno-trace: XNTRACEIOC_THAW");
+	    exit(1);
+	    }
+
+	exit(0);
+	}
+
+    if (freeze && ioctl(fd,XNTRACEIOC_FREEZE) < 0)
+	{
+	perror("xeno-trace: XNTRACEIOC_FREEZE");
+	exit(1);
+	}
+
+    if (ioctl(fd,XNTRACEIOC_GET_INFO,&info) < 0)
+	{
+	perror("xeno-trace: XNTRACEIOC_GET_INFO");
+	exit(1);
+	}
+
+    for (n = 0; n < info.ncpus; n++)
+	{
+	if (cpu >= 0 && n != (unsigned)cpu)
+	    continue;
+
+	ring = mmap(NULL,info.ringsz,PROT_READ,MAP_SHARED,fd,(off_t)n * info.ringsz);
+
+	if (ring == MAP_FAILED)
+	    {
+	    fprintf(stderr,"xeno-trace: cannot map trace ring for CPU%u: %s\n",
+		    n,strerror(errno));
+	    exit(1);
+	    }
+
+	if (snapshot_ring((xntrace_ring_t *)ring,n,count))
+	    exit(1);
+
+	munmap(ring,info.ringsz);
+	}
+
+    close(fd);
+
+    if (nevents == 0)
+	exit(0);
+
+    qsort(events,nevents,sizeof(*events),&compare_events);
+    collect_threads();
+
+    printf("CPU  TIME (us)       EVENT\n");
+
+    for (n = 0; n < nevents; n++)
+	print_event(events + n,events[0].rec.stamp);
+
+    exit(0);
+}
@@ -30,6 +30,7 @@
 #include <limits.h>
 #include <unistd.h>
 #include <xeno_config.h>
+#include <nucleus/asm-generic/arith.h>
 
 struct xnthread;
 struct xnsynch;
@@ -186,6 +187,14 @@ typedef unsigned long atomic_flags_t;
 #define xnarch_atomic_set_mask(pflags,mask)    (*(pflags) |= (mask))
 #define xnarch_atomic_clear_mask(pflags,mask)  (*(pflags) &= ~(mask))
 
+static inline unsigned long xnarch_atomic_xchg (volatile void *ptr,
+						unsigned long x)
+{
+    unsigned long oldval = *(volatile unsigned long *)ptr;
+    *(volatile unsigned long *)ptr = x;
+    return oldval;
+}
+
 typedef struct xnarch_heapcb {
 
 #if (__GNUC__ <= 2)
@@ -63,13 +63,13 @@ static int __alarm_read_proc (char *page,
 
 #if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
     {
-    xnpholder_t *holder = getheadpq(xnsynch_wait_queue(&alarm->synch_base));
+    xnpholder_t *holder = synch_getheadpq(xnsynch_wait_queue(&alarm->synch_base));
     
     while (holder)
         {
         xnthread_t *sleeper = link2thread(holder,plink);
         p += sprintf(p,"+%s\n",xnthread_name(sleeper));
-        holder = nextpq(xnsynch_wait_queue(&alarm->synch_base),holder);
+        holder = synch_nextpq(xnsynch_wait_queue(&alarm->synch_base),holder);
         }
     }
 #endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
@@ -426,6 +426,74 @@ int rt_alarm_stop (RT_ALARM *alarm)
     return err;
 }
 
+/**
+ * @fn int rt_alarm_set_slack(RT_ALARM *alarm,RTIME slack)
+ * @brief Set the slack of an alarm.
+ *
+ * Define the amount of lateness an alarm tolerates. Alarms which are
+ * due within the slack window of each other may be triggered by a
+ * single timer interrupt, which saves hardware timer shots on
+ * systems running many alarms or watchdogs. An alarm is never
+ * triggered before its nominal expiry date, nor later than this date
+ * plus @a slack (modulo the usual latencies).
+ *
+ * The new slack is applied from the next shot on, i.e. once the alarm
+ * has been (re)started by rt_alarm_start(), or reloaded.
+ *
+ * @param alarm The descriptor address of the affected alarm.
+ *
+ * @param slack The tolerated lateness, expressed in clock ticks (see
+ * note). Zero, which is the default, disables coalescing for this
+ * alarm.
+ *
+ * @return 0 is returned upon success. Otherwise:
+ *
+ * - -EINVAL is returned if @a alarm is not a alarm descriptor.
+ *
+ * - -EIDRM is returned if @a alarm is a deleted alarm descriptor.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ *
+ * @note Slack only applies when the system timer runs in oneshot
+ * mode, as defined by the rt_timer_start() service, in which case
+ * clock ticks are interpreted as nanoseconds. It is ignored in
+ * periodic mode.
+ */
+
+int rt_alarm_set_slack (RT_ALARM *alarm,
+			RTIME slack)
+{
+    int err = 0;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    alarm = xeno_h2obj_validate(alarm,XENO_ALARM_MAGIC,RT_ALARM);
+
+    if (!alarm)
+        {
+        err = xeno_handle_error(alarm,XENO_ALARM_MAGIC,RT_ALARM);
+        goto unlock_and_exit;
+        }
+
+    xntimer_set_slack(&alarm->timer_base,slack);
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
 /**
  * @fn int rt_alarm_inquire(RT_ALARM *alarm, RT_ALARM_INFO *info)
  * @brief Inquire about an alarm.
@@ -583,4 +651,5 @@ EXPORT_SYMBOL(rt_alarm_create);
 EXPORT_SYMBOL(rt_alarm_delete);
 EXPORT_SYMBOL(rt_alarm_start);
 EXPORT_SYMBOL(rt_alarm_stop);
+EXPORT_SYMBOL(rt_alarm_set_slack);
 EXPORT_SYMBOL(rt_alarm_inquire);
@@ -129,6 +129,9 @@ int rt_alarm_start(RT_ALARM *alarm,
 
 int rt_alarm_stop(RT_ALARM *alarm);
 
+int rt_alarm_set_slack(RT_ALARM *alarm,
+		       RTIME slack);
+
 int rt_alarm_inquire(RT_ALARM *alarm,
 		     RT_ALARM_INFO *info);
 
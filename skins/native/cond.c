@@ -67,13 +67,13 @@ static int __cond_read_proc (char *page,
 	
 	/* Pended condvar -- dump waiters. */
 
-	holder = getheadpq(xnsynch_wait_queue(&cond->synch_base));
+	holder = synch_getheadpq(xnsynch_wait_queue(&cond->synch_base));
 
 	while (holder)
 	    {
 	    xnthread_t *sleeper = link2thread(holder,plink);
 	    p += sprintf(p,"+%s\n",xnthread_name(sleeper));
-	    holder = nextpq(xnsynch_wait_queue(&cond->synch_base),holder);
+	    holder = synch_nextpq(xnsynch_wait_queue(&cond->synch_base),holder);
 	    }
 	}
 
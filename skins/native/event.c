@@ -66,7 +66,7 @@ static int __event_read_proc (char *page,
 
 	/* Pended event -- dump waiters. */
 
-	holder = getheadpq(xnsynch_wait_queue(&event->synch_base));
+	holder = synch_getheadpq(xnsynch_wait_queue(&event->synch_base));
 
 	while (holder)
 	    {
@@ -75,7 +75,7 @@ static int __event_read_proc (char *page,
 	    const char *mode = (task->wait_args.event.mode & EV_ANY) ? "any" : "all";
 	    unsigned long mask = task->wait_args.event.mask;
 	    p += sprintf(p,"+%s (mask=0x%lx, %s)\n",xnthread_name(sleeper),mask,mode);
-	    holder = nextpq(xnsynch_wait_queue(&event->synch_base),holder);
+	    holder = synch_nextpq(xnsynch_wait_queue(&event->synch_base),holder);
 	    }
 	}
 
@@ -177,6 +177,7 @@ int rt_event_create (RT_EVENT *event,
 
     xnsynch_init(&event->synch_base,mode & EV_PRIO);
     event->value = ivalue;
+    xnselect_init(&event->select,ivalue);
     event->handle = 0;  /* i.e. (still) unregistered event. */
     event->magic = XENO_EVENT_MAGIC;
     xnobject_copy_name(event->name,name);
@@ -265,6 +266,9 @@ int rt_event_delete (RT_EVENT *event)
     
     rc = xnsynch_destroy(&event->synch_base);
 
+    if (xnselect_destroy(&event->select))
+	rc = XNSYNCH_RESCHED;
+
 #ifdef CONFIG_XENO_OPT_NATIVE_REGISTRY
     if (event->handle)
         rt_registry_remove(event->handle);
@@ -334,9 +338,12 @@ int rt_event_signal (RT_EVENT *event,
 
     event->value |= mask;
 
+    if (xnselect_signal(&event->select,event->value))
+        resched = 1;
+
     /* And wakeup any sleeper having its request fulfilled. */
 
-    nholder = getheadpq(xnsynch_wait_queue(&event->synch_base));
+    nholder = synch_getheadpq(xnsynch_wait_queue(&event->synch_base));
 
     while ((holder = nholder) != NULL)
         {
@@ -352,7 +359,7 @@ int rt_event_signal (RT_EVENT *event,
             resched = 1;
             }
         else
-            nholder = nextpq(xnsynch_wait_queue(&event->synch_base),holder);
+            nholder = synch_nextpq(xnsynch_wait_queue(&event->synch_base),holder);
         }
 
     if (resched)
@@ -572,6 +579,7 @@ int rt_event_clear (RT_EVENT *event,
     /* Clear the flags. */
 
     event->value &= ~mask;
+    xnselect_signal(&event->select,event->value);
 
  unlock_and_exit:
 
@@ -23,6 +23,7 @@
 #define _XENO_EVENT_H
 
 #include <nucleus/synch.h>
+#include <nucleus/select.h>
 #include <native/types.h>
 
 /* Creation flags. */
@@ -57,6 +58,8 @@ typedef struct rt_event {
 
     xnsynch_t synch_base; /* !< Base synchronization object. */
 
+    xnselect_t select; /* !< Readiness state for rt_select(). */
+
     unsigned long value; /* !< Event group value. */
 
     rt_handle_t handle;	/* !< Handle in registry -- zero if unregistered. */
@@ -56,6 +56,9 @@ static int __heap_read_proc (char *page,
 			     void *data)
 {
     RT_HEAP *heap = (RT_HEAP *)data;
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+    xnheap_magstat_t stat;
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
     char *p = page;
     int len;
     spl_t s;
@@ -65,6 +68,16 @@ static int __heap_read_proc (char *page,
 		 heap->csize,
 		 xnheap_used_mem(&heap->heap_base));
 
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+    xnheap_get_magstat(&heap->heap_base,-1,&stat);
+
+    p += sprintf(p,"magazine:hits=%lu:misses=%lu:refills=%lu:flushes=%lu\n",
+		 stat.hits,
+		 stat.misses,
+		 stat.refills,
+		 stat.flushes);
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+
     xnlock_get_irqsave(&nklock,s);
 
     if (xnsynch_nsleepers(&heap->synch_base) > 0)
@@ -73,7 +86,7 @@ static int __heap_read_proc (char *page,
 	
 	/* Pended heap -- dump waiters. */
 
-	holder = getheadpq(xnsynch_wait_queue(&heap->synch_base));
+	holder = synch_getheadpq(xnsynch_wait_queue(&heap->synch_base));
 
 	while (holder)
 	    {
@@ -81,7 +94,7 @@ static int __heap_read_proc (char *page,
 	    RT_TASK *task = thread2rtask(sleeper);
 	    size_t size = task->wait_args.heap.size;
 	    p += sprintf(p,"+%s (size=%zd)\n",xnthread_name(sleeper),size);
-	    holder = nextpq(xnsynch_wait_queue(&heap->synch_base),holder);
+	    holder = synch_nextpq(xnsynch_wait_queue(&heap->synch_base),holder);
 	    }
 	}
 
@@ -181,6 +194,14 @@ static void __heap_flush_private (xnheap_t *heap,
  * operations with I/O devices. A 128Kb limit exists for @a heapsize
  * when this flag is passed.
  *
+ * - H_LARGE causes the block pool associated to the heap to be
+ * allocated as a single block of physically contiguous pages, taken
+ * from the memory node of the current CPU. This reduces the TLB
+ * pressure when accessing large shared pools, both from kernel and
+ * user-space. H_NODE(n) may be passed instead to allocate from
+ * memory node @a n. These flags are only meaningful along with
+ * H_SHARED.
+ *
  * @return 0 is returned upon success. Otherwise:
  *
  * - -EEXIST is returned if the @a name is already in use by some
@@ -247,9 +268,15 @@ int rt_heap_create (RT_HEAP *heap,
 	    return -EINVAL;
 
 #ifdef CONFIG_XENO_OPT_PERVASIVE
-	err = xnheap_init_shared(&heap->heap_base,
-				 heapsize,
-				 (mode & H_DMA) ? GFP_DMA : 0);
+	if (mode & H_LARGE)
+	    err = xnheap_init_shared_node(&heap->heap_base,
+					  heapsize,
+					  (mode & H_DMA) ? GFP_DMA : 0,
+					  H_NODE_OF(mode));
+	else
+	    err = xnheap_init_shared(&heap->heap_base,
+				     heapsize,
+				     (mode & H_DMA) ? GFP_DMA : 0);
 	if (err)
 	    return err;
 
@@ -284,6 +311,9 @@ int rt_heap_create (RT_HEAP *heap,
     heap->shm_block = NULL;
     xnobject_copy_name(heap->name,name);
 
+    if (name && *name)
+	xnheap_set_label(&heap->heap_base,heap->name);
+
 #ifdef CONFIG_XENO_OPT_NATIVE_REGISTRY
     /* <!> Since rt_register_enter() may reschedule, only register
        complete objects, so that the registry cannot return handles to
@@ -626,7 +656,7 @@ int rt_heap_free (RT_HEAP *heap,
 	{
 	xnpholder_t *holder, *nholder;
 	
-	nholder = getheadpq(xnsynch_wait_queue(&heap->synch_base));
+	nholder = synch_getheadpq(xnsynch_wait_queue(&heap->synch_base));
 	nwake = 0;
 
 	while ((holder = nholder) != NULL)
@@ -643,7 +673,7 @@ int rt_heap_free (RT_HEAP *heap,
 		nwake++;
 		}
 	    else
-		nholder = nextpq(xnsynch_wait_queue(&heap->synch_base),holder);
+		nholder = synch_nextpq(xnsynch_wait_queue(&heap->synch_base),holder);
 	    }
 
 	if (nwake > 0)
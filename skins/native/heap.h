@@ -31,6 +31,9 @@
 #define H_FIFO   XNSYNCH_FIFO	/* Pend by FIFO order. */
 #define H_DMA    0x100		/* Use memory suitable for DMA. */
 #define H_SHARED 0x200		/* Use mappable shared memory. */
+#define H_LARGE  0x400		/* Use node-local contiguous memory. */
+#define H_NODE(n) (H_LARGE|((((n) + 1) & 0xff) << 16)) /* ... from node n. */
+#define H_NODE_OF(mode) ((((mode) >> 16) & 0xff) - 1)
 
 typedef struct rt_heap_info {
 
@@ -76,13 +76,13 @@ static int __intr_read_proc (char *page,
 
     /* Pended interrupt -- dump waiters. */
 
-    holder = getheadpq(xnsynch_wait_queue(&intr->synch_base));
+    holder = synch_getheadpq(xnsynch_wait_queue(&intr->synch_base));
 
     while (holder)
 	{
 	xnthread_t *sleeper = link2thread(holder,plink);
 	p += sprintf(p,"+%s\n",xnthread_name(sleeper));
-	holder = nextpq(xnsynch_wait_queue(&intr->synch_base),holder);
+	holder = synch_nextpq(xnsynch_wait_queue(&intr->synch_base),holder);
 	}
 
     xnlock_put_irqrestore(&nklock,s);
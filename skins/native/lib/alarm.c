@@ -65,6 +65,15 @@ int rt_alarm_stop (RT_ALARM *alarm)
 			     alarm);
 }
 
+int rt_alarm_set_slack (RT_ALARM *alarm,
+			RTIME slack)
+{
+    return XENOMAI_SKINCALL2(__xeno_muxid,
+			     __xeno_alarm_set_slack,
+			     alarm,
+			     &slack);
+}
+
 int rt_alarm_inquire (RT_ALARM *alarm,
 		      RT_ALARM_INFO *info)
 {
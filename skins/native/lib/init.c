@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
+#include <nucleus/vdso.h>
 #include <native/syscall.h>
 #include <native/task.h>
 
@@ -27,6 +28,8 @@ pthread_key_t __xeno_tskey;
 
 int __xeno_muxid = -1;
 
+xnvdso_t *__xeno_vdso;
+
 static void __flush_tsd (void *tsd)
 
 {
@@ -37,9 +40,10 @@ static void __flush_tsd (void *tsd)
 static __attribute__((constructor)) void __init_xeno_interface(void)
 
 {
+    xnsysinfo_t info;
     int muxid;
 
-    muxid = XENOMAI_SYSCALL2(__xn_sys_bind,XENO_SKIN_MAGIC,NULL); /* atomic */
+    muxid = XENOMAI_SYSCALL2(__xn_sys_bind,XENO_SKIN_MAGIC,&info); /* atomic */
 
     if (muxid < 0)
 	{
@@ -56,5 +60,9 @@ static __attribute__((constructor)) void __init_xeno_interface(void)
 	exit(1);
 	}
 
+    /* Map the shared time page if available, so that the timer
+       services can read the nucleus clock without syscalls. */
+    __xeno_vdso = xnvdso_map(&info);
+
     __xeno_muxid = muxid;
 }
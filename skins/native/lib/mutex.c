@@ -30,6 +30,17 @@ int rt_mutex_create (RT_MUTEX *mutex,
 			     name);
 }
 
+int rt_mutex_create_ceiling (RT_MUTEX *mutex,
+			     const char *name,
+			     int ceiling)
+{
+    return XENOMAI_SKINCALL3(__xeno_muxid,
+			     __xeno_mutex_create_ceiling,
+			     mutex,
+			     name,
+			     ceiling);
+}
+
 int rt_mutex_bind (RT_MUTEX *mutex,
 		   const char *name,
 		   RTIME timeout)
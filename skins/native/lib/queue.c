@@ -21,12 +21,354 @@
 #include <sys/ioctl.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
 #include <native/syscall.h>
 #include <native/task.h>
 #include <native/queue.h>
 
 extern int __xeno_muxid;
 
+/* Per-thread cache of message buffers. Buffers of up to a page are
+   refilled from and flushed to the kernel by batches, so that
+   rt_queue_alloc() and rt_queue_free() need no syscall in the common
+   case. Cached buffers are regular pool blocks owned by the caching
+   thread (refcount == 1), so they may still be sent, received and
+   released by anyone through the usual services. */
+
+#define QCACHE_SLOTS    4	/* Queues cached per thread. */
+#define QCACHE_MINLOG2  3	/* Same as XNHEAP_MINLOG2. */
+#define QCACHE_MAXLOG2  16	/* Largest cacheable buffer (if <= page). */
+#define QCACHE_NCLASSES (QCACHE_MAXLOG2 - QCACHE_MINLOG2 + 1)
+#define QCACHE_DEPTH    (RT_QUEUE_BATCH_MAX * 2) /* Per class. */
+
+struct qcache_slot {
+
+    RT_QUEUE_PLACEHOLDER q;	/* Owning queue -- invalid handle if unused. */
+
+    void *freelist[QCACHE_NCLASSES];
+
+    int count[QCACHE_NCLASSES];
+};
+
+struct qcache {
+
+    pthread_mutex_t lock;	/* Owner vs. unbinding or exiting threads. */
+
+    struct qcache *next, *prev;
+
+    unsigned victim;
+
+    struct qcache_slot slots[QCACHE_SLOTS];
+};
+
+static pthread_key_t __qcache_key;
+
+/* All the thread caches of the process, so that unbinding a queue or
+   exiting the process can flush the buffers any thread cached. Each
+   cache is locked by its owner while in use; since other threads
+   only lock it when a queue goes away or on exit, this costs no
+   syscall in the common case. */
+
+static struct qcache *__qcache_list;
+
+static pthread_mutex_t __qcache_list_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void __qcache_flush_class (struct qcache_slot *slot, int class, int count)
+
+{
+    void *bufs[RT_QUEUE_BATCH_MAX];
+    int n;
+
+    while (count > 0 && slot->count[class] > 0)
+	{
+	for (n = 0; n < RT_QUEUE_BATCH_MAX && n < count && slot->freelist[class]; n++)
+	    {
+	    bufs[n] = slot->freelist[class];
+	    slot->freelist[class] = *(void **)bufs[n];
+	    slot->count[class]--;
+	    }
+
+	XENOMAI_SKINCALL3(__xeno_muxid,
+			  __xeno_queue_free_batch,
+			  &slot->q,
+			  n,
+			  bufs);
+	count -= n;
+	}
+}
+
+static void __qcache_flush_slot (struct qcache_slot *slot)
+
+{
+    int class;
+
+    if (slot->q.opaque != RT_HANDLE_INVALID)
+	for (class = 0; class < QCACHE_NCLASSES; class++)
+	    __qcache_flush_class(slot,class,slot->count[class]);
+}
+
+static void __qcache_reset_slot (struct qcache_slot *slot)
+
+{
+    memset(slot,0,sizeof(*slot));
+    slot->q.opaque = RT_HANDLE_INVALID;
+}
+
+static inline int __qcache_match (struct qcache_slot *slot, RT_QUEUE *q)
+
+{
+    return slot->q.opaque == q->opaque && slot->q.mapbase == q->mapbase;
+}
+
+/* Apply to the slots of all threads caching buffers from q: flush
+   them back to the pool if flush is non-zero, and unbind them if
+   reset is non-zero. The caller must not hold its own cache lock. */
+
+static void __qcache_drop (RT_QUEUE *q, int flush, int reset)
+
+{
+    struct qcache_slot *slot;
+    struct qcache *cache;
+    int n;
+
+    pthread_mutex_lock(&__qcache_list_lock);
+
+    for (cache = __qcache_list; cache; cache = cache->next)
+	{
+	pthread_mutex_lock(&cache->lock);
+
+	for (n = 0; n < QCACHE_SLOTS; n++)
+	    {
+	    slot = &cache->slots[n];
+
+	    if (!__qcache_match(slot,q))
+		continue;
+
+	    if (flush)
+		__qcache_flush_slot(slot);
+
+	    if (reset)
+		__qcache_reset_slot(slot);
+	    }
+
+	pthread_mutex_unlock(&cache->lock);
+	}
+
+    pthread_mutex_unlock(&__qcache_list_lock);
+}
+
+static void __qcache_flush_tsd (void *tsd)
+
+{
+    struct qcache *cache = (struct qcache *)tsd;
+    int n;
+
+    /* Give the cached buffers back on thread exit. */
+
+    pthread_mutex_lock(&__qcache_list_lock);
+
+    if (cache->prev)
+	cache->prev->next = cache->next;
+    else
+	__qcache_list = cache->next;
+
+    if (cache->next)
+	cache->next->prev = cache->prev;
+
+    pthread_mutex_unlock(&__qcache_list_lock);
+
+    for (n = 0; n < QCACHE_SLOTS; n++)
+	__qcache_flush_slot(&cache->slots[n]);
+
+    pthread_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+static void __qcache_flush_all (void)
+
+{
+    struct qcache *cache;
+    int n;
+
+    /* TSD destructors do not run upon exit(), so flush the caches of
+       all threads from there too. */
+
+    pthread_mutex_lock(&__qcache_list_lock);
+
+    for (cache = __qcache_list; cache; cache = cache->next)
+	{
+	pthread_mutex_lock(&cache->lock);
+
+	for (n = 0; n < QCACHE_SLOTS; n++)
+	    {
+	    __qcache_flush_slot(&cache->slots[n]);
+	    __qcache_reset_slot(&cache->slots[n]);
+	    }
+
+	pthread_mutex_unlock(&cache->lock);
+	}
+
+    pthread_mutex_unlock(&__qcache_list_lock);
+}
+
+static __attribute__((constructor)) void __init_queue_cache (void)
+
+{
+    if (pthread_key_create(&__qcache_key,&__qcache_flush_tsd) != 0)
+	{
+	fprintf(stderr,"Xenomai: failed to allocate new TSD key?!\n");
+	exit(1);
+	}
+
+    atexit(&__qcache_flush_all);
+}
+
+/* Return the cache of the current thread, locked. */
+
+static struct qcache *__qcache_get (void)
+
+{
+    struct qcache *cache = (struct qcache *)pthread_getspecific(__qcache_key);
+    int n;
+
+    if (!cache)
+	{
+	/* Happens once per thread; this may cause a switch to
+	   secondary mode. */
+	cache = (struct qcache *)malloc(sizeof(*cache));
+
+	if (!cache)
+	    return NULL;
+
+	pthread_mutex_init(&cache->lock,NULL);
+	cache->victim = 0;
+
+	for (n = 0; n < QCACHE_SLOTS; n++)
+	    __qcache_reset_slot(&cache->slots[n]);
+
+	pthread_mutex_lock(&__qcache_list_lock);
+	cache->prev = NULL;
+	cache->next = __qcache_list;
+
+	if (__qcache_list)
+	    __qcache_list->prev = cache;
+
+	__qcache_list = cache;
+	pthread_mutex_unlock(&__qcache_list_lock);
+
+	pthread_setspecific(__qcache_key,cache);
+	}
+
+    pthread_mutex_lock(&cache->lock);
+
+    return cache;
+}
+
+static inline void __qcache_put (struct qcache *cache)
+
+{
+    pthread_mutex_unlock(&cache->lock);
+}
+
+static struct qcache_slot *__qcache_lookup (struct qcache *cache, RT_QUEUE *q)
+
+{
+    struct qcache_slot *slot;
+    int n;
+
+    for (n = 0; n < QCACHE_SLOTS; n++)
+	{
+	slot = &cache->slots[n];
+
+	if (__qcache_match(slot,q))
+	    return slot;
+	}
+
+    for (n = 0; n < QCACHE_SLOTS; n++)
+	{
+	slot = &cache->slots[n];
+
+	if (slot->q.opaque == RT_HANDLE_INVALID)
+	    goto bind_slot;
+	}
+
+    /* All slots busy, recycle one. */
+    slot = &cache->slots[cache->victim++ % QCACHE_SLOTS];
+    __qcache_flush_slot(slot);
+    __qcache_reset_slot(slot);
+
+ bind_slot:
+
+    slot->q = *q;
+
+    return slot;
+}
+
+/* Return the size class for a buffer of the given payload size, or
+   -1 if it should not be cached. This mirrors the rounding done by
+   xnheap_alloc() for sizes up to a page. */
+
+static inline int __qcache_class (RT_QUEUE *q, size_t size)
+
+{
+    size_t bsize;
+    int log2size;
+
+    if (q->pageshift == 0 || size == 0)
+	return -1;
+
+    /* The free list is linked through the payload. */
+    if (size < sizeof(void *))
+	size = sizeof(void *);
+
+    bsize = size + sizeof(rt_queue_msg_t);
+
+    for (log2size = QCACHE_MINLOG2; (1UL << log2size) < bsize; log2size++)
+	;
+
+    if (log2size > q->pageshift || log2size > QCACHE_MAXLOG2)
+	return -1;
+
+    return log2size;
+}
+
+/* Return the size class of an exclusively owned buffer from the
+   pool, or -1 if it should be released through the kernel. */
+
+static inline int __qcache_owned_class (RT_QUEUE *q, void *buf)
+
+{
+    rt_queue_msg_t *msg = ((rt_queue_msg_t *)buf) - 1;
+    caddr_t pagebase = q->mapbase + q->pagebase;
+    u_long boffset;
+    int log2size;
+
+    if (q->pageshift == 0 ||
+	(caddr_t)msg < pagebase ||
+	(caddr_t)buf >= q->mapbase + q->mapsize)
+	return -1;
+
+    boffset = (caddr_t)msg - pagebase;
+    log2size = ((u_char *)q->mapbase + q->pagemap)[boffset >> q->pageshift];
+
+    if (log2size < QCACHE_MINLOG2 ||
+	log2size > q->pageshift ||
+	log2size > QCACHE_MAXLOG2 ||
+	(boffset & ((1UL << log2size) - 1)) != 0 ||
+	(1UL << log2size) < sizeof(rt_queue_msg_t) + sizeof(void *))
+	return -1;
+
+    /* Nobody else may hold the message once its refcount is 1, so
+       reading it unlocked is safe. */
+    if (msg->refcount != 1)
+	return -1;
+
+    return log2size;
+}
+
 static int __map_queue_memory (RT_QUEUE *q, RT_QUEUE_PLACEHOLDER *php)
 
 {
@@ -115,7 +457,13 @@ int rt_queue_bind (RT_QUEUE *q,
 int rt_queue_unbind (RT_QUEUE *q)
 
 {
-    int err = munmap(q->mapbase,q->mapsize);
+    int err;
+
+    /* The cached buffers are linked through the mapping, so they must
+       be returned to the pool before it goes away. */
+    __qcache_drop(q,1,1);
+
+    err = munmap(q->mapbase,q->mapsize);
 
     q->opaque = RT_HANDLE_INVALID;
     q->mapbase = NULL;
@@ -129,6 +477,9 @@ int rt_queue_delete (RT_QUEUE *q)
 {
     int err;
 
+    /* The cached buffers go away with the pool. */
+    __qcache_drop(q,0,1);
+
     err = munmap(q->mapbase,q->mapsize);
 
     if (!err)
@@ -150,22 +501,129 @@ int rt_queue_delete (RT_QUEUE *q)
 void *rt_queue_alloc (RT_QUEUE *q,
 		      size_t size)
 {
-    void *buf;
-
-    return XENOMAI_SKINCALL3(__xeno_muxid,
-			     __xeno_queue_alloc,
-			     q,
-			     size,
-			     &buf) ? NULL : buf;
+    void *bufs[RT_QUEUE_BATCH_MAX], *buf = NULL;
+    int log2size, class, n, retried = 0;
+    struct qcache_slot *slot;
+    struct qcache *cache;
+
+    log2size = __qcache_class(q,size);
+
+ retry:
+
+    if (log2size < 0 || (cache = __qcache_get()) == NULL)
+	{
+	if (XENOMAI_SKINCALL3(__xeno_muxid,
+			      __xeno_queue_alloc,
+			      q,
+			      size,
+			      &buf) != 0)
+	    buf = NULL;
+
+	goto out;
+	}
+
+    slot = __qcache_lookup(cache,q);
+    class = log2size - QCACHE_MINLOG2;
+
+    if (slot->count[class] == 0)
+	{
+	/* Refill with blocks of the whole class size, so that any
+	   request falling into this class can reuse them. */
+	n = XENOMAI_SKINCALL4(__xeno_muxid,
+			      __xeno_queue_alloc_batch,
+			      q,
+			      (1UL << log2size) - sizeof(rt_queue_msg_t),
+			      RT_QUEUE_BATCH_MAX,
+			      bufs);
+	if (n <= 0)
+	    {
+	    __qcache_put(cache);
+	    goto out;
+	    }
+
+	while (n-- > 0)
+	    {
+	    *(void **)bufs[n] = slot->freelist[class];
+	    slot->freelist[class] = bufs[n];
+	    slot->count[class]++;
+	    }
+	}
+
+    buf = slot->freelist[class];
+    slot->freelist[class] = *(void **)buf;
+    slot->count[class]--;
+
+    __qcache_put(cache);
+
+ out:
+
+    if (!buf && !retried)
+	{
+	/* The pool may only look exhausted because of the buffers
+	   hoarded by the thread caches: give them back and retry. */
+	__qcache_drop(q,1,0);
+	retried = 1;
+	goto retry;
+	}
+
+    return buf;
 }
 
 int rt_queue_free (RT_QUEUE *q,
 		   void *buf)
 {
+    struct qcache_slot *slot;
+    struct qcache *cache;
+    int log2size, class;
+
+    log2size = __qcache_owned_class(q,buf);
+
+    if (log2size < 0 || (cache = __qcache_get()) == NULL)
+	return XENOMAI_SKINCALL2(__xeno_muxid,
+				 __xeno_queue_free,
+				 q,
+				 buf);
+
+    slot = __qcache_lookup(cache,q);
+    class = log2size - QCACHE_MINLOG2;
+
+    if (slot->count[class] >= QCACHE_DEPTH)
+	/* Keep the hoard bounded, other threads may need memory too. */
+	__qcache_flush_class(slot,class,RT_QUEUE_BATCH_MAX);
+
+    *(void **)buf = slot->freelist[class];
+    slot->freelist[class] = buf;
+    slot->count[class]++;
+
+    __qcache_put(cache);
+
+    return 0;
+}
+
+int rt_queue_reserve (RT_QUEUE *q,
+		      size_t size)
+{
+    struct qcache *cache;
+    int n;
+
+    /* Some of the buffers we cache may come from our previous
+       reserve, hand them back first so that it can be released. */
+
+    cache = __qcache_get();
+
+    if (cache)
+	{
+	for (n = 0; n < QCACHE_SLOTS; n++)
+	    if (__qcache_match(&cache->slots[n],q))
+		__qcache_flush_slot(&cache->slots[n]);
+
+	__qcache_put(cache);
+	}
+
     return XENOMAI_SKINCALL2(__xeno_muxid,
-			     __xeno_queue_free,
+			     __xeno_queue_reserve,
 			     q,
-			     buf);
+			     size);
 }
 
 int rt_queue_send (RT_QUEUE *q,
@@ -192,6 +650,81 @@ ssize_t rt_queue_recv (RT_QUEUE *q,
 			     &timeout);
 }
 
+/* Vectors larger than a syscall can carry are split; the send stops
+   at the first partial chunk, and the receive only waits for the
+   first one. */
+
+int rt_queue_send_multi (RT_QUEUE *q,
+			 void *bufs[],
+			 const size_t sizes[],
+			 int count,
+			 int mode)
+{
+    int n, ret, sent = 0;
+
+    if (count <= 0)
+	return -EINVAL;
+
+    do
+	{
+	n = count - sent;
+
+	if (n > RT_QUEUE_MULTI_MAX)
+	    n = RT_QUEUE_MULTI_MAX;
+
+	ret = XENOMAI_SKINCALL5(__xeno_muxid,
+				__xeno_queue_send_multi,
+				q,
+				bufs + sent,
+				sizes + sent,
+				n,
+				mode);
+	if (ret < 0)
+	    return sent ?: ret;
+
+	sent += ret;
+	}
+    while (ret == n && sent < count);
+
+    return sent;
+}
+
+int rt_queue_recv_multi (RT_QUEUE *q,
+			 void *bufs[],
+			 size_t sizes[],
+			 int count,
+			 RTIME timeout)
+{
+    int n, ret, rcvd = 0;
+
+    if (count <= 0)
+	return -EINVAL;
+
+    do
+	{
+	n = count - rcvd;
+
+	if (n > RT_QUEUE_MULTI_MAX)
+	    n = RT_QUEUE_MULTI_MAX;
+
+	ret = XENOMAI_SKINCALL5(__xeno_muxid,
+				__xeno_queue_recv_multi,
+				q,
+				bufs + rcvd,
+				sizes + rcvd,
+				n,
+				&timeout);
+	if (ret < 0)
+	    return rcvd ?: ret;
+
+	rcvd += ret;
+	timeout = TM_NONBLOCK;
+	}
+    while (ret == n && rcvd < count);
+
+    return rcvd;
+}
+
 int rt_queue_inquire (RT_QUEUE *q,
 		      RT_QUEUE_INFO *info)
 {
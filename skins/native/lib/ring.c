@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2026 The Xenomai project <http://www.xenomai.org>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <native/syscall.h>
+#include <native/task.h>
+#include <native/ring.h>
+
+extern int __xeno_muxid;
+
+static int __map_ring_memory (RT_RING *ring, RT_RING_PLACEHOLDER *php)
+
+{
+    int err, heapfd;
+
+    /* Open the heap device to share the ring memory with the
+       in-kernel skin and bound clients. */
+    heapfd = open(XNHEAP_DEV_NAME,O_RDWR);
+
+    if (heapfd < 0)
+	return -ENOENT;
+
+    /* Bind this file instance to the shared heap. */
+    err = ioctl(heapfd,0,php->opaque2);
+
+    if (err)
+	goto close_and_exit;
+
+    /* Map the heap memory into our address space. */
+    php->mapbase = (caddr_t)mmap(NULL,
+				 php->mapsize,
+				 PROT_READ|PROT_WRITE,
+				 MAP_SHARED,
+				 heapfd,
+				 0L);
+
+    if (php->mapbase != MAP_FAILED)
+	{
+	php->ctl = (rt_ring_ctl_t *)(php->mapbase + php->ctloff);
+	/* Copy back a complete placeholder only if all is ok. */
+	*ring = *php;
+	}
+    else
+	err = -ENOMEM;
+
+ close_and_exit:
+
+    close(heapfd);
+
+    return err;
+}
+
+int rt_ring_create (RT_RING *ring,
+		    const char *name,
+		    size_t size,
+		    int mode)
+{
+    RT_RING_PLACEHOLDER ph;
+    int err;
+
+    err = XENOMAI_SKINCALL4(__xeno_muxid,
+			    __xeno_ring_create,
+			    &ph,
+			    name,
+			    size,
+			    mode|R_SHARED);
+    if (err)
+	return err;
+
+    err = __map_ring_memory(ring,&ph);
+
+    if (err)
+	/* If the mapping fails, make sure we don't leave a dandling
+	   ring in kernel space -- remove it. */
+	XENOMAI_SKINCALL1(__xeno_muxid,
+			  __xeno_ring_delete,
+			  &ph);
+    return err;
+}
+
+int rt_ring_bind (RT_RING *ring,
+		  const char *name,
+		  RTIME timeout)
+{
+    RT_RING_PLACEHOLDER ph;
+    int err;
+
+    err = XENOMAI_SKINCALL3(__xeno_muxid,
+			    __xeno_ring_bind,
+			    &ph,
+			    name,
+			    &timeout);
+
+    return err ?: __map_ring_memory(ring,&ph);
+}
+
+int rt_ring_unbind (RT_RING *ring)
+
+{
+    int err = munmap(ring->mapbase,ring->mapsize);
+
+    ring->opaque = RT_HANDLE_INVALID;
+    ring->mapbase = NULL;
+    ring->mapsize = 0;
+    ring->ctl = NULL;
+
+    return err;
+}
+
+int rt_ring_delete (RT_RING *ring)
+
+{
+    int err;
+
+    err = munmap(ring->mapbase,ring->mapsize);
+
+    if (!err)
+	err = XENOMAI_SKINCALL1(__xeno_muxid,
+				__xeno_ring_delete,
+				ring);
+
+    /* If the deletion fails, there is likely something fishy about
+       this ring descriptor, so we'd better clean it up anyway so
+       that it could not be further used. */
+
+    ring->opaque = RT_HANDLE_INVALID;
+    ring->mapbase = NULL;
+    ring->mapsize = 0;
+    ring->ctl = NULL;
+
+    return err;
+}
+
+/* Records are moved through the shared mapping directly; the kernel
+   is only entered to wait for room or data, and to wake up a peer
+   which raised its waiter flag. The kernel updates the timeout with
+   the time left after each wait, so that retrying does not extend
+   the overall delay. */
+
+int rt_ring_write (RT_RING *ring,
+		   const void *buf,
+		   size_t size,
+		   RTIME timeout)
+{
+    int err;
+
+    if (ring->ctl == NULL)
+	return -EINVAL;
+
+    while ((err = __rt_ring_put(ring->ctl,ring->ctl->size,buf,size)) == -EWOULDBLOCK)
+	{
+	if (timeout == TM_NONBLOCK)
+	    return err;
+
+	err = XENOMAI_SKINCALL4(__xeno_muxid,
+				__xeno_ring_pend,
+				ring,
+				R_WRITE,
+				size,
+				&timeout);
+	if (err)
+	    return err;
+	}
+
+    if (!err && __rt_ring_wakeup_p(ring->ctl,R_READ))
+	XENOMAI_SKINCALL2(__xeno_muxid,
+			  __xeno_ring_post,
+			  ring,
+			  R_READ);
+    return err;
+}
+
+ssize_t rt_ring_read (RT_RING *ring,
+		      void *buf,
+		      size_t size,
+		      RTIME timeout)
+{
+    ssize_t ret;
+    int err;
+
+    if (ring->ctl == NULL)
+	return -EINVAL;
+
+    while ((ret = __rt_ring_get(ring->ctl,ring->ctl->size,buf,size)) == -EWOULDBLOCK)
+	{
+	if (timeout == TM_NONBLOCK)
+	    return ret;
+
+	err = XENOMAI_SKINCALL4(__xeno_muxid,
+				__xeno_ring_pend,
+				ring,
+				R_READ,
+				0,
+				&timeout);
+	if (err)
+	    return err;
+	}
+
+    if (ret >= 0 && __rt_ring_wakeup_p(ring->ctl,R_WRITE))
+	XENOMAI_SKINCALL2(__xeno_muxid,
+			  __xeno_ring_post,
+			  ring,
+			  R_WRITE);
+    return ret;
+}
+
+int rt_ring_inquire (RT_RING *ring,
+		     RT_RING_INFO *info)
+{
+    return XENOMAI_SKINCALL2(__xeno_muxid,
+			     __xeno_ring_inquire,
+			     ring,
+			     info);
+}
@@ -339,6 +339,23 @@ int rt_task_slice (RT_TASK *task,
 			     &quantum);
 }
 
+#ifdef CONFIG_XENO_OPT_BUDGET
+
+int rt_task_set_budget (RT_TASK *task,
+			RTIME budget,
+			RTIME period,
+			int mode)
+{
+    return XENOMAI_SKINCALL4(__xeno_muxid,
+			     __xeno_task_set_budget,
+			     task,
+			     &budget,
+			     &period,
+			     mode);
+}
+
+#endif /* CONFIG_XENO_OPT_BUDGET */
+
 #ifdef CONFIG_XENO_OPT_NATIVE_MPS
 
 ssize_t rt_task_send (RT_TASK *task,
@@ -16,11 +16,14 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
  */
 
+#include <nucleus/vdso.h>
 #include <native/syscall.h>
 #include <native/task.h>
 
 extern int __xeno_muxid;
 
+extern xnvdso_t *__xeno_vdso;
+
 int rt_timer_start (RTIME tickval)
 
 {
@@ -40,6 +43,17 @@ RTIME rt_timer_read (void)
 
 {
     RTIME now;
+#ifdef CONFIG_XENO_HW_DIRECT_TSC
+    xnvdso_t *vdso = __xeno_vdso;
+    long long offset;
+
+    /* In aperiodic mode, the nucleus time is the CPU time converted
+       to nanoseconds, plus the wallclock offset: no need to ask the
+       kernel for this. */
+
+    if (vdso && xnvdso_read_state(vdso,&offset) == XNVDSO_POD)
+	return xnarch_uscale(&vdso->tsc2ns,__xn_rdtsc()) + offset;
+#endif /* CONFIG_XENO_HW_DIRECT_TSC */
 
     XENOMAI_SKINCALL1(__xeno_muxid,
 		      __xeno_timer_read,
@@ -92,6 +106,9 @@ SRTIME rt_timer_ns2tsc (SRTIME ns)
 {
     RTIME ticks;
 
+    if (__xeno_vdso)
+	return xnarch_scale(&__xeno_vdso->ns2tsc,ns);
+
     XENOMAI_SKINCALL2(__xeno_muxid,
 		      __xeno_timer_ns2tsc,
 		      &ticks,
@@ -104,6 +121,9 @@ SRTIME rt_timer_tsc2ns (SRTIME ticks)
 {
     SRTIME ns;
 
+    if (__xeno_vdso)
+	return xnarch_scale(&__xeno_vdso->tsc2ns,ticks);
+
     XENOMAI_SKINCALL2(__xeno_muxid,
 		      __xeno_timer_tsc2ns,
 		      &ns,
@@ -44,6 +44,7 @@
 #include <native/heap.h>
 #include <native/alarm.h>
 #include <native/intr.h>
+#include <native/ring.h>
 
 MODULE_DESCRIPTION("Native skin");
 MODULE_AUTHOR("rpm@xenomai.org");
@@ -56,6 +57,10 @@ static xnpod_t __xeno_pod;
 static void xeno_shutdown (int xtype)
 
 {
+#ifdef CONFIG_XENO_OPT_NATIVE_RING
+    __ring_pkg_cleanup();
+#endif /* CONFIG_XENO_OPT_NATIVE_RING */
+
 #ifdef CONFIG_XENO_OPT_NATIVE_INTR
     __intr_pkg_cleanup();
 #endif /* CONFIG_XENO_OPT_NATIVE_INTR */
@@ -199,11 +204,18 @@ int __xeno_skin_init (void)
 	goto cleanup_alarm;
 #endif /* CONFIG_XENO_OPT_NATIVE_INTR */
 
+#ifdef CONFIG_XENO_OPT_NATIVE_RING
+    err = __ring_pkg_init();
+
+    if (err)
+	goto cleanup_intr;
+#endif /* CONFIG_XENO_OPT_NATIVE_RING */
+
 #if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
     err = __xeno_syscall_init();
 
     if (err)
-	goto cleanup_intr;
+	goto cleanup_ring;
 #endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
     
     xnprintf("starting native API services.\n");
@@ -211,9 +223,15 @@ int __xeno_skin_init (void)
     return 0;	/* SUCCESS. */
 
 #if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
- cleanup_intr:
+ cleanup_ring:
 #endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
 
+#ifdef CONFIG_XENO_OPT_NATIVE_RING
+    __ring_pkg_cleanup();
+
+ cleanup_intr:
+#endif /* CONFIG_XENO_OPT_NATIVE_RING */
+
 #ifdef CONFIG_XENO_OPT_NATIVE_INTR
     __intr_pkg_cleanup();
 
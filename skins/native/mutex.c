@@ -73,13 +73,13 @@ static int __mutex_read_proc (char *page,
 		     xnthread_name(&mutex->owner->thread_base),
 		     mutex->lockcnt);
 
-	holder = getheadpq(xnsynch_wait_queue(&mutex->synch_base));
+	holder = synch_getheadpq(xnsynch_wait_queue(&mutex->synch_base));
 
 	while (holder)
 	    {
 	    xnthread_t *sleeper = link2thread(holder,plink);
 	    p += sprintf(p,"+%s\n",xnthread_name(sleeper));
-	    holder = nextpq(xnsynch_wait_queue(&mutex->synch_base),holder);
+	    holder = synch_nextpq(xnsynch_wait_queue(&mutex->synch_base),holder);
 	    }
 	}
     else
@@ -157,15 +157,21 @@ static RT_OBJECT_PROCNODE __mutex_pnode = {
  * Rescheduling: possible.
  */
 
-int rt_mutex_create (RT_MUTEX *mutex,
-		     const char *name)
+static int __mutex_create (RT_MUTEX *mutex,
+			   const char *name,
+			   xnflags_t flags,
+			   int ceiling)
 {
     int err = 0;
 
     if (xnpod_asynch_p())
 	return -EPERM;
 
-    xnsynch_init(&mutex->synch_base,XNSYNCH_PRIO|XNSYNCH_PIP);
+    xnsynch_init(&mutex->synch_base,flags);
+
+    if (flags & XNSYNCH_PCP)
+	xnsynch_set_ceiling(&mutex->synch_base,ceiling);
+
     mutex->handle = 0;  /* i.e. (still) unregistered mutex. */
     mutex->magic = XENO_MUTEX_MAGIC;
     mutex->owner = NULL;
@@ -204,6 +210,73 @@ int rt_mutex_create (RT_MUTEX *mutex,
     return err;
 }
 
+int rt_mutex_create (RT_MUTEX *mutex,
+		     const char *name)
+{
+    return __mutex_create(mutex,name,XNSYNCH_PRIO|XNSYNCH_PIP,0);
+}
+
+/**
+ * @fn int rt_mutex_create_ceiling(RT_MUTEX *mutex,const char *name,int ceiling)
+ *
+ * @brief Create a mutex enforcing the priority ceiling protocol.
+ *
+ * Create a mutex like rt_mutex_create() does, except that the
+ * immediate priority ceiling protocol is used instead of priority
+ * inheritance: a task acquiring the mutex is raised to the @a ceiling
+ * priority at once if its current priority is lower, then restored
+ * when it releases the mutex. Contending for such mutex never causes
+ * the priority of its owner to be changed.
+ *
+ * @param mutex The address of a mutex descriptor Xenomai will use to
+ * store the mutex-related data.  This descriptor must always be valid
+ * while the mutex is active therefore it must be allocated in
+ * permanent memory.
+ *
+ * @param name An ASCII string standing for the symbolic name of the
+ * mutex. When non-NULL and non-empty, this string is copied to a safe
+ * place into the descriptor, and passed to the registry package if
+ * enabled for indexing the created mutex.
+ *
+ * @param ceiling The ceiling priority, which should be the highest
+ * priority of all the tasks which may lock the mutex. This value must
+ * range from [1 .. 99] (inclusive).
+ *
+ * @return 0 is returned upon success. Otherwise:
+ *
+ * - -EINVAL is returned if @a ceiling is invalid.
+ *
+ * - -ENOMEM is returned if the system fails to get enough dynamic
+ * memory from the global real-time heap in order to register the
+ * mutex.
+ *
+ * - -EEXIST is returned if the @a name is already in use by some
+ * registered object.
+ *
+ * - -EPERM is returned if this service was called from an
+ * asynchronous context.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: possible.
+ */
+
+int rt_mutex_create_ceiling (RT_MUTEX *mutex,
+			     const char *name,
+			     int ceiling)
+{
+    if (ceiling < T_LOPRIO || ceiling > T_HIPRIO)
+	return -EINVAL;
+
+    return __mutex_create(mutex,name,XNSYNCH_PRIO|XNSYNCH_PCP,ceiling);
+}
+
 /**
  * @fn int rt_mutex_delete(RT_MUTEX *mutex)
  *
@@ -465,6 +538,9 @@ int rt_mutex_unlock (RT_MUTEX *mutex)
 	mutex->lockcnt = 1;
 	xnpod_schedule();
 	}
+    else if (xnsynch_test_flags(&mutex->synch_base,XNSYNCH_PCP))
+	/* Dropping the ceiling may have lowered our priority. */
+	xnpod_schedule();
 
  unlock_and_exit:
 
@@ -620,6 +696,7 @@ void __mutex_pkg_cleanup (void)
 /*@}*/
 
 EXPORT_SYMBOL(rt_mutex_create);
+EXPORT_SYMBOL(rt_mutex_create_ceiling);
 EXPORT_SYMBOL(rt_mutex_delete);
 EXPORT_SYMBOL(rt_mutex_lock);
 EXPORT_SYMBOL(rt_mutex_unlock);
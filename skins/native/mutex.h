@@ -111,6 +111,10 @@ extern "C" {
 int rt_mutex_create(RT_MUTEX *mutex,
 		    const char *name);
 
+int rt_mutex_create_ceiling(RT_MUTEX *mutex,
+			    const char *name,
+			    int ceiling);
+
 int rt_mutex_delete(RT_MUTEX *mutex);
 
 int rt_mutex_lock(RT_MUTEX *mutex,
@@ -96,6 +96,34 @@ static inline ssize_t __pipe_flush (RT_PIPE *pipe)
     /* The buffer will be freed by the output handler. */
 }
 
+/* Copy a message directly to the shared ring of a pipe switched to
+   ring mode from the Linux side. -ENXIO is returned if the pipe is not
+   in ring mode, or if streamed data must be flushed first. */
+
+static ssize_t __pipe_put (RT_PIPE *pipe,
+			   const void *buf,
+			   size_t size,
+			   int mode)
+{
+    ssize_t n;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    pipe = xeno_h2obj_validate(pipe,XENO_PIPE_MAGIC,RT_PIPE);
+
+    if (!pipe)
+	n = xeno_handle_error(pipe,XENO_PIPE_MAGIC,RT_PIPE);
+    else if (test_bit(0,&pipe->flushable))
+	n = -ENXIO;
+    else
+	n = xnpipe_put(pipe->minor,buf,size,mode);
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return n;
+}
+
 static void __pipe_flush_handler (void *cookie)
 
 {
@@ -622,7 +650,7 @@ ssize_t rt_pipe_read (RT_PIPE *pipe,
  * @param mode A set of flags affecting the operation:
  *
  * - P_URGENT causes the message to be prepended to the output
- * queue, ensuring a LIFO ordering.
+ * queue, ensuring a LIFO ordering. This flag is ignored in ring mode.
  *
  * - P_NORMAL causes the message to be appended to the output
  * queue, ensuring a FIFO ordering.
@@ -636,6 +664,10 @@ ssize_t rt_pipe_read (RT_PIPE *pipe,
  * - -EPIPE is returned if the associated special device is not yet
  * open.
  *
+ * - -ENOSPC is returned if the pipe is in ring mode and the shared
+ * ring has not enough free space to hold the message, which is then
+ * dropped and accounted for in the ring's @a lost counter.
+ *
  * - -EIDRM is returned if @a pipe is a closed pipe descriptor.
  *
  * - -ENODEV or -EBADF are returned if @a pipe is scrambled.
@@ -707,7 +739,9 @@ ssize_t rt_pipe_send (RT_PIPE *pipe,
  * @param pipe The descriptor address of the pipe to write to.
  *
  * @param buf The address of the first data byte to send. The
- * data will be copied to an internal buffer before transmission.
+ * data will be copied to an internal buffer before transmission, or
+ * directly to the shared ring if the Linux side switched the pipe to
+ * ring mode (see XNPIPEIOC_SETRING).
  *
  * @param size The size in bytes of the message (payload data
  * only). Zero is a valid value, in which case the service returns
@@ -722,7 +756,7 @@ ssize_t rt_pipe_send (RT_PIPE *pipe,
  * @param mode A set of flags affecting the operation:
  *
  * - P_URGENT causes the message to be prepended to the output
- * queue, ensuring a LIFO ordering.
+ * queue, ensuring a LIFO ordering. This flag is ignored in ring mode.
  *
  * - P_NORMAL causes the message to be appended to the output
  * queue, ensuring a FIFO ordering.
@@ -736,6 +770,10 @@ ssize_t rt_pipe_send (RT_PIPE *pipe,
  * - -EPIPE is returned if the associated special device is not yet
  * open.
  *
+ * - -ENOSPC is returned if the pipe is in ring mode and the shared
+ * ring has not enough free space to hold the message, which is then
+ * dropped and accounted for in the ring's @a lost counter.
+ *
  * - -ENOMEM is returned if not enough buffer space is available to
  * complete the operation.
  *
@@ -767,6 +805,12 @@ ssize_t rt_pipe_write (RT_PIPE *pipe,
 	/* Try flushing the streaming buffer in any case. */
 	return rt_pipe_send(pipe,NULL,0,mode);
 
+    /* No intermediate buffer is needed in ring mode. */
+    nbytes = __pipe_put(pipe,buf,size,mode);
+
+    if (nbytes != -ENXIO)
+	return nbytes;
+
     msg = rt_pipe_alloc(size);
 	
     if (!msg)
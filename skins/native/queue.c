@@ -45,6 +45,9 @@
 #include <native/queue.h>
 #include <native/registry.h>
 
+/* All reserves, so that those of a deleted task can be found. */
+static DECLARE_XNQUEUE(__xeno_qrsv_q);
+
 #ifdef CONFIG_XENO_NATIVE_EXPORT_REGISTRY
 
 static int __queue_read_proc (char *page,
@@ -55,6 +58,9 @@ static int __queue_read_proc (char *page,
 			      void *data)
 {
     RT_QUEUE *q = (RT_QUEUE *)data;
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+    xnheap_magstat_t stat;
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
     char *p = page;
     int len;
     spl_t s;
@@ -65,6 +71,16 @@ static int __queue_read_proc (char *page,
 		 q->qlimit,
 		 countq(&q->pendq));
 
+#ifdef CONFIG_XENO_OPT_HEAP_MAGAZINE
+    xnheap_get_magstat(&q->bufpool,-1,&stat);
+
+    p += sprintf(p,"magazine:hits=%lu:misses=%lu:refills=%lu:flushes=%lu\n",
+		 stat.hits,
+		 stat.misses,
+		 stat.refills,
+		 stat.flushes);
+#endif /* CONFIG_XENO_OPT_HEAP_MAGAZINE */
+
     xnlock_get_irqsave(&nklock,s);
 
     if (xnsynch_nsleepers(&q->synch_base) > 0)
@@ -73,13 +89,13 @@ static int __queue_read_proc (char *page,
 	
 	/* Pended queue -- dump waiters. */
 
-	holder = getheadpq(xnsynch_wait_queue(&q->synch_base));
+	holder = synch_getheadpq(xnsynch_wait_queue(&q->synch_base));
 
 	while (holder)
 	    {
 	    xnthread_t *sleeper = link2thread(holder,plink);
 	    p += sprintf(p,"+%s\n",xnthread_name(sleeper));
-	    holder = nextpq(xnsynch_wait_queue(&q->synch_base),holder);
+	    holder = synch_nextpq(xnsynch_wait_queue(&q->synch_base),holder);
 	    }
 	}
 
@@ -120,6 +136,77 @@ static void __queue_flush_private (xnheap_t *heap,
     xnarch_sysfree(poolmem,poolsize);
 }
 
+static inline rt_queue_rsv_t *__queue_find_rsv (RT_QUEUE *q,
+						 xnthread_t *thread)
+{
+    xnholder_t *holder;
+
+    for (holder = getheadq(&q->rsvq);
+	 holder; holder = nextq(&q->rsvq,holder))
+	if (link2rsv(holder)->owner == thread)
+	    return link2rsv(holder);
+
+    return NULL;
+}
+
+static inline xnheap_t *__queue_msg_heap (RT_QUEUE *q,
+					  rt_queue_msg_t *msg)
+{
+    xnholder_t *holder;
+
+    for (holder = getheadq(&q->rsvq);
+	 holder; holder = nextq(&q->rsvq,holder))
+	if (xnheap_check_block(&link2rsv(holder)->heap,msg))
+	    return &link2rsv(holder)->heap;
+
+    return &q->bufpool;
+}
+
+static void __queue_drop_reserves (RT_QUEUE *q)
+
+{
+    xnholder_t *holder;
+    rt_queue_rsv_t *rsv;
+
+    while ((holder = getq(&q->rsvq)) != NULL)
+	{
+	rsv = link2rsv(holder);
+	removeq(&__xeno_qrsv_q,&rsv->glink);
+	xnheap_destroy(&rsv->heap,NULL,NULL);
+	xnfree(rsv);
+	}
+}
+
+static void __queue_delete_hook (xnthread_t *thread)
+
+{
+    xnholder_t *holder, *nholder;
+    rt_queue_rsv_t *rsv;
+
+    /* The nklock is held while hooks are running. Reserves still
+       holding buffers in use are orphaned: they stay in their queue
+       until it is deleted, and buffers may still be freed to them,
+       but they are no longer drawn from. */
+
+    for (holder = getheadq(&__xeno_qrsv_q); holder; holder = nholder)
+	{
+	nholder = nextq(&__xeno_qrsv_q,holder);
+	rsv = glink2rsv(holder);
+
+	if (rsv->owner != thread)
+	    continue;
+
+	rsv->owner = NULL;
+
+	if (xnheap_destroy_reserve(&rsv->heap) == 0)
+	    {
+	    removeq(&rsv->q->rsvq,&rsv->link);
+	    removeq(&__xeno_qrsv_q,&rsv->glink);
+	    xnfree(rsv);
+	    }
+	}
+}
+
 /**
  * @fn int rt_queue_create(RT_QUEUE *q,const char *name,size_t poolsize,size_t qlimit,int mode)
  *
@@ -174,6 +261,14 @@ static void __queue_flush_private (xnheap_t *heap,
  * operations with I/O devices. A 128Kb limit exists for @a poolsize
  * when this flag is passed.
  *
+ * - Q_LARGE causes the buffer pool associated to the queue to be
+ * allocated as a single block of physically contiguous pages, taken
+ * from the memory node of the current CPU. This reduces the TLB
+ * pressure when accessing large shared pools, both from kernel and
+ * user-space. Q_NODE(n) may be passed instead to allocate from
+ * memory node @a n. These flags are only meaningful along with
+ * Q_SHARED.
+ *
  * @return 0 is returned upon success. Otherwise:
  *
  * - -EEXIST is returned if the @a name is already in use by some
@@ -238,9 +333,15 @@ int rt_queue_create (RT_QUEUE *q,
 	    return -EINVAL;
 
 #ifdef CONFIG_XENO_OPT_PERVASIVE
-	err = xnheap_init_shared(&q->bufpool,
-				 poolsize,
-				 (mode & Q_DMA) ? GFP_DMA : 0);
+	if (mode & Q_LARGE)
+	    err = xnheap_init_shared_node(&q->bufpool,
+					  poolsize,
+					  (mode & Q_DMA) ? GFP_DMA : 0,
+					  Q_NODE_OF(mode));
+	else
+	    err = xnheap_init_shared(&q->bufpool,
+				     poolsize,
+				     (mode & Q_DMA) ? GFP_DMA : 0);
 	if (err)
 	    return err;
 
@@ -270,12 +371,17 @@ int rt_queue_create (RT_QUEUE *q,
 
     xnsynch_init(&q->synch_base,mode & (Q_PRIO|Q_FIFO));
     initq(&q->pendq);
+    initq(&q->rsvq);
+    xnselect_init(&q->select,0);
     q->handle = 0;  /* i.e. (still) unregistered queue. */
     q->magic = XENO_QUEUE_MAGIC;
     q->qlimit = qlimit;
     q->mode = mode;
     xnobject_copy_name(q->name,name);
 
+    if (name && *name)
+	xnheap_set_label(&q->bufpool,q->name);
+
 #ifdef CONFIG_XENO_OPT_NATIVE_REGISTRY
     /* <!> Since rt_register_enter() may reschedule, only register
        complete objects, so that the registry cannot return handles to
@@ -364,8 +470,14 @@ int rt_queue_delete (RT_QUEUE *q)
     if (err)
 	goto unlock_and_exit;
 
+    /* The reserved memory went away with the pool. */
+    __queue_drop_reserves(q);
+
     rc = xnsynch_destroy(&q->synch_base);
 
+    if (xnselect_destroy(&q->select))
+	rc = XNSYNCH_RESCHED;
+
 #ifdef CONFIG_XENO_OPT_NATIVE_REGISTRY
     if (q->handle)
         rt_registry_remove(q->handle);
@@ -394,6 +506,13 @@ int rt_queue_delete (RT_QUEUE *q)
  * pool which can be subsequently filled by the caller then passed to
  * rt_queue_send() for sending.
  *
+ * In user-space, buffers of up to a page are served from a per-thread
+ * cache which is refilled from the pool by batches, so that most
+ * allocations do not enter the kernel. Symmetrically, rt_queue_free()
+ * returns exclusively owned buffers to the caller's cache, which
+ * gives them back to the pool when it grows too large or when the
+ * thread exits.
+ *
  * @param q The descriptor address of the affected queue.
  *
  * @param size The requested size in bytes of the buffer. Zero is an
@@ -431,7 +550,19 @@ void *rt_queue_alloc (RT_QUEUE *q,
 	return NULL;
         }
     
-    msg = (rt_queue_msg_t *)xnheap_alloc(&q->bufpool,size + sizeof(rt_queue_msg_t));
+    msg = NULL;
+
+    if (countq(&q->rsvq) > 0 && !xnpod_asynch_p())
+	{
+	/* Tasks holding a reserve draw from it first. */
+	rt_queue_rsv_t *rsv = __queue_find_rsv(q,xnpod_current_thread());
+
+	if (rsv)
+	    msg = (rt_queue_msg_t *)xnheap_alloc(&rsv->heap,size + sizeof(rt_queue_msg_t));
+	}
+
+    if (!msg)
+	msg = (rt_queue_msg_t *)xnheap_alloc(&q->bufpool,size + sizeof(rt_queue_msg_t));
 
     if (msg)
 	{
@@ -511,7 +642,7 @@ int rt_queue_free (RT_QUEUE *q,
         goto unlock_and_exit;
         }
     
-    err = xnheap_test_and_free(&q->bufpool,
+    err = xnheap_test_and_free(__queue_msg_heap(q,((rt_queue_msg_t *)buf) - 1),
 			       ((rt_queue_msg_t *)buf) - 1,
 			       &__queue_check_msg);
     if (err == -EBUSY)
@@ -526,6 +657,142 @@ int rt_queue_free (RT_QUEUE *q,
     return err;
 }
 
+/**
+ * @fn int rt_queue_reserve(RT_QUEUE *q,size_t size)
+ *
+ * @brief Reserve message buffer memory for the current task.
+ *
+ * This service sets aside @a size bytes of the queue's buffer pool
+ * for the exclusive use of the calling task. rt_queue_alloc() serves
+ * the requests of this task from its reserve first, falling back to
+ * the shared part of the pool when the reserve is exhausted, so that
+ * other tasks filling up the pool cannot starve it from memory.
+ * Buffers are returned to the reserve by rt_queue_free(), regardless
+ * of the task releasing them.
+ *
+ * A reserve is a private sub-heap of the pool, so the usual
+ * rounding and fragmentation rules of the heap manager apply within
+ * it. Each reserve is listed in /proc/xenomai/heap, under a label
+ * made of the queue and task names.
+ *
+ * @param q The descriptor address of the affected queue.
+ *
+ * @param size The amount of memory to reserve. Passing zero releases
+ * the reserve of the calling task. Any reserve previously held by
+ * the calling task on this queue is replaced.
+ *
+ * @return 0 is returned upon success. Otherwise:
+ *
+ * - -EINVAL is returned if @a q is not a message queue descriptor.
+ *
+ * - -EIDRM is returned if @a q is a deleted queue descriptor.
+ *
+ * - -ENOMEM is returned if the pool has no free memory range large
+ * enough for the reserve. The previous reserve, if any, has been
+ * released in this case.
+ *
+ * - -EBUSY is returned if the previous reserve of the calling task
+ * cannot be released because some of its buffers are still in use.
+ *
+ * - -EPERM is returned if this service was called from a context
+ * which is not a real-time task.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel-based task
+ * - User-space task (switches to primary mode)
+ *
+ * Rescheduling: never.
+ *
+ * @note The reserves of a task are returned to the pool when the
+ * task is deleted. A reserve which still holds buffers in use at
+ * that time is only returned to the pool upon deletion of the queue.
+ */
+
+int rt_queue_reserve (RT_QUEUE *q,
+		      size_t size)
+{
+    rt_queue_rsv_t *rsv, *oldrsv;
+    xnthread_t *curr;
+    int err = 0;
+    spl_t s;
+
+    if (xnpod_asynch_p() || xnpod_root_p())
+	return -EPERM;
+
+    curr = xnpod_current_thread();
+
+    if (size > 0)
+	{
+	rsv = (rt_queue_rsv_t *)xnmalloc(sizeof(*rsv));
+
+	if (!rsv)
+	    return -ENOMEM;
+	}
+    else
+	rsv = NULL;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    q = xeno_h2obj_validate(q,XENO_QUEUE_MAGIC,RT_QUEUE);
+
+    if (!q)
+        {
+        err = xeno_handle_error(q,XENO_QUEUE_MAGIC,RT_QUEUE);
+        goto unlock_and_exit;
+        }
+
+    oldrsv = __queue_find_rsv(q,curr);
+
+    if (oldrsv)
+	{
+	err = xnheap_destroy_reserve(&oldrsv->heap);
+
+	if (err)
+	    goto unlock_and_exit;
+
+	removeq(&q->rsvq,&oldrsv->link);
+	removeq(&__xeno_qrsv_q,&oldrsv->glink);
+	xnfree(oldrsv);
+	}
+
+    if (rsv)
+	{
+	err = xnheap_init_reserve(&q->bufpool,&rsv->heap,size);
+
+	if (err)
+	    goto unlock_and_exit;
+
+	rsv->owner = curr;
+	rsv->q = q;
+	inith(&rsv->link);
+	appendq(&q->rsvq,&rsv->link);
+	inith(&rsv->glink);
+	appendq(&__xeno_qrsv_q,&rsv->glink);
+
+#ifdef CONFIG_XENO_OPT_STATS
+	snprintf(rsv->heap.label,
+		 sizeof(rsv->heap.label),
+		 "%s:%s",
+		 q->name,
+		 xnthread_name(curr));
+#endif /* CONFIG_XENO_OPT_STATS */
+
+	rsv = NULL;
+	}
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    if (rsv)
+	xnfree(rsv);
+
+    return err;
+}
+
 /**
  * @fn int rt_queue_send(RT_QUEUE *q,void *buf,size_t size,int mode)
  *
@@ -653,6 +920,9 @@ int rt_queue_send (RT_QUEUE *q,
 	    prependq(&q->pendq,&msg->link);
 	else
 	    appendq(&q->pendq,&msg->link);
+
+	if (xnselect_signal(&q->select,1))
+	    xnpod_schedule();
 	}
 
     err = nrecv;
@@ -664,6 +934,152 @@ int rt_queue_send (RT_QUEUE *q,
     return err;
 }
 
+/**
+ * @fn int rt_queue_send_multi(RT_QUEUE *q,void *bufs[],const size_t sizes[],int count,int mode)
+ *
+ * @brief Send a vector of messages to a queue.
+ *
+ * This service sends several complete messages to a given queue in a
+ * single operation. Each message is handed over to the next task
+ * waiting on the queue, or enqueued if none is waiting; the tasks
+ * awaken by the whole operation are rescheduled at once on return.
+ *
+ * @param q The descriptor address of the message queue to send to.
+ *
+ * @param bufs An array of @a count message addresses, obtained from
+ * rt_queue_alloc(). Messages are sent in array order. The same
+ * ownership rules as with rt_queue_send() apply to each of them once
+ * sent.
+ *
+ * @param sizes An array of @a count message sizes in bytes.
+ *
+ * @param count The number of messages to send.
+ *
+ * @param mode A set of flags affecting the operation:
+ *
+ * - Q_URGENT causes the messages to be prepended to the message
+ * queue, before any message already pending. They still keep their
+ * relative order.
+ *
+ * - Q_NORMAL causes the messages to be appended to the message queue,
+ * ensuring a FIFO ordering.
+ *
+ * Q_BROADCAST is not supported by this service.
+ *
+ * @return Upon success, this service returns the number of messages
+ * sent, which is less than @a count if the queue limit was reached or
+ * an invalid buffer was met. The messages which have not been sent
+ * are still owned by the caller. If no message could be sent, one of
+ * the following error codes is returned:
+ *
+ * - -EINVAL is returned if @a q is not a message queue descriptor,
+ * @a count is not positive, @a mode contains Q_BROADCAST, or the
+ * first buffer is not a valid message buffer.
+ *
+ * - -EIDRM is returned if @a q is a deleted queue descriptor.
+ *
+ * - -ENOMEM is returned if queuing the first message would exceed the
+ * limit defined for the queue at creation.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: possible.
+ */
+
+int rt_queue_send_multi (RT_QUEUE *q,
+			 void *bufs[],
+			 const size_t sizes[],
+			 int count,
+			 int mode)
+{
+    xnholder_t *pos = NULL;
+    xnthread_t *sleeper;
+    rt_queue_msg_t *msg;
+    int err, n, nrecv = 0;
+    spl_t s;
+
+    if (count <= 0 || (mode & Q_BROADCAST))
+	return -EINVAL;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    q = xeno_h2obj_validate(q,XENO_QUEUE_MAGIC,RT_QUEUE);
+
+    if (!q)
+        {
+        err = xeno_handle_error(q,XENO_QUEUE_MAGIC,RT_QUEUE);
+        goto unlock_and_exit;
+        }
+
+    for (n = 0, err = 0; n < count; n++)
+	{
+	if (bufs[n] == NULL)
+	    {
+	    err = -EINVAL;
+	    break;
+	    }
+
+	msg = ((rt_queue_msg_t *)bufs[n]) - 1;
+
+	if (msg->refcount == 0)
+	    {
+	    err = -EINVAL;
+	    break;
+	    }
+
+	sleeper = xnsynch_wakeup_one_sleeper(&q->synch_base);
+
+	if (sleeper)
+	    {
+	    /* Ownership goes straight to the receiver. */
+	    thread2rtask(sleeper)->wait_args.qmsg = msg;
+	    msg->size = sizes[n];
+	    nrecv++;
+	    continue;
+	    }
+
+	if (q->qlimit != Q_UNLIMITED && countq(&q->pendq) >= q->qlimit)
+	    {
+	    err = -ENOMEM;
+	    break;
+	    }
+
+	msg->refcount--;
+	msg->size = sizes[n];
+
+	if (!(mode & Q_URGENT))
+	    appendq(&q->pendq,&msg->link);
+	else if (pos == NULL)
+	    prependq(&q->pendq,&msg->link);
+	else
+	    /* Keep urgent messages in array order. */
+	    insertq(&q->pendq,pos->next,&msg->link);
+
+	pos = &msg->link;
+	}
+
+    /* A single rescheduling pass for all the receivers. */
+
+    if (xnselect_signal(&q->select,countq(&q->pendq) != 0) || nrecv > 0)
+	xnpod_schedule();
+
+    if (n > 0)
+	err = n;
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
 /**
  * @fn ssize_t rt_queue_recv(RT_QUEUE *q,void **bufp,RTIME timeout)
  *
@@ -755,6 +1171,7 @@ ssize_t rt_queue_recv (RT_QUEUE *q,
         {
 	msg = link2rtmsg(holder);
 	msg->refcount++;
+	xnselect_signal(&q->select,countq(&q->pendq) != 0);
 	}
     else
 	{
@@ -800,6 +1217,160 @@ ssize_t rt_queue_recv (RT_QUEUE *q,
     return err;
 }
 
+/**
+ * @fn int rt_queue_recv_multi(RT_QUEUE *q,void *bufs[],size_t sizes[],int count,RTIME timeout)
+ *
+ * @brief Receive a vector of messages from a queue.
+ *
+ * This service retrieves up to @a count messages from the given
+ * queue in a single operation. Unless otherwise specified, the caller
+ * is blocked for a given amount of time if no message is immediately
+ * available on entry; once a message has been received, the call
+ * never blocks again and returns the messages pending at this time.
+ *
+ * @param q The descriptor address of the message queue to receive
+ * from.
+ *
+ * @param bufs An array of @a count entries, the first of which are
+ * written upon success with the addresses of the received messages,
+ * in queue order. Once consumed, each message space should be freed
+ * using rt_queue_free().
+ *
+ * @param sizes An array of @a count entries, receiving the number of
+ * bytes available from each received message.
+ *
+ * @param count The maximum number of messages to receive.
+ *
+ * @param timeout The number of clock ticks to wait for some message
+ * to arrive (see note). Passing TM_INFINITE causes the caller to
+ * block indefinitely until some message is eventually
+ * available. Passing TM_NONBLOCK causes the service to return
+ * immediately without waiting if no message is available on entry.
+ *
+ * @return The number of messages received is returned upon
+ * success. Otherwise:
+ *
+ * - -EINVAL is returned if @a q is not a message queue descriptor, or
+ * @a count is not positive.
+ *
+ * - -EIDRM is returned if @a q is a deleted queue descriptor.
+ *
+ * - -ETIMEDOUT is returned if @a timeout is different from
+ * TM_NONBLOCK and no message is available within the specified amount
+ * of time.
+ *
+ * - -EWOULDBLOCK is returned if @a timeout is equal to TM_NONBLOCK
+ * and no message is immediately available on entry.
+ *
+ * - -EINTR is returned if rt_task_unblock() has been called for the
+ * waiting task before any data was available.
+ *
+ * - -EPERM is returned if this service should block, but was called
+ * from a context which cannot sleep (e.g. interrupt, non-realtime or
+ * scheduler locked).
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ *   only if @a timeout is equal to TM_NONBLOCK.
+ *
+ * - Kernel-based task
+ * - User-space task (switches to primary mode)
+ *
+ * Rescheduling: always unless the request is immediately satisfied or
+ * @a timeout specifies a non-blocking operation.
+ *
+ * @note This service is sensitive to the current operation mode of
+ * the system timer, as defined by the rt_timer_start() service. In
+ * periodic mode, clock ticks are interpreted as periodic jiffies. In
+ * oneshot mode, clock ticks are interpreted as nanoseconds.
+ */
+
+int rt_queue_recv_multi (RT_QUEUE *q,
+			 void *bufs[],
+			 size_t sizes[],
+			 int count,
+			 RTIME timeout)
+{
+    rt_queue_msg_t *msg;
+    xnholder_t *holder;
+    int err = 0, n = 0;
+    RT_TASK *task;
+    spl_t s;
+
+    if (count <= 0)
+	return -EINVAL;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    q = xeno_h2obj_validate(q,XENO_QUEUE_MAGIC,RT_QUEUE);
+
+    if (!q)
+        {
+        err = xeno_handle_error(q,XENO_QUEUE_MAGIC,RT_QUEUE);
+        goto unlock_and_exit;
+        }
+
+    if (countq(&q->pendq) == 0)
+	{
+	if (timeout == TM_NONBLOCK)
+	    {
+	    err = -EWOULDBLOCK;
+	    goto unlock_and_exit;
+	    }
+
+	if (xnpod_unblockable_p())
+	    {
+	    err = -EPERM;
+	    goto unlock_and_exit;
+	    }
+
+	xnsynch_sleep_on(&q->synch_base,timeout);
+
+	task = xeno_current_task();
+
+	if (xnthread_test_flags(&task->thread_base,XNRMID))
+	    err = -EIDRM; /* Queue deleted while pending. */
+	else if (xnthread_test_flags(&task->thread_base,XNTIMEO))
+	    err = -ETIMEDOUT; /* Timeout.*/
+	else if (xnthread_test_flags(&task->thread_base,XNBREAK))
+	    err = -EINTR; /* Unblocked.*/
+	else
+	    {
+	    msg = task->wait_args.qmsg;
+	    task->wait_args.qmsg = NULL;
+	    bufs[n] = msg + 1;
+	    sizes[n++] = msg->size;
+	    }
+
+	if (err)
+	    goto unlock_and_exit;
+	}
+
+    /* Grab whatever else is pending, up to the caller's limit. */
+
+    while (n < count && (holder = getq(&q->pendq)) != NULL)
+	{
+	msg = link2rtmsg(holder);
+	msg->refcount++;
+	bufs[n] = msg + 1;
+	sizes[n++] = msg->size;
+	}
+
+    xnselect_signal(&q->select,countq(&q->pendq) != 0);
+
+    err = n;
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
 /**
  * @fn int rt_queue_inquire(RT_QUEUE *q, RT_QUEUE_INFO *info)
  *
@@ -945,12 +1516,15 @@ int rt_queue_inquire (RT_QUEUE *q,
 int __queue_pkg_init (void)
 
 {
+    xnpod_add_hook(XNHOOK_THREAD_DELETE,&__queue_delete_hook);
+
     return 0;
 }
 
 void __queue_pkg_cleanup (void)
 
 {
+    xnpod_remove_hook(XNHOOK_THREAD_DELETE,&__queue_delete_hook);
 }
 
 /*@}*/
@@ -959,6 +1533,9 @@ EXPORT_SYMBOL(rt_queue_create);
 EXPORT_SYMBOL(rt_queue_delete);
 EXPORT_SYMBOL(rt_queue_alloc);
 EXPORT_SYMBOL(rt_queue_free);
+EXPORT_SYMBOL(rt_queue_reserve);
 EXPORT_SYMBOL(rt_queue_send);
+EXPORT_SYMBOL(rt_queue_send_multi);
 EXPORT_SYMBOL(rt_queue_recv);
+EXPORT_SYMBOL(rt_queue_recv_multi);
 EXPORT_SYMBOL(rt_queue_inquire);
@@ -23,6 +23,7 @@
 #define _XENO_QUEUE_H
 
 #include <nucleus/synch.h>
+#include <nucleus/select.h>
 #include <nucleus/heap.h>
 #include <native/types.h>
 
@@ -31,6 +32,9 @@
 #define Q_FIFO   XNSYNCH_FIFO	/* Pend by FIFO order. */
 #define Q_DMA    0x100		/* Use memory suitable for DMA. */
 #define Q_SHARED 0x200		/* Use mappable shared memory. */
+#define Q_LARGE  0x400		/* Use node-local contiguous memory. */
+#define Q_NODE(n) (Q_LARGE|((((n) + 1) & 0xff) << 16)) /* ... from node n. */
+#define Q_NODE_OF(mode) ((((mode) >> 16) & 0xff) - 1)
 
 #define Q_UNLIMITED 0		/* No size limit. */
 
@@ -65,8 +69,31 @@ typedef struct rt_queue_placeholder {
 
     size_t mapsize;
 
+    /* Pool geometry, used by the user-space buffer cache. */
+
+    u_long pagemap;	/* !< Offset of the page map in the mapping. */
+
+    u_long pagebase;	/* !< Offset of the first page in the mapping. */
+
+    int pageshift;	/* !< Log2 of the pool page size. */
+
 } RT_QUEUE_PLACEHOLDER;
 
+/* Message header, preceding every buffer in the pool. */
+
+typedef struct rt_queue_msg {
+
+    size_t size;
+
+    volatile unsigned refcount;
+
+    xnholder_t link;
+
+#define link2rtmsg(laddr) \
+((rt_queue_msg_t *)(((char *)laddr) - (int)(&((rt_queue_msg_t *)0)->link)))
+
+} rt_queue_msg_t;
+
 #if defined(__KERNEL__) || defined(__XENO_SIM__)
 
 #define XENO_QUEUE_MAGIC 0x55550707
@@ -77,6 +104,8 @@ typedef struct rt_queue {
 
     xnsynch_t synch_base; /* !< Base synchronization object. */
 
+    xnselect_t select; /* !< Readiness state for rt_select(). */
+
     xnqueue_t pendq;	/* !< Pending message queue. */
 
     xnheap_t bufpool;	/* !< Message buffer pool. */
@@ -89,24 +118,33 @@ typedef struct rt_queue {
 
     char name[XNOBJECT_NAME_LEN]; /* !< Symbolic name. */
 
+    xnqueue_t rsvq;	/* !< Buffer reserves of tasks. */
+
 #if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
     pid_t cpid;			/* !< Creator's pid. */
 #endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
 
 } RT_QUEUE;
 
-typedef struct rt_queue_msg {
+typedef struct rt_queue_rsv {
 
-    size_t size;
+    xnheap_t heap;	/* !< Reserve carved from the buffer pool. */
 
-    volatile unsigned refcount;
+    struct xnthread *owner; /* !< Task the reserve belongs to -- NULL if deleted. */
 
-    xnholder_t link;
+    struct rt_queue *q;	/* !< Queue the reserve belongs to. */
 
-#define link2rtmsg(laddr) \
-((rt_queue_msg_t *)(((char *)laddr) - (int)(&((rt_queue_msg_t *)0)->link)))
+    xnholder_t link;	/* !< Link in the queue's reserve list. */
 
-} rt_queue_msg_t;
+#define link2rsv(laddr) \
+((rt_queue_rsv_t *)(((char *)laddr) - (int)(&((rt_queue_rsv_t *)0)->link)))
+
+    xnholder_t glink;	/* !< Link in the global reserve list. */
+
+#define glink2rsv(laddr) \
+((rt_queue_rsv_t *)(((char *)laddr) - (int)(&((rt_queue_rsv_t *)0)->glink)))
+
+} rt_queue_rsv_t;
 
 #ifdef __cplusplus
 extern "C" {
@@ -160,15 +198,30 @@ void *rt_queue_alloc(RT_QUEUE *q,
 int rt_queue_free(RT_QUEUE *q,
 		  void *buf);
 
+int rt_queue_reserve(RT_QUEUE *q,
+		     size_t size);
+
 int rt_queue_send(RT_QUEUE *q,
 		  void *buf,
 		  size_t size,
 		  int mode);
 
+int rt_queue_send_multi(RT_QUEUE *q,
+			void *bufs[],
+			const size_t sizes[],
+			int count,
+			int mode);
+
 ssize_t rt_queue_recv(RT_QUEUE *q,
 		      void **bufp,
 		      RTIME timeout);
 
+int rt_queue_recv_multi(RT_QUEUE *q,
+			void *bufs[],
+			size_t sizes[],
+			int count,
+			RTIME timeout);
+
 int rt_queue_inquire(RT_QUEUE *q,
 		     RT_QUEUE_INFO *info);
 
@@ -66,6 +66,8 @@ static RT_HASH **__xeno_hash_table;
 
 static int __xeno_hash_entries;
 
+static xnslab_t __xeno_hash_slab; /* Hash entries. */
+
 static xnsynch_t __xeno_hash_synch;
 
 #ifdef CONFIG_XENO_NATIVE_EXPORT_REGISTRY
@@ -148,6 +150,24 @@ int __registry_pkg_init (void)
     for (n = 0; n < __xeno_hash_entries; n++)
 	__xeno_hash_table[n] = NULL;
 
+    /* There cannot be more hash entries than registry slots, so
+       reserve all of them upfront: entering a key never involves the
+       system heap afterwards. */
+
+    if (xnslab_init(&__xeno_hash_slab,
+		    &kheap,
+		    sizeof(RT_HASH),
+		    CONFIG_XENO_OPT_NATIVE_REGISTRY_NRSLOTS - 1,
+		    NULL) != 0)
+	{
+	xnarch_sysfree(__xeno_hash_table,sizeof(RT_HASH *) * __xeno_hash_entries);
+#ifdef CONFIG_XENO_NATIVE_EXPORT_REGISTRY
+	rthal_apc_free(registry_proc_apc);
+	remove_proc_entry("registry",rthal_proc_root);
+#endif /* CONFIG_XENO_NATIVE_EXPORT_REGISTRY */
+	return -ENOMEM;
+	}
+
     xnsynch_init(&__xeno_hash_synch,XNSYNCH_FIFO);
 
     return 0;
@@ -178,11 +198,11 @@ void __registry_pkg_cleanup (void)
 		}
 
 #endif /* CONFIG_XENO_NATIVE_EXPORT_REGISTRY */
-
-	    xnfree(ecurr);
 	    }
 	}
 
+    xnslab_destroy(&__xeno_hash_slab);
+
     xnarch_sysfree(__xeno_hash_table,sizeof(RT_HASH *) * __xeno_hash_entries);
 
     xnsynch_destroy(&__xeno_hash_synch);
@@ -442,7 +462,7 @@ static inline int __registry_hash_enter (const char *key,
 	    return -EEXIST;
 	}
 
-    enew = (RT_HASH *)xnmalloc(sizeof(*enew));
+    enew = (RT_HASH *)xnslab_alloc(&__xeno_hash_slab);
 
     if (!enew)
 	return -ENOMEM;
@@ -470,7 +490,7 @@ static inline int __registry_hash_remove (RT_OBJECT *object)
 	    else
 		__xeno_hash_table[s] = ecurr->next;
 
-	    xnfree(ecurr);
+	    xnslab_free(&__xeno_hash_slab,ecurr);
 
 	    return 0;
 	    }
@@ -499,7 +519,7 @@ static inline unsigned __registry_wakeup_sleepers(const char *key)
     xnpholder_t *holder, *nholder;
     unsigned cnt = 0;
 
-    nholder = getheadpq(xnsynch_wait_queue(&__xeno_hash_synch));
+    nholder = synch_getheadpq(xnsynch_wait_queue(&__xeno_hash_synch));
 					
     while ((holder = nholder) != NULL)
 	{
@@ -513,7 +533,7 @@ static inline unsigned __registry_wakeup_sleepers(const char *key)
 	    ++cnt;
 	    }
 	else
-	    nholder = nextpq(xnsynch_wait_queue(&__xeno_hash_synch),holder);
+	    nholder = synch_nextpq(xnsynch_wait_queue(&__xeno_hash_synch),holder);
         }
 													    
     return cnt;
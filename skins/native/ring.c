@@ -0,0 +1,948 @@
+/**
+ * @file
+ * This file is part of the Xenomai project.
+ *
+ * @note Copyright (C) 2026 The Xenomai project <http://www.xenomai.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * \ingroup native_ring
+ */
+
+/*!
+ * \ingroup native
+ * \defgroup native_ring Lock-free ring services.
+ *
+ * Ring services.
+ *
+ * A ring is a byte stream of variable-size records flowing from a
+ * single producer to a single consumer. The records and the read and
+ * write indices live in a nucleus heap, which is mapped into the
+ * address space of user-space callers when the ring is shared. Since
+ * each index is only ever written by one side, records are exchanged
+ * without locking and, in user-space, without entering the kernel.
+ *
+ * The kernel is only involved when a task needs to wait for data or
+ * room, in which case it raises a waiter flag into the ring's control
+ * block before sleeping; the peer then issues a wakeup call after its
+ * next successful operation. Serializing multiple producers or
+ * multiple consumers is left to the application.
+ *
+ *@{*/
+
+#include <nucleus/pod.h>
+#include <native/task.h>
+#include <native/ring.h>
+#include <native/registry.h>
+
+#ifdef CONFIG_XENO_NATIVE_EXPORT_REGISTRY
+
+static int __ring_read_proc (char *page,
+			     char **start,
+			     off_t off,
+			     int count,
+			     int *eof,
+			     void *data)
+{
+    RT_RING *ring = (RT_RING *)data;
+    xnsynch_t *synch;
+    char *p = page;
+    int len, n;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    p += sprintf(p,"type=%s:size=%lu:used=%lu\n",
+		 ring->mode & R_SHARED ? "shared" : "local",
+		 ring->size,
+		 ring->ctl->head - ring->ctl->tail);
+
+    for (n = 0, synch = &ring->rsynch; n < 2; n++, synch = &ring->wsynch)
+	{
+	xnpholder_t *holder;
+
+	/* Pended ring -- dump waiters. */
+
+	holder = synch_getheadpq(xnsynch_wait_queue(synch));
+
+	while (holder)
+	    {
+	    xnthread_t *sleeper = link2thread(holder,plink);
+	    p += sprintf(p,"+%s (%s)\n",
+			 xnthread_name(sleeper),
+			 synch == &ring->rsynch ? "read" : "write");
+	    holder = synch_nextpq(xnsynch_wait_queue(synch),holder);
+	    }
+	}
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    len = (p - page) - off;
+    if (len <= off + count) *eof = 1;
+    *start = page + off;
+    if(len > count) len = count;
+    if(len < 0) len = 0;
+
+    return len;
+}
+
+static RT_OBJECT_PROCNODE __ring_pnode = {
+
+    .dir = NULL,
+    .type = "rings",
+    .entries = 0,
+    .read_proc = &__ring_read_proc,
+    .write_proc = NULL
+};
+
+#elif CONFIG_XENO_OPT_NATIVE_REGISTRY
+
+static RT_OBJECT_PROCNODE __ring_pnode = {
+
+    .type = "rings"
+};
+
+#endif /* CONFIG_XENO_NATIVE_EXPORT_REGISTRY */
+
+static void __ring_flush_private (xnheap_t *heap,
+				  void *poolmem,
+				  u_long poolsize,
+				  void *cookie)
+{
+    xnarch_sysfree(poolmem,poolsize);
+}
+
+/**
+ * @fn int rt_ring_create(RT_RING *ring,const char *name,size_t size,int mode)
+ *
+ * @brief Create a lock-free ring.
+ *
+ * Create a ring object through which a single producer may pass
+ * variable-size records to a single consumer. A ring is created
+ * empty. Rings can be local to the kernel space, or shared between
+ * kernel and user-space.
+ *
+ * This service needs the special character device /dev/rtheap
+ * (10,254) when called from user-space tasks.
+ *
+ * @param ring The address of a ring descriptor Xenomai will use to
+ * store the ring-related data.  This descriptor must always be valid
+ * while the ring is active therefore it must be allocated in
+ * permanent memory.
+ *
+ * @param name An ASCII string standing for the symbolic name of the
+ * ring. When non-NULL and non-empty, this string is copied to a safe
+ * place into the descriptor, and passed to the registry package if
+ * enabled for indexing the created ring. Shared rings must be given
+ * a valid name.
+ *
+ * @param size The size (in bytes) of the ring's data area, which is
+ * rounded up to the next power of two. Each record consumes its
+ * payload size rounded up to a word, plus a word for its length.
+ *
+ * @param mode The ring creation mode. The following flags can be
+ * OR'ed into this bitmask:
+ *
+ * - R_SHARED causes the ring to be sharable between kernel and
+ * user-space tasks. Otherwise, the new ring is only available for
+ * kernel-based usage. This flag is implicitely set when the caller is
+ * running in user-space. This feature requires the real-time support
+ * in user-space to be configured in (CONFIG_XENO_OPT_PERVASIVE).
+ *
+ * @return 0 is returned upon success. Otherwise:
+ *
+ * - -EEXIST is returned if the @a name is already in use by some
+ * registered object.
+ *
+ * - -EINVAL is returned if @a size is null or greater than the
+ * system limit, or @a name is null or empty for a shared ring.
+ *
+ * - -ENOMEM is returned if not enough system memory is available to
+ * create or register the ring. Additionally, and if R_SHARED has
+ * been passed in @a mode, errors while mapping the ring in the
+ * caller's address space might beget this return code too.
+ *
+ * - -EPERM is returned if this service was called from an invalid
+ * context.
+ *
+ * - -ENOSYS is returned if @a mode specifies R_SHARED, but the
+ * real-time support in user-space is unavailable.
+ *
+ * - -ENOENT is returned if /dev/rtheap can't be opened.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - User-space task (switches to secondary mode)
+ *
+ * Rescheduling: possible.
+ */
+
+int rt_ring_create (RT_RING *ring,
+		    const char *name,
+		    size_t size,
+		    int mode)
+{
+    u_long rsize, heapsize;
+    int err;
+
+    if (!xnpod_root_p())
+	return -EPERM;
+
+    if (size == 0 || size > (~0UL >> 2))
+	return -EINVAL;
+
+    for (rsize = RT_RING_LINESZ; rsize < size; rsize <<= 1)
+	;
+
+    /* The control block and the data area are obtained as a single
+       block, so the heap must be large enough to hold the power of
+       two the allocator might round it up to. */
+
+    heapsize = PAGE_ALIGN(sizeof(rt_ring_ctl_t) + rsize);
+
+    if (heapsize < 2 * PAGE_SIZE)
+	heapsize = 2 * PAGE_SIZE;
+
+    heapsize += xnheap_overhead(heapsize,PAGE_SIZE);
+    heapsize = PAGE_ALIGN(heapsize);
+
+#ifdef __KERNEL__
+    if (mode & R_SHARED)
+	{
+	if (!name || !*name)
+	    return -EINVAL;
+
+#ifdef CONFIG_XENO_OPT_PERVASIVE
+	err = xnheap_init_shared(&ring->heapbase,heapsize,0);
+
+	if (err)
+	    return err;
+
+	ring->cpid = 0;
+#else /* !CONFIG_XENO_OPT_PERVASIVE */
+	return -ENOSYS;
+#endif /* CONFIG_XENO_OPT_PERVASIVE */
+	}
+    else
+#endif /* __KERNEL__ */
+	{
+	void *poolmem = xnarch_sysalloc(heapsize);
+
+	if (!poolmem)
+	    return -ENOMEM;
+
+	err = xnheap_init(&ring->heapbase,
+			  poolmem,
+			  heapsize,
+			  PAGE_SIZE); /* Use natural page size */
+	if (err)
+	    {
+	    xnarch_sysfree(poolmem,heapsize);
+	    return err;
+	    }
+	}
+
+    ring->ctl = (rt_ring_ctl_t *)xnheap_alloc(&ring->heapbase,
+					      sizeof(rt_ring_ctl_t) + rsize);
+    if (!ring->ctl)
+	{
+	/* Cannot happen, the heap was sized for it. */
+#if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
+	if (mode & R_SHARED)
+	    xnheap_destroy_shared(&ring->heapbase);
+	else
+#endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
+	    xnheap_destroy(&ring->heapbase,&__ring_flush_private,NULL);
+
+	return -ENOMEM;
+	}
+
+    ring->ctl->head = 0;
+    ring->ctl->tail = 0;
+    ring->ctl->flags = 0;
+    ring->ctl->size = rsize;
+    ring->size = rsize;
+
+    xnsynch_init(&ring->rsynch,XNSYNCH_FIFO);
+    xnsynch_init(&ring->wsynch,XNSYNCH_FIFO);
+    ring->handle = 0;  /* i.e. (still) unregistered ring. */
+    ring->magic = XENO_RING_MAGIC;
+    ring->mode = mode;
+    xnobject_copy_name(ring->name,name);
+
+    if (name && *name)
+	xnheap_set_label(&ring->heapbase,ring->name);
+
+#ifdef CONFIG_XENO_OPT_NATIVE_REGISTRY
+    /* <!> Since rt_register_enter() may reschedule, only register
+       complete objects, so that the registry cannot return handles to
+       half-baked objects... */
+
+    if (name)
+        {
+	RT_OBJECT_PROCNODE *pnode = &__ring_pnode;
+
+	if (!*name)
+	    {
+	    /* Since this is an anonymous object (empty name on entry)
+	       from user-space, it gets registered under an unique
+	       internal name but is not exported through /proc. */
+	    xnobject_create_name(ring->name,sizeof(ring->name),(void*)ring);
+	    pnode = NULL;
+	    }
+
+        err = rt_registry_enter(ring->name,ring,&ring->handle,pnode);
+
+        if (err)
+            rt_ring_delete(ring);
+        }
+#endif /* CONFIG_XENO_OPT_NATIVE_REGISTRY */
+
+    return err;
+}
+
+/**
+ * @fn int rt_ring_delete(RT_RING *ring)
+ *
+ * @brief Delete a lock-free ring.
+ *
+ * Destroy a ring and release the tasks currently waiting on it, which
+ * then receive -EIDRM. Records still held by the ring are discarded.
+ * The peers must not access the ring once it has been deleted.
+ *
+ * @param ring The descriptor address of the affected ring.
+ *
+ * @return 0 is returned upon success. Otherwise:
+ *
+ * - -EINVAL is returned if @a ring is not a ring descriptor.
+ *
+ * - -EIDRM is returned if @a ring is a deleted ring descriptor.
+ *
+ * - -EPERM is returned if this service was called from an
+ * asynchronous context.
+ *
+ * - -EBUSY is returned if the ring memory is still mapped by
+ * user-space tasks.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - User-space task (switches to secondary mode)
+ *
+ * Rescheduling: possible.
+ */
+
+int rt_ring_delete (RT_RING *ring)
+
+{
+    int err = 0, rc;
+    spl_t s;
+
+    if (xnpod_asynch_p())
+	return -EPERM;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    ring = xeno_h2obj_validate(ring,XENO_RING_MAGIC,RT_RING);
+
+    if (!ring)
+        {
+        err = xeno_handle_error(ring,XENO_RING_MAGIC,RT_RING);
+        goto unlock_and_exit;
+        }
+
+#if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
+    if (ring->mode & R_SHARED)
+	err = xnheap_destroy_shared(&ring->heapbase);
+    else
+#endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
+	err = xnheap_destroy(&ring->heapbase,&__ring_flush_private,NULL);
+
+    if (err)
+	goto unlock_and_exit;
+
+    rc = xnsynch_destroy(&ring->rsynch);
+
+    if (xnsynch_destroy(&ring->wsynch) == XNSYNCH_RESCHED)
+	rc = XNSYNCH_RESCHED;
+
+#ifdef CONFIG_XENO_OPT_NATIVE_REGISTRY
+    if (ring->handle)
+        rt_registry_remove(ring->handle);
+#endif /* CONFIG_XENO_OPT_NATIVE_REGISTRY */
+
+    xeno_mark_deleted(ring);
+
+    if (rc == XNSYNCH_RESCHED)
+        /* Some task has been woken up as a result of the deletion:
+           reschedule now. */
+        xnpod_schedule();
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
+/*
+ * Wait for the ring to hold a record (dir == R_READ) or to have room
+ * for a record of the given size (dir == R_WRITE). The waiter flag is
+ * raised before the indices are checked again, so that a peer
+ * completing its operation concurrently either sees the flag and
+ * issues a wakeup, or has published its index early enough for us
+ * not to sleep. The wait goes on until the condition holds, and the
+ * time left is returned at timeoutp, so that the caller does not
+ * restart the whole timeout if it has to wait again.
+ */
+
+int rt_ring_pend (RT_RING *ring,
+		  int dir,
+		  size_t size,
+		  RTIME *timeoutp)
+{
+    RTIME timeout = *timeoutp;
+    u_long flag, need = 0;
+    xnticks_t stime, now;
+    rt_ring_ctl_t *ctl;
+    xnsynch_t *synch;
+    RT_TASK *task;
+    int err = 0;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    ring = xeno_h2obj_validate(ring,XENO_RING_MAGIC,RT_RING);
+
+    if (!ring)
+        {
+        err = xeno_handle_error(ring,XENO_RING_MAGIC,RT_RING);
+        goto unlock_and_exit;
+        }
+
+    ctl = ring->ctl;
+
+    if (dir == R_READ)
+	{
+	synch = &ring->rsynch;
+	flag = RT_RING_RWAIT;
+	}
+    else if (dir == R_WRITE)
+	{
+	need = RT_RING_RECSZ(size);
+
+	if (need > ring->size)
+	    {
+	    err = -EINVAL;
+	    goto unlock_and_exit;
+	    }
+
+	synch = &ring->wsynch;
+	flag = RT_RING_WWAIT;
+	}
+    else
+	{
+	err = -EINVAL;
+	goto unlock_and_exit;
+	}
+
+    if (timeout == TM_NONBLOCK)
+	{
+	err = -EWOULDBLOCK;
+	goto unlock_and_exit;
+	}
+
+    if (xnpod_unblockable_p())
+	{
+	err = -EPERM;
+	goto unlock_and_exit;
+	}
+
+    task = xeno_current_task();
+
+    stime = xnpod_get_time();
+
+    for (;;)
+	{
+	ctl->flags |= flag;
+	xnarch_memory_barrier();
+
+	if (dir == R_READ
+	    ? ctl->head != ctl->tail
+	    : ring->size - (ctl->head - ctl->tail) >= need)
+	    break;
+
+	if (timeout != TM_INFINITE)
+	    {
+	    now = xnpod_get_time();
+
+	    if (now - stime >= timeout)
+		{
+		err = -ETIMEDOUT;
+		break;
+		}
+
+	    timeout -= now - stime;
+	    stime = now;
+	    }
+
+	xnsynch_sleep_on(synch,timeout);
+
+	if (xnthread_test_flags(&task->thread_base,XNRMID))
+	    {
+	    err = -EIDRM; /* Ring deleted while pending. */
+	    goto unlock_and_exit;
+	    }
+
+	if (xnthread_test_flags(&task->thread_base,XNTIMEO))
+	    {
+	    err = -ETIMEDOUT; /* Timeout.*/
+	    break;
+	    }
+
+	if (xnthread_test_flags(&task->thread_base,XNBREAK))
+	    {
+	    err = -EINTR; /* Unblocked.*/
+	    break;
+	    }
+	}
+
+    if (xnsynch_nsleepers(synch) == 0)
+	ctl->flags &= ~flag;
+
+    *timeoutp = timeout;
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
+/*
+ * Wake up the task waiting for data (dir == R_READ) or for room (dir
+ * == R_WRITE), if any.
+ */
+
+int rt_ring_post (RT_RING *ring,
+		  int dir)
+{
+    rt_ring_ctl_t *ctl;
+    xnsynch_t *synch;
+    int err = 0;
+    u_long flag;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    ring = xeno_h2obj_validate(ring,XENO_RING_MAGIC,RT_RING);
+
+    if (!ring)
+        {
+        err = xeno_handle_error(ring,XENO_RING_MAGIC,RT_RING);
+        goto unlock_and_exit;
+        }
+
+    if (dir == R_READ)
+	{
+	synch = &ring->rsynch;
+	flag = RT_RING_RWAIT;
+	}
+    else if (dir == R_WRITE)
+	{
+	synch = &ring->wsynch;
+	flag = RT_RING_WWAIT;
+	}
+    else
+	{
+	err = -EINVAL;
+	goto unlock_and_exit;
+	}
+
+    ctl = ring->ctl;
+
+    if (xnsynch_wakeup_one_sleeper(synch) != NULL)
+	{
+	if (xnsynch_nsleepers(synch) == 0)
+	    ctl->flags &= ~flag;
+
+	xnpod_schedule();
+	}
+    else
+	ctl->flags &= ~flag;
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
+/**
+ * @fn int rt_ring_write(RT_RING *ring,const void *buf,size_t size,RTIME timeout)
+ *
+ * @brief Write a record to a ring.
+ *
+ * Copy a record into the ring, waiting for enough room to be
+ * released by the consumer if needed. The record becomes visible to
+ * the consumer as a whole. Only a single task may write to a given
+ * ring at any point in time.
+ *
+ * In user-space, this service is performed without entering the
+ * kernel, unless the ring is full or the consumer waits for data.
+ *
+ * @param ring The descriptor address of the ring to write to.
+ *
+ * @param buf The address of the record payload.
+ *
+ * @param size The size in bytes of the payload. Zero is a valid
+ * value, the consumer then receives an empty record.
+ *
+ * @param timeout The number of clock ticks to wait for enough room
+ * in the ring (see note). Passing TM_INFINITE causes the caller to
+ * block indefinitely. Passing TM_NONBLOCK causes the service to
+ * return immediately without waiting if the ring is full.
+ *
+ * @return 0 is returned upon success. Otherwise:
+ *
+ * - -EINVAL is returned if @a ring is not a ring descriptor, or if
+ * the record could never fit into the ring.
+ *
+ * - -EIDRM is returned if @a ring is a deleted ring descriptor,
+ * including if the deletion occurred while the caller was waiting.
+ *
+ * - -EWOULDBLOCK is returned if @a timeout is equal to TM_NONBLOCK
+ * and the ring is full.
+ *
+ * - -EIO is returned if the read index of a shared ring has been
+ * corrupted by the consumer.
+ *
+ * - -EINTR is returned if rt_task_unblock() has been called for the
+ * waiting task before room was available.
+ *
+ * - -ETIMEDOUT is returned if no room has been released within the
+ * specified amount of time.
+ *
+ * - -EPERM is returned if this service should block, but was called
+ * from a context which cannot sleep (e.g. interrupt, non-realtime or
+ * scheduler locked).
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ *   only if @a timeout is equal to TM_NONBLOCK.
+ *
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: always unless the request is immediately satisfied or
+ * @a timeout specifies a non-blocking operation.
+ *
+ * @note This service is sensitive to the current operation mode of
+ * the system timer, as defined by the rt_timer_start() service. In
+ * periodic mode, clock ticks are interpreted as periodic jiffies. In
+ * oneshot mode, clock ticks are interpreted as nanoseconds.
+ */
+
+int rt_ring_write (RT_RING *ring,
+		   const void *buf,
+		   size_t size,
+		   RTIME timeout)
+{
+    int err;
+
+    ring = xeno_h2obj_validate(ring,XENO_RING_MAGIC,RT_RING);
+
+    if (!ring)
+	return xeno_handle_error(ring,XENO_RING_MAGIC,RT_RING);
+
+    while ((err = __rt_ring_put(ring->ctl,ring->size,buf,size)) == -EWOULDBLOCK)
+	{
+	err = rt_ring_pend(ring,R_WRITE,size,&timeout);
+
+	if (err)
+	    return err;
+	}
+
+    if (!err && __rt_ring_wakeup_p(ring->ctl,R_READ))
+	rt_ring_post(ring,R_READ);
+
+    return err;
+}
+
+/**
+ * @fn ssize_t rt_ring_read(RT_RING *ring,void *buf,size_t size,RTIME timeout)
+ *
+ * @brief Read a record from a ring.
+ *
+ * Copy the oldest record out of the ring, waiting for the producer to
+ * write one if the ring is empty. Only a single task may read from a
+ * given ring at any point in time.
+ *
+ * In user-space, this service is performed without entering the
+ * kernel, unless the ring is empty or the producer waits for room.
+ *
+ * @param ring The descriptor address of the ring to read from.
+ *
+ * @param buf The address of the buffer receiving the record payload.
+ *
+ * @param size The size in bytes of @a buf.
+ *
+ * @param timeout The number of clock ticks to wait for a record to be
+ * available (see note). Passing TM_INFINITE causes the caller to
+ * block indefinitely. Passing TM_NONBLOCK causes the service to
+ * return immediately without waiting if the ring is empty.
+ *
+ * @return The size in bytes of the record payload is returned upon
+ * success. Otherwise:
+ *
+ * - -EMSGSIZE is returned if the oldest record is larger than @a
+ * size. The record is left in the ring.
+ *
+ * - -EINVAL is returned if @a ring is not a ring descriptor.
+ *
+ * - -EIDRM is returned if @a ring is a deleted ring descriptor,
+ * including if the deletion occurred while the caller was waiting.
+ *
+ * - -EWOULDBLOCK is returned if @a timeout is equal to TM_NONBLOCK
+ * and the ring is empty.
+ *
+ * - -EIO is returned if the contents of a shared ring have been
+ * corrupted by the producer.
+ *
+ * - -EINTR is returned if rt_task_unblock() has been called for the
+ * waiting task before a record was available.
+ *
+ * - -ETIMEDOUT is returned if no record has been written within the
+ * specified amount of time.
+ *
+ * - -EPERM is returned if this service should block, but was called
+ * from a context which cannot sleep (e.g. interrupt, non-realtime or
+ * scheduler locked).
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ *   only if @a timeout is equal to TM_NONBLOCK.
+ *
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: always unless the request is immediately satisfied or
+ * @a timeout specifies a non-blocking operation.
+ *
+ * @note This service is sensitive to the current operation mode of
+ * the system timer, as defined by the rt_timer_start() service. In
+ * periodic mode, clock ticks are interpreted as periodic jiffies. In
+ * oneshot mode, clock ticks are interpreted as nanoseconds.
+ */
+
+ssize_t rt_ring_read (RT_RING *ring,
+		      void *buf,
+		      size_t size,
+		      RTIME timeout)
+{
+    ssize_t ret;
+    int err;
+
+    ring = xeno_h2obj_validate(ring,XENO_RING_MAGIC,RT_RING);
+
+    if (!ring)
+	return xeno_handle_error(ring,XENO_RING_MAGIC,RT_RING);
+
+    while ((ret = __rt_ring_get(ring->ctl,ring->size,buf,size)) == -EWOULDBLOCK)
+	{
+	err = rt_ring_pend(ring,R_READ,0,&timeout);
+
+	if (err)
+	    return err;
+	}
+
+    if (ret >= 0 && __rt_ring_wakeup_p(ring->ctl,R_WRITE))
+	rt_ring_post(ring,R_WRITE);
+
+    return ret;
+}
+
+/**
+ * @fn int rt_ring_inquire(RT_RING *ring, RT_RING_INFO *info)
+ *
+ * @brief Inquire about a lock-free ring.
+ *
+ * Return various information about the status of a given ring.
+ *
+ * @param ring The descriptor address of the inquired ring.
+ *
+ * @param info The address of a structure the ring information will
+ * be written to.
+
+ * @return 0 is returned and status information is written to the
+ * structure pointed at by @a info upon success. Otherwise:
+ *
+ * - -EINVAL is returned if @a ring is not a ring descriptor.
+ *
+ * - -EIDRM is returned if @a ring is a deleted ring descriptor.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: never.
+ */
+
+int rt_ring_inquire (RT_RING *ring,
+		     RT_RING_INFO *info)
+{
+    int err = 0;
+    spl_t s;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    ring = xeno_h2obj_validate(ring,XENO_RING_MAGIC,RT_RING);
+
+    if (!ring)
+        {
+        err = xeno_handle_error(ring,XENO_RING_MAGIC,RT_RING);
+        goto unlock_and_exit;
+        }
+
+    strcpy(info->name,ring->name);
+    info->nwaiters = xnsynch_nsleepers(&ring->rsynch) + xnsynch_nsleepers(&ring->wsynch);
+    info->mode = ring->mode;
+    info->size = ring->size;
+    info->used = ring->ctl->head - ring->ctl->tail;
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
+/**
+ * @fn int rt_ring_bind(RT_RING *ring,const char *name,RTIME timeout)
+ *
+ * @brief Bind to a shared lock-free ring.
+ *
+ * This user-space only service retrieves the uniform descriptor of a
+ * given shared Xenomai ring identified by its symbolic name, and maps
+ * the ring memory into the caller's address space. If the ring does
+ * not exist on entry, this service blocks the caller until a ring of
+ * the given name is created.
+ *
+ * @param name A valid NULL-terminated name which identifies the
+ * ring to bind to.
+ *
+ * @param ring The address of a ring descriptor retrieved by the
+ * operation. Contents of this memory is undefined upon failure.
+ *
+ * @param timeout The number of clock ticks to wait for the
+ * registration to occur (see note). Passing TM_INFINITE causes the
+ * caller to block indefinitely until the object is
+ * registered. Passing TM_NONBLOCK causes the service to return
+ * immediately without waiting if the object is not registered on
+ * entry.
+ *
+ * @return 0 is returned upon success. Otherwise:
+ *
+ * - -EFAULT is returned if @a ring or @a name is referencing invalid
+ * memory.
+ *
+ * - -EINTR is returned if rt_task_unblock() has been called for the
+ * waiting task before the retrieval has completed.
+ *
+ * - -EWOULDBLOCK is returned if @a timeout is equal to TM_NONBLOCK
+ * and the searched object is not registered on entry.
+ *
+ * - -ETIMEDOUT is returned if the object cannot be retrieved within
+ * the specified amount of time.
+ *
+ * - -EPERM is returned if this service should block, but was called
+ * from a context which cannot sleep (e.g. interrupt, non-realtime or
+ * scheduler locked).
+ *
+ * - -ENOENT is returned if /dev/rtheap can't be opened.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - User-space task (switches to primary mode)
+ *
+ * Rescheduling: always unless the request is immediately satisfied or
+ * @a timeout specifies a non-blocking operation.
+ *
+ * @note This service is sensitive to the current operation mode of
+ * the system timer, as defined by the rt_timer_start() service. In
+ * periodic mode, clock ticks are interpreted as periodic jiffies. In
+ * oneshot mode, clock ticks are interpreted as nanoseconds.
+ */
+
+/**
+ * @fn int rt_ring_unbind(RT_RING *ring)
+ *
+ * @brief Unbind from a shared lock-free ring.
+ *
+ * This user-space only service unbinds the calling task from the
+ * ring object previously retrieved by a call to rt_ring_bind(), and
+ * releases the mapping of the ring memory.
+ *
+ * @param ring The address of a ring descriptor to unbind from.
+ *
+ * @return 0 is always returned.
+ *
+ * This service can be called from:
+ *
+ * - User-space task.
+ *
+ * Rescheduling: never.
+ */
+
+int __ring_pkg_init (void)
+
+{
+    return 0;
+}
+
+void __ring_pkg_cleanup (void)
+
+{
+}
+
+/*@}*/
+
+EXPORT_SYMBOL(rt_ring_create);
+EXPORT_SYMBOL(rt_ring_delete);
+EXPORT_SYMBOL(rt_ring_write);
+EXPORT_SYMBOL(rt_ring_read);
+EXPORT_SYMBOL(rt_ring_inquire);
+EXPORT_SYMBOL(rt_ring_pend);
+EXPORT_SYMBOL(rt_ring_post);
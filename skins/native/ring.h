@@ -0,0 +1,325 @@
+/**
+ * @file
+ * This file is part of the Xenomai project.
+ *
+ * @note Copyright (C) 2026 The Xenomai project <http://www.xenomai.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _XENO_RING_H
+#define _XENO_RING_H
+
+#include <nucleus/synch.h>
+#include <nucleus/heap.h>
+#include <native/types.h>
+
+#if !defined(__KERNEL__) && !defined(__XENO_SIM__)
+#include <string.h>
+#include <nucleus/asm/atomic.h>
+#endif /* !__KERNEL__ && !__XENO_SIM__ */
+
+/* Creation flags. */
+#define R_SHARED 0x200		/* Use mappable shared memory. */
+
+/* Directions for waiting and waking up. */
+#define R_READ   0x1
+#define R_WRITE  0x2
+
+/* Waiter flags, raised in the control block by blocked tasks. */
+#define RT_RING_RWAIT 0x1	/* Consumer waits for data. */
+#define RT_RING_WWAIT 0x2	/* Producer waits for space. */
+
+#define RT_RING_LINESZ 64	/* Keeps both indices on separate lines. */
+
+/* Records are prefixed by their length and padded to a word. */
+#define RT_RING_ALIGN(n) \
+(((n) + sizeof(u_long) - 1) & ~(sizeof(u_long) - 1))
+#define RT_RING_RECSZ(n) (sizeof(u_long) + RT_RING_ALIGN(n))
+
+typedef struct rt_ring_info {
+
+    int nwaiters;		/* !< Number of pending tasks. */
+
+    int mode;			/* !< Creation mode. */
+
+    size_t size;		/* !< Size of the data area. */
+
+    size_t used;		/* !< Bytes currently held. */
+
+    char name[XNOBJECT_NAME_LEN]; /* !< Symbolic name. */
+
+} RT_RING_INFO;
+
+/* Control block heading the shared data area. The producer only
+   writes the head index and the consumer only writes the tail; both
+   indices run freely and are masked with (size - 1) on access. */
+
+typedef struct rt_ring_ctl {
+
+    volatile u_long head;	/* !< Write index -- producer owned. */
+
+    char __pad1[RT_RING_LINESZ - sizeof(u_long)];
+
+    volatile u_long tail;	/* !< Read index -- consumer owned. */
+
+    char __pad2[RT_RING_LINESZ - sizeof(u_long)];
+
+    volatile u_long flags;	/* !< Waiter flags -- updated by the kernel. */
+
+    u_long size;		/* !< Data area size (power of 2). */
+
+    char __pad3[RT_RING_LINESZ - 2 * sizeof(u_long)];
+
+} rt_ring_ctl_t;
+
+#define rt_ring_data(ctl) ((caddr_t)((ctl) + 1))
+
+typedef struct rt_ring_placeholder {
+
+    rt_handle_t opaque;
+
+    void *opaque2;
+
+    caddr_t mapbase;
+
+    size_t mapsize;
+
+    u_long ctloff;	/* !< Offset of the control block in the mapping. */
+
+    rt_ring_ctl_t *ctl;	/* !< Control block, once mapped. */
+
+} RT_RING_PLACEHOLDER;
+
+/* The helpers below take the data area size from their caller: the
+   control block is writable by both sides of a shared ring, so the
+   kernel never relies on its contents but for the indices, which are
+   checked before use. */
+
+static inline void __rt_ring_copy_in (rt_ring_ctl_t *ctl,
+				      u_long rsize,
+				      u_long index,
+				      const void *src,
+				      size_t len)
+{
+    u_long pos = index & (rsize - 1), n = rsize - pos;
+
+    if (n > len)
+	n = len;
+
+    memcpy(rt_ring_data(ctl) + pos,src,n);
+
+    if (len > n)
+	memcpy(rt_ring_data(ctl),(const char *)src + n,len - n);
+}
+
+static inline void __rt_ring_copy_out (rt_ring_ctl_t *ctl,
+				       u_long rsize,
+				       u_long index,
+				       void *dst,
+				       size_t len)
+{
+    u_long pos = index & (rsize - 1), n = rsize - pos;
+
+    if (n > len)
+	n = len;
+
+    memcpy(dst,rt_ring_data(ctl) + pos,n);
+
+    if (len > n)
+	memcpy((char *)dst + n,rt_ring_data(ctl),len - n);
+}
+
+/* Producer side: append a record, or return -EWOULDBLOCK if there
+   is not enough room left. The head index is published by an atomic
+   exchange, which also orders the record contents before it and the
+   subsequent read of the waiter flags by the caller. -EIO is
+   returned if the consumer has moved the tail index out of the
+   ring. */
+
+static inline int __rt_ring_put (rt_ring_ctl_t *ctl,
+				 u_long rsize,
+				 const void *buf,
+				 size_t size)
+{
+    u_long head = ctl->head, len = size, need = RT_RING_RECSZ(size), used;
+
+    if (need > rsize)
+	return -EINVAL;
+
+    used = head - ctl->tail;
+
+    if (used > rsize)
+	return -EIO;
+
+    if (rsize - used < need)
+	return -EWOULDBLOCK;
+
+    xnarch_memory_barrier();
+
+    __rt_ring_copy_in(ctl,rsize,head,&len,sizeof(len));
+    __rt_ring_copy_in(ctl,rsize,head + sizeof(len),buf,size);
+
+    xnarch_atomic_xchg(&ctl->head,head + need);
+
+    return 0;
+}
+
+/* Consumer side: remove the oldest record, returning its length, or
+   -EWOULDBLOCK if the ring is empty. -EMSGSIZE is returned, leaving
+   the record in place, if it does not fit into the caller's
+   buffer. -EIO is returned if the producer has moved the head index
+   out of the ring, or written a record length which exceeds the
+   data it published. */
+
+static inline ssize_t __rt_ring_get (rt_ring_ctl_t *ctl,
+				     u_long rsize,
+				     void *buf,
+				     size_t size)
+{
+    u_long tail = ctl->tail, len, used;
+
+    used = ctl->head - tail;
+
+    if (used == 0)
+	return -EWOULDBLOCK;
+
+    if (used > rsize)
+	return -EIO;
+
+    xnarch_memory_barrier();
+
+    __rt_ring_copy_out(ctl,rsize,tail,&len,sizeof(len));
+
+    if (len > rsize || RT_RING_RECSZ(len) > used)
+	return -EIO;
+
+    if (len > size)
+	return -EMSGSIZE;
+
+    __rt_ring_copy_out(ctl,rsize,tail + sizeof(len),buf,len);
+
+    xnarch_atomic_xchg(&ctl->tail,tail + RT_RING_RECSZ(len));
+
+    return (ssize_t)len;
+}
+
+/* Tell whether a blocked peer must be woken up after a successful
+   put (dir == R_READ) or get (dir == R_WRITE). */
+
+#define __rt_ring_wakeup_p(ctl,dir) \
+((ctl)->flags & ((dir) == R_READ ? RT_RING_RWAIT : RT_RING_WWAIT))
+
+#if defined(__KERNEL__) || defined(__XENO_SIM__)
+
+#define XENO_RING_MAGIC 0x55550b0b
+
+typedef struct rt_ring {
+
+    unsigned magic;   /* !< Magic code - must be first */
+
+    xnsynch_t rsynch;	/* !< Consumer waiting for data. */
+
+    xnsynch_t wsynch;	/* !< Producer waiting for space. */
+
+    xnheap_t heapbase;	/* !< Backing heap of the control block. */
+
+    rt_ring_ctl_t *ctl;	/* !< Control block and data area. */
+
+    u_long size;	/* !< Data area size -- trusted copy. */
+
+    int mode;		/* !< Creation mode. */
+
+    rt_handle_t handle;	/* !< Handle in registry -- zero if unregistered. */
+
+    char name[XNOBJECT_NAME_LEN]; /* !< Symbolic name. */
+
+#if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_PERVASIVE)
+    pid_t cpid;			/* !< Creator's pid. */
+#endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
+
+} RT_RING;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int rt_ring_pend(RT_RING *ring,
+		 int dir,
+		 size_t size,
+		 RTIME *timeoutp);
+
+int rt_ring_post(RT_RING *ring,
+		 int dir);
+
+int __ring_pkg_init(void);
+
+void __ring_pkg_cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#else /* !(__KERNEL__ || __XENO_SIM__) */
+
+typedef RT_RING_PLACEHOLDER RT_RING;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int rt_ring_bind(RT_RING *ring,
+		 const char *name,
+		 RTIME timeout);
+
+int rt_ring_unbind(RT_RING *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KERNEL__ || __XENO_SIM__ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Public interface. */
+
+int rt_ring_create(RT_RING *ring,
+		   const char *name,
+		   size_t size,
+		   int mode);
+
+int rt_ring_delete(RT_RING *ring);
+
+int rt_ring_write(RT_RING *ring,
+		  const void *buf,
+		  size_t size,
+		  RTIME timeout);
+
+ssize_t rt_ring_read(RT_RING *ring,
+		     void *buf,
+		     size_t size,
+		     RTIME timeout);
+
+int rt_ring_inquire(RT_RING *ring,
+		    RT_RING_INFO *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !_XENO_RING_H */
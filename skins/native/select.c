@@ -0,0 +1,235 @@
+/**
+ * @file
+ * This file is part of the Xenomai project.
+ *
+ * @note Copyright (C) 2026 The Xenomai project <http://www.xenomai.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * \ingroup native_select
+ */
+
+/*!
+ * \ingroup native
+ * \defgroup native_select Multiple object waiting services.
+ *
+ * Multiple object waiting services.
+ *
+ * rt_select() lets a single task wait for any of a set of message
+ * queues, semaphores, event groups and pipes to become ready, instead
+ * of polling each of them or dedicating one task per source. Upon
+ * return, the caller is told which objects are ready, and is expected
+ * to perform the regular non-blocking operation on them (e.g.
+ * rt_queue_receive() with TM_NONBLOCK). Since other tasks may compete
+ * for the same objects, such operation may still fail with
+ * -EWOULDBLOCK.
+ *
+ *@{*/
+
+#include <nucleus/pod.h>
+#include <native/task.h>
+#include <native/queue.h>
+#include <native/sem.h>
+#include <native/event.h>
+#include <native/pipe.h>
+#include <native/select.h>
+
+static int __select_lookup (RT_SELECT_ITEM *item,
+			    xnselect_t **fdp,
+			    u_long *maskp,
+			    int *modep)
+{
+    *maskp = 1;
+    *modep = XNSELECT_ANY;
+
+    switch (item->type)
+	{
+#ifdef CONFIG_XENO_OPT_NATIVE_QUEUE
+	case RT_SELECT_QUEUE:
+	    {
+	    RT_QUEUE *q = xeno_h2obj_validate(item->object,XENO_QUEUE_MAGIC,RT_QUEUE);
+
+	    if (!q)
+		return xeno_handle_error(item->object,XENO_QUEUE_MAGIC,RT_QUEUE);
+
+	    *fdp = &q->select;
+	    return 0;
+	    }
+#endif /* CONFIG_XENO_OPT_NATIVE_QUEUE */
+
+#ifdef CONFIG_XENO_OPT_NATIVE_SEM
+	case RT_SELECT_SEM:
+	    {
+	    RT_SEM *sem = xeno_h2obj_validate(item->object,XENO_SEM_MAGIC,RT_SEM);
+
+	    if (!sem)
+		return xeno_handle_error(item->object,XENO_SEM_MAGIC,RT_SEM);
+
+	    *fdp = &sem->select;
+	    return 0;
+	    }
+#endif /* CONFIG_XENO_OPT_NATIVE_SEM */
+
+#ifdef CONFIG_XENO_OPT_NATIVE_EVENT
+	case RT_SELECT_EVENT:
+	    {
+	    RT_EVENT *event = xeno_h2obj_validate(item->object,XENO_EVENT_MAGIC,RT_EVENT);
+
+	    if (!event)
+		return xeno_handle_error(item->object,XENO_EVENT_MAGIC,RT_EVENT);
+
+	    *fdp = &event->select;
+	    *maskp = item->mask;
+	    *modep = (item->mode & EV_ANY) ? XNSELECT_ANY : XNSELECT_ALL;
+	    return 0;
+	    }
+#endif /* CONFIG_XENO_OPT_NATIVE_EVENT */
+
+#if defined(__KERNEL__) && defined(CONFIG_XENO_OPT_NATIVE_PIPE)
+	case RT_SELECT_PIPE:
+	    {
+	    RT_PIPE *pipe = xeno_h2obj_validate(item->object,XENO_PIPE_MAGIC,RT_PIPE);
+
+	    if (!pipe)
+		return xeno_handle_error(item->object,XENO_PIPE_MAGIC,RT_PIPE);
+
+	    *fdp = xnpipe_get_select(pipe->minor);
+	    return *fdp ? 0 : -EINVAL;
+	    }
+#endif /* __KERNEL__ && CONFIG_XENO_OPT_NATIVE_PIPE */
+
+	default:
+
+	    return -EINVAL;
+	}
+}
+
+/**
+ * @fn int rt_select(RT_SELECT_ITEM *items,int nitems,RTIME timeout)
+ * @brief Wait for any of a set of objects to become ready.
+ *
+ * This service waits until at least one of the objects described by
+ * @a items becomes ready, i.e. a message is pending on a queue, a
+ * semaphore count is positive, an event group mask matches the
+ * requested bits, or some input is pending on a pipe. If one of the
+ * objects is already ready, rt_select() returns immediately.
+ *
+ * @param items An array of descriptors, one per watched object. For
+ * each item, @a type is one of RT_SELECT_QUEUE, RT_SELECT_SEM,
+ * RT_SELECT_EVENT or RT_SELECT_PIPE, and @a object is the address of
+ * the corresponding object descriptor. For event groups, @a mask
+ * gives the bits to wait for, and @a mode tells whether any of them
+ * (EV_ANY) or all of them (EV_ALL) must be set, as with
+ * rt_event_pend(). Upon success, the @a ready field of each item is
+ * set to a non-zero value if the object is ready, zero otherwise.
+ *
+ * @param nitems The number of items in @a items, which must not
+ * exceed RT_SELECT_MAX.
+ *
+ * @param timeout The number of clock ticks to wait for an object to
+ * become ready (see note). Passing TM_INFINITE causes the caller to
+ * block indefinitely. Passing TM_NONBLOCK causes the service to poll
+ * the objects and return immediately.
+ *
+ * @return The number of ready objects is returned upon success, which
+ * may be zero if @a timeout is TM_NONBLOCK. Otherwise:
+ *
+ * - -EINVAL is returned if @a nitems is out of range, if an item has
+ * an invalid type, if an item does not refer to a valid object of the
+ * given type, or if an event item has an empty mask.
+ *
+ * - -EIDRM is returned if an item refers to a deleted object.
+ *
+ * - -ETIMEDOUT is returned if @a timeout is different from
+ * TM_NONBLOCK and no object became ready within the specified amount
+ * of time.
+ *
+ * - -EINTR is returned if rt_task_unblock() has been called for the
+ * waiting task before any object became ready.
+ *
+ * - -EPERM is returned if this service should block, but was called
+ * from a context which cannot sleep (e.g. interrupt, non-realtime or
+ * scheduler locked).
+ *
+ * An object deleted while the caller waits is reported as ready, so
+ * that the next operation on it returns -EIDRM.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * - Interrupt service routine
+ *   only if @a timeout is equal to TM_NONBLOCK.
+ *
+ * - Kernel-based task
+ * - User-space task (switches to primary mode)
+ *
+ * Rescheduling: always unless an object is already ready or @a
+ * timeout specifies a non-blocking operation.
+ *
+ * @note This service is sensitive to the current operation mode of
+ * the system timer, as defined by the rt_timer_start() service. In
+ * periodic mode, clock ticks are interpreted as periodic jiffies. In
+ * oneshot mode, clock ticks are interpreted as nanoseconds.
+ */
+
+int rt_select (RT_SELECT_ITEM *items,
+	       int nitems,
+	       RTIME timeout)
+{
+    xnselect_binding_t bindings[RT_SELECT_MAX];
+    xnselector_t selector;
+    int n, mode, err = 0;
+    xnselect_t *fd;
+    u_long mask;
+    spl_t s;
+
+    if (nitems <= 0 || nitems > RT_SELECT_MAX)
+	return -EINVAL;
+
+    xnselector_init(&selector);
+
+    xnlock_get_irqsave(&nklock,s);
+
+    for (n = 0; n < nitems; n++)
+	{
+	err = __select_lookup(&items[n],&fd,&mask,&mode);
+
+	if (!err)
+	    err = xnselect_bind(&selector,&bindings[n],fd,mask,mode);
+
+	if (err)
+	    goto unbind_and_exit;
+	}
+
+    err = xnselector_wait(&selector,timeout);
+
+    if (err >= 0)
+	for (n = 0; n < nitems; n++)
+	    items[n].ready = bindings[n].ready;
+
+ unbind_and_exit:
+
+    xnselector_destroy(&selector);
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
+/*@}*/
+
+EXPORT_SYMBOL(rt_select);
@@ -0,0 +1,65 @@
+/**
+ * @file
+ * This file is part of the Xenomai project.
+ *
+ * @note Copyright (C) 2026 The Xenomai project <http://www.xenomai.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _XENO_SELECT_H
+#define _XENO_SELECT_H
+
+#include <nucleus/select.h>
+#include <native/types.h>
+
+/* Object types. */
+#define RT_SELECT_QUEUE  0x1	/* Ready when a message is pending. */
+#define RT_SELECT_SEM    0x2	/* Ready when the count is positive. */
+#define RT_SELECT_EVENT  0x3	/* Ready when the event mask matches. */
+#define RT_SELECT_PIPE   0x4	/* Ready when input is pending. */
+
+/* Max. number of objects watched by a single rt_select() call. */
+#define RT_SELECT_MAX    16
+
+typedef struct rt_select_item {
+
+    int type;			/* !< Object type (RT_SELECT_*). */
+
+    void *object;		/* !< Object descriptor address. */
+
+    unsigned long mask;		/* !< Event bits (RT_SELECT_EVENT only). */
+
+    int mode;			/* !< EV_ANY or EV_ALL (RT_SELECT_EVENT only). */
+
+    int ready;			/* !< Set upon return if the object is ready. */
+
+} RT_SELECT_ITEM;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Public interface. */
+
+int rt_select(RT_SELECT_ITEM *items,
+	      int nitems,
+	      RTIME timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !_XENO_SELECT_H */
@@ -70,13 +70,13 @@ static int __sem_read_proc (char *page,
 	
 	/* Pended semaphore -- dump waiters. */
 
-	holder = getheadpq(xnsynch_wait_queue(&sem->synch_base));
+	holder = synch_getheadpq(xnsynch_wait_queue(&sem->synch_base));
 
 	while (holder)
 	    {
 	    xnthread_t *sleeper = link2thread(holder,plink);
 	    p += sprintf(p,"+%s\n",xnthread_name(sleeper));
-	    holder = nextpq(xnsynch_wait_queue(&sem->synch_base),holder);
+	    holder = synch_nextpq(xnsynch_wait_queue(&sem->synch_base),holder);
 	    }
 	}
 
@@ -179,6 +179,7 @@ int rt_sem_create (RT_SEM *sem,
 
     xnsynch_init(&sem->synch_base,mode & S_PRIO);
     sem->count = icount;
+    xnselect_init(&sem->select,icount > 0);
     sem->mode = mode;
     sem->handle = 0;    /* i.e. (still) unregistered semaphore. */
     sem->magic = XENO_SEM_MAGIC;
@@ -268,6 +269,9 @@ int rt_sem_delete (RT_SEM *sem)
     
     rc = xnsynch_destroy(&sem->synch_base);
 
+    if (xnselect_destroy(&sem->select))
+	rc = XNSYNCH_RESCHED;
+
 #ifdef CONFIG_XENO_OPT_NATIVE_REGISTRY
     if (sem->handle)
         rt_registry_remove(sem->handle);
@@ -365,7 +369,10 @@ int rt_sem_p (RT_SEM *sem,
     if (timeout == TM_NONBLOCK)
         {
         if (sem->count > 0)
+            {
             sem->count--;
+            xnselect_signal(&sem->select,sem->count > 0);
+            }
         else
             err = -EWOULDBLOCK;
 
@@ -379,7 +386,10 @@ int rt_sem_p (RT_SEM *sem,
 	}
 
     if (sem->count > 0)
+        {
         --sem->count;
+        xnselect_signal(&sem->select,sem->count > 0);
+        }
     else
         {
         RT_TASK *task = xeno_current_task();
@@ -448,8 +458,13 @@ int rt_sem_v (RT_SEM *sem)
     if (xnsynch_wakeup_one_sleeper(&sem->synch_base) != NULL)
         xnpod_schedule();
     else if (!(sem->mode & S_PULSE))
+        {
         sem->count++;
 
+        if (xnselect_signal(&sem->select,1))
+            xnpod_schedule();
+        }
+
  unlock_and_exit:
 
     xnlock_put_irqrestore(&nklock,s);
@@ -505,6 +520,7 @@ int rt_sem_broadcast (RT_SEM *sem)
 	xnpod_schedule();
 
     sem->count = 0;
+    xnselect_signal(&sem->select,0);
 
  unlock_and_exit:
 
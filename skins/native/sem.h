@@ -23,6 +23,7 @@
 #define _XENO_SEM_H
 
 #include <nucleus/synch.h>
+#include <nucleus/select.h>
 #include <native/types.h>
 
 /* Creation flags. */
@@ -54,6 +55,8 @@ typedef struct rt_sem {
 
     xnsynch_t synch_base; /* !< Base synchronization object. */
 
+    xnselect_t select; /* !< Readiness state for rt_select(). */
+
     unsigned long count; /* !< Current semaphore value. */
 
     int mode;		/* !< Creation mode. */
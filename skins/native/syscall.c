@@ -36,6 +36,8 @@
 #include <native/alarm.h>
 #include <native/intr.h>
 #include <native/pipe.h>
+#include <native/ring.h>
+#include <native/select.h>
 
 /* This file implements the Xenomai syscall wrappers;
  *
@@ -613,6 +615,53 @@ static int __rt_task_slice (struct task_struct *curr, struct pt_regs *regs)
     return rt_task_slice(task,quantum);
 }
 
+#ifdef CONFIG_XENO_OPT_BUDGET
+
+/*
+ * int __rt_task_set_budget(RT_TASK_PLACEHOLDER *ph,
+ *                          RTIME *budgetp,
+ *                          RTIME *periodp,
+ *                          int mode)
+ */
+
+static int __rt_task_set_budget (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    RT_TASK_PLACEHOLDER ph;
+    RTIME budget, period;
+    RT_TASK *task;
+
+    if (__xn_reg_arg1(regs))
+	{
+	if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg1(regs),sizeof(ph)))
+	    return -EFAULT;
+
+	__xn_copy_from_user(curr,&ph,(void __user *)__xn_reg_arg1(regs),sizeof(ph));
+
+	task = (RT_TASK *)rt_registry_fetch(ph.opaque);
+	}
+    else
+	task = __rt_task_current(curr);
+
+    if (!task)
+	return -ESRCH;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg2(regs),sizeof(budget)) ||
+	!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg3(regs),sizeof(period)))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,&budget,(void __user *)__xn_reg_arg2(regs),sizeof(budget));
+    __xn_copy_from_user(curr,&period,(void __user *)__xn_reg_arg3(regs),sizeof(period));
+
+    return rt_task_set_budget(task,budget,period,(int)__xn_reg_arg4(regs));
+}
+
+#else /* !CONFIG_XENO_OPT_BUDGET */
+
+#define __rt_task_set_budget  __rt_call_not_available
+
+#endif /* CONFIG_XENO_OPT_BUDGET */
+
 #ifdef CONFIG_XENO_OPT_NATIVE_MPS
 
 /*
@@ -1021,6 +1070,8 @@ static int __rt_timer_spin (struct task_struct *curr, struct pt_regs *regs)
 
 #ifdef CONFIG_XENO_OPT_NATIVE_SEM
 
+static xnslab_t __xeno_sem_slab;
+
 /*
  * int __rt_sem_create(RT_SEM_PLACEHOLDER *ph,
  *                     const char *name,
@@ -1056,7 +1107,7 @@ static int __rt_sem_create (struct task_struct *curr, struct pt_regs *regs)
     /* Creation mode. */
     mode = (int)__xn_reg_arg4(regs);
 
-    sem = (RT_SEM *)xnmalloc(sizeof(*sem));
+    sem = (RT_SEM *)xnslab_alloc(&__xeno_sem_slab);
 
     if (!sem)
 	return -ENOMEM;
@@ -1071,7 +1122,7 @@ static int __rt_sem_create (struct task_struct *curr, struct pt_regs *regs)
 	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg1(regs),&ph,sizeof(ph));
 	}
     else
-	xnfree(sem);
+	xnslab_free(&__xeno_sem_slab,sem);
 
     return err;
 }
@@ -1123,7 +1174,7 @@ static int __rt_sem_delete (struct task_struct *curr, struct pt_regs *regs)
     err = rt_sem_delete(sem);
 
     if (!err && sem->cpid)
-	xnfree(sem);
+	xnslab_free(&__xeno_sem_slab,sem);
 
     return err;
 }
@@ -1249,6 +1300,8 @@ static int __rt_sem_inquire (struct task_struct *curr, struct pt_regs *regs)
 
 #ifdef CONFIG_XENO_OPT_NATIVE_EVENT
 
+static xnslab_t __xeno_event_slab;
+
 /*
  * int __rt_event_create(RT_EVENT_PLACEHOLDER *ph,
  *                       const char *name,
@@ -1284,7 +1337,7 @@ static int __rt_event_create (struct task_struct *curr, struct pt_regs *regs)
     /* Creation mode. */
     mode = (int)__xn_reg_arg4(regs);
 
-    event = (RT_EVENT *)xnmalloc(sizeof(*event));
+    event = (RT_EVENT *)xnslab_alloc(&__xeno_event_slab);
 
     if (!event)
 	return -ENOMEM;
@@ -1299,7 +1352,7 @@ static int __rt_event_create (struct task_struct *curr, struct pt_regs *regs)
 	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg1(regs),&ph,sizeof(ph));
 	}
     else
-	xnfree(event);
+	xnslab_free(&__xeno_event_slab,event);
 
     return err;
 }
@@ -1351,7 +1404,7 @@ static int __rt_event_delete (struct task_struct *curr, struct pt_regs *regs)
     err = rt_event_delete(event);
 
     if (!err && event->cpid)
-	xnfree(event);
+	xnslab_free(&__xeno_event_slab,event);
 
     return err;
 }
@@ -1508,6 +1561,8 @@ static int __rt_event_inquire (struct task_struct *curr, struct pt_regs *regs)
 
 #ifdef CONFIG_XENO_OPT_NATIVE_MUTEX
 
+static xnslab_t __xeno_mutex_slab;
+
 /*
  * int __rt_mutex_create(RT_MUTEX_PLACEHOLDER *ph,
  *                       const char *name)
@@ -1535,7 +1590,7 @@ static int __rt_mutex_create (struct task_struct *curr, struct pt_regs *regs)
     else
 	*name = '\0';
 
-    mutex = (RT_MUTEX *)xnmalloc(sizeof(*mutex));
+    mutex = (RT_MUTEX *)xnslab_alloc(&__xeno_mutex_slab);
 
     if (!mutex)
 	return -ENOMEM;
@@ -1550,7 +1605,55 @@ static int __rt_mutex_create (struct task_struct *curr, struct pt_regs *regs)
 	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg1(regs),&ph,sizeof(ph));
 	}
     else
-	xnfree(mutex);
+	xnslab_free(&__xeno_mutex_slab,mutex);
+
+    return err;
+}
+
+/*
+ * int __rt_mutex_create_ceiling(RT_MUTEX_PLACEHOLDER *ph,
+ *                               const char *name,
+ *                               int ceiling)
+ */
+
+static int __rt_mutex_create_ceiling (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    char name[XNOBJECT_NAME_LEN];
+    RT_MUTEX_PLACEHOLDER ph;
+    RT_MUTEX *mutex;
+    int err;
+
+    if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg1(regs),sizeof(ph)))
+	return -EFAULT;
+
+    if (__xn_reg_arg2(regs))
+	{
+	if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg2(regs),sizeof(name)))
+	    return -EFAULT;
+
+	__xn_strncpy_from_user(curr,name,(const char __user *)__xn_reg_arg2(regs),sizeof(name) - 1);
+	name[sizeof(name) - 1] = '\0';
+	}
+    else
+	*name = '\0';
+
+    mutex = (RT_MUTEX *)xnslab_alloc(&__xeno_mutex_slab);
+
+    if (!mutex)
+	return -ENOMEM;
+
+    err = rt_mutex_create_ceiling(mutex,name,(int)__xn_reg_arg3(regs));
+
+    if (err == 0)
+	{
+	mutex->cpid = curr->pid;
+	/* Copy back the registry handle to the ph struct. */
+	ph.opaque = mutex->handle;
+	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg1(regs),&ph,sizeof(ph));
+	}
+    else
+	xnslab_free(&__xeno_mutex_slab,mutex);
 
     return err;
 }
@@ -1602,7 +1705,7 @@ static int __rt_mutex_delete (struct task_struct *curr, struct pt_regs *regs)
     err = rt_mutex_delete(mutex);
 
     if (!err && mutex->cpid)
-	xnfree(mutex);
+	xnslab_free(&__xeno_mutex_slab,mutex);
 
     return err;
 }
@@ -1694,6 +1797,7 @@ static int __rt_mutex_inquire (struct task_struct *curr, struct pt_regs *regs)
 #else /* !CONFIG_XENO_OPT_NATIVE_MUTEX */
 
 #define __rt_mutex_create  __rt_call_not_available
+#define __rt_mutex_create_ceiling  __rt_call_not_available
 #define __rt_mutex_bind    __rt_call_not_available
 #define __rt_mutex_delete  __rt_call_not_available
 #define __rt_mutex_lock    __rt_call_not_available
@@ -1704,6 +1808,8 @@ static int __rt_mutex_inquire (struct task_struct *curr, struct pt_regs *regs)
 
 #ifdef CONFIG_XENO_OPT_NATIVE_COND
 
+static xnslab_t __xeno_cond_slab;
+
 /*
  * int __rt_cond_create(RT_COND_PLACEHOLDER *ph,
  *                      const char *name)
@@ -1731,7 +1837,7 @@ static int __rt_cond_create (struct task_struct *curr, struct pt_regs *regs)
     else
 	*name = '\0';
 
-    cond = (RT_COND *)xnmalloc(sizeof(*cond));
+    cond = (RT_COND *)xnslab_alloc(&__xeno_cond_slab);
 
     if (!cond)
 	return -ENOMEM;
@@ -1746,7 +1852,7 @@ static int __rt_cond_create (struct task_struct *curr, struct pt_regs *regs)
 	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg1(regs),&ph,sizeof(ph));
 	}
     else
-	xnfree(cond);
+	xnslab_free(&__xeno_cond_slab,cond);
 
     return err;
 }
@@ -1798,7 +1904,7 @@ static int __rt_cond_delete (struct task_struct *curr, struct pt_regs *regs)
     err = rt_cond_delete(cond);
 
     if (!err && cond->cpid)
-	xnfree(cond);
+	xnslab_free(&__xeno_cond_slab,cond);
 
     return err;
 }
@@ -1933,6 +2039,8 @@ static int __rt_cond_inquire (struct task_struct *curr, struct pt_regs *regs)
 
 #ifdef CONFIG_XENO_OPT_NATIVE_QUEUE
 
+static xnslab_t __xeno_queue_slab;
+
 /*
  * int __rt_queue_create(RT_QUEUE_PLACEHOLDER *ph,
  *                       const char *name,
@@ -1971,7 +2079,7 @@ static int __rt_queue_create (struct task_struct *curr, struct pt_regs *regs)
     /* Creation mode. */
     mode = (int)__xn_reg_arg5(regs);
 
-    q = (RT_QUEUE *)xnmalloc(sizeof(*q));
+    q = (RT_QUEUE *)xnslab_alloc(&__xeno_queue_slab);
 
     if (!q)
 	return -ENOMEM;
@@ -1987,6 +2095,9 @@ static int __rt_queue_create (struct task_struct *curr, struct pt_regs *regs)
     ph.opaque = q->handle;
     ph.opaque2 = &q->bufpool;
     ph.mapsize = xnheap_size(&q->bufpool);
+    ph.pagemap = xnheap_shared_pagemap(&q->bufpool);
+    ph.pagebase = xnheap_shared_pagebase(&q->bufpool);
+    ph.pageshift = q->bufpool.pageshift;
 
     __xn_copy_to_user(curr,(void __user *)__xn_reg_arg1(regs),&ph,sizeof(ph));
 
@@ -1994,7 +2105,7 @@ static int __rt_queue_create (struct task_struct *curr, struct pt_regs *regs)
 
  free_and_fail:
 	
-    xnfree(q);
+    xnslab_free(&__xeno_queue_slab,q);
 
     return err;
 }
@@ -2025,6 +2136,9 @@ static int __rt_queue_bind (struct task_struct *curr, struct pt_regs *regs)
 
     ph.opaque2 = &q->bufpool;
     ph.mapsize = xnheap_size(&q->bufpool);
+    ph.pagemap = xnheap_shared_pagemap(&q->bufpool);
+    ph.pagebase = xnheap_shared_pagebase(&q->bufpool);
+    ph.pageshift = q->bufpool.pageshift;
 
     xnlock_put_irqrestore(&nklock,s);
 
@@ -2076,7 +2190,7 @@ static int __rt_queue_delete (struct task_struct *curr, struct pt_regs *regs)
     err = rt_queue_delete(q);
 
     if (!err && q->cpid)
-	xnfree(q);
+	xnslab_free(&__xeno_queue_slab,q);
 
  unlock_and_exit:
 
@@ -2189,6 +2303,168 @@ static int __rt_queue_free (struct task_struct *curr, struct pt_regs *regs)
     return err;
 }
 
+/*
+ * int __rt_queue_reserve(RT_QUEUE_PLACEHOLDER *ph,
+ *                        size_t size)
+ */
+
+static int __rt_queue_reserve (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    RT_QUEUE_PLACEHOLDER ph;
+    RT_QUEUE *q;
+    int err;
+    spl_t s;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg1(regs),sizeof(ph)))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,&ph,(void __user *)__xn_reg_arg1(regs),sizeof(ph));
+
+    xnlock_get_irqsave(&nklock,s);
+
+    q = (RT_QUEUE *)rt_registry_fetch(ph.opaque);
+
+    if (q)
+	err = rt_queue_reserve(q,(size_t)__xn_reg_arg2(regs));
+    else
+	err = -ESRCH;
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
+/*
+ * int __rt_queue_alloc_batch(RT_QUEUE_PLACEHOLDER *ph,
+ *                            size_t size,
+ *                            int count,
+ *                            void **bufs)
+ */
+
+static int __rt_queue_alloc_batch (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    void *bufs[RT_QUEUE_BATCH_MAX];
+    RT_QUEUE_PLACEHOLDER ph;
+    int count, n, err = 0;
+    size_t size;
+    RT_QUEUE *q;
+    spl_t s;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg1(regs),sizeof(ph)))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,&ph,(void __user *)__xn_reg_arg1(regs),sizeof(ph));
+
+    size = (size_t)__xn_reg_arg2(regs);
+    count = (int)__xn_reg_arg3(regs);
+
+    if (count <= 0 || count > RT_QUEUE_BATCH_MAX)
+	return -EINVAL;
+
+    if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg4(regs),sizeof(void *) * count))
+	return -EFAULT;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    q = (RT_QUEUE *)rt_registry_fetch(ph.opaque);
+
+    if (!q)
+	{
+	err = -ESRCH;
+	goto unlock_and_exit;
+	}
+
+    /* Stop at the first failure: the caller gets what could be
+       allocated, which is what a single rt_queue_alloc() loop would
+       have returned too. */
+
+    for (n = 0; n < count; n++)
+	{
+	bufs[n] = rt_queue_alloc(q,size);
+
+	if (!bufs[n])
+	    break;
+
+	/* Convert the kernel-based address to the equivalent area
+	   into the caller's address space. */
+	bufs[n] = ph.mapbase + xnheap_shared_offset(&q->bufpool,bufs[n]);
+	}
+
+    err = n > 0 ? n : -ENOMEM;
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    if (err > 0)
+	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg4(regs),bufs,sizeof(void *) * err);
+
+    return err;
+}
+
+/*
+ * int __rt_queue_free_batch(RT_QUEUE_PLACEHOLDER *ph,
+ *                           int count,
+ *                           void **bufs)
+ */
+
+static int __rt_queue_free_batch (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    void *bufs[RT_QUEUE_BATCH_MAX];
+    RT_QUEUE_PLACEHOLDER ph;
+    int count, n, ret, err = 0;
+    RT_QUEUE *q;
+    spl_t s;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg1(regs),sizeof(ph)))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,&ph,(void __user *)__xn_reg_arg1(regs),sizeof(ph));
+
+    count = (int)__xn_reg_arg2(regs);
+
+    if (count <= 0 || count > RT_QUEUE_BATCH_MAX)
+	return -EINVAL;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg3(regs),sizeof(void *) * count))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,bufs,(void __user *)__xn_reg_arg3(regs),sizeof(void *) * count);
+
+    xnlock_get_irqsave(&nklock,s);
+
+    q = (RT_QUEUE *)rt_registry_fetch(ph.opaque);
+
+    if (!q)
+	{
+	err = -ESRCH;
+	goto unlock_and_exit;
+	}
+
+    /* Release all buffers, even past a bad one, reporting the first
+       error only. */
+
+    for (n = 0; n < count; n++)
+	{
+	if (!bufs[n])
+	    ret = -EINVAL;
+	else
+	    ret = rt_queue_free(q,xnheap_shared_address(&q->bufpool,
+							(caddr_t)bufs[n] - ph.mapbase));
+	if (ret && !err)
+	    err = ret;
+	}
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
 /*
  * int __rt_queue_send(RT_QUEUE_PLACEHOLDER *ph,
  *                     void *buf,
@@ -2308,72 +2584,217 @@ static int __rt_queue_recv (struct task_struct *curr, struct pt_regs *regs)
 }
 
 /*
- * int __rt_queue_inquire(RT_QUEUE_PLACEHOLDER *ph,
- *                        RT_QUEUE_INFO *infop)
+ * int __rt_queue_send_multi(RT_QUEUE_PLACEHOLDER *ph,
+ *                           void **bufs,
+ *                           size_t *sizes,
+ *                           int count,
+ *                           int mode)
  */
 
-static int __rt_queue_inquire (struct task_struct *curr, struct pt_regs *regs)
+static int __rt_queue_send_multi (struct task_struct *curr, struct pt_regs *regs)
 
 {
+    void *bufs[RT_QUEUE_MULTI_MAX];
+    size_t sizes[RT_QUEUE_MULTI_MAX];
     RT_QUEUE_PLACEHOLDER ph;
-    RT_QUEUE_INFO info;
+    int count, mode, n, err;
     RT_QUEUE *q;
-    int err;
+    spl_t s;
 
     if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg1(regs),sizeof(ph)))
 	return -EFAULT;
 
-    if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg2(regs),sizeof(info)))
+    __xn_copy_from_user(curr,&ph,(void __user *)__xn_reg_arg1(regs),sizeof(ph));
+
+    count = (int)__xn_reg_arg4(regs);
+
+    if (count <= 0 || count > RT_QUEUE_MULTI_MAX)
+	return -EINVAL;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg2(regs),sizeof(void *) * count))
 	return -EFAULT;
 
-    __xn_copy_from_user(curr,&ph,(void __user *)__xn_reg_arg1(regs),sizeof(ph));
+    __xn_copy_from_user(curr,bufs,(void __user *)__xn_reg_arg2(regs),sizeof(void *) * count);
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg3(regs),sizeof(size_t) * count))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,sizes,(void __user *)__xn_reg_arg3(regs),sizeof(size_t) * count);
+
+    /* Sending mode. */
+    mode = (int)__xn_reg_arg5(regs);
+
+    xnlock_get_irqsave(&nklock,s);
 
     q = (RT_QUEUE *)rt_registry_fetch(ph.opaque);
 
     if (!q)
-	return -ESRCH;
-
-    err = rt_queue_inquire(q,&info);
+	{
+	err = -ESRCH;
+	goto unlock_and_exit;
+	}
 
-    if (!err)
-	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg2(regs),&info,sizeof(info));
+    /* Convert the caller-based addresses of the buffers to the
+       equivalent areas into the kernel address space. A null buffer
+       is left as is, so that the send stops there. */
 
-    return err;
-}
+    for (n = 0; n < count; n++)
+	if (bufs[n])
+	    bufs[n] = xnheap_shared_address(&q->bufpool,(caddr_t)bufs[n] - ph.mapbase);
 
-#else /* !CONFIG_XENO_OPT_NATIVE_QUEUE */
+    err = rt_queue_send_multi(q,bufs,sizes,count,mode);
 
-#define __rt_queue_create    __rt_call_not_available
-#define __rt_queue_bind      __rt_call_not_available
-#define __rt_queue_delete    __rt_call_not_available
-#define __rt_queue_alloc     __rt_call_not_available
-#define __rt_queue_free      __rt_call_not_available
-#define __rt_queue_send      __rt_call_not_available
-#define __rt_queue_recv      __rt_call_not_available
-#define __rt_queue_inquire   __rt_call_not_available
+ unlock_and_exit:
 
-#endif /* CONFIG_XENO_OPT_NATIVE_QUEUE */
+    xnlock_put_irqrestore(&nklock,s);
 
-#ifdef CONFIG_XENO_OPT_NATIVE_HEAP
+    return err;
+}
 
 /*
- * int __rt_heap_create(RT_HEAP_PLACEHOLDER *ph,
- *                      const char *name,
- *                      size_t heapsize,
- *                      int mode)
+ * int __rt_queue_recv_multi(RT_QUEUE_PLACEHOLDER *ph,
+ *                           void **bufs,
+ *                           size_t *sizes,
+ *                           int count,
+ *                           RTIME *timeoutp)
  */
 
-static int __rt_heap_create (struct task_struct *curr, struct pt_regs *regs)
+static int __rt_queue_recv_multi (struct task_struct *curr, struct pt_regs *regs)
 
 {
-    char name[XNOBJECT_NAME_LEN];
-    RT_HEAP_PLACEHOLDER ph;
-    size_t heapsize;
-    int err, mode;
-    RT_HEAP *heap;
-
-    if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg1(regs),sizeof(ph)))
-	return -EFAULT;
+    void *bufs[RT_QUEUE_MULTI_MAX];
+    size_t sizes[RT_QUEUE_MULTI_MAX];
+    RT_QUEUE_PLACEHOLDER ph;
+    RTIME timeout;
+    int count, n, err;
+    RT_QUEUE *q;
+    spl_t s;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg1(regs),sizeof(ph)))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,&ph,(void __user *)__xn_reg_arg1(regs),sizeof(ph));
+
+    count = (int)__xn_reg_arg4(regs);
+
+    if (count <= 0 || count > RT_QUEUE_MULTI_MAX)
+	return -EINVAL;
+
+    if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg2(regs),sizeof(void *) * count))
+	return -EFAULT;
+
+    if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg3(regs),sizeof(size_t) * count))
+	return -EFAULT;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg5(regs),sizeof(timeout)))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,&timeout,(void __user *)__xn_reg_arg5(regs),sizeof(timeout));
+
+    xnlock_get_irqsave(&nklock,s);
+
+    q = (RT_QUEUE *)rt_registry_fetch(ph.opaque);
+
+    if (!q)
+	{
+	err = -ESRCH;
+	goto unlock_and_exit;
+	}
+
+    err = rt_queue_recv_multi(q,bufs,sizes,count,timeout);
+
+    if (err > 0)
+	{
+	/* Convert the kernel-based addresses of the buffers to the
+	   equivalent areas into the caller's address space. */
+	for (n = 0; n < err; n++)
+	    bufs[n] = ph.mapbase + xnheap_shared_offset(&q->bufpool,bufs[n]);
+
+	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg2(regs),bufs,sizeof(void *) * err);
+	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg3(regs),sizes,sizeof(size_t) * err);
+	}
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
+/*
+ * int __rt_queue_inquire(RT_QUEUE_PLACEHOLDER *ph,
+ *                        RT_QUEUE_INFO *infop)
+ */
+
+static int __rt_queue_inquire (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    RT_QUEUE_PLACEHOLDER ph;
+    RT_QUEUE_INFO info;
+    RT_QUEUE *q;
+    int err;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg1(regs),sizeof(ph)))
+	return -EFAULT;
+
+    if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg2(regs),sizeof(info)))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,&ph,(void __user *)__xn_reg_arg1(regs),sizeof(ph));
+
+    q = (RT_QUEUE *)rt_registry_fetch(ph.opaque);
+
+    if (!q)
+	return -ESRCH;
+
+    err = rt_queue_inquire(q,&info);
+
+    if (!err)
+	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg2(regs),&info,sizeof(info));
+
+    return err;
+}
+
+#else /* !CONFIG_XENO_OPT_NATIVE_QUEUE */
+
+#define __rt_queue_create    __rt_call_not_available
+#define __rt_queue_bind      __rt_call_not_available
+#define __rt_queue_delete    __rt_call_not_available
+#define __rt_queue_alloc     __rt_call_not_available
+#define __rt_queue_free      __rt_call_not_available
+#define __rt_queue_alloc_batch __rt_call_not_available
+#define __rt_queue_free_batch  __rt_call_not_available
+#define __rt_queue_reserve     __rt_call_not_available
+#define __rt_queue_send      __rt_call_not_available
+#define __rt_queue_recv      __rt_call_not_available
+#define __rt_queue_send_multi  __rt_call_not_available
+#define __rt_queue_recv_multi  __rt_call_not_available
+#define __rt_queue_inquire   __rt_call_not_available
+
+#endif /* CONFIG_XENO_OPT_NATIVE_QUEUE */
+
+#ifdef CONFIG_XENO_OPT_NATIVE_HEAP
+
+static xnslab_t __xeno_heap_slab;
+
+/*
+ * int __rt_heap_create(RT_HEAP_PLACEHOLDER *ph,
+ *                      const char *name,
+ *                      size_t heapsize,
+ *                      int mode)
+ */
+
+static int __rt_heap_create (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    char name[XNOBJECT_NAME_LEN];
+    RT_HEAP_PLACEHOLDER ph;
+    size_t heapsize;
+    int err, mode;
+    RT_HEAP *heap;
+
+    if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg1(regs),sizeof(ph)))
+	return -EFAULT;
 
     if (__xn_reg_arg2(regs))
 	{
@@ -2391,7 +2812,7 @@ static int __rt_heap_create (struct task_struct *curr, struct pt_regs *regs)
     /* Creation mode. */
     mode = (int)__xn_reg_arg4(regs);
 
-    heap = (RT_HEAP *)xnmalloc(sizeof(*heap));
+    heap = (RT_HEAP *)xnslab_alloc(&__xeno_heap_slab);
 
     if (!heap)
 	return -ENOMEM;
@@ -2414,7 +2835,7 @@ static int __rt_heap_create (struct task_struct *curr, struct pt_regs *regs)
 
  free_and_fail:
 	
-    xnfree(heap);
+    xnslab_free(&__xeno_heap_slab,heap);
 
     return err;
 }
@@ -2496,7 +2917,7 @@ static int __rt_heap_delete (struct task_struct *curr, struct pt_regs *regs)
     err = rt_heap_delete(heap);
 
     if (!err && heap->cpid)
-	xnfree(heap);
+	xnslab_free(&__xeno_heap_slab,heap);
 
  unlock_and_exit:
 
@@ -2661,6 +3082,8 @@ static int __rt_heap_inquire (struct task_struct *curr, struct pt_regs *regs)
 
 #ifdef CONFIG_XENO_OPT_NATIVE_ALARM
 
+static xnslab_t __xeno_alarm_slab;
+
 void rt_alarm_handler (RT_ALARM *alarm, void *cookie)
 
 {
@@ -2697,7 +3120,7 @@ static int __rt_alarm_create (struct task_struct *curr, struct pt_regs *regs)
     else
 	*name = '\0';
 
-    alarm = (RT_ALARM *)xnmalloc(sizeof(*alarm));
+    alarm = (RT_ALARM *)xnslab_alloc(&__xeno_alarm_slab);
 
     if (!alarm)
 	return -ENOMEM;
@@ -2712,7 +3135,7 @@ static int __rt_alarm_create (struct task_struct *curr, struct pt_regs *regs)
 	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg1(regs),&ph,sizeof(ph));
 	}
     else
-	xnfree(alarm);
+	xnslab_free(&__xeno_alarm_slab,alarm);
 
     return err;
 }
@@ -2741,7 +3164,7 @@ static int __rt_alarm_delete (struct task_struct *curr, struct pt_regs *regs)
     err = rt_alarm_delete(alarm);
 
     if (!err && alarm->cpid)
-	xnfree(alarm);
+	xnslab_free(&__xeno_alarm_slab,alarm);
 
     return err;
 }
@@ -2844,6 +3267,36 @@ static int __rt_alarm_wait (struct task_struct *curr, struct pt_regs *regs)
     return err;
 }
 
+/*
+ * int __rt_alarm_set_slack(RT_ALARM_PLACEHOLDER *ph,
+ *                          RTIME slack)
+ */
+
+static int __rt_alarm_set_slack (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    RT_ALARM_PLACEHOLDER ph;
+    RT_ALARM *alarm;
+    RTIME slack;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg1(regs),sizeof(ph)))
+	return -EFAULT;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg2(regs),sizeof(slack)))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,&ph,(void __user *)__xn_reg_arg1(regs),sizeof(ph));
+
+    alarm = (RT_ALARM *)rt_registry_fetch(ph.opaque);
+
+    if (!alarm)
+	return -ESRCH;
+
+    __xn_copy_from_user(curr,&slack,(void __user *)__xn_reg_arg2(regs),sizeof(slack));
+
+    return rt_alarm_set_slack(alarm,slack);
+}
+
 /*
  * int __rt_alarm_inquire(RT_ALARM_PLACEHOLDER *ph,
  *                        RT_ALARM_INFO *infop)
@@ -2886,11 +3339,14 @@ static int __rt_alarm_inquire (struct task_struct *curr, struct pt_regs *regs)
 #define __rt_alarm_stop       __rt_call_not_available
 #define __rt_alarm_wait       __rt_call_not_available
 #define __rt_alarm_inquire    __rt_call_not_available
+#define __rt_alarm_set_slack  __rt_call_not_available
 
 #endif /* CONFIG_XENO_OPT_NATIVE_ALARM */
 
 #ifdef CONFIG_XENO_OPT_NATIVE_INTR
 
+static xnslab_t __xeno_intr_slab;
+
 int rt_intr_handler (xnintr_t *cookie)
 
 {
@@ -2935,7 +3391,7 @@ static int __rt_intr_create (struct task_struct *curr, struct pt_regs *regs)
     if (mode & ~(I_AUTOENA|I_PROPAGATE))
 	return -EINVAL;
 
-    intr = (RT_INTR *)xnmalloc(sizeof(*intr));
+    intr = (RT_INTR *)xnslab_alloc(&__xeno_intr_slab);
 
     if (!intr)
 	return -ENOMEM;
@@ -2951,7 +3407,7 @@ static int __rt_intr_create (struct task_struct *curr, struct pt_regs *regs)
 	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg1(regs),&ph,sizeof(ph));
 	}
     else
-	xnfree(intr);
+	xnslab_free(&__xeno_intr_slab,intr);
 
     return err;
 }
@@ -3003,7 +3459,7 @@ static int __rt_intr_delete (struct task_struct *curr, struct pt_regs *regs)
     err = rt_intr_delete(intr);
 
     if (!err && intr->cpid)
-	xnfree(intr);
+	xnslab_free(&__xeno_intr_slab,intr);
 
     return err;
 }
@@ -3169,8 +3625,287 @@ static int __rt_intr_inquire (struct task_struct *curr, struct pt_regs *regs)
 
 #endif /* CONFIG_XENO_OPT_NATIVE_INTR */
 
+#ifdef CONFIG_XENO_OPT_NATIVE_RING
+
+static xnslab_t __xeno_ring_slab;
+
+/*
+ * int __rt_ring_create(RT_RING_PLACEHOLDER *ph,
+ *                      const char *name,
+ *                      size_t size,
+ *                      int mode)
+ */
+
+static int __rt_ring_create (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    char name[XNOBJECT_NAME_LEN];
+    RT_RING_PLACEHOLDER ph;
+    RT_RING *ring;
+    size_t size;
+    int err, mode;
+
+    if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg1(regs),sizeof(ph)))
+	return -EFAULT;
+
+    if (__xn_reg_arg2(regs))
+	{
+	if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg2(regs),sizeof(name)))
+	    return -EFAULT;
+
+	__xn_strncpy_from_user(curr,name,(const char __user *)__xn_reg_arg2(regs),sizeof(name) - 1);
+	name[sizeof(name) - 1] = '\0';
+	}
+    else
+	*name = '\0';
+
+    /* Size of the data area. */
+    size = (size_t)__xn_reg_arg3(regs);
+    /* Creation mode. */
+    mode = (int)__xn_reg_arg4(regs);
+
+    ring = (RT_RING *)xnslab_alloc(&__xeno_ring_slab);
+
+    if (!ring)
+	return -ENOMEM;
+
+    err = rt_ring_create(ring,name,size,mode);
+
+    if (err)
+	goto free_and_fail;
+
+    ring->cpid = curr->pid;
+
+    /* Copy back the registry handle to the ph struct. */
+    ph.opaque = ring->handle;
+    ph.opaque2 = &ring->heapbase;
+    ph.mapsize = xnheap_size(&ring->heapbase);
+    ph.ctloff = xnheap_shared_offset(&ring->heapbase,ring->ctl);
+
+    __xn_copy_to_user(curr,(void __user *)__xn_reg_arg1(regs),&ph,sizeof(ph));
+
+    return 0;
+
+ free_and_fail:
+	
+    xnslab_free(&__xeno_ring_slab,ring);
+
+    return err;
+}
+
+/*
+ * int __rt_ring_bind(RT_RING_PLACEHOLDER *ph,
+ *                    const char *name,
+ *                    RTIME *timeoutp)
+ */
+
+static int __rt_ring_bind (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    RT_RING_PLACEHOLDER ph;
+    RT_RING *ring;
+    int err;
+    spl_t s;
+
+    if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg1(regs),sizeof(ph)))
+	return -EFAULT;
+
+    xnlock_get_irqsave(&nklock,s);
+
+    err = __rt_bind_helper(curr,regs,&ph.opaque,XENO_RING_MAGIC,(void **)&ring);
+
+    if (err)
+	goto unlock_and_exit;
+
+    ph.opaque2 = &ring->heapbase;
+    ph.mapsize = xnheap_size(&ring->heapbase);
+    ph.ctloff = xnheap_shared_offset(&ring->heapbase,ring->ctl);
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    __xn_copy_to_user(curr,(void __user *)__xn_reg_arg1(regs),&ph,sizeof(ph));
+
+    /* We might need to migrate to secondary mode now for mapping the
+       ring memory to user-space; since this syscall is conforming, we
+       might have entered it in primary mode. */
+
+    if (xnpod_primary_p())
+	xnshadow_relax(0);
+
+    return err;
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
+/*
+ * int __rt_ring_delete(RT_RING_PLACEHOLDER *ph)
+ */
+
+static int __rt_ring_delete (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    RT_RING_PLACEHOLDER ph;
+    RT_RING *ring;
+    int err = 0;
+    spl_t s;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg1(regs),sizeof(ph)))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,&ph,(void __user *)__xn_reg_arg1(regs),sizeof(ph));
+
+    xnlock_get_irqsave(&nklock,s);
+
+    ring = (RT_RING *)rt_registry_fetch(ph.opaque);
+
+    if (!ring)
+	{
+	err = -ESRCH;
+	goto unlock_and_exit;
+	}
+
+    err = rt_ring_delete(ring);
+
+    if (!err && ring->cpid)
+	xnslab_free(&__xeno_ring_slab,ring);
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
+/*
+ * int __rt_ring_pend(RT_RING_PLACEHOLDER *ph,
+ *                    int dir,
+ *                    size_t size,
+ *                    RTIME *timeoutp)
+ */
+
+static int __rt_ring_pend (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    RT_RING_PLACEHOLDER ph;
+    RTIME timeout;
+    RT_RING *ring;
+    int err;
+    spl_t s;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg1(regs),sizeof(ph)))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,&ph,(void __user *)__xn_reg_arg1(regs),sizeof(ph));
+
+    if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg4(regs),sizeof(timeout)))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,&timeout,(void __user *)__xn_reg_arg4(regs),sizeof(timeout));
+
+    xnlock_get_irqsave(&nklock,s);
+
+    ring = (RT_RING *)rt_registry_fetch(ph.opaque);
+
+    if (!ring)
+	{
+	err = -ESRCH;
+	goto unlock_and_exit;
+	}
+
+    err = rt_ring_pend(ring,
+		       (int)__xn_reg_arg2(regs),
+		       (size_t)__xn_reg_arg3(regs),
+		       &timeout);
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    /* Return the time left, for the caller to wait again if a
+       competing task took the room or the record first. */
+    if (!err)
+	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg4(regs),&timeout,sizeof(timeout));
+
+    return err;
+}
+
+/*
+ * int __rt_ring_post(RT_RING_PLACEHOLDER *ph,
+ *                    int dir)
+ */
+
+static int __rt_ring_post (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    RT_RING_PLACEHOLDER ph;
+    RT_RING *ring;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg1(regs),sizeof(ph)))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,&ph,(void __user *)__xn_reg_arg1(regs),sizeof(ph));
+
+    ring = (RT_RING *)rt_registry_fetch(ph.opaque);
+
+    if (!ring)
+	return -ESRCH;
+
+    return rt_ring_post(ring,(int)__xn_reg_arg2(regs));
+}
+
+/*
+ * int __rt_ring_inquire(RT_RING_PLACEHOLDER *ph,
+ *                       RT_RING_INFO *infop)
+ */
+
+static int __rt_ring_inquire (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    RT_RING_PLACEHOLDER ph;
+    RT_RING_INFO info;
+    RT_RING *ring;
+    int err;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg1(regs),sizeof(ph)))
+	return -EFAULT;
+
+    if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg2(regs),sizeof(info)))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,&ph,(void __user *)__xn_reg_arg1(regs),sizeof(ph));
+
+    ring = (RT_RING *)rt_registry_fetch(ph.opaque);
+
+    if (!ring)
+	return -ESRCH;
+
+    err = rt_ring_inquire(ring,&info);
+
+    if (!err)
+	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg2(regs),&info,sizeof(info));
+
+    return err;
+}
+
+#else /* !CONFIG_XENO_OPT_NATIVE_RING */
+
+#define __rt_ring_create     __rt_call_not_available
+#define __rt_ring_bind       __rt_call_not_available
+#define __rt_ring_delete     __rt_call_not_available
+#define __rt_ring_pend       __rt_call_not_available
+#define __rt_ring_post       __rt_call_not_available
+#define __rt_ring_inquire    __rt_call_not_available
+
+#endif /* CONFIG_XENO_OPT_NATIVE_RING */
+
 #ifdef CONFIG_XENO_OPT_NATIVE_PIPE
 
+static xnslab_t __xeno_pipe_slab;
+
 /*
  * int __rt_pipe_create(RT_PIPE_PLACEHOLDER *ph,
  *                      const char *name,
@@ -3202,7 +3937,7 @@ static int __rt_pipe_create (struct task_struct *curr, struct pt_regs *regs)
     /* Device minor. */
     minor = (int)__xn_reg_arg3(regs);
 
-    pipe = (RT_PIPE *)xnmalloc(sizeof(*pipe));
+    pipe = (RT_PIPE *)xnslab_alloc(&__xeno_pipe_slab);
 
     if (!pipe)
 	return -ENOMEM;
@@ -3217,7 +3952,7 @@ static int __rt_pipe_create (struct task_struct *curr, struct pt_regs *regs)
 	__xn_copy_to_user(curr,(void __user *)__xn_reg_arg1(regs),&ph,sizeof(ph));
 	}
     else
-	xnfree(pipe);
+	xnslab_free(&__xeno_pipe_slab,pipe);
 
     return err;
 }
@@ -3269,7 +4004,7 @@ static int __rt_pipe_delete (struct task_struct *curr, struct pt_regs *regs)
     err = rt_pipe_delete(pipe);
 
     if (!err && pipe->cpid)
-	xnfree(pipe);
+	xnslab_free(&__xeno_pipe_slab,pipe);
 
     return err;
 }
@@ -3495,6 +4230,75 @@ static int __rt_misc_put_io_region (struct task_struct *curr, struct pt_regs *re
     return 0;
 }
 
+/*
+ * int __rt_select(RT_SELECT_ITEM *items,
+ *                 int nitems,
+ *                 RTIME *timeoutp)
+ */
+
+static int __rt_select (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    RT_SELECT_ITEM items[RT_SELECT_MAX];
+    rt_handle_t handles[RT_SELECT_MAX];
+    RT_SELECT_ITEM __user *uitems;
+    int nitems, n, err;
+    RTIME timeout;
+    spl_t s;
+
+    uitems = (RT_SELECT_ITEM __user *)__xn_reg_arg1(regs);
+    nitems = (int)__xn_reg_arg2(regs);
+
+    if (nitems <= 0 || nitems > RT_SELECT_MAX)
+	return -EINVAL;
+
+    if (!__xn_access_ok(curr,VERIFY_WRITE,uitems,sizeof(*uitems) * nitems))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,items,uitems,sizeof(*uitems) * nitems);
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg3(regs),sizeof(timeout)))
+	return -EFAULT;
+
+    __xn_copy_from_user(curr,&timeout,(void __user *)__xn_reg_arg3(regs),sizeof(timeout));
+
+    /* All the native placeholders start with the registry handle of
+       the object they stand for. */
+
+    for (n = 0; n < nitems; n++)
+	{
+	if (!__xn_access_ok(curr,VERIFY_READ,items[n].object,sizeof(handles[n])))
+	    return -EFAULT;
+
+	__xn_copy_from_user(curr,&handles[n],(void __user *)items[n].object,sizeof(handles[n]));
+	}
+
+    xnlock_get_irqsave(&nklock,s);
+
+    for (n = 0; n < nitems; n++)
+	{
+	items[n].object = rt_registry_fetch(handles[n]);
+
+	if (!items[n].object)
+	    {
+	    err = -ESRCH;
+	    goto unlock_and_exit;
+	    }
+	}
+
+    err = rt_select(items,nitems,timeout);
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    if (err >= 0)
+	for (n = 0; n < nitems; n++)
+	    __xn_copy_to_user(curr,&uitems[n].ready,&items[n].ready,sizeof(items[n].ready));
+
+    return err;
+}
+
 static  __attribute__((unused))
 int __rt_call_not_available (struct task_struct *curr, struct pt_regs *regs) {
     return -ENOSYS;
@@ -3594,6 +4398,21 @@ static xnsysent_t __systab[] = {
     [__xeno_misc_put_io_region ] = { &__rt_misc_put_io_region, __xn_exec_lostage },
     [__xeno_timer_ns2tsc ] = { &__rt_timer_ns2tsc, __xn_exec_any },
     [__xeno_timer_tsc2ns ] = { &__rt_timer_tsc2ns, __xn_exec_any },
+    [__xeno_alarm_set_slack ] = { &__rt_alarm_set_slack, __xn_exec_any },
+    [__xeno_mutex_create_ceiling ] = { &__rt_mutex_create_ceiling, __xn_exec_any },
+    [__xeno_task_set_budget ] = { &__rt_task_set_budget, __xn_exec_any },
+    [__xeno_queue_alloc_batch ] = { &__rt_queue_alloc_batch, __xn_exec_any },
+    [__xeno_queue_free_batch ] = { &__rt_queue_free_batch, __xn_exec_any },
+    [__xeno_queue_reserve ] = { &__rt_queue_reserve, __xn_exec_primary },
+    [__xeno_ring_create ] = { &__rt_ring_create, __xn_exec_lostage },
+    [__xeno_ring_bind ] = { &__rt_ring_bind, __xn_exec_conforming },
+    [__xeno_ring_delete ] = { &__rt_ring_delete, __xn_exec_lostage },
+    [__xeno_ring_pend ] = { &__rt_ring_pend, __xn_exec_primary },
+    [__xeno_ring_post ] = { &__rt_ring_post, __xn_exec_any },
+    [__xeno_ring_inquire ] = { &__rt_ring_inquire, __xn_exec_any },
+    [__xeno_queue_send_multi ] = { &__rt_queue_send_multi, __xn_exec_any },
+    [__xeno_queue_recv_multi ] = { &__rt_queue_recv_multi, __xn_exec_primary },
+    [__xeno_select ] = { &__rt_select, __xn_exec_primary },
 };
 
 static void __shadow_delete_hook (xnthread_t *thread)
@@ -3604,9 +4423,65 @@ static void __shadow_delete_hook (xnthread_t *thread)
 	xnshadow_unmap(thread);
 }
 
+/* The control blocks of the objects created from user-space are
+   obtained from per-type slabs, which are grown on demand from the
+   system heap. Tasks are not, since the descriptor of a task
+   deleting itself is released after the switch by xnfreesafe(),
+   which only knows about heap blocks. */
+
+static struct {
+    xnslab_t *slab;
+    u_long objsize;
+} __xeno_slabs[] = {
+#ifdef CONFIG_XENO_OPT_NATIVE_SEM
+    { &__xeno_sem_slab, sizeof(RT_SEM) },
+#endif /* CONFIG_XENO_OPT_NATIVE_SEM */
+#ifdef CONFIG_XENO_OPT_NATIVE_EVENT
+    { &__xeno_event_slab, sizeof(RT_EVENT) },
+#endif /* CONFIG_XENO_OPT_NATIVE_EVENT */
+#ifdef CONFIG_XENO_OPT_NATIVE_MUTEX
+    { &__xeno_mutex_slab, sizeof(RT_MUTEX) },
+#endif /* CONFIG_XENO_OPT_NATIVE_MUTEX */
+#ifdef CONFIG_XENO_OPT_NATIVE_COND
+    { &__xeno_cond_slab, sizeof(RT_COND) },
+#endif /* CONFIG_XENO_OPT_NATIVE_COND */
+#ifdef CONFIG_XENO_OPT_NATIVE_QUEUE
+    { &__xeno_queue_slab, sizeof(RT_QUEUE) },
+#endif /* CONFIG_XENO_OPT_NATIVE_QUEUE */
+#ifdef CONFIG_XENO_OPT_NATIVE_HEAP
+    { &__xeno_heap_slab, sizeof(RT_HEAP) },
+#endif /* CONFIG_XENO_OPT_NATIVE_HEAP */
+#ifdef CONFIG_XENO_OPT_NATIVE_ALARM
+    { &__xeno_alarm_slab, sizeof(RT_ALARM) },
+#endif /* CONFIG_XENO_OPT_NATIVE_ALARM */
+#ifdef CONFIG_XENO_OPT_NATIVE_INTR
+    { &__xeno_intr_slab, sizeof(RT_INTR) },
+#endif /* CONFIG_XENO_OPT_NATIVE_INTR */
+#ifdef CONFIG_XENO_OPT_NATIVE_RING
+    { &__xeno_ring_slab, sizeof(RT_RING) },
+#endif /* CONFIG_XENO_OPT_NATIVE_RING */
+#ifdef CONFIG_XENO_OPT_NATIVE_PIPE
+    { &__xeno_pipe_slab, sizeof(RT_PIPE) },
+#endif /* CONFIG_XENO_OPT_NATIVE_PIPE */
+    { NULL, 0 }
+};
+
 int __xeno_syscall_init (void)
 
 {
+    int n, err;
+
+    for (n = 0; __xeno_slabs[n].slab; n++)
+	{
+	err = xnslab_init(__xeno_slabs[n].slab,
+			  &kheap,
+			  __xeno_slabs[n].objsize,
+			  0,
+			  NULL);
+	if (err)
+	    goto destroy_slabs;
+	}
+
     __muxid =
 	xnshadow_register_interface("native",
 				    XENO_SKIN_MAGIC,
@@ -3614,16 +4489,36 @@ int __xeno_syscall_init (void)
 				    __systab,
 				    NULL);
     if (__muxid < 0)
-	return -ENOSYS;
+	{
+	err = -ENOSYS;
+	goto destroy_slabs;
+	}
 
     xnpod_add_hook(XNHOOK_THREAD_DELETE,&__shadow_delete_hook);
     
     return 0;
+
+ destroy_slabs:
+
+    while (--n >= 0)
+	xnslab_destroy(__xeno_slabs[n].slab);
+
+    return err;
 }
 
 void __xeno_syscall_cleanup (void)
 
 {
+    int n;
+
     xnpod_remove_hook(XNHOOK_THREAD_DELETE,&__shadow_delete_hook);
     xnshadow_unregister_interface(__muxid);
+
+    /* Objects user-space did not delete may still be referred to by
+       the registry; leave their slab in place, as their memory
+       would have stayed allocated from the system heap. */
+
+    for (n = 0; __xeno_slabs[n].slab; n++)
+	if (xnslab_free_count(__xeno_slabs[n].slab) == xnslab_count(__xeno_slabs[n].slab))
+	    xnslab_destroy(__xeno_slabs[n].slab);
 }
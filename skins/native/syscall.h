@@ -116,6 +116,27 @@
 #define __xeno_misc_put_io_region 90
 #define __xeno_timer_ns2tsc       91
 #define __xeno_timer_tsc2ns       92
+#define __xeno_alarm_set_slack    93
+#define __xeno_mutex_create_ceiling 94
+#define __xeno_task_set_budget    95
+#define __xeno_queue_alloc_batch  96
+#define __xeno_queue_free_batch   97
+#define __xeno_queue_reserve      98
+#define __xeno_ring_create        99
+#define __xeno_ring_bind          100
+#define __xeno_ring_delete        101
+#define __xeno_ring_pend          102
+#define __xeno_ring_post          103
+#define __xeno_ring_inquire       104
+#define __xeno_queue_send_multi   105
+#define __xeno_queue_recv_multi   106
+#define __xeno_select             107
+
+/* Max. number of message buffers moved by a single batch call. */
+#define RT_QUEUE_BATCH_MAX  8
+
+/* Max. number of messages moved by a single vectored send/recv call. */
+#define RT_QUEUE_MULTI_MAX  16
 
 struct rt_arg_bulk {
 
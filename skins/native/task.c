@@ -1062,6 +1062,7 @@ int rt_task_inquire (RT_TASK *task, RT_TASK_INFO *info)
     info->cprio = xnthread_current_priority(&task->thread_base);
     info->status = xnthread_status_flags(&task->thread_base);
     info->relpoint = xntimer_get_date(&task->timer);
+    info->exectime = xnpod_get_exec_time(&task->thread_base);
 
  unlock_and_exit:
 
@@ -1308,10 +1309,11 @@ int rt_task_notify (RT_TASK *task,
  *
  * Each Xenomai task has a set of internal bits determining various
  * operating conditions; the rt_task_set_mode() service allows to
- * alter three of them, respectively controlling:
+ * alter four of them, respectively controlling:
  *
  * - whether the task locks the rescheduling procedure,
  * - whether the task undergoes a round-robin scheduling,
+ * - whether the task undergoes an earliest deadline first scheduling,
  * - whether the task blocks the delivery of signals.
  *
  * To this end, rt_task_set_mode() takes a bitmask of mode bits to
@@ -1329,6 +1331,16 @@ int rt_task_notify (RT_TASK *task,
  * the round-robin scheduling policy at the time this service is
  * called, the time quantum remains unchanged.
  *
+ * - T_EDF causes the current task to be scheduled by earliest
+ * deadline first among the tasks of its priority level which have
+ * this bit set. The deadline of each job of a periodic task is its
+ * next release point, as defined by rt_task_set_periodic(); a task
+ * readied with an earlier deadline preempts a running one of the
+ * same priority. Since priorities still prevail over deadlines, a
+ * set of EDF tasks is best given a dedicated priority level, which
+ * allows them to coexist with fixed-priority tasks above and below
+ * this level.
+ *
  * - T_NOSIG disables the asynchronous signal delivery for the current
  * task.
  *
@@ -1406,7 +1418,7 @@ int rt_task_set_mode (int clrmask,
 	    return 0;
 	}
 
-    if (((clrmask|setmask) & ~(T_LOCK|T_RRB|T_NOSIG|T_SHIELD|T_WARNSW)) != 0)
+    if (((clrmask|setmask) & ~(T_LOCK|T_RRB|T_EDF|T_NOSIG|T_SHIELD|T_WARNSW)) != 0)
 	return -EINVAL;
 
     if (!xnpod_primary_p())
@@ -1533,6 +1545,107 @@ int rt_task_slice (RT_TASK *task, RTIME quantum)
     return err;
 }
 
+#ifdef CONFIG_XENO_OPT_BUDGET
+
+/**
+ * @fn int rt_task_set_budget(RT_TASK *task,RTIME budget,RTIME period,int mode)
+ * @brief Set a task's CPU budget.
+ *
+ * Limit the CPU time a task may consume in primary mode over a
+ * recurring period. The budget is replenished at the beginning of
+ * each period; when a task exhausts it before the period ends, the
+ * action selected by @a mode is taken. This allows tasks with soft
+ * real-time requirements to share a CPU with time-critical ones
+ * without being able to starve them.
+ *
+ * @param task The descriptor address of the affected task. If @a task
+ * is NULL, the current task is considered.
+ *
+ * @param budget The CPU time allotted to the task per period,
+ * expressed in clock ticks (see note). Passing TM_INFINITE removes
+ * the current budget, releasing the task if it is throttled.
+ *
+ * @param period The replenishment period, expressed in clock ticks
+ * (see note). The first period starts upon return from this call.
+ *
+ * @param mode The action taken upon budget overrun:
+ *
+ * - T_THROTTLE suspends the task until the next replenishment.
+ *
+ * - T_NOTIFY lets the task run, sending the SIGXCPU signal to
+ * user-space tasks once per period.
+ *
+ * @return 0 is returned upon success. Otherwise:
+ *
+ * - -EINVAL is returned if @a task is not a task descriptor, if @a
+ * mode is invalid, or if @a period is shorter than @a budget.
+ *
+ * - -EIDRM is returned if @a task is a deleted task descriptor.
+ *
+ * - -EWOULDBLOCK is returned if the system timer has not been started
+ * using rt_timer_start().
+ *
+ * - -EPERM is returned if @a task is NULL but not called from a task
+ * context.
+ *
+ * Environments:
+ *
+ * This service can be called from:
+ *
+ * - Kernel module initialization/cleanup code
+ * only if @a task is non-NULL.
+ *
+ * - Kernel-based task
+ * - User-space task
+ *
+ * Rescheduling: possible if a throttled task is released.
+ *
+ * @note A task throttled while holding a mutex delays all tasks
+ * waiting for it, regardless of their priority.
+ *
+ * @note This service is sensitive to the current operation mode of
+ * the system timer, as defined by the rt_timer_start() service. In
+ * periodic mode, clock ticks are interpreted as periodic jiffies. In
+ * oneshot mode, clock ticks are interpreted as nanoseconds.
+ */
+
+int rt_task_set_budget (RT_TASK *task,
+			RTIME budget,
+			RTIME period,
+			int mode)
+{
+    int err;
+    spl_t s;
+
+    if (!task)
+	{
+	if (!xnpod_primary_p())
+	    return -EPERM;
+
+	task = xeno_current_task();
+	}
+
+    xnlock_get_irqsave(&nklock,s);
+
+    task = xeno_h2obj_validate(task,XENO_TASK_MAGIC,RT_TASK);
+
+    if (!task)
+	{
+	err = xeno_handle_error(task,XENO_TASK_MAGIC,RT_TASK);
+	goto unlock_and_exit;
+	}
+
+    err = xnpod_set_thread_budget(&task->thread_base,budget,period,mode);
+
+ unlock_and_exit:
+
+    xnlock_put_irqrestore(&nklock,s);
+
+    return err;
+}
+
+#endif /* CONFIG_XENO_OPT_BUDGET */
+
 #ifdef CONFIG_XENO_OPT_NATIVE_MPS
 
 /**
@@ -1853,7 +1966,7 @@ int rt_task_receive (RT_TASK_MCB *mcb_r,
        until our caller invokes rt_task_reply(). IOW,
        rt_task_receive() will fetch back the exact same message until
        rt_task_reply() is called to release the heading sender. */
-    holder = getheadpq(xnsynch_wait_queue(&receiver->msendq));
+    holder = synch_getheadpq(xnsynch_wait_queue(&receiver->msendq));
 
     if (holder)
 	goto pull_message;
@@ -1889,7 +2002,7 @@ int rt_task_receive (RT_TASK_MCB *mcb_r,
 	goto unlock_and_exit;
 	}
 
-    holder = getheadpq(xnsynch_wait_queue(&receiver->msendq));
+    holder = synch_getheadpq(xnsynch_wait_queue(&receiver->msendq));
     /* There must be a valid holder since we waited for it. */
 
  pull_message:
@@ -2000,9 +2113,9 @@ int rt_task_reply (int flowid, RT_TASK_MCB *mcb_s)
 
     xnlock_get_irqsave(&nklock,s);
 
-    for (holder = getheadpq(xnsynch_wait_queue(&sender->msendq)), receiver = NULL;
+    for (holder = synch_getheadpq(xnsynch_wait_queue(&sender->msendq)), receiver = NULL;
 	 holder != NULL;
-	 holder = nextpq(xnsynch_wait_queue(&sender->msendq),holder))
+	 holder = synch_nextpq(xnsynch_wait_queue(&sender->msendq),holder))
 	{
 	receiver = thread2rtask(link2thread(holder,plink));
 
@@ -2303,6 +2416,9 @@ EXPORT_SYMBOL(rt_task_notify);
 EXPORT_SYMBOL(rt_task_set_mode);
 EXPORT_SYMBOL(rt_task_self);
 EXPORT_SYMBOL(rt_task_slice);
+#ifdef CONFIG_XENO_OPT_BUDGET
+EXPORT_SYMBOL(rt_task_set_budget);
+#endif /* CONFIG_XENO_OPT_BUDGET */
 #ifdef CONFIG_XENO_OPT_NATIVE_MPS
 EXPORT_SYMBOL(rt_task_send);
 EXPORT_SYMBOL(rt_task_receive);
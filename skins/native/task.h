@@ -47,6 +47,11 @@
 #define T_SHIELD  XNSHIELD
 #define T_WARNSW  XNTRAPSW
 #define T_PRIMARY XNTHREAD_SPARE0
+#define T_EDF     XNEDF
+
+/* Budget overrun actions. */
+#define T_THROTTLE XNBUDGET_THROTTLE
+#define T_NOTIFY   XNBUDGET_NOTIFY
 
 /* Task hook types. */
 #define T_HOOK_START  XNHOOK_THREAD_START
@@ -76,6 +81,8 @@ typedef struct rt_task_info {
 
     RTIME relpoint;		/* !< Periodic release point. */
 
+    RTIME exectime;		/* !< Execution time in primary mode (ns). */
+
     char name[XNOBJECT_NAME_LEN]; /* !< Symbolic name. */
 
 } RT_TASK_INFO;
@@ -268,6 +275,15 @@ RT_TASK *rt_task_self(void);
 int rt_task_slice(RT_TASK *task,
 		  RTIME quantum);
 
+#ifdef CONFIG_XENO_OPT_BUDGET
+
+int rt_task_set_budget(RT_TASK *task,
+		       RTIME budget,
+		       RTIME period,
+		       int mode);
+
+#endif /* CONFIG_XENO_OPT_BUDGET */
+
 #ifdef CONFIG_XENO_OPT_NATIVE_MPS
 
 ssize_t rt_task_send(RT_TASK *task,
@@ -30,6 +30,8 @@ typedef struct {
 ((cleanup_handler_t *)(((char *)laddr)-(int)(&((cleanup_handler_t *)0)->link)))
 } cleanup_handler_t;
 
+static xnslab_t cleanup_handler_slab;
+
 int pthread_cancel (pthread_t thread)
 
 {
@@ -84,11 +86,11 @@ void pthread_cleanup_push (cleanup_routine_t routine, void *arg)
     /* The allocation is inside the critical section in order to make the
        function async-signal safe, that is in order to avoid leaks if an
        asynchronous cancellation request could occur between the call to
-       xnmalloc and xnlock_get_irqsave. */
+       xnslab_alloc and xnlock_get_irqsave. */
 
     xnlock_get_irqsave(&nklock, s);
 
-    handler = xnmalloc(sizeof(*handler));
+    handler = xnslab_alloc(&cleanup_handler_slab);
 
     if (!handler)
 	{
@@ -129,8 +131,8 @@ void pthread_cleanup_pop (int execute)
     if (execute)
         handler->routine(handler->arg);
 
-    /* Same remark as xnmalloc in pthread_cleanup_push */
-    xnfree(handler);
+    /* Same remark as xnslab_alloc in pthread_cleanup_push */
+    xnslab_free(&cleanup_handler_slab, handler);
 
     xnlock_put_irqrestore(&nklock, s);
 }
@@ -245,10 +247,24 @@ void pse51_cancel_cleanup_thread (pthread_t thread)
 	{
         cleanup_handler_t *handler = link2cleanup_handler(holder);
         handler->routine(handler->arg);
-        xnfree(handler);
+        xnslab_free(&cleanup_handler_slab, handler);
 	}
 }
 
+void pse51_cancel_pkg_init (void)
+
+{
+    /* Chunks of handlers are obtained from the system heap on
+       demand. */
+    xnslab_init(&cleanup_handler_slab, &kheap, sizeof(cleanup_handler_t), 0, NULL);
+}
+
+void pse51_cancel_pkg_cleanup (void)
+
+{
+    xnslab_destroy(&cleanup_handler_slab);
+}
+
 EXPORT_SYMBOL(pthread_cancel);
 EXPORT_SYMBOL(pthread_cleanup_push);
 EXPORT_SYMBOL(pthread_cleanup_pop);
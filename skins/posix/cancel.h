@@ -23,4 +23,8 @@ void pse51_cancel_init_thread(pthread_t thread);
 
 void pse51_cancel_cleanup_thread(pthread_t thread);
 
+void pse51_cancel_pkg_init(void);
+
+void pse51_cancel_pkg_cleanup(void);
+
 #endif /* !_POSIX_CANCEL_H */
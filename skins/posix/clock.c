@@ -22,6 +22,20 @@
 int clock_getres (clockid_t clock_id, struct timespec *res)
 
 {
+#ifdef CONFIG_XENO_OPT_STATS
+    if (clock_id == CLOCK_THREAD_CPUTIME_ID)
+        {
+        /* Execution times are accounted in CPU cycles. */
+        if (res)
+            {
+            res->tv_sec = 0;
+            res->tv_nsec = 1;
+            }
+
+        return 0;
+        }
+#endif /* CONFIG_XENO_OPT_STATS */
+
     if (clock_id != CLOCK_MONOTONIC && clock_id != CLOCK_REALTIME)
         {
         thread_set_errno(EINVAL);
@@ -50,6 +64,14 @@ int clock_gettime (clockid_t clock_id, struct timespec *tp)
             tp->tv_sec = xnarch_uldivrem(cpu_time, ONE_BILLION, &tp->tv_nsec);
             break;
 
+#ifdef CONFIG_XENO_OPT_STATS
+        case CLOCK_THREAD_CPUTIME_ID:
+            /* Time spent in primary mode by the calling thread. */
+            cpu_time = xnpod_get_exec_time(xnpod_current_thread());
+            tp->tv_sec = xnarch_uldivrem(cpu_time, ONE_BILLION, &tp->tv_nsec);
+            break;
+#endif /* CONFIG_XENO_OPT_STATS */
+
         default:
             thread_set_errno(EINVAL);
             return -1;
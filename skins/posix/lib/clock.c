@@ -17,11 +17,14 @@
  */
 
 #include <errno.h>
+#include <nucleus/vdso.h>
 #include <posix/lib/pthread.h>
 #include <posix/syscall.h>
 
 extern int __pse51_muxid;
 
+extern xnvdso_t *__pse51_vdso;
+
 /* Xenomai only deals with the CLOCK_MONOTONIC clock for
    now. Calls referring to other clock types are simply routed to the
    libc. */
@@ -44,10 +47,36 @@ int __wrap_clock_getres (clockid_t clock_id, struct timespec *tp)
 int __wrap_clock_gettime (clockid_t clock_id, struct timespec *tp)
 
 {
-    int err = -XENOMAI_SKINCALL2(__pse51_muxid,
-                                 __pse51_clock_gettime,
-                                 clock_id,
-                                 tp);
+    int err;
+#ifdef CONFIG_XENO_HW_DIRECT_TSC
+    xnvdso_t *vdso = __pse51_vdso;
+    unsigned long long ns;
+    long long offset;
+
+    /* Read the clocks from the shared time page when possible; the
+       real-time clock is only tracked there in aperiodic mode, where
+       it counts nanoseconds. */
+
+    if (vdso && (clock_id == CLOCK_MONOTONIC ||
+		 (clock_id == CLOCK_REALTIME &&
+		  xnvdso_read_state(vdso,&offset) == XNVDSO_POD)))
+	{
+	ns = xnarch_uscale(&vdso->tsc2ns,__xn_rdtsc());
+
+	if (clock_id == CLOCK_REALTIME)
+	    ns += offset;
+
+	tp->tv_sec = ns / 1000000000;
+	tp->tv_nsec = ns % 1000000000;
+
+	return 0;
+	}
+#endif /* CONFIG_XENO_HW_DIRECT_TSC */
+
+    err = -XENOMAI_SKINCALL2(__pse51_muxid,
+                             __pse51_clock_gettime,
+                             clock_id,
+                             tp);
 
     if(!err)
         return 0;
@@ -19,6 +19,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <nucleus/vdso.h>
 #include <posix/posix.h>
 #include <posix/syscall.h>
 #include <rtdm/syscall.h>
@@ -27,12 +28,15 @@ int __pse51_muxid = -1;
 int __rtdm_muxid  = -1;
 int __rtdm_fd_start = INT_MAX;
 
+xnvdso_t *__pse51_vdso;
+
 static __attribute__((constructor)) void __init_posix_interface(void)
 
 {
+    xnsysinfo_t info;
     int muxid;
 
-    muxid = XENOMAI_SYSCALL2(__xn_sys_bind,PSE51_SKIN_MAGIC,NULL); /* atomic */
+    muxid = XENOMAI_SYSCALL2(__xn_sys_bind,PSE51_SKIN_MAGIC,&info); /* atomic */
 
     if (muxid < 0)
 	{
@@ -43,6 +47,9 @@ static __attribute__((constructor)) void __init_posix_interface(void)
 
     __pse51_muxid = muxid;
 
+    /* Shared time page for clock_gettime(); NULL if unavailable. */
+    __pse51_vdso = xnvdso_map(&info);
+
     muxid = XENOMAI_SYSCALL2(__xn_sys_bind,RTDM_SKIN_MAGIC,NULL); /* atomic */
 
     if (muxid > 0)
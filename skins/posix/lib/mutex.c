@@ -28,14 +28,30 @@ int __wrap_pthread_mutex_init (pthread_mutex_t *mutex,
 			       const pthread_mutexattr_t *attr)
 {
     union __xeno_mutex *_mutex = (union __xeno_mutex *)mutex;
-    int err;
-
-    /* Mutex attributes are ignored, since we always build recursive,
-       PIP-enabled mutexes. */
-
-    err = -XENOMAI_SKINCALL1(__pse51_muxid,
-			     __pse51_mutex_init,
-			     &_mutex->shadow_mutex.handle);
+    int err, protocol, prioceiling;
+
+    /* Mutex attributes are ignored but the protocol, since we always
+       build recursive mutexes, enforcing the priority ceiling
+       protocol if requested, or priority inheritance otherwise. */
+
+    if (attr &&
+	pthread_mutexattr_getprotocol(attr,&protocol) == 0 &&
+	protocol == PTHREAD_PRIO_PROTECT)
+	{
+	err = pthread_mutexattr_getprioceiling(attr,&prioceiling);
+
+	if (err)
+	    return err;
+
+	err = -XENOMAI_SKINCALL2(__pse51_muxid,
+				 __pse51_mutex_init_ceiling,
+				 &_mutex->shadow_mutex.handle,
+				 prioceiling);
+	}
+    else
+	err = -XENOMAI_SKINCALL1(__pse51_muxid,
+				 __pse51_mutex_init,
+				 &_mutex->shadow_mutex.handle);
     if (!err)
 	_mutex->shadow_mutex.magic = SHADOW_MUTEX_MAGIC;
 
@@ -91,6 +91,9 @@ int pthread_intr_wait_np(pthread_intr_t intr,
 int pthread_intr_control_np(pthread_intr_t intr,
 			    int cmd);
 
+int timer_setslack_np(timer_t timerid,
+		      const struct timespec *slack);
+
 int __real_pthread_create(pthread_t *tid,
 			  const pthread_attr_t *attr,
 			  void *(*start) (void *),
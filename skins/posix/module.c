@@ -26,6 +26,7 @@
 #include <posix/sem.h>
 #include <posix/signal.h>
 #include <posix/thread.h>
+#include <posix/cancel.h>
 #include <posix/tsd.h>
 #include <posix/mq.h>
 #include <posix/intr.h>
@@ -54,6 +55,7 @@ static void pse51_shutdown(int xtype)
     xnpod_stop_timer();
 
     pse51_thread_pkg_cleanup();
+    pse51_cancel_pkg_cleanup();
     pse51_timer_pkg_cleanup();
     pse51_tsd_pkg_cleanup();
     pse51_cond_pkg_cleanup();
@@ -133,6 +135,7 @@ int __xeno_skin_init(void)
     pse51_intr_pkg_init();
 #endif /* __KERNEL__ && CONFIG_XENO_OPT_PERVASIVE */
     pse51_timer_pkg_init();
+    pse51_cancel_pkg_init();
 
     pse51_thread_pkg_init(module_param_value(time_slice_arg));
 
@@ -89,8 +89,13 @@ int pthread_mutex_init (pthread_mutex_t *mutex, const pthread_mutexattr_t *attr)
 
     if (attr->protocol == PTHREAD_PRIO_INHERIT)
         synch_flags |= XNSYNCH_PIP;
+    else if (attr->protocol == PTHREAD_PRIO_PROTECT)
+        synch_flags |= XNSYNCH_PCP;
     
     xnsynch_init(&mutex->synchbase, synch_flags);
+
+    if (attr->protocol == PTHREAD_PRIO_PROTECT)
+        xnsynch_set_ceiling(&mutex->synchbase, attr->prioceiling);
     mutex->count = 0;
     appendq(&pse51_mutexq, &mutex->link);
 
@@ -89,7 +89,9 @@ static inline int mutex_unlock_internal(pthread_mutex_t *mutex)
     
     mutex->owner = NULL;
     mutex->count = 0;
-    if (xnsynch_wakeup_one_sleeper(&mutex->synchbase))
+    if (xnsynch_wakeup_one_sleeper(&mutex->synchbase) ||
+        xnsynch_test_flags(&mutex->synchbase, XNSYNCH_PCP))
+        /* Dropping the ceiling may have lowered our priority. */
         xnpod_schedule();
 
     return 0;
@@ -21,7 +21,8 @@
 static const pthread_mutexattr_t default_mutex_attr = {
     magic: PSE51_MUTEX_ATTR_MAGIC,
     type: PTHREAD_MUTEX_NORMAL,
-    protocol: PTHREAD_PRIO_NONE
+    protocol: PTHREAD_PRIO_NONE,
+    prioceiling: PSE51_MAX_PRIORITY
 };
 
 int pthread_mutexattr_init (pthread_mutexattr_t * attr)
@@ -157,13 +158,9 @@ int pthread_mutexattr_setprotocol (pthread_mutexattr_t *attr, int proto)
 	    xnlock_put_irqrestore(&nklock, s);
 	    return EINVAL;
 
-	case PTHREAD_PRIO_PROTECT:
-
-	    xnlock_put_irqrestore(&nklock, s);
-	    return ENOTSUP;
-
 	case PTHREAD_PRIO_NONE:
 	case PTHREAD_PRIO_INHERIT:
+	case PTHREAD_PRIO_PROTECT:
 	    break;
 	}
     
@@ -174,9 +171,57 @@ int pthread_mutexattr_setprotocol (pthread_mutexattr_t *attr, int proto)
     return 0;
 }
 
+int pthread_mutexattr_getprioceiling (const pthread_mutexattr_t *attr,
+				      int *prioceiling)
+{
+    spl_t s;
+
+    if (!prioceiling)
+        return EINVAL;
+    
+    xnlock_get_irqsave(&nklock, s);
+
+    if (!pse51_obj_active(attr, PSE51_MUTEX_ATTR_MAGIC, pthread_attr_t))
+	{
+        xnlock_put_irqrestore(&nklock, s);
+        return EINVAL;
+	}
+
+    *prioceiling = attr->prioceiling;
+
+    xnlock_put_irqrestore(&nklock, s);
+
+    return 0;
+}
+
+int pthread_mutexattr_setprioceiling (pthread_mutexattr_t *attr,
+				      int prioceiling)
+{
+    spl_t s;
+
+    if (prioceiling < PSE51_MIN_PRIORITY || prioceiling > PSE51_MAX_PRIORITY)
+        return EINVAL;
+
+    xnlock_get_irqsave(&nklock, s);
+
+    if (!pse51_obj_active(attr, PSE51_MUTEX_ATTR_MAGIC, pthread_attr_t))
+	{
+        xnlock_put_irqrestore(&nklock, s);
+        return EINVAL;
+	}
+
+    attr->prioceiling = prioceiling;
+
+    xnlock_put_irqrestore(&nklock, s);
+
+    return 0;
+}
+
 EXPORT_SYMBOL(pthread_mutexattr_init);
 EXPORT_SYMBOL(pthread_mutexattr_destroy);
 EXPORT_SYMBOL(pthread_mutexattr_gettype);
 EXPORT_SYMBOL(pthread_mutexattr_settype);
 EXPORT_SYMBOL(pthread_mutexattr_getprotocol);
 EXPORT_SYMBOL(pthread_mutexattr_setprotocol);
+EXPORT_SYMBOL(pthread_mutexattr_getprioceiling);
+EXPORT_SYMBOL(pthread_mutexattr_setprioceiling);
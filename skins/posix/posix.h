@@ -58,6 +58,7 @@ typedef unsigned mqd_t;
 #undef SCHED_FIFO
 #undef SCHED_RR
 #undef SCHED_OTHER
+#undef SCHED_EDF
 #undef sigemptyset
 #undef sigfillset
 #undef sigaddset
@@ -97,6 +98,7 @@ END_C_DECLS
 #define SCHED_FIFO  1
 #define SCHED_RR    2
 #define SCHED_OTHER 3
+#define SCHED_EDF   4	/* Non portable: EDF within priority level */
 
 #define PTHREAD_STACK_MIN   1024
 
@@ -249,6 +251,7 @@ typedef struct pse51_mutexattr {
     unsigned magic;
     int type;
     int protocol;
+    int prioceiling;
 } pthread_mutexattr_t;
 
 BEGIN_C_DECLS
@@ -269,6 +272,12 @@ int pthread_mutexattr_getprotocol(const pthread_mutexattr_t *attr,
 int pthread_mutexattr_setprotocol(pthread_mutexattr_t *attr,
 				  int proto);
 
+int pthread_mutexattr_getprioceiling(const pthread_mutexattr_t *attr,
+				     int *prioceiling);
+
+int pthread_mutexattr_setprioceiling(pthread_mutexattr_t *attr,
+				     int prioceiling);
+
 END_C_DECLS
 
 /* Mutex. */
@@ -306,9 +315,11 @@ END_C_DECLS
 #ifndef __KERNEL__
 #undef CLOCK_MONOTONIC
 #undef CLOCK_REALTIME
+#undef CLOCK_THREAD_CPUTIME_ID
 typedef enum pse51_clockid {
     CLOCK_REALTIME  =0,		/* For absolute timeouts. */
-    CLOCK_MONOTONIC =1		/* For relative timeouts. */
+    CLOCK_MONOTONIC =1,		/* For relative timeouts. */
+    CLOCK_THREAD_CPUTIME_ID =3	/* CPU time consumed by the caller. */
 } clockid_t;
 #endif /* __KERNEL__ */
 
@@ -573,6 +584,8 @@ int timer_gettime(timer_t timerid, struct itimerspec *value);
 
 int timer_getoverrun(timer_t timerid);
 
+int timer_setslack_np(timer_t timerid, const struct timespec *slack);
+
 END_C_DECLS
 
 
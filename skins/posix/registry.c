@@ -29,6 +29,8 @@ struct {
     unsigned mapsz;
 } pse51_reg;
 
+static xnslab_t pse51_desc_slab;
+
 #define PSE51_NODE_PARTIAL_INIT 1
 
 int pse51_reg_pkg_init (unsigned buckets_count, unsigned maxfds)
@@ -44,9 +46,17 @@ int pse51_reg_pkg_init (unsigned buckets_count, unsigned maxfds)
         sizeof(pse51_desc_t) * maxfds +
         sizeof(long) * mapsize;
 
+    /* At most maxfds descriptors may exist concurrently, reserve
+       them all. */
+    if (xnslab_init(&pse51_desc_slab, &kheap, sizeof(pse51_desc_t), maxfds, NULL))
+        return ENOMEM;
+
     chunk = (char *) xnmalloc(size);
     if(!chunk)
+        {
+        xnslab_destroy(&pse51_desc_slab);
         return ENOMEM;
+        }
 
     pse51_reg.node_buckets = (pse51_node_t **) chunk;
     pse51_reg.buckets_count = buckets_count;
@@ -96,6 +106,7 @@ void pse51_reg_pkg_cleanup (void)
 #endif /* CONFIG_XENO_OPT_DEBUG */
 
     xnfree(pse51_reg.node_buckets);
+    xnslab_destroy(&pse51_desc_slab);
 }
 
 
@@ -362,7 +373,7 @@ int pse51_desc_create(pse51_desc_t **descp, pse51_node_t *node)
     if (fd == -1)
         return ENFILE;
 
-    desc = (pse51_desc_t *) xnmalloc(sizeof(*desc));
+    desc = (pse51_desc_t *) xnslab_alloc(&pse51_desc_slab);
 
     if (!desc)
         return ENOMEM;
@@ -378,7 +389,7 @@ int pse51_desc_create(pse51_desc_t **descp, pse51_node_t *node)
 int pse51_desc_destroy(pse51_desc_t *desc)
 {
     pse51_reg_fd_put(desc->fd);
-    xnfree(desc);
+    xnslab_free(&pse51_desc_slab, desc);
     return 0;
 }
 
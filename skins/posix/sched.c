@@ -26,6 +26,7 @@ int sched_get_priority_min (int policy)
 	case SCHED_FIFO:
 	case SCHED_RR:
 	case SCHED_OTHER:
+	case SCHED_EDF:
 
 	    return PSE51_MIN_PRIORITY;
 
@@ -44,6 +45,7 @@ int sched_get_priority_max (int policy)
 	case SCHED_FIFO:
 	case SCHED_RR:
 	case SCHED_OTHER:
+	case SCHED_EDF:
 
 	    return PSE51_MAX_PRIORITY;
 
@@ -116,6 +118,12 @@ int pthread_setschedparam (pthread_t tid, int pol, const struct sched_param *par
 	case SCHED_FIFO:
 
 	    setmask = 0;
+	    clrmask = XNRRB|XNEDF;
+	    break;
+
+	case SCHED_EDF:
+
+	    setmask = XNEDF;
 	    clrmask = XNRRB;
 	    break;
 
@@ -127,7 +135,7 @@ int pthread_setschedparam (pthread_t tid, int pol, const struct sched_param *par
 
 	    xnthread_time_slice(&tid->threadbase) = pse51_time_slice;
 	    setmask = XNRRB;
-	    clrmask = 0;
+	    clrmask = XNEDF;
 	}
 
     if (par->sched_priority < PSE51_MIN_PRIORITY
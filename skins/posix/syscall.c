@@ -44,6 +44,16 @@ struct pthread_jhash {
 
 static struct pthread_jhash *__jhash_buckets[1<<PTHREAD_HASHBITS]; /* Guaranteed zero */
 
+/* The hash slots and the control blocks of the objects created from
+   user-space are obtained from per-type slabs, which are grown on
+   demand from the system heap. */
+
+static xnslab_t __pse51_jhash_slab,
+		__pse51_sem_slab,
+		__pse51_mutex_slab,
+		__pse51_cond_slab,
+		__pse51_intr_slab;
+
 /* We want to keep the native pthread_t token unmodified for
    Xenomai mapped threads, and keep it pointing at a genuine
    NPTL/LinuxThreads descriptor, so that portions of the POSIX
@@ -65,7 +75,7 @@ static inline struct pthread_jhash *__pthread_hash (const struct pse51_hkey *hke
     u32 hash;
     spl_t s;
 
-    slot = (struct pthread_jhash *)xnmalloc(sizeof(*slot));
+    slot = (struct pthread_jhash *)xnslab_alloc(&__pse51_jhash_slab);
 
     if (!slot)
 	return NULL;
@@ -118,7 +128,7 @@ static inline void __pthread_unhash (const struct pse51_hkey *hkey)
     xnlock_put_irqrestore(&nklock,s);
 
     if (slot)
-	xnfree(slot);
+	xnslab_free(&__pse51_jhash_slab,slot);
 }
 
 static pthread_t __pthread_find (const struct pse51_hkey *hkey)
@@ -412,7 +422,7 @@ int __sem_init (struct task_struct *curr, struct pt_regs *regs)
     if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg1(regs),sizeof(handle)))
 	return -EFAULT;
 
-    sem = (sem_t *)xnmalloc(sizeof(*sem));
+    sem = (sem_t *)xnslab_alloc(&__pse51_sem_slab);
 
     if (!sem)
 	return -ENOMEM;
@@ -422,7 +432,7 @@ int __sem_init (struct task_struct *curr, struct pt_regs *regs)
 
     if (sem_init(sem,pshared,value) == -1)
         {
-        xnfree(sem);
+        xnslab_free(&__pse51_sem_slab,sem);
         return -thread_get_errno();
         }
 
@@ -532,7 +542,7 @@ int __sem_destroy (struct task_struct *curr, struct pt_regs *regs)
        been ok so far, we can reasonably expect the sem block to be
        valid, so let's free it. */
 
-    xnfree(sem);
+    xnslab_free(&__pse51_sem_slab,sem);
 
     return 0;
 }
@@ -710,8 +720,10 @@ int __clock_nanosleep (struct task_struct *curr, struct pt_regs *regs)
     return -EINTR;
 }
 
-int __mutex_init (struct task_struct *curr, struct pt_regs *regs)
-
+static int __mutex_init_inner (struct task_struct *curr,
+			       struct pt_regs *regs,
+			       int protocol,
+			       int prioceiling)
 {
     pthread_mutexattr_t attr;
     pthread_mutex_t *mutex;
@@ -721,19 +733,32 @@ int __mutex_init (struct task_struct *curr, struct pt_regs *regs)
     if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg1(regs),sizeof(handle)))
 	return -EFAULT;
 
-    mutex = (pthread_mutex_t *)xnmalloc(sizeof(*mutex));
+    /* Recursive mutexes are always built; the protocol is PIP unless
+       the priority ceiling protocol is explicitly requested. */
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutexattr_setprotocol(&attr,protocol);
+
+    if (protocol == PTHREAD_PRIO_PROTECT)
+	{
+	err = pthread_mutexattr_setprioceiling(&attr,prioceiling);
+
+	if (err)
+	    return -err;
+	}
+
+    mutex = (pthread_mutex_t *)xnslab_alloc(&__pse51_mutex_slab);
 
     if (!mutex)
 	return -ENOMEM;
 
-    /* Recursive + PIP forced. */
-    pthread_mutexattr_init(&attr);
-    pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE);
-    pthread_mutexattr_setprotocol(&attr,PTHREAD_PRIO_INHERIT);
     err = pthread_mutex_init(mutex,&attr);
 
     if (err)
+        {
+        xnslab_free(&__pse51_mutex_slab,mutex);
         return -err;
+        }
 
     handle = (unsigned long)mutex;
 
@@ -744,6 +769,18 @@ int __mutex_init (struct task_struct *curr, struct pt_regs *regs)
     return 0;
 }
 
+int __mutex_init (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    return __mutex_init_inner(curr,regs,PTHREAD_PRIO_INHERIT,0);
+}
+
+int __mutex_init_ceiling (struct task_struct *curr, struct pt_regs *regs)
+
+{
+    return __mutex_init_inner(curr,regs,PTHREAD_PRIO_PROTECT,(int)__xn_reg_arg2(regs));
+}
+
 int __mutex_destroy (struct task_struct *curr, struct pt_regs *regs)
 
 {
@@ -759,7 +796,7 @@ int __mutex_destroy (struct task_struct *curr, struct pt_regs *regs)
        far, we can reasonably expect the mutex block to be valid, so
        let's free it. */
 
-    xnfree(mutex);
+    xnslab_free(&__pse51_mutex_slab,mutex);
 
     return 0;
 }
@@ -812,7 +849,7 @@ int __cond_init (struct task_struct *curr, struct pt_regs *regs)
     if (!__xn_access_ok(curr,VERIFY_WRITE,__xn_reg_arg1(regs),sizeof(handle)))
 	return -EFAULT;
 
-    cond = (pthread_cond_t *)xnmalloc(sizeof(*cond));
+    cond = (pthread_cond_t *)xnslab_alloc(&__pse51_cond_slab);
 
     if (!cond)
 	return -ENOMEM;
@@ -820,7 +857,10 @@ int __cond_init (struct task_struct *curr, struct pt_regs *regs)
     err = pthread_cond_init(cond,NULL);	/* Always use default attribute. */
 
     if (err)
+        {
+        xnslab_free(&__pse51_cond_slab,cond);
         return -err;
+        }
 
     handle = (unsigned long)cond;
 
@@ -842,7 +882,7 @@ int __cond_destroy (struct task_struct *curr, struct pt_regs *regs)
     if (err)
 	return -err;
 
-    xnfree(cond);
+    xnslab_free(&__pse51_cond_slab,cond);
 
     return 0;
 }
@@ -1298,7 +1338,7 @@ int __intr_attach (struct task_struct *curr, struct pt_regs *regs)
     if (mode & ~(XN_ISR_ENABLE|XN_ISR_CHAINED))
 	return -EINVAL;
 
-    intr = (struct pse51_interrupt *)xnmalloc(sizeof(*intr));
+    intr = (struct pse51_interrupt *)xnslab_alloc(&__pse51_intr_slab);
 
     if (!intr)
 	return -ENOMEM;
@@ -1315,7 +1355,7 @@ int __intr_attach (struct task_struct *curr, struct pt_regs *regs)
 			  sizeof(handle));
 	}
     else
-	xnfree(intr);
+	xnslab_free(&__pse51_intr_slab,intr);
 
     return -err;
 }
@@ -1326,7 +1366,7 @@ int __intr_detach (struct task_struct *curr, struct pt_regs *regs)
     int err = pse51_intr_detach(intr);
 
     if (!err)
-	xnfree(intr);
+	xnslab_free(&__pse51_intr_slab,intr);
 
     return -err;
 }
@@ -1504,6 +1544,21 @@ int __timer_getoverrun (struct task_struct *curr, struct pt_regs *regs)
     return rc >= 0 ? rc : -thread_get_errno();
 }
 
+int __timer_setslack (struct task_struct *curr, struct pt_regs *regs)
+{
+    struct timespec slack;
+    int rc;
+
+    if (!__xn_access_ok(curr,VERIFY_READ,__xn_reg_arg2(regs),sizeof(slack)))
+        return -EFAULT;
+
+    __xn_copy_from_user(curr, &slack, (char *) __xn_reg_arg2(regs), sizeof(slack));
+
+    rc = timer_setslack_np((timer_t) __xn_reg_arg1(regs), &slack);
+
+    return rc == 0 ? 0 : -thread_get_errno();
+}
+
 #if 0
 int __itimer_set (struct task_struct *curr, struct pt_regs *regs)
 {
@@ -1637,6 +1692,8 @@ static xnsysent_t __systab[] = {
     [__pse51_timer_settime] = { &__timer_settime, __xn_exec_any },
     [__pse51_timer_gettime] = { &__timer_gettime, __xn_exec_any },
     [__pse51_timer_getoverrun] = { &__timer_getoverrun, __xn_exec_any },
+    [__pse51_timer_setslack] = { &__timer_setslack, __xn_exec_any },
+    [__pse51_mutex_init_ceiling] = { &__mutex_init_ceiling, __xn_exec_any },
 };
 
 static void __shadow_delete_hook (xnthread_t *thread)
@@ -1651,9 +1708,34 @@ static void __shadow_delete_hook (xnthread_t *thread)
 	}
 }
 
+static struct {
+    xnslab_t *slab;
+    u_long objsize;
+} __pse51_slabs[] = {
+    { &__pse51_jhash_slab, sizeof(struct pthread_jhash) },
+    { &__pse51_sem_slab, sizeof(sem_t) },
+    { &__pse51_mutex_slab, sizeof(pthread_mutex_t) },
+    { &__pse51_cond_slab, sizeof(pthread_cond_t) },
+    { &__pse51_intr_slab, sizeof(struct pse51_interrupt) },
+    { NULL, 0 }
+};
+
 int pse51_syscall_init (void)
 
 {
+    int n, err;
+
+    for (n = 0; __pse51_slabs[n].slab; n++)
+	{
+	err = xnslab_init(__pse51_slabs[n].slab,
+			  &kheap,
+			  __pse51_slabs[n].objsize,
+			  0,
+			  NULL);
+	if (err)
+	    goto destroy_slabs;
+	}
+
     __muxid =
 	xnshadow_register_interface("posix",
 				    PSE51_SKIN_MAGIC,
@@ -1661,19 +1743,39 @@ int pse51_syscall_init (void)
 				    __systab,
 				    NULL);
     if (__muxid < 0)
-	return -ENOSYS;
+	{
+	err = -ENOSYS;
+	goto destroy_slabs;
+	}
 
     xnpod_add_hook(XNHOOK_THREAD_DELETE,&__shadow_delete_hook);
 
     __pse51_errptd = rthal_alloc_ptdkey();
     
     return 0;
+
+ destroy_slabs:
+
+    while (--n >= 0)
+	xnslab_destroy(__pse51_slabs[n].slab);
+
+    return err;
 }
 
 void pse51_syscall_cleanup (void)
 
 {
+    int n;
+
     xnpod_remove_hook(XNHOOK_THREAD_DELETE,&__shadow_delete_hook);
     xnshadow_unregister_interface(__muxid);
     rthal_free_ptdkey(__pse51_errptd);
+
+    /* Leave a slab in place if user-space did not release all its
+       objects, as their memory would have stayed allocated from the
+       system heap. */
+
+    for (n = 0; __pse51_slabs[n].slab; n++)
+	if (xnslab_free_count(__pse51_slabs[n].slab) == xnslab_count(__pse51_slabs[n].slab))
+	    xnslab_destroy(__pse51_slabs[n].slab);
 }
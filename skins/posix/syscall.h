@@ -75,6 +75,8 @@
 #define __pse51_sem_close             49
 #define __pse51_sem_unlink            50
 #define __pse51_sem_timedwait         51
+#define __pse51_timer_setslack        52
+#define __pse51_mutex_init_ceiling    53
 
 #ifdef __KERNEL__
 
@@ -29,6 +29,8 @@ xnqueue_t pse51_threadq;
 
 static pthread_attr_t default_attr;
 
+static xnslab_t thread_slab;	/* Thread control blocks. */
+
 static void thread_destroy (pthread_t thread)
 
 {
@@ -36,7 +38,7 @@ static void thread_destroy (pthread_t thread)
     /* join_sync wait queue may not be empty only when this function is called
        from pse51_cond_obj_cleanup, hence the absence of xnpod_schedule(). */
     xnsynch_destroy(&thread->join_synch);
-    xnfree(thread);
+    xnslab_free(&thread_slab, thread);
 }
 
 static void thread_trampoline (void *cookie)
@@ -105,7 +107,7 @@ int pthread_create (pthread_t *tid,
     if (attr && attr->magic != PSE51_THREAD_ATTR_MAGIC)
         return EINVAL;
 
-    thread = (pthread_t)xnmalloc(sizeof(*thread));
+    thread = (pthread_t)xnslab_alloc(&thread_slab);
 
     if (!thread)
 	return EAGAIN;
@@ -122,7 +124,7 @@ int pthread_create (pthread_t *tid,
 
         if (!cur)
 	    {
-            xnfree(thread);
+            xnslab_free(&thread_slab, thread);
             return EINVAL;
 	    }
 
@@ -146,7 +148,7 @@ int pthread_create (pthread_t *tid,
 			  flags,
                           stacksize) != 0)
 	{
-	xnfree(thread);
+	xnslab_free(&thread_slab, thread);
 	return EAGAIN;
 	}
 
@@ -171,6 +173,8 @@ int pthread_create (pthread_t *tid,
 	xnthread_time_slice(&thread->threadbase) = pse51_time_slice;
         flags = XNRRB;
 	}
+    else if (thread->attr.policy == SCHED_EDF)
+        flags = XNEDF;
     else
         flags = 0;
 
@@ -376,6 +380,9 @@ void pse51_thread_pkg_init (u_long rrperiod)
 {
     initq(&pse51_threadq);
     pthread_attr_init(&default_attr);
+    /* Chunks of control blocks are obtained from the system heap on
+       demand. */
+    xnslab_init(&thread_slab, &kheap, sizeof(struct pse51_thread), 0, NULL);
     pse51_time_slice = rrperiod;
     xnpod_add_hook(XNHOOK_THREAD_DELETE,thread_delete_hook);
 }
@@ -413,6 +420,8 @@ void pse51_thread_pkg_cleanup (void)
     xnlock_put_irqrestore(&nklock, s);
 
     xnpod_remove_hook(XNHOOK_THREAD_DELETE,thread_delete_hook);
+
+    xnslab_destroy(&thread_slab);
 }
 
 extern int __pse51_errptd;
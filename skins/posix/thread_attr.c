@@ -287,6 +287,7 @@ int pthread_attr_setschedpolicy (pthread_attr_t *attr, int policy)
 
 	case SCHED_FIFO:
 	case SCHED_RR:
+	case SCHED_EDF:
 
 	    break;
 	}
@@ -281,6 +281,40 @@ int timer_settime (timer_t timerid,
     return -1;
 }
 
+/* Non-portable extension: set the lateness a timer tolerates, so that
+   the nucleus may elapse it along with other timers due within the
+   same window, from a single hardware shot (oneshot mode only). */
+int timer_setslack_np (timer_t timerid, const struct timespec *slack)
+{
+    struct pse51_timer *timer;
+    spl_t s;
+
+    if ((unsigned) timerid >= PSE51_TIMER_MAX)
+        goto einval;
+
+    if ((unsigned) slack->tv_nsec >= ONE_BILLION)
+        goto einval;
+
+    xnlock_get_irqsave(&nklock, s);
+
+    timer = &timer_pool[timerid];
+
+    if (!xntimer_active_p(&timer->timerbase))
+        goto unlock_and_einval;
+
+    xntimer_set_slack(&timer->timerbase, ts2ticks_ceil(slack));
+
+    xnlock_put_irqrestore(&nklock, s);
+
+    return 0;
+
+  unlock_and_einval:
+    xnlock_put_irqrestore(&nklock, s);
+  einval:
+    thread_set_errno(EINVAL);
+    return -1;
+}
+
 int timer_gettime(timer_t timerid, struct itimerspec *value)
 {
     struct pse51_timer *timer;
@@ -391,3 +425,4 @@ EXPORT_SYMBOL(timer_delete);
 EXPORT_SYMBOL(timer_settime);
 EXPORT_SYMBOL(timer_gettime);
 EXPORT_SYMBOL(timer_getoverrun);
+EXPORT_SYMBOL(timer_setslack_np);
@@ -243,7 +243,7 @@ static u_long q_destroy_internal (psosqueue_t *queue)
 
     removeq(&psosqueueq,&queue->link);
 
-    if (countpq(xnsynch_wait_queue(&queue->synchbase)) > 0)
+    if (synch_countpq(xnsynch_wait_queue(&queue->synchbase)) > 0)
 	err = ERR_TATQDEL;
     else if (countq(&queue->inq) > 0)
 	err = ERR_MATQDEL;
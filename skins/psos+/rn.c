@@ -132,6 +132,8 @@ u_long rn_create (char name[4],
     if (xnheap_init(&rn->heapbase,rn->data,rnsize,4096) != 0)
 	return ERR_TINYRN;
 
+    xnheap_set_label(&rn->heapbase,rn->name);
+
     xnsynch_init(&rn->synchbase,bflags);
 
     rn->magic = PSOS_RN_MAGIC;
@@ -330,7 +332,7 @@ u_long rn_retseg (u_long rnid,
 	{
 	xnpholder_t *holder, *nholder;
 	
-	nholder = getheadpq(xnsynch_wait_queue(synch));
+	nholder = synch_getheadpq(xnsynch_wait_queue(synch));
 
 	while ((holder = nholder) != NULL)
 	    {
@@ -344,7 +346,7 @@ u_long rn_retseg (u_long rnid,
 		sleeper->waitargs.region.chunk = chunk;
 		}
 	    else
-		nholder = nextpq(xnsynch_wait_queue(synch),holder);
+		nholder = synch_nextpq(xnsynch_wait_queue(synch),holder);
 	    }
 
 	xnpod_schedule();
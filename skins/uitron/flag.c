@@ -151,7 +151,7 @@ ER set_flg (ID flgid, UINT setptn)
 
     if (xnsynch_nsleepers(&flg->synchbase) > 0)
 	{
-	for (holder = getheadpq(xnsynch_wait_queue(&flg->synchbase));
+	for (holder = synch_getheadpq(xnsynch_wait_queue(&flg->synchbase));
 	     holder; holder = nholder)
 	    {
 	    uitask_t *sleeper = thread2uitask(link2thread(holder,plink));
@@ -168,7 +168,7 @@ ER set_flg (ID flgid, UINT setptn)
 		    flg->flgvalue = 0;
 		}
 	    else
-		nholder = nextpq(xnsynch_wait_queue(&flg->synchbase),holder);
+		nholder = synch_nextpq(xnsynch_wait_queue(&flg->synchbase),holder);
 	    }
 
 	xnpod_schedule();
@@ -332,7 +332,7 @@ ER ref_flg (T_RFLG *pk_rflg, ID flgid)
 	return E_NOEXS;
 	}
 
-    sleeper = thread2uitask(link2thread(getheadpq(xnsynch_wait_queue(&flg->synchbase)),plink));
+    sleeper = thread2uitask(link2thread(synch_getheadpq(xnsynch_wait_queue(&flg->synchbase)),plink));
     pk_rflg->exinf = flg->exinf;
     pk_rflg->flgptn = flg->flgvalue;
     pk_rflg->wtsk = sleeper ? sleeper->tskid : FALSE;
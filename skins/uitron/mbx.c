@@ -293,7 +293,7 @@ ER ref_mbx (T_RMBX *pk_rmbx, ID mbxid)
 	return E_NOEXS;
 	}
 
-    sleeper = thread2uitask(link2thread(getheadpq(xnsynch_wait_queue(&mbx->synchbase)),plink));
+    sleeper = thread2uitask(link2thread(synch_getheadpq(xnsynch_wait_queue(&mbx->synchbase)),plink));
     pk_rmbx->exinf = mbx->exinf;
     pk_rmbx->pk_msg = mbx->mcount > 0 ? mbx->ring[mbx->rdptr] : (T_MSG *)NADR;
     pk_rmbx->wtsk = sleeper ? sleeper->tskid : FALSE;
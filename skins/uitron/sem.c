@@ -268,7 +268,7 @@ ER ref_sem (T_RSEM *pk_rsem, ID semid)
 	return E_NOEXS;
 	}
 
-    sleeper = thread2uitask(link2thread(getheadpq(xnsynch_wait_queue(&sem->synchbase)),plink));
+    sleeper = thread2uitask(link2thread(synch_getheadpq(xnsynch_wait_queue(&sem->synchbase)),plink));
     pk_rsem->exinf = sem->exinf;
     pk_rsem->semcnt = sem->semcnt;
     pk_rsem->wtsk = sleeper ? sleeper->tskid : FALSE;
@@ -223,7 +223,7 @@ void sc_fpost (int group_id, int mask, int *errp)
 
     evgroup->events |= mask;
 
-    nholder = getheadpq(xnsynch_wait_queue(&evgroup->synchbase));
+    nholder = synch_getheadpq(xnsynch_wait_queue(&evgroup->synchbase));
 
     while ((holder = nholder) != NULL)
 	{
@@ -237,7 +237,7 @@ void sc_fpost (int group_id, int mask, int *errp)
 	    nholder = xnsynch_wakeup_this_sleeper(&evgroup->synchbase,holder);
 	    }
 	else
-	    nholder = nextpq(xnsynch_wait_queue(&evgroup->synchbase),holder);
+	    nholder = synch_nextpq(xnsynch_wait_queue(&evgroup->synchbase),holder);
 	}
 
     xnpod_schedule();
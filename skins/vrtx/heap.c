@@ -88,6 +88,7 @@ int sc_hcreate(char *heapaddr,
 {
     u_long pagesize;
     vrtxheap_t *heap;
+    char name[16];
     spl_t s;
 
     int err;
@@ -144,6 +145,9 @@ int sc_hcreate(char *heapaddr,
     appendq(&vrtxheapq, &heap->link);
     xnlock_put_irqrestore(&nklock,s);
 
+    sprintf(name,"h%.3d",heapid);
+    xnheap_set_label(&heap->sysheap,name);
+
     return heapid;
 }
 
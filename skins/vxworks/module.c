@@ -137,6 +137,7 @@ EXPORT_SYMBOL(wdCreate);
 EXPORT_SYMBOL(wdDelete);
 EXPORT_SYMBOL(wdStart);
 EXPORT_SYMBOL(wdCancel);
+EXPORT_SYMBOL(wdSlackSet);
 EXPORT_SYMBOL(msgQCreate);
 EXPORT_SYMBOL(msgQDelete);
 EXPORT_SYMBOL(msgQNumMsgs);
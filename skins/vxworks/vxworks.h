@@ -373,6 +373,8 @@ extern "C" {
 
     STATUS wdCancel (WDOG_ID handle);
 
+    STATUS wdSlackSet (WDOG_ID handle, int slack);
+
 
 
     /* Messages queues */
@@ -34,6 +34,8 @@ typedef struct wind_wd {
 
     xntimer_t timerbase;
 
+    int slack;   /* Tolerated lateness (in ticks) */
+
 } wind_wd_t;
 
 typedef void (* xntimer_handler) (void *);
@@ -73,6 +75,7 @@ WDOG_ID wdCreate (void)
 
     inith(&wd->link);
     wd->magic = WIND_WD_MAGIC;
+    wd->slack = 0;
 
     setbits(wd->timerbase.status, WIND_WD_INITIALIZED);
     
@@ -127,6 +130,8 @@ STATUS wdStart ( WDOG_ID handle,
             xntimer_stop(&wd->timerbase);
     
     xntimer_init(&wd->timerbase, (xntimer_handler) handler, (void *) (long)arg);
+
+    xntimer_set_slack(&wd->timerbase, wd->slack);
     
     xntimer_start(&wd->timerbase,timeout,XN_INFINITE);
 
@@ -161,6 +166,33 @@ STATUS wdCancel ( WDOG_ID handle )
 
 
 
+/* Non-standard extension: define the lateness a watchdog tolerates,
+   so that watchdogs due within the same window may be fired from a
+   single timer interrupt (oneshot mode only). Applies from the next
+   call to wdStart() on. */
+STATUS wdSlackSet ( WDOG_ID handle, int slack )
+{
+    wind_wd_t *wd;
+    spl_t s;
+
+    if (slack < 0)
+	return ERROR;
+
+    xnlock_get_irqsave(&nklock, s);
+    check_OBJ_ID_ERROR(handle, wind_wd_t, wd, WIND_WD_MAGIC, goto error);
+    wd->slack = slack;
+    xnlock_put_irqrestore(&nklock, s);
+
+    return OK;
+
+ error:
+    xnlock_put_irqrestore(&nklock, s);
+    return ERROR;
+}
+
+
+
+
 static void wd_destroy_internal (wind_wd_t * handle)
 {
     spl_t s;